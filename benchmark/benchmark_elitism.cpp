@@ -0,0 +1,62 @@
+/**
+ * @file benchmark_elitism.cpp
+ * @brief timing of the top-k elite selection against a full sort of the fitness.
+ *
+ * The full sort is the O(N log N) argsort used by Elitism before top_k_indices;
+ * the top-k selection should scale linearly with the population size.
+ */
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+#include "xtensor/xrandom.hpp"
+
+#include "xevo/selection.hpp"
+
+template <class FUNC>
+double time_per_call(FUNC f, std::size_t repeats)
+{
+  f();
+
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t r{ 0 }; r < repeats; ++r)
+  {
+    f();
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::micro>(stop - start).count() / static_cast<double>(repeats);
+}
+
+int main()
+{
+  std::cout << "individuals, elites, full sort [us], top-k [us], best (k = 1) [us]" << std::endl;
+  for (std::size_t num_of_indiv = 1000; num_of_indiv <= 1000000; num_of_indiv *= 10)
+  {
+    std::array<std::size_t, 1> shape_y = { num_of_indiv };
+    xt::xtensor<double, 1> Y = xt::random::rand<double>(shape_y);
+    std::size_t num_of_elites = static_cast<std::size_t>(std::ceil(0.05 * num_of_indiv));
+    std::size_t repeats = std::max<std::size_t>(1, 10000000 / num_of_indiv);
+    std::vector<std::size_t> indices;
+
+    double t_sort = time_per_call([&]()
+    {
+      indices.resize(num_of_indiv);
+      std::iota(indices.begin(), indices.end(), std::size_t(0));
+      std::sort(indices.begin(), indices.end(), [&Y](std::size_t a, std::size_t b) { return Y(a) > Y(b); });
+      indices.resize(num_of_elites);
+    }, repeats);
+    double t_top_k = time_per_call([&]() { xevo::top_k_indices(Y, num_of_elites, true, indices); }, repeats);
+    double t_best = time_per_call([&]() { xevo::top_k_indices(Y, 1, true, indices); }, repeats);
+
+    std::cout << num_of_indiv << ", " << num_of_elites << ", " << t_sort << ", " << t_top_k << ", "
+      << t_best << std::endl;
+  }
+
+  return 0;
+}
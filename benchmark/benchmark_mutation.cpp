@@ -0,0 +1,44 @@
+/**
+ * @file benchmark_mutation.cpp
+ * @brief timing of the polynomial mutation on wide genomes.
+ *
+ * The time per mutated gene should stay roughly constant when the mutation rate
+ * drops: the cost follows the number of mutations, not the size of the population.
+ */
+#include <array>
+#include <chrono>
+#include <iostream>
+
+#include "xtensor/xtensor.hpp"
+#include "xtensor/xrandom.hpp"
+
+#include "xevo/functors.hpp"
+
+int main()
+{
+  std::size_t num_of_indiv = 100;
+  std::size_t num_of_vars = 10000;
+  std::array<std::size_t, 2> shape = { num_of_indiv, num_of_vars };
+  xt::xtensor<double, 2> X = xt::random::rand<double>(shape);
+
+  std::cout << "rate, time per generation [us], time per mutated gene [ns]" << std::endl;
+  for (double rate : { 1e-1, 1e-2, 1e-3, 1e-4, 1e-5 })
+  {
+    xevo::Mutation_polynomial mutation_f(rate, 20.0);
+    std::size_t repeats = 50;
+
+    mutation_f(X, X);
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t r{ 0 }; r < repeats; ++r)
+    {
+      mutation_f(X, X);
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count() / repeats;
+    double num_of_mutations = rate * num_of_indiv * num_of_vars;
+    std::cout << rate << ", " << ns / 1000.0 << ", " << ns / num_of_mutations << std::endl;
+  }
+
+  return 0;
+}
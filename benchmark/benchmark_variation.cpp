@@ -0,0 +1,61 @@
+/**
+ * @file benchmark_variation.cpp
+ * @brief timing of crossover followed by mutation against the fused variation pass.
+ *
+ * For large populations the separate passes are bound by memory bandwidth: the
+ * children are written by the crossover and read back by the mutation. The fused
+ * pass mutates every block of the children while it is still in cache.
+ */
+#include <array>
+#include <chrono>
+#include <iostream>
+
+#include "xtensor/xtensor.hpp"
+#include "xtensor/xrandom.hpp"
+
+#include "xevo/crossover.hpp"
+#include "xevo/functors.hpp"
+
+template <class FUNC>
+double time_per_generation(FUNC&& f, std::size_t repeats)
+{
+  f();
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t r{ 0 }; r < repeats; ++r)
+  {
+    f();
+  }
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count() / repeats;
+}
+
+int main()
+{
+  std::size_t num_of_vars = 1000;
+  std::size_t repeats = 20;
+
+  std::cout << "individuals, separate [ms/generation], fused [ms/generation]" << std::endl;
+  for (std::size_t num_of_indiv = 1000; num_of_indiv <= 100000; num_of_indiv *= 10)
+  {
+    std::array<std::size_t, 2> shape = { num_of_indiv, num_of_vars };
+    xt::xtensor<double, 2> X = xt::random::rand<double>(shape);
+    xt::xtensor<double, 2> X_out = xt::zeros<double>(shape);
+
+    xevo::Crossover_sbx cross_f(0.9, 15.0);
+    xevo::Mutation_polynomial mutation_f(0.01, 20.0);
+
+    double t_separate = time_per_generation([&]()
+    {
+      cross_f(X, X_out);
+      mutation_f(X_out, X_out);
+    }, repeats);
+    double t_fused = time_per_generation([&]()
+    {
+      cross_f(X, X_out, mutation_f);
+    }, repeats);
+
+    std::cout << num_of_indiv << ", " << t_separate << ", " << t_fused << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file benchmark_velocity.cpp
+ * @brief timing of the velocity functors against the swarm size.
+ *
+ * The time per particle should stay constant when the swarm grows
+ * (linear scaling of a generation).
+ */
+#include <array>
+#include <chrono>
+#include <iostream>
+
+#include "xtensor/xtensor.hpp"
+#include "xtensor/xrandom.hpp"
+
+#include "xevo/functors.hpp"
+
+template <class VEL>
+double time_per_particle(VEL vel_f, std::size_t num_of_particles, std::size_t num_of_vars, std::size_t repeats)
+{
+  std::array<std::size_t, 2> shape = { num_of_particles, num_of_vars };
+  std::array<std::size_t, 1> shape_y = { num_of_particles };
+  xt::xarray<double> X = xt::random::rand<double>(shape);
+  xt::xarray<double> XB = xt::random::rand<double>(shape);
+  xt::xarray<double> V = xt::zeros<double>(shape);
+  xt::xarray<double> YB = xt::random::rand<double>(shape_y);
+
+  vel_f(X, XB, V, YB);
+
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t r{ 0 }; r < repeats; ++r)
+  {
+    vel_f(X, XB, V, YB);
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+  return ns / static_cast<double>(repeats * num_of_particles);
+}
+
+int main()
+{
+  std::size_t num_of_vars = 10;
+
+  std::cout << "particles, Velocity [ns/particle], Velocity_cf_ring_topology [ns/particle], "
+    << "ring k = 64 [ns/particle], von Neumann [ns/particle]" << std::endl;
+  for (std::size_t num_of_particles = 1000; num_of_particles <= 1000000; num_of_particles *= 10)
+  {
+    std::size_t repeats = std::max<std::size_t>(1, 10000000 / num_of_particles);
+    double t_global = time_per_particle(xevo::Velocity(0.5, 0.8, 0.9), num_of_particles, num_of_vars, repeats);
+    double t_ring = time_per_particle(xevo::Velocity_cf_ring_topology(0.7298, 2.05, 2.05, 4),
+      num_of_particles, num_of_vars, repeats);
+    double t_ring_large = time_per_particle(xevo::Velocity_cf_ring_topology(0.7298, 2.05, 2.05, 64),
+      num_of_particles, num_of_vars, repeats);
+    double t_von_neumann = time_per_particle(
+      xevo::Velocity_topology<xevo::Topology_von_neumann>(0.7298, 1.49618, 1.49618, xevo::Topology_von_neumann()),
+      num_of_particles, num_of_vars, repeats);
+    std::cout << num_of_particles << ", " << t_global << ", " << t_ring << ", " << t_ring_large << ", "
+      << t_von_neumann << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file ask_tell.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief header file with the bookkeeping of the ask/tell interface of the solvers.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __ASK_TELL_HPP__
+#define __ASK_TELL_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+
+#include "functors.hpp"
+
+
+namespace xevo
+{
+
+  /**
+   * @brief placeholder objective of solvers driven through ask/tell
+   *
+   * The candidates are evaluated outside the solver (e.g. by a job system) and their
+   * fitness is passed back with tell(); calling the objective (step(), run() or
+   * fitness() before the generation is told) throws.
+   */
+  struct No_objective
+  {
+    template <class E>
+    xt::xtensor<double, 1> operator()(const E&)
+    {
+      throw std::runtime_error("No_objective: the candidates are evaluated with ask/tell");
+    }
+  };
+
+  /**
+   * @brief candidates handed out by ask()
+   *
+   * X is a view of consecutive rows of the population buffer of the solver (no copy);
+   * row k of X is row indices[k] of the generation. The view stays valid until the
+   * fitness of every row of the generation has been told.
+   *
+   * @tparam T value type
+   */
+  template <class T>
+  struct ask_batch
+  {
+    ask_batch(std::size_t generation_, std::size_t first, std::size_t num_of_rows, row_block<T> X_) :
+      generation{ generation_ }, indices(num_of_rows), X(std::move(X_))
+    {
+      for (std::size_t k{ 0 }; k < num_of_rows; ++k)
+      {
+        indices[k] = first + k;
+      }
+    }
+
+    /**
+     * @brief number of candidates
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const
+    {
+      return indices.size();
+    }
+
+    std::size_t generation; ///< generation of the candidates
+    std::vector<std::size_t> indices; ///< rows of the candidates in the generation
+    row_block<T> X; ///< candidates (one per row)
+  };
+
+  /**
+   * @brief rows of a generation handed out by ask() and told back by tell()
+   *
+   * Rows are handed out in order, in batches of any size, and can be told back in any
+   * order; the generation is complete when every row has been told once.
+   */
+  class ask_tell_tracker
+  {
+  public:
+
+    /**
+     * @brief start collecting the fitness of a generation
+     *
+     * @param num_of_rows size of the generation
+     */
+    void start(std::size_t num_of_rows)
+    {
+      _told.assign(num_of_rows, false);
+      _handed_out = 0;
+      _remaining = num_of_rows;
+      _collecting = num_of_rows > 0;
+    }
+
+    /**
+     * @brief true while the fitness of the generation is incomplete
+     *
+     * @return bool
+     */
+    bool collecting() const
+    {
+      return _collecting;
+    }
+
+    /**
+     * @brief hand out the next rows
+     *
+     * @param max_rows maximum number of rows
+     * @param first first handed out row (output)
+     * @return std::size_t number of handed out rows (0 when every row is out)
+     */
+    std::size_t hand_out(std::size_t max_rows, std::size_t& first)
+    {
+      first = _handed_out;
+      std::size_t num_of_rows = std::min(max_rows, _told.size() - _handed_out);
+      _handed_out += num_of_rows;
+      return num_of_rows;
+    }
+
+    /**
+     * @brief record the fitness of a row
+     *
+     * @param i row of the generation
+     * @return true when the generation is complete
+     */
+    bool tell(std::size_t i)
+    {
+      if (!_collecting || i >= _handed_out)
+      {
+        throw std::runtime_error("tell: the row has not been asked for");
+      }
+      if (_told[i])
+      {
+        throw std::runtime_error("tell: the fitness of the row has already been told");
+      }
+      _told[i] = true;
+      _collecting = --_remaining > 0;
+      return !_collecting;
+    }
+
+    /**
+     * @brief number of rows handed out and not told yet
+     *
+     * @return std::size_t
+     */
+    std::size_t outstanding() const
+    {
+      return _remaining - (_told.size() - _handed_out);
+    }
+
+  private:
+    std::vector<bool> _told; ///< rows told
+    std::size_t _handed_out{ 0 }; ///< rows [0, _handed_out) are out
+    std::size_t _remaining{ 0 }; ///< rows not told yet
+    bool _collecting{ false };
+  };
+
+}
+
+#endif
@@ -0,0 +1,425 @@
+/**
+ * @file async_ga.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief templated header file with the asynchronous steady-state genetic algorithm.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __ASYNC_GA_HPP__
+#define __ASYNC_GA_HPP__
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+
+#include "crossover.hpp"
+#include "functors.hpp"
+#include "rng.hpp"
+#include "thread_pool.hpp"
+
+
+namespace xevo
+{
+
+  /**
+   * @brief individual replaced by an offspring of the steady-state algorithms
+   */
+  enum class replacement_policy
+  {
+    worst, ///< worst individual of the population
+    tournament ///< worst of tournament_size individuals drawn at random
+  };
+
+  /**
+   * @brief parameters of async_ga_state
+   */
+  struct async_ga_options
+  {
+    replacement_policy replacement{ replacement_policy::worst }; ///< individual replaced by an offspring
+    std::size_t tournament_size{ 2 }; ///< individuals drawn by replacement_policy::tournament
+    bool maximise{ true }; ///< true when larger fitness is better
+  };
+
+  /**
+   * @brief asynchronous steady-state genetic algorithm
+   *
+   * Every thread of the pool evaluates one individual at a time. Whenever an evaluation
+   * finishes, the thread inserts the result into the population (the offspring
+   * replaces the individual chosen by the replacement policy when it is not worse),
+   * breeds a new offspring with the SEL, CROSS and MUT functors and evaluates it. No
+   * thread waits for the others, so with evaluation times that vary between
+   * individuals the throughput follows the total core time instead of the slowest
+   * evaluation of a generation as in ga_state.
+   *
+   * Parents are selected from the population as it is when the offspring is bred; the
+   * crossover produces two children, the second of which is dispatched next. The
+   * initial population is evaluated row by row by the same workers.
+   *
+   * The objective function is called with a single row (1 x num_of_vars) and must be
+   * safe to call concurrently. The population update and the selection, crossover and
+   * mutation functors run under a lock, one thread at a time. The order in which the
+   * results arrive depends on the evaluation times, so runs with more than one thread
+   * are not reproducible. Without a pool (or with a single thread pool) the evaluations
+   * run on the calling thread.
+   *
+   * @tparam E xtensor type of the population (row-major container)
+   * @tparam OBJ functor for objective function
+   * @tparam SEL functor for selection
+   * @tparam CROSS functor for crossover
+   * @tparam MUT functor for mutation
+   */
+  template<class E, class OBJ, class SEL = Roulette_selection, class CROSS = Crossover, class MUT = Mutation_polynomial>
+  class async_ga_state
+  {
+  public:
+
+    using value_type = typename std::decay_t<E>::value_type;
+    using fitness_type = xt::xtensor<value_type, 1>;
+
+    /**
+     * @brief Construct a new async_ga_state object
+     *
+     * @param X initial population
+     * @param objective_f objective function
+     * @param selection_f functor for selection
+     * @param cross_f functor for crossover
+     * @param mutation_f functor for mutation
+     * @param options replacement and direction
+     * @param pool thread pool of the evaluations (nullptr evaluates on the calling thread)
+     */
+    async_ga_state(const E& X, OBJ objective_f, SEL selection_f, CROSS cross_f, MUT mutation_f,
+      async_ga_options options = async_ga_options{}, std::shared_ptr<thread_pool> pool = nullptr) :
+      _population(X), _objective_f{ std::move(objective_f) }, _selection_f{ std::move(selection_f) },
+      _cross_f{ std::move(cross_f) }, _mutation_f{ std::move(mutation_f) }, _options{ options },
+      _pool{ std::move(pool) }
+    {
+      _options.tournament_size = std::max<std::size_t>(1, _options.tournament_size);
+
+      std::size_t num_of_indiv = _population.shape()[0];
+      std::size_t num_of_vars = _population.shape()[1];
+      std::array<std::size_t, 1> shape_y = { num_of_indiv };
+      std::array<std::size_t, 2> shape_pair = { 2, num_of_vars };
+      std::array<std::size_t, 2> shape_row = { 1, num_of_vars };
+      _y = xt::zeros<value_type>(shape_y);
+      _parents = xt::zeros<value_type>(shape_pair);
+      _children = xt::zeros<value_type>(shape_pair);
+      _jobs.resize(_pool ? _pool->size() : 1);
+      for (auto& j : _jobs)
+      {
+        j.x = xt::zeros<value_type>(shape_row);
+      }
+    }
+
+    /**
+     * @brief evaluate a number of offspring
+     *
+     * The first call also evaluates the initial population. Returns when every
+     * dispatched offspring has been evaluated and inserted. The first exception thrown
+     * by the objective function is rethrown once the other threads have inserted the
+     * evaluations they had started. The state stays valid: the failed offspring is
+     * dropped, and a failed row of the initial population is evaluated again by the
+     * next call.
+     *
+     * @param evaluations number of offspring evaluated
+     */
+    void run(std::size_t evaluations)
+    {
+      _target = _dispatched + evaluations;
+      std::mutex mutex;
+      std::condition_variable completed_cv;
+      bool stop{ false };
+      if (_jobs.size() < 2)
+      {
+        work(_jobs[0], mutex, completed_cv, stop);
+        return;
+      }
+      _pool->parallel_for(_jobs.size(), [&](std::size_t t)
+      {
+        work(_jobs[t], mutex, completed_cv, stop);
+      });
+    }
+
+    /**
+     * @brief current population
+     *
+     * @return const E&
+     */
+    const E& population() const
+    {
+      return _population;
+    }
+
+    /**
+     * @brief fitness of the current population (evaluated on first access)
+     *
+     * @return const fitness_type&
+     */
+    const fitness_type& fitness()
+    {
+      if (!_evaluated)
+      {
+        run(0);
+      }
+      return _y;
+    }
+
+    /**
+     * @brief number of individuals passed to the objective function so far
+     *
+     * @return std::size_t
+     */
+    std::size_t evaluations() const
+    {
+      return _evaluations;
+    }
+
+    /**
+     * @brief number of offspring inserted into the population so far
+     *
+     * @return std::size_t
+     */
+    std::size_t replacements() const
+    {
+      return _replacements;
+    }
+
+    /**
+     * @brief number of evaluating threads
+     *
+     * @return std::size_t
+     */
+    std::size_t threads() const
+    {
+      return _jobs.size();
+    }
+
+    /**
+     * @brief thread pool of the evaluations (nullptr when they run on the calling thread)
+     *
+     * @return std::shared_ptr<thread_pool>
+     */
+    std::shared_ptr<thread_pool> pool() const
+    {
+      return _pool;
+    }
+
+  private:
+
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    struct job
+    {
+      E x; ///< individual (1 x num_of_vars)
+      value_type y; ///< fitness of the individual
+      std::size_t row; ///< row of the initial population (npos for an offspring)
+    };
+
+    value_type evaluate(const E& x)
+    {
+      auto&& y = _objective_f(x);
+      return value_type(y(0));
+    }
+
+    bool better(value_type a, value_type b) const
+    {
+      return _options.maximise ? b < a : a < b;
+    }
+
+    /**
+     * @brief fill a job with the next row of the initial population or a new offspring
+     *
+     * @return false when there is nothing to dispatch (yet)
+     */
+    bool prepare(job& j)
+    {
+      std::size_t num_of_indiv = _population.shape()[0];
+      if (!_failed_rows.empty())
+      {
+        detail::copy_row(_population, _failed_rows.back(), j.x, 0);
+        j.row = _failed_rows.back();
+        _failed_rows.pop_back();
+        return true;
+      }
+      if (_next_row < num_of_indiv)
+      {
+        detail::copy_row(_population, _next_row, j.x, 0);
+        j.row = _next_row++;
+        return true;
+      }
+      if (!_evaluated || _dispatched >= _target)
+      {
+        return false;
+      }
+      breed(j.x);
+      j.row = npos;
+      ++_dispatched;
+      return true;
+    }
+
+    void breed(E& x)
+    {
+      if (!_has_spare)
+      {
+        select_rows(_selection_f, _population, _y, _parents, _indices);
+        vary_rows(_cross_f, _mutation_f, _parents, _children);
+        detail::copy_row(_children, 0, x, 0);
+        _has_spare = true;
+      }
+      else
+      {
+        detail::copy_row(_children, 1, x, 0);
+        _has_spare = false;
+      }
+    }
+
+    void complete(const job& j)
+    {
+      ++_evaluations;
+      if (j.row != npos)
+      {
+        _y(j.row) = j.y;
+        _evaluated = ++_rows_done == _population.shape()[0];
+        return;
+      }
+
+      std::size_t num_of_indiv = _population.shape()[0];
+      std::size_t victim;
+      if (_options.replacement == replacement_policy::worst)
+      {
+        top_k_indices(_y, 1, !_options.maximise, _indices);
+        victim = _indices[0];
+      }
+      else
+      {
+        victim = uniform_index(_gen, num_of_indiv);
+        for (std::size_t k{ 1 }; k < _options.tournament_size; ++k)
+        {
+          std::size_t i = uniform_index(_gen, num_of_indiv);
+          victim = better(_y(victim), _y(i)) ? i : victim;
+        }
+      }
+      if (!better(_y(victim), j.y))
+      {
+        detail::copy_row(j.x, 0, _population, victim);
+        _y(victim) = j.y;
+        ++_replacements;
+      }
+    }
+
+    /**
+     * @brief true while the last rows of the initial population are evaluated by other threads
+     */
+    bool waiting_for_rows() const
+    {
+      return !_evaluated && _failed_rows.empty() && _next_row == _population.shape()[0];
+    }
+
+    /**
+     * @brief evaluate jobs until the target is reached (one call per thread)
+     */
+    void work(job& j, std::mutex& mutex, std::condition_variable& completed_cv, bool& stop)
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true)
+      {
+        completed_cv.wait(lock, [&]() { return stop || !waiting_for_rows(); });
+        if (stop || !prepare(j))
+        {
+          return;
+        }
+        lock.unlock();
+        try
+        {
+          j.y = evaluate(j.x);
+        }
+        catch (...)
+        {
+          lock.lock();
+          if (j.row != npos)
+          {
+            _failed_rows.push_back(j.row);
+          }
+          else
+          {
+            --_dispatched;
+          }
+          stop = true;
+          completed_cv.notify_all();
+          throw;
+        }
+        lock.lock();
+        complete(j);
+        completed_cv.notify_all();
+      }
+    }
+
+    E _population; ///< current population
+    fitness_type _y; ///< fitness of the current population
+    OBJ _objective_f;
+    SEL _selection_f;
+    CROSS _cross_f;
+    MUT _mutation_f;
+    async_ga_options _options;
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    E _parents; ///< mating pair (2 x num_of_vars)
+    E _children; ///< children of the mating pair (2 x num_of_vars)
+    bool _has_spare{ false }; ///< second child not dispatched yet
+    std::vector<job> _jobs; ///< one individual per evaluating thread
+    std::vector<std::size_t> _indices; ///< scratch: selected indices
+    random_engine _gen = make_random_engine(); ///< random engine of the tournament replacement
+    std::size_t _next_row{ 0 }; ///< next row of the initial population to evaluate
+    std::vector<std::size_t> _failed_rows; ///< rows of the initial population to evaluate again
+    std::size_t _rows_done{ 0 }; ///< evaluated rows of the initial population
+    bool _evaluated{ false };
+    std::size_t _dispatched{ 0 }; ///< offspring dispatched so far
+    std::size_t _target{ 0 }; ///< offspring to dispatch in the current run
+    std::size_t _evaluations{ 0 };
+    std::size_t _replacements{ 0 };
+  };
+
+  template<class E, class OBJ, class SEL, class CROSS, class MUT>
+  constexpr std::size_t async_ga_state<E, OBJ, SEL, CROSS, MUT>::npos;
+
+  /**
+   * @brief helper to construct an async_ga_state with deduced functor types
+   *
+   * @tparam E xtensor type of the population
+   * @tparam OBJ functor for objective function
+   * @tparam SEL functor for selection
+   * @tparam CROSS functor for crossover
+   * @tparam MUT functor for mutation
+   * @param X initial population
+   * @param objective_f objective function
+   * @param selection_f functor for selection
+   * @param cross_f functor for crossover
+   * @param mutation_f functor for mutation
+   * @param options replacement and direction
+   * @param pool thread pool of the evaluations (nullptr evaluates on the calling thread)
+   * @return async_ga_state<E, OBJ, SEL, CROSS, MUT>
+   */
+  template<class E, class OBJ, class SEL, class CROSS, class MUT>
+  auto make_async_ga_state(const E& X, OBJ objective_f, SEL selection_f, CROSS cross_f, MUT mutation_f,
+    async_ga_options options = async_ga_options{}, std::shared_ptr<thread_pool> pool = nullptr)
+  {
+    return async_ga_state<E, OBJ, SEL, CROSS, MUT>(X, std::move(objective_f), std::move(selection_f),
+      std::move(cross_f), std::move(mutation_f), options, std::move(pool));
+  }
+
+}
+
+#endif
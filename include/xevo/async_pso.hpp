@@ -0,0 +1,535 @@
+/**
+ * @file async_pso.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief templated header file with the asynchronous particle swarm optimisation and
+ *  the versioned global best record.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __ASYNC_PSO_HPP__
+#define __ASYNC_PSO_HPP__
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#ifdef XEVO_ENABLE_THREADS
+#include <thread>
+#endif
+
+#include "xtensor/xtensor.hpp"
+
+#include "functors.hpp"
+#include "kernels.hpp"
+#include "rng.hpp"
+#include "thread_pool.hpp"
+
+
+namespace xevo
+{
+  namespace detail
+  {
+    /**
+     * @brief give the core away while another thread holds a sequence lock
+     */
+    inline void spin_pause()
+    {
+#ifdef XEVO_ENABLE_THREADS
+      std::this_thread::yield();
+#endif
+    }
+  }
+
+  /**
+   * @brief best position and evaluation shared between threads without locks
+   *
+   * A sequence lock: the version is odd while a writer copies a new record in and is
+   * increased by two per published record. Readers copy the record and retry when the
+   * version changed meanwhile, so they never block a writer; writers only exclude each
+   * other for the copy of an improvement, which is rare. Threads keep a copy of the
+   * record and call read() only when version() differs from the version of their copy.
+   *
+   * @tparam T value type
+   */
+  template <class T>
+  class best_record
+  {
+  public:
+
+    /**
+     * @brief Construct a new best_record object without a record (version 0)
+     *
+     * @param num_of_vars number of genes
+     * @param maximise true when larger evaluations are better
+     */
+    best_record(std::size_t num_of_vars, bool maximise = false) :
+      _x(num_of_vars), _maximise{ maximise }
+    {
+      for (auto& x : _x)
+      {
+        x.store(T(0), std::memory_order_relaxed);
+      }
+      _y.store(_maximise ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief publish a position when its evaluation is better than the record
+     *
+     * @param x genes
+     * @param y evaluation
+     * @return true when the record was replaced
+     */
+    bool offer(const T* x, T y)
+    {
+      if (!better(y, _y.load(std::memory_order_relaxed)))
+      {
+        return false;
+      }
+
+      std::uint64_t version = _version.load(std::memory_order_relaxed);
+      while (true)
+      {
+        if (version & 1u)
+        {
+          detail::spin_pause();
+          version = _version.load(std::memory_order_relaxed);
+        }
+        else if (_version.compare_exchange_weak(version, version + 1, std::memory_order_acq_rel,
+          std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      std::atomic_thread_fence(std::memory_order_release);
+
+      bool replaced = better(y, _y.load(std::memory_order_relaxed));
+      if (replaced)
+      {
+        for (std::size_t j{ 0 }; j < _x.size(); ++j)
+        {
+          _x[j].store(x[j], std::memory_order_relaxed);
+        }
+        _y.store(y, std::memory_order_relaxed);
+      }
+      _version.store(replaced ? version + 2 : version, std::memory_order_release);
+      return replaced;
+    }
+
+    /**
+     * @brief copy a consistent record
+     *
+     * @param x genes (output)
+     * @param y evaluation (output)
+     * @return std::uint64_t version of the copied record
+     */
+    std::uint64_t read(T* x, T& y) const
+    {
+      while (true)
+      {
+        std::uint64_t version = _version.load(std::memory_order_acquire);
+        if (version & 1u)
+        {
+          detail::spin_pause();
+          continue;
+        }
+        for (std::size_t j{ 0 }; j < _x.size(); ++j)
+        {
+          x[j] = _x[j].load(std::memory_order_relaxed);
+        }
+        y = _y.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_version.load(std::memory_order_relaxed) == version)
+        {
+          return version;
+        }
+      }
+    }
+
+    /**
+     * @brief version of the record (twice the number of records published)
+     *
+     * @return std::uint64_t
+     */
+    std::uint64_t version() const
+    {
+      return _version.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief evaluation of the record
+     *
+     * @return T
+     */
+    T fitness() const
+    {
+      return _y.load(std::memory_order_relaxed);
+    }
+
+  private:
+
+    bool better(T a, T b) const
+    {
+      return _maximise ? b < a : a < b;
+    }
+
+    std::vector<std::atomic<T>> _x; ///< genes of the record
+    std::atomic<T> _y; ///< evaluation of the record
+    bool _maximise;
+    std::atomic<std::uint64_t> _version{ 0 }; ///< odd while a record is written
+  };
+
+
+  /**
+   * @brief parameters of async_pso_state
+   */
+  struct async_pso_options
+  {
+    std::size_t block_size{ 1 }; ///< particles updated and evaluated together
+    bool maximise{ false }; ///< true when larger evaluations are better (pso minimises)
+  };
+
+  /**
+   * @brief asynchronous particle swarm optimisation
+   *
+   * The swarm is split in blocks of block_size particles. Every thread repeatedly
+   * claims a free block with an atomic flag, updates the velocities and positions of
+   * its particles (as xevo::Velocity and xevo::Position do) with the latest global best
+   * it has seen, evaluates them and updates their personal best slots. An improvement
+   * of the global best is published through a best_record, and threads copy the record
+   * only when its version changed. There is no generation barrier: a block is updated
+   * again as soon as its evaluation has finished and a thread is free, whatever the
+   * state of the other blocks.
+   *
+   * The objective function is called with the rows of one block and must be safe to
+   * call concurrently. At most one thread per block is used. The interleaving of the
+   * updates depends on the evaluation times, so runs with more than one thread are not
+   * reproducible. Without a pool (or with a single thread pool) the blocks are updated
+   * in turn on the calling thread.
+   *
+   * @tparam E xtensor type for positions and velocities (contiguous row-major container,
+   *  see has_row_major_data)
+   * @tparam OBJ functor for objective function
+   */
+  template <class E, class OBJ>
+  class async_pso_state
+  {
+    static_assert(has_row_major_data<E>::value, "async_pso_state requires contiguous row-major positions");
+
+  public:
+
+    using value_type = typename std::decay_t<E>::value_type;
+    using fitness_type = xt::xtensor<value_type, 1>;
+
+    /**
+     * @brief Construct a new async_pso_state object
+     *
+     * @param X initial positions of the swarm
+     * @param V initial velocities of the swarm
+     * @param objective_f objective function
+     * @param w inertia weight
+     * @param c1 cognitive coefficient
+     * @param c2 social coefficient
+     * @param options blocks and direction
+     * @param pool thread pool of the updates (nullptr updates on the calling thread)
+     */
+    async_pso_state(const E& X, const E& V, OBJ objective_f, double w, double c1, double c2,
+      async_pso_options options = async_pso_options{}, std::shared_ptr<thread_pool> pool = nullptr) :
+      _position(X), _position_best(X), _velocity(V), _objective_f{ std::move(objective_f) },
+      _w{ w }, _c1{ c1 }, _c2{ c2 }, _options{ options }, _pool{ std::move(pool) },
+      _shared{ new shared(X.shape()[1], options.maximise) }
+    {
+      std::size_t num_of_indiv = _position.shape()[0];
+      _options.block_size = std::max<std::size_t>(1, std::min(_options.block_size, num_of_indiv));
+      _num_of_blocks = (num_of_indiv + _options.block_size - 1) / _options.block_size;
+      _shared->blocks.reset(new block[_num_of_blocks]);
+      _num_threads = std::min(_pool ? _pool->size() : 1, _num_of_blocks);
+
+      std::array<std::size_t, 1> shape_y = { num_of_indiv };
+      _y_best = xt::zeros<value_type>(shape_y);
+    }
+
+    /**
+     * @brief update and evaluate particles
+     *
+     * The first update of every particle evaluates its initial position. Returns when
+     * at least the given number of particle evaluations have been made (whole blocks
+     * are evaluated); the first exception thrown by the objective function is rethrown
+     * once the threads have stopped.
+     *
+     * @param evaluations number of particle evaluations
+     */
+    void run(std::size_t evaluations)
+    {
+      _target = evaluations;
+      _shared->dispatched.store(0, std::memory_order_relaxed);
+      _shared->stop.store(false, std::memory_order_relaxed);
+      for (std::size_t b{ 0 }; b < _num_of_blocks; ++b)
+      {
+        _shared->blocks[b].busy.store(false, std::memory_order_relaxed);
+      }
+
+      std::uint64_t call = _call++;
+      auto task = [this, call](std::size_t t)
+      {
+        try
+        {
+          work(call, t);
+        }
+        catch (...)
+        {
+          _shared->stop.store(true, std::memory_order_relaxed);
+          throw;
+        }
+      };
+
+      if (_num_threads < 2)
+      {
+        task(0);
+        return;
+      }
+      _pool->parallel_for(_num_threads, task);
+    }
+
+    const E& position() const
+    {
+      return _position;
+    }
+
+    const E& position_best() const
+    {
+      return _position_best;
+    }
+
+    /**
+     * @brief personal best evaluations (valid for the particles evaluated at least once)
+     *
+     * @return const fitness_type&
+     */
+    const fitness_type& fitness_best() const
+    {
+      return _y_best;
+    }
+
+    const E& velocity() const
+    {
+      return _velocity;
+    }
+
+    /**
+     * @brief global best position and its evaluation
+     *
+     * @param x genes (output, resized)
+     * @return value_type evaluation of the global best
+     */
+    value_type best(std::vector<value_type>& x) const
+    {
+      x.resize(_position.shape()[1]);
+      value_type y;
+      _shared->best.read(x.data(), y);
+      return y;
+    }
+
+    /**
+     * @brief record of the global best shared by the threads
+     *
+     * @return const best_record<value_type>&
+     */
+    const best_record<value_type>& global_best() const
+    {
+      return _shared->best;
+    }
+
+    /**
+     * @brief number of particle evaluations so far
+     *
+     * @return std::size_t
+     */
+    std::size_t evaluations() const
+    {
+      return _shared->evaluations.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief number of threads updating the swarm
+     *
+     * @return std::size_t
+     */
+    std::size_t threads() const
+    {
+      return _num_threads;
+    }
+
+    /**
+     * @brief thread pool of the updates (nullptr when they run on the calling thread)
+     *
+     * @return std::shared_ptr<thread_pool>
+     */
+    std::shared_ptr<thread_pool> pool() const
+    {
+      return _pool;
+    }
+
+  private:
+
+    struct block
+    {
+      std::atomic<bool> busy{ false }; ///< claimed by a thread
+      bool evaluated{ false }; ///< initial positions evaluated
+    };
+
+    /**
+     * @brief state shared by the threads (kept apart so that the solver can be moved)
+     */
+    struct shared
+    {
+      shared(std::size_t num_of_vars, bool maximise) : best(num_of_vars, maximise)
+      {
+
+      }
+
+      best_record<value_type> best; ///< global best
+      std::unique_ptr<block[]> blocks;
+      std::atomic<std::size_t> ticket{ 0 }; ///< next block to try
+      std::atomic<std::size_t> dispatched{ 0 }; ///< evaluations claimed in the current run
+      std::atomic<std::size_t> evaluations{ 0 };
+      std::atomic<bool> stop{ false };
+    };
+
+    void work(std::uint64_t call, std::size_t t)
+    {
+      shared& s = *_shared;
+      std::size_t num_of_indiv = _position.shape()[0];
+      std::size_t num_of_vars = _position.shape()[1];
+      random_engine gen = _rng.stream(call, t);
+      std::vector<value_type> global_x(num_of_vars);
+      value_type global_y{ 0 };
+      std::uint64_t seen = std::numeric_limits<std::uint64_t>::max();
+      std::vector<double> r;
+      E X_block;
+
+      while (!s.stop.load(std::memory_order_relaxed))
+      {
+        std::size_t b = s.ticket.fetch_add(1, std::memory_order_relaxed) % _num_of_blocks;
+        bool expected{ false };
+        if (!s.blocks[b].busy.compare_exchange_strong(expected, true, std::memory_order_acquire,
+          std::memory_order_relaxed))
+        {
+          // every block may be claimed when the threads outnumber the free blocks
+          detail::spin_pause();
+          continue;
+        }
+
+        std::size_t first = b * _options.block_size;
+        std::size_t last = std::min(first + _options.block_size, num_of_indiv);
+        std::size_t n = last - first;
+        if (s.dispatched.fetch_add(n, std::memory_order_relaxed) >= _target)
+        {
+          s.blocks[b].busy.store(false, std::memory_order_release);
+          break;
+        }
+
+        if (s.blocks[b].evaluated)
+        {
+          std::uint64_t version = s.best.version();
+          if (version != seen)
+          {
+            seen = s.best.read(global_x.data(), global_y);
+          }
+          r.resize(2 * n);
+          fill_uniform(gen, r.data(), r.size());
+          for (std::size_t i{ first }; i < last; ++i)
+          {
+            value_type* v = kernels::row(_velocity, i);
+            value_type* x = kernels::row(_position, i);
+            kernels::velocity_update(v, x, kernels::row(_position_best, i), global_x.data(), num_of_vars,
+              value_type(1), value_type(_w), value_type(_c1 * r[i - first]), value_type(_c2 * r[n + i - first]));
+            for (std::size_t j{ 0 }; j < num_of_vars; ++j)
+            {
+              x[j] += v[j];
+            }
+          }
+        }
+
+        if (X_block.shape().size() != 2 || X_block.shape()[0] != n)
+        {
+          std::array<std::size_t, 2> shape_block = { n, num_of_vars };
+          X_block = xt::zeros<value_type>(shape_block);
+        }
+        for (std::size_t i{ first }; i < last; ++i)
+        {
+          detail::copy_row(_position, i, X_block, i - first);
+        }
+        auto&& y = _objective_f(X_block);
+
+        // personal best slots, then a single offer of the best of the block
+        std::size_t block_best = first;
+        for (std::size_t i{ first }; i < last; ++i)
+        {
+          value_type y_i = value_type(y(i - first));
+          if (!s.blocks[b].evaluated || better(y_i, _y_best(i)))
+          {
+            _y_best(i) = y_i;
+            std::copy(kernels::row(_position, i), kernels::row(_position, i) + num_of_vars,
+              kernels::row(_position_best, i));
+          }
+          block_best = better(_y_best(i), _y_best(block_best)) ? i : block_best;
+        }
+        s.blocks[b].evaluated = true;
+        s.best.offer(kernels::row(_position_best, block_best), _y_best(block_best));
+        s.evaluations.fetch_add(n, std::memory_order_relaxed);
+
+        s.blocks[b].busy.store(false, std::memory_order_release);
+      }
+    }
+
+    bool better(value_type a, value_type b) const
+    {
+      return _options.maximise ? b < a : a < b;
+    }
+
+    E _position;
+    E _position_best; ///< personal best slots
+    fitness_type _y_best; ///< personal best evaluations
+    E _velocity;
+    OBJ _objective_f;
+    double _w;
+    double _c1;
+    double _c2;
+    async_pso_options _options;
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    std::unique_ptr<shared> _shared;
+    std::size_t _num_of_blocks;
+    std::size_t _num_threads; ///< tasks updating the swarm
+    rng _rng; ///< random number service of the swarm
+    std::uint64_t _call{ 0 }; ///< number of runs (random stream)
+    std::size_t _target{ 0 }; ///< evaluations of the current run
+  };
+
+  /**
+   * @brief helper to construct an async_pso_state with a deduced objective type
+   *
+   * @return async_pso_state<E, OBJ>
+   */
+  template <class E, class OBJ>
+  auto make_async_pso_state(const E& X, const E& V, OBJ objective_f, double w, double c1, double c2,
+    async_pso_options options = async_pso_options{}, std::shared_ptr<thread_pool> pool = nullptr)
+  {
+    return async_pso_state<E, OBJ>(X, V, std::move(objective_f), w, c1, c2, options, std::move(pool));
+  }
+
+}
+
+#endif
@@ -0,0 +1,668 @@
+/**
+ * @file cmaes.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief header file with the covariance matrix adaptation evolution strategy (CMA-ES).
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __CMAES_HPP__
+#define __CMAES_HPP__
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+
+#include "functors.hpp"
+#include "kernels.hpp"
+#include "rng.hpp"
+#include "selection.hpp"
+#include "thread_pool.hpp"
+
+
+namespace xevo
+{
+
+  namespace detail
+  {
+    /**
+     * @brief eigendecomposition of a symmetric matrix (cyclic Jacobi rotations)
+     *
+     * @param n order of the matrix
+     * @param A row-major symmetric matrix (destroyed)
+     * @param values output with the n eigenvalues
+     * @param vectors output with the eigenvectors in the columns (row-major)
+     */
+    inline void symmetric_eigen(std::size_t n, std::vector<double>& A, std::vector<double>& values,
+      std::vector<double>& vectors)
+    {
+      vectors.assign(n * n, 0.0);
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        vectors[i * n + i] = 1.0;
+      }
+
+      for (int sweep{ 0 }; sweep < 64; ++sweep)
+      {
+        double off{ 0.0 };
+        double diagonal{ 0.0 };
+        for (std::size_t p{ 0 }; p < n; ++p)
+        {
+          diagonal += A[p * n + p] * A[p * n + p];
+          for (std::size_t q = p + 1; q < n; ++q)
+          {
+            off += A[p * n + q] * A[p * n + q];
+          }
+        }
+        if (off <= 1e-30 * diagonal)
+        {
+          break;
+        }
+
+        for (std::size_t p{ 0 }; p < n; ++p)
+        {
+          for (std::size_t q = p + 1; q < n; ++q)
+          {
+            double apq = A[p * n + q];
+            if (apq == 0.0)
+            {
+              continue;
+            }
+            double theta = (A[q * n + q] - A[p * n + p]) / (2.0 * apq);
+            double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+            double c = 1.0 / std::sqrt(t * t + 1.0);
+            double s = t * c;
+
+            for (std::size_t k{ 0 }; k < n; ++k)
+            {
+              double akp = A[k * n + p];
+              double akq = A[k * n + q];
+              A[k * n + p] = c * akp - s * akq;
+              A[k * n + q] = s * akp + c * akq;
+            }
+            for (std::size_t k{ 0 }; k < n; ++k)
+            {
+              double apk = A[p * n + k];
+              double aqk = A[q * n + k];
+              A[p * n + k] = c * apk - s * aqk;
+              A[q * n + k] = s * apk + c * aqk;
+            }
+            for (std::size_t k{ 0 }; k < n; ++k)
+            {
+              double vkp = vectors[k * n + p];
+              double vkq = vectors[k * n + q];
+              vectors[k * n + p] = c * vkp - s * vkq;
+              vectors[k * n + q] = s * vkp + c * vkq;
+            }
+          }
+        }
+      }
+
+      values.resize(n);
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        values[i] = A[i * n + i];
+      }
+    }
+  }
+
+  /**
+   * @brief parameters of cmaes
+   */
+  struct cmaes_options
+  {
+    double sigma{ 0.3 }; ///< initial step size
+    std::size_t mu{ 0 }; ///< number of parents (0: half of the population)
+    bool separable{ false }; ///< diagonal covariance matrix (sep-CMA-ES) for thousands of genes
+    bool maximise{ false }; ///< true when larger fitness is better
+    std::size_t eigen_interval{ 0 }; ///< generations between eigendecompositions (0: automatic, O(D))
+  };
+
+  /**
+   * @brief class for the covariance matrix adaptation evolution strategy (CMA-ES)
+   *
+   * The population X (lambda x D) is sampled from the multivariate normal distribution
+   * N(m, sigma^2 C) and evaluated by the objective function in a single batched call, as
+   * for ga and pso. The mean moves to the weighted recombination of the mu best samples,
+   * the step size follows cumulative step-size adaptation and the covariance matrix gets
+   * the rank-one (evolution path) and rank-mu updates. The eigendecomposition C = B D^2 B^T
+   * used for sampling is refreshed lazily, every lambda / (10 D (c_1 + c_mu)) = O(D)
+   * generations, so a generation costs O(lambda D^2) instead of O(D^3).
+   *
+   * The separable variant (cmaes_options::separable) adapts a diagonal covariance matrix
+   * with learning rates scaled by (D + 2) / 3; a generation costs O(lambda D) and memory
+   * is O(D), which suits problems with thousands of genes.
+   *
+   * N. Hansen and A. Ostermeier, Completely derandomized self-adaptation in evolution
+   * strategies, Evolutionary Computation, vol. 9, no. 2, pp. 159-195, 2001.
+   *
+   * R. Ros and N. Hansen, A simple modification in CMA-ES achieving linear time and space
+   * complexity, Parallel Problem Solving from Nature (PPSN X), pp. 296-305, 2008.
+   */
+  class cmaes
+  {
+  public:
+
+    /**
+     * @brief Construct a new cmaes object
+     *
+     * @param options parameters of the strategy
+     * @param pool thread pool for sampling and for the covariance update (nullptr for serial)
+     */
+    explicit cmaes(cmaes_options options = cmaes_options{}, std::shared_ptr<thread_pool> pool = nullptr) :
+      _options{ options }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    /**
+     * @brief method to initialise the strategy with its mean at the centre of the unit box
+     *  and to sample the first population
+     *
+     * @tparam E xtensor type of the population
+     * @param X population (lambda x D), overwritten with the first samples
+     */
+    template<class E>
+    void initialise(xt::xexpression<E>& X)
+    {
+      std::vector<double> mean(X.derived_cast().shape()[1], 0.5);
+      initialise(X, mean);
+    }
+
+    /**
+     * @brief method to initialise the strategy with a given mean and to sample the first population
+     *
+     * @tparam E xtensor type of the population
+     * @param X population (lambda x D), overwritten with the first samples
+     * @param mean initial mean (D genes)
+     */
+    template<class E>
+    void initialise(xt::xexpression<E>& X, const std::vector<double>& mean)
+    {
+      E& _X = X.derived_cast();
+      std::size_t lambda = _X.shape()[0];
+      std::size_t num_of_vars = _X.shape()[1];
+      if (lambda < 2 || num_of_vars == 0 || mean.size() != num_of_vars)
+      {
+        throw std::runtime_error("cmaes needs at least two individuals and a mean with one value per gene");
+      }
+
+      _lambda = lambda;
+      _num_of_vars = num_of_vars;
+      set_parameters();
+
+      _mean = mean;
+      _sigma = _options.sigma;
+      _path_sigma.assign(num_of_vars, 0.0);
+      _path_c.assign(num_of_vars, 0.0);
+      _scale.assign(num_of_vars, 1.0);
+      if (_options.separable)
+      {
+        _covariance.assign(num_of_vars, 1.0);
+        _basis.clear();
+      }
+      else
+      {
+        _covariance.assign(num_of_vars * num_of_vars, 0.0);
+        _basis.assign(num_of_vars * num_of_vars, 0.0);
+        for (std::size_t i{ 0 }; i < num_of_vars; ++i)
+        {
+          _covariance[i * num_of_vars + i] = 1.0;
+          _basis[i * num_of_vars + i] = 1.0;
+        }
+      }
+      _generation = 0;
+      _eigen_generation = 0;
+      _eigendecompositions = 0;
+      _has_best = false;
+      _best.assign(num_of_vars, 0.0);
+
+      sample(_X);
+    }
+
+    /**
+     * @brief method to evolve the population by one generation
+     *
+     * Evaluates X, updates the distribution and overwrites X with the next samples.
+     *
+     * @tparam E xtensor type of the population
+     * @tparam OBJ functor for objective function
+     * @param X population (lambda x D)
+     * @param objective_f objective function
+     */
+    template<class E, class OBJ>
+    void evolve(xt::xexpression<E>& X, OBJ objective_f)
+    {
+      E& _X = X.derived_cast();
+      auto y = objective_f(_X);
+      update(_X, y);
+      sample(_X);
+    }
+
+    /**
+     * @brief method to evolve the population by one generation
+     *
+     * @tparam E xtensor type of the population
+     * @tparam OBJ functor for objective function
+     * @tparam TERM functor for termination
+     * @tparam TermArgs types of arguments for terminating functor
+     * @param X population (lambda x D)
+     * @param objective_f objective function
+     * @param termargs arguments for terminating functor
+     *
+     * @return auto type from terminating functor, evaluated with the new samples
+     */
+    template<class E, class OBJ, class TERM = Terminate_gen_max, typename... TermArgs>
+    auto evolve(xt::xexpression<E>& X, OBJ objective_f, std::tuple<TermArgs...> termargs)
+    {
+      return evolve<E, OBJ, TERM>(X, objective_f, std::move(termargs), std::index_sequence_for<TermArgs...>{});
+    }
+
+    /**
+     * @brief overwrite X with lambda samples of N(m, sigma^2 C)
+     *
+     * Row k is drawn from the stream (generation, k), so the samples do not depend on
+     * the number of threads.
+     *
+     * @tparam E xtensor type of the population (contiguous row-major container, see
+     *  has_row_major_data)
+     * @param X population (lambda x D)
+     */
+    template<class E, typename T = typename std::decay_t<E>::value_type>
+    void sample(xt::xexpression<E>& X)
+    {
+      static_assert(has_row_major_data<E>::value, "cmaes requires a contiguous row-major population");
+      E& _X = X.derived_cast();
+      check_shape(_X.shape()[0], _X.shape()[1]);
+      std::size_t n = _num_of_vars;
+
+      parallel_for_chunks(_pool.get(), _lambda, [&](std::size_t first, std::size_t last)
+      {
+        std::vector<double> z(n);
+        for (std::size_t k = first; k < last; ++k)
+        {
+          random_engine gen = _rng.stream(_generation, k);
+          fill_normal(gen, z.data(), n);
+          for (std::size_t j{ 0 }; j < n; ++j)
+          {
+            z[j] *= _scale[j];
+          }
+
+          T* x = kernels::row(_X, k);
+          if (_options.separable)
+          {
+            for (std::size_t i{ 0 }; i < n; ++i)
+            {
+              x[i] = static_cast<T>(_mean[i] + _sigma * z[i]);
+            }
+          }
+          else
+          {
+            for (std::size_t i{ 0 }; i < n; ++i)
+            {
+              const double* b = _basis.data() + i * n;
+              double yi{ 0.0 };
+              for (std::size_t j{ 0 }; j < n; ++j)
+              {
+                yi += b[j] * z[j];
+              }
+              x[i] = static_cast<T>(_mean[i] + _sigma * yi);
+            }
+          }
+        }
+      });
+    }
+
+    /**
+     * @brief update the distribution from the evaluated population
+     *
+     * The rows of X need not be the last samples (they may have been repaired or
+     * injected); the update uses the steps (x - m) / sigma of the mu best rows.
+     *
+     * @tparam E xtensor type of the population (contiguous row-major container, see
+     *  has_row_major_data)
+     * @tparam F xtensor type of the evaluations
+     * @param X population (lambda x D)
+     * @param Y evaluations of the population
+     */
+    template<class E, class F>
+    void update(const xt::xexpression<E>& X, const xt::xexpression<F>& Y)
+    {
+      static_assert(has_row_major_data<E>::value, "cmaes requires a contiguous row-major population");
+      const E& _X = X.derived_cast();
+      const F& _Y = Y.derived_cast();
+      check_shape(_X.shape()[0], _X.shape()[1]);
+      std::size_t n = _num_of_vars;
+
+      top_k_indices(_Y, _mu, _options.maximise, _indices);
+      if (!_has_best || better(double(_Y(_indices[0])), _best_fitness))
+      {
+        const auto* x = kernels::row(_X, _indices[0]);
+        std::copy(x, x + n, _best.begin());
+        _best_fitness = double(_Y(_indices[0]));
+        _has_best = true;
+      }
+
+      // steps of the parents and of the mean
+      _steps.resize(_mu * n);
+      std::vector<double> step_mean(n, 0.0);
+      for (std::size_t k{ 0 }; k < _mu; ++k)
+      {
+        const auto* x = kernels::row(_X, _indices[k]);
+        double* s = _steps.data() + k * n;
+        for (std::size_t i{ 0 }; i < n; ++i)
+        {
+          s[i] = (double(x[i]) - _mean[i]) / _sigma;
+          step_mean[i] += _weights[k] * s[i];
+        }
+      }
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        _mean[i] += _sigma * step_mean[i];
+      }
+
+      // C^(-1/2) times the step of the mean
+      std::vector<double> whitened(n);
+      if (_options.separable)
+      {
+        for (std::size_t i{ 0 }; i < n; ++i)
+        {
+          whitened[i] = step_mean[i] / _scale[i];
+        }
+      }
+      else
+      {
+        std::vector<double> t(n, 0.0);
+        for (std::size_t i{ 0 }; i < n; ++i)
+        {
+          const double* b = _basis.data() + i * n;
+          for (std::size_t j{ 0 }; j < n; ++j)
+          {
+            t[j] += b[j] * step_mean[i];
+          }
+        }
+        for (std::size_t j{ 0 }; j < n; ++j)
+        {
+          t[j] /= _scale[j];
+        }
+        for (std::size_t i{ 0 }; i < n; ++i)
+        {
+          const double* b = _basis.data() + i * n;
+          double w{ 0.0 };
+          for (std::size_t j{ 0 }; j < n; ++j)
+          {
+            w += b[j] * t[j];
+          }
+          whitened[i] = w;
+        }
+      }
+
+      // evolution paths
+      double norm_sigma{ 0.0 };
+      double a_sigma = std::sqrt(_c_sigma * (2.0 - _c_sigma) * _mu_eff);
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        _path_sigma[i] = (1.0 - _c_sigma) * _path_sigma[i] + a_sigma * whitened[i];
+        norm_sigma += _path_sigma[i] * _path_sigma[i];
+      }
+      norm_sigma = std::sqrt(norm_sigma);
+
+      double correction = std::sqrt(1.0 - std::pow(1.0 - _c_sigma, 2.0 * double(_generation + 1)));
+      bool h_sigma = norm_sigma / correction / _chi_n < 1.4 + 2.0 / (double(n) + 1.0);
+      double a_c = h_sigma ? std::sqrt(_c_c * (2.0 - _c_c) * _mu_eff) : 0.0;
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        _path_c[i] = (1.0 - _c_c) * _path_c[i] + a_c * step_mean[i];
+      }
+
+      // rank-one and rank-mu updates of the covariance matrix
+      double delta = h_sigma ? 0.0 : _c_c * (2.0 - _c_c);
+      double keep = 1.0 - _c_1 - _c_mu + _c_1 * delta;
+      if (_options.separable)
+      {
+        for (std::size_t i{ 0 }; i < n; ++i)
+        {
+          double rank_mu{ 0.0 };
+          for (std::size_t k{ 0 }; k < _mu; ++k)
+          {
+            double s = _steps[k * n + i];
+            rank_mu += _weights[k] * s * s;
+          }
+          _covariance[i] = keep * _covariance[i] + _c_1 * _path_c[i] * _path_c[i] + _c_mu * rank_mu;
+          _scale[i] = std::sqrt(std::max(_covariance[i], 1e-300));
+        }
+      }
+      else
+      {
+        parallel_for_chunks(_pool.get(), n, [&](std::size_t first, std::size_t last)
+        {
+          for (std::size_t i = first; i < last; ++i)
+          {
+            double* c = _covariance.data() + i * n;
+            for (std::size_t j = i; j < n; ++j)
+            {
+              c[j] = keep * c[j] + _c_1 * _path_c[i] * _path_c[j];
+            }
+            for (std::size_t k{ 0 }; k < _mu; ++k)
+            {
+              const double* s = _steps.data() + k * n;
+              double ws = _c_mu * _weights[k] * s[i];
+              for (std::size_t j = i; j < n; ++j)
+              {
+                c[j] += ws * s[j];
+              }
+            }
+          }
+        });
+      }
+
+      // cumulative step-size adaptation
+      _sigma *= std::exp(std::min(1.0, (_c_sigma / _d_sigma) * (norm_sigma / _chi_n - 1.0)));
+      ++_generation;
+
+      if (!_options.separable && _generation - _eigen_generation >= _eigen_interval)
+      {
+        decompose();
+      }
+    }
+
+    /**
+     * @brief mean of the distribution
+     *
+     * @return const std::vector<double>&
+     */
+    const std::vector<double>& mean() const
+    {
+      return _mean;
+    }
+
+    /**
+     * @brief step size
+     *
+     * @return double
+     */
+    double sigma() const
+    {
+      return _sigma;
+    }
+
+    /**
+     * @brief number of generations evolved so far
+     *
+     * @return std::size_t
+     */
+    std::size_t generation() const
+    {
+      return _generation;
+    }
+
+    /**
+     * @brief best individual evaluated so far
+     *
+     * @return const std::vector<double>&
+     */
+    const std::vector<double>& best() const
+    {
+      return _best;
+    }
+
+    /**
+     * @brief fitness of the best individual evaluated so far
+     *
+     * @return double
+     */
+    double best_fitness() const
+    {
+      return _best_fitness;
+    }
+
+    /**
+     * @brief number of eigendecompositions of the covariance matrix so far
+     *
+     * @return std::size_t
+     */
+    std::size_t eigendecompositions() const
+    {
+      return _eigendecompositions;
+    }
+
+  private:
+
+    template<class E, class OBJ, class TERM, typename... TermArgs, std::size_t... TIs>
+    auto evolve(xt::xexpression<E>& X, OBJ objective_f, std::tuple<TermArgs...>&& termargs,
+      std::index_sequence<TIs...>)
+    {
+      TERM terminate_f(std::get<TIs>(std::move(termargs))...);
+
+      E& _X = X.derived_cast();
+      evolve(_X, objective_f);
+
+      return terminate_f(_X, objective_f(_X));
+    }
+
+    /**
+     * @brief default strategy parameters for lambda and D
+     */
+    void set_parameters()
+    {
+      double n = double(_num_of_vars);
+      _mu = _options.mu > 0 ? std::min(_options.mu, _lambda) : _lambda / 2;
+
+      _weights.resize(_mu);
+      double sum{ 0.0 };
+      for (std::size_t k{ 0 }; k < _mu; ++k)
+      {
+        _weights[k] = std::log(double(_mu) + 0.5) - std::log(double(k + 1));
+        sum += _weights[k];
+      }
+      double sum_of_squares{ 0.0 };
+      for (auto& w : _weights)
+      {
+        w /= sum;
+        sum_of_squares += w * w;
+      }
+      _mu_eff = 1.0 / sum_of_squares;
+
+      _c_sigma = (_mu_eff + 2.0) / (n + _mu_eff + 5.0);
+      _d_sigma = 1.0 + 2.0 * std::max(0.0, std::sqrt((_mu_eff - 1.0) / (n + 1.0)) - 1.0) + _c_sigma;
+      _c_c = (4.0 + _mu_eff / n) / (n + 4.0 + 2.0 * _mu_eff / n);
+      _c_1 = 2.0 / ((n + 1.3) * (n + 1.3) + _mu_eff);
+      _c_mu = std::min(1.0 - _c_1, 2.0 * (_mu_eff - 2.0 + 1.0 / _mu_eff) / ((n + 2.0) * (n + 2.0) + _mu_eff));
+      if (_options.separable)
+      {
+        _c_1 = std::min(1.0, _c_1 * (n + 2.0) / 3.0);
+        _c_mu = std::min(1.0 - _c_1, _c_mu * (n + 2.0) / 3.0);
+      }
+      _chi_n = std::sqrt(n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+      _eigen_interval = _options.eigen_interval > 0 ? _options.eigen_interval :
+        std::max<std::size_t>(1, static_cast<std::size_t>(double(_lambda) / (10.0 * n * (_c_1 + _c_mu))));
+    }
+
+    /**
+     * @brief refresh B and D from the upper triangle of C
+     */
+    void decompose()
+    {
+      std::size_t n = _num_of_vars;
+      std::vector<double> A(_covariance);
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        for (std::size_t j = i + 1; j < n; ++j)
+        {
+          A[j * n + i] = A[i * n + j];
+        }
+      }
+      std::vector<double> values;
+      detail::symmetric_eigen(n, A, values, _basis);
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        _scale[i] = std::sqrt(std::max(values[i], 1e-300));
+      }
+      _eigen_generation = _generation;
+      ++_eigendecompositions;
+    }
+
+    void check_shape(std::size_t lambda, std::size_t num_of_vars) const
+    {
+      if (lambda != _lambda || num_of_vars != _num_of_vars)
+      {
+        throw std::runtime_error("The population does not match the initialised cmaes");
+      }
+    }
+
+    bool better(double a, double b) const
+    {
+      return _options.maximise ? a > b : a < b;
+    }
+
+    cmaes_options _options; ///< parameters
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    rng _rng; ///< random number service of the strategy
+
+    std::size_t _lambda{ 0 }; ///< number of samples
+    std::size_t _num_of_vars{ 0 }; ///< number of genes
+    std::size_t _mu{ 0 }; ///< number of parents
+    std::vector<double> _weights; ///< recombination weights
+    double _mu_eff{ 0.0 }; ///< variance effective selection mass
+    double _c_sigma{ 0.0 }; ///< learning rate of the step-size path
+    double _d_sigma{ 0.0 }; ///< damping of the step size
+    double _c_c{ 0.0 }; ///< learning rate of the covariance path
+    double _c_1{ 0.0 }; ///< learning rate of the rank-one update
+    double _c_mu{ 0.0 }; ///< learning rate of the rank-mu update
+    double _chi_n{ 0.0 }; ///< expected norm of a standard normal vector
+    std::size_t _eigen_interval{ 1 }; ///< generations between eigendecompositions
+
+    std::vector<double> _mean; ///< mean m
+    double _sigma{ 0.0 }; ///< step size
+    std::vector<double> _path_sigma; ///< evolution path of the step size
+    std::vector<double> _path_c; ///< evolution path of the covariance matrix
+    std::vector<double> _covariance; ///< C (upper triangle, row-major) or its diagonal
+    std::vector<double> _basis; ///< eigenvectors B of C (columns, row-major)
+    std::vector<double> _scale; ///< square roots D of the eigenvalues of C
+    std::vector<double> _steps; ///< steps of the parents (scratch)
+    std::vector<std::size_t> _indices; ///< parents (scratch)
+
+    std::size_t _generation{ 0 }; ///< generation number
+    std::size_t _eigen_generation{ 0 }; ///< generation of the last eigendecomposition
+    std::size_t _eigendecompositions{ 0 }; ///< number of eigendecompositions
+    bool _has_best{ false };
+    double _best_fitness{ 0.0 }; ///< fitness of the best individual
+    std::vector<double> _best; ///< best individual
+  };
+
+}
+
+#endif
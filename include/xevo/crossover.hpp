@@ -0,0 +1,529 @@
+/**
+ * @file crossover.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief templated header file with crossover functors working on whole parent rows.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __CROSSOVER_HPP__
+#define __CROSSOVER_HPP__
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include "functors.hpp"
+#include "kernels.hpp"
+#include "rng.hpp"
+#include "thread_pool.hpp"
+
+
+namespace xevo
+{
+
+  namespace detail
+  {
+    /**
+     * @brief mutation step of the crossover pass when no mutation is fused
+     */
+    struct no_mutation
+    {
+      template <class T>
+      void operator()(T*, std::size_t, random_engine&) const
+      {
+      }
+    };
+
+    /**
+     * @brief apply a crossover kernel to the pairs (0, 1), (2, 3), ... of the mating pool
+     *
+     * Every pair is crossed with probability rate, otherwise its rows are copied
+     * (an odd last row is always copied). The random numbers of pair i come from
+     * the stream (call, i) of r, so the children do not depend on the number of
+     * threads. With a pool the pairs are split in chunks that run in parallel.
+     *
+     * The rows are processed in blocks of 256 genes: make_kernel(gen, n) is called once
+     * per crossed pair and returns a callable (p1, p2, c1, c2, m, j) crossing the m genes
+     * starting at gene j (the pointers are already offset by j). mutate(c, m, gen) is
+     * applied to every block of the children right after it is written, while it is
+     * still in cache.
+     *
+     * Populations that are not contiguous row-major containers (see has_row_major_data)
+     * are crossed on a row-major copy, which is then copied to X_out.
+     *
+     * @param X parents
+     * @param X_out children (may be X itself)
+     * @param rate crossover rate
+     * @param r random number service of the functor
+     * @param call call number of the functor
+     * @param pool thread pool (nullptr for serial execution)
+     * @param make_kernel factory of the block kernel of a pair
+     * @param mutate mutation of a block of genes (no_mutation for crossover only)
+     */
+    template <class E, class O, class KERNEL, class MUTATE>
+    inline void crossover_pairs(const E& X, O& X_out, double rate, const rng& r, std::uint64_t call,
+      thread_pool* pool, KERNEL&& make_kernel, MUTATE&& mutate)
+    {
+      using row_major = std::integral_constant<bool, has_row_major_data<const E>::value && has_row_major_data<O>::value>;
+      crossover_pairs(X, X_out, rate, r, call, pool, make_kernel, mutate, row_major{});
+    }
+
+    template <class E, class O, class KERNEL, class MUTATE>
+    inline void crossover_pairs(const E& X, O& X_out, double rate, const rng& r, std::uint64_t call,
+      thread_pool* pool, KERNEL&& make_kernel, MUTATE&& mutate, std::false_type)
+    {
+      auto X_rows = row_major_copy(X);
+      crossover_pairs(X_rows, X_rows, rate, r, call, pool, make_kernel, mutate, std::true_type{});
+      copy_rows(X_rows, X_out);
+    }
+
+    template <class E, class O, class KERNEL, class MUTATE>
+    inline void crossover_pairs(const E& X, O& X_out, double rate, const rng& r, std::uint64_t call,
+      thread_pool* pool, KERNEL&& make_kernel, MUTATE&& mutate, std::true_type)
+    {
+      constexpr std::size_t block_size = 256;
+      std::size_t num_of_indiv = X.shape()[0];
+      std::size_t num_of_vars = X.shape()[1];
+      std::size_t num_of_pairs = num_of_indiv / 2;
+      bool in_place = same_object(X, X_out);
+
+      auto cross = [&](std::size_t first_pair, std::size_t last_pair)
+      {
+        for (std::size_t i = first_pair; i < last_pair; ++i)
+        {
+          random_engine gen = r.stream(call, i);
+          const auto* p1 = kernels::row(X, 2 * i);
+          const auto* p2 = kernels::row(X, 2 * i + 1);
+          auto* c1 = kernels::row(X_out, 2 * i);
+          auto* c2 = kernels::row(X_out, 2 * i + 1);
+          if (uniform01(gen) < rate)
+          {
+            auto kernel = make_kernel(gen, num_of_vars);
+            for (std::size_t j{ 0 }; j < num_of_vars; j += block_size)
+            {
+              std::size_t m = std::min(block_size, num_of_vars - j);
+              kernel(p1 + j, p2 + j, c1 + j, c2 + j, m, j);
+              mutate(c1 + j, m, gen);
+              mutate(c2 + j, m, gen);
+            }
+          }
+          else
+          {
+            for (std::size_t j{ 0 }; j < num_of_vars; j += block_size)
+            {
+              std::size_t m = std::min(block_size, num_of_vars - j);
+              if (!in_place)
+              {
+                std::copy(p1 + j, p1 + j + m, c1 + j);
+                std::copy(p2 + j, p2 + j + m, c2 + j);
+              }
+              mutate(c1 + j, m, gen);
+              mutate(c2 + j, m, gen);
+            }
+          }
+        }
+      };
+
+      parallel_for_chunks(pool, num_of_pairs, cross);
+
+      if (num_of_indiv % 2 == 1)
+      {
+        std::size_t last = num_of_indiv - 1;
+        if (!in_place)
+        {
+          copy_row(X, last, X_out, last);
+        }
+        random_engine gen = r.stream(call, num_of_pairs);
+        mutate(kernels::row(X_out, last), num_of_vars, gen);
+      }
+    }
+
+    /**
+     * @brief fused mutation step calling mutation_f.mutate (see has_gene_mutation)
+     */
+    template <class MUT>
+    inline auto fused_mutation(MUT& mutation_f)
+    {
+      return [&mutation_f](auto* genes, std::size_t n, random_engine& gen)
+      {
+        mutation_f.mutate(genes, n, gen);
+      };
+    }
+  }
+
+  /**
+   * @brief Functor for simulated binary crossover (SBX)
+   *
+   * Consecutive rows of the mating pool are paired and crossed with probability
+   * crossoverrate using kernels::sbx_crossover over the whole rows.
+   *
+   * The functor writes into a preallocated child buffer (operator()(X, X_out)), so
+   * it can be used as CROSS in ga::evolve and ga_state. With a thread pool the pairs
+   * are crossed in parallel, with results independent of the number of threads.
+   * Mutation functors providing mutate() (e.g. Mutation_polynomial) are applied in
+   * the same pass over the children (see has_fused_variation).
+   */
+  struct Crossover_sbx
+  {
+    /**
+     * @brief Construct a new Crossover_sbx object
+     *
+     * @param crossoverrate probability of crossing a pair
+     * @param eta_c distribution index (large values give children close to the parents)
+     * @param pool thread pool for crossing the pairs in parallel (nullptr for serial)
+     */
+    Crossover_sbx(double crossoverrate, double eta_c = 15.0, std::shared_ptr<thread_pool> pool = nullptr) :
+      _crossover_rate{ crossoverrate }, _eta_c{ eta_c }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    template <class E>
+    auto operator()(const xt::xexpression<E>& X)->E
+    {
+      E _X_out(X.derived_cast());
+      (*this)(_X_out, _X_out);
+      return _X_out;
+    }
+
+    /**
+     * @brief write the children of X to X_out (X_out may be X itself)
+     *
+     * @tparam E xtensor type of parents
+     * @tparam O xtensor type of children (e.g. a row_block of a population buffer)
+     * @param X parents
+     * @param X_out children
+     */
+    template <class E, class O>
+    void operator()(const xt::xexpression<E>& X, xt::xexpression<O>& X_out)
+    {
+      cross(X.derived_cast(), X_out.derived_cast(), detail::no_mutation{});
+    }
+
+    /**
+     * @brief write the crossed and mutated children of X to X_out in a single pass
+     *
+     * @tparam MUT mutation functor providing mutate() (see has_gene_mutation)
+     * @param X parents
+     * @param X_out children
+     * @param mutation_f mutation functor
+     */
+    template <class E, class O, class MUT, typename T = typename std::decay_t<O>::value_type,
+      typename = std::enable_if_t<has_gene_mutation<MUT, T>::value>>
+    void operator()(const xt::xexpression<E>& X, xt::xexpression<O>& X_out, MUT& mutation_f)
+    {
+      cross(X.derived_cast(), X_out.derived_cast(), detail::fused_mutation(mutation_f));
+    }
+
+  private:
+    template <class E, class O, class MUTATE, typename T = typename O::value_type>
+    void cross(const E& X, O& X_out, MUTATE&& mutate)
+    {
+      T e = static_cast<T>(1.0 / (_eta_c + 1.0));
+      detail::crossover_pairs(X, X_out, _crossover_rate, _rng, _calls++, _pool.get(),
+        [e](random_engine& gen, std::size_t)
+      {
+        return [e, &gen](const T* p1, const T* p2, T* c1, T* c2, std::size_t m, std::size_t)
+        {
+          double u[256];
+          fill_uniform(gen, u, m);
+          kernels::sbx_crossover(p1, p2, c1, c2, u, m, e);
+        };
+      }, mutate);
+    }
+
+    double _crossover_rate; ///< probability of crossing a pair
+    double _eta_c; ///< distribution index
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    rng _rng; ///< random number service of the functor
+    std::uint64_t _calls{ 0 }; ///< number of calls (substream of the random numbers)
+  };
+
+  /**
+   * @brief Functor for blend crossover (BLX-alpha)
+   *
+   * Consecutive rows of the mating pool are paired and crossed with probability
+   * crossoverrate using kernels::blend_crossover over the whole rows.
+   *
+   * L. J. Eshelman and J. D. Schaffer, Real-coded genetic algorithms and interval-schemata,
+   * Foundations of Genetic Algorithms 2, pp. 187-202, 1993.
+   */
+  struct Crossover_blx
+  {
+    /**
+     * @brief Construct a new Crossover_blx object
+     *
+     * @param crossoverrate probability of crossing a pair
+     * @param alpha extension of the parent interval (0.5 is common)
+     * @param pool thread pool for crossing the pairs in parallel (nullptr for serial)
+     */
+    Crossover_blx(double crossoverrate, double alpha = 0.5, std::shared_ptr<thread_pool> pool = nullptr) :
+      _crossover_rate{ crossoverrate }, _alpha{ alpha }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    template <class E>
+    auto operator()(const xt::xexpression<E>& X)->E
+    {
+      E _X_out(X.derived_cast());
+      (*this)(_X_out, _X_out);
+      return _X_out;
+    }
+
+    /**
+     * @brief write the children of X to X_out (X_out may be X itself)
+     *
+     * @tparam E xtensor type of parents
+     * @tparam O xtensor type of children (e.g. a row_block of a population buffer)
+     * @param X parents
+     * @param X_out children
+     */
+    template <class E, class O>
+    void operator()(const xt::xexpression<E>& X, xt::xexpression<O>& X_out)
+    {
+      cross(X.derived_cast(), X_out.derived_cast(), detail::no_mutation{});
+    }
+
+    /**
+     * @brief write the crossed and mutated children of X to X_out in a single pass
+     *
+     * @tparam MUT mutation functor providing mutate() (see has_gene_mutation)
+     * @param X parents
+     * @param X_out children
+     * @param mutation_f mutation functor
+     */
+    template <class E, class O, class MUT, typename T = typename std::decay_t<O>::value_type,
+      typename = std::enable_if_t<has_gene_mutation<MUT, T>::value>>
+    void operator()(const xt::xexpression<E>& X, xt::xexpression<O>& X_out, MUT& mutation_f)
+    {
+      cross(X.derived_cast(), X_out.derived_cast(), detail::fused_mutation(mutation_f));
+    }
+
+  private:
+    template <class E, class O, class MUTATE, typename T = typename O::value_type>
+    void cross(const E& X, O& X_out, MUTATE&& mutate)
+    {
+      T alpha = static_cast<T>(_alpha);
+      detail::crossover_pairs(X, X_out, _crossover_rate, _rng, _calls++, _pool.get(),
+        [alpha](random_engine& gen, std::size_t)
+      {
+        return [alpha, &gen](const T* p1, const T* p2, T* c1, T* c2, std::size_t m, std::size_t)
+        {
+          double u[512];
+          fill_uniform(gen, u, 2 * m);
+          kernels::blend_crossover(p1, p2, c1, c2, u, u + m, m, alpha);
+        };
+      }, mutate);
+    }
+
+    double _crossover_rate; ///< probability of crossing a pair
+    double _alpha; ///< extension of the parent interval
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    rng _rng; ///< random number service of the functor
+    std::uint64_t _calls{ 0 }; ///< number of calls (substream of the random numbers)
+  };
+
+  /**
+   * @brief Functor for uniform crossover
+   *
+   * Consecutive rows of the mating pool are paired and crossed with probability
+   * crossoverrate; every gene of a crossed pair is swapped with probability
+   * swap_probability (kernels::uniform_crossover).
+   */
+  struct Crossover_uniform
+  {
+    /**
+     * @brief Construct a new Crossover_uniform object
+     *
+     * @param crossoverrate probability of crossing a pair
+     * @param swap_probability probability of swapping a gene
+     * @param pool thread pool for crossing the pairs in parallel (nullptr for serial)
+     */
+    Crossover_uniform(double crossoverrate, double swap_probability = 0.5,
+      std::shared_ptr<thread_pool> pool = nullptr) :
+      _crossover_rate{ crossoverrate }, _swap_probability{ swap_probability }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    template <class E>
+    auto operator()(const xt::xexpression<E>& X)->E
+    {
+      E _X_out(X.derived_cast());
+      (*this)(_X_out, _X_out);
+      return _X_out;
+    }
+
+    /**
+     * @brief write the children of X to X_out (X_out may be X itself)
+     *
+     * @tparam E xtensor type of parents
+     * @tparam O xtensor type of children (e.g. a row_block of a population buffer)
+     * @param X parents
+     * @param X_out children
+     */
+    template <class E, class O>
+    void operator()(const xt::xexpression<E>& X, xt::xexpression<O>& X_out)
+    {
+      cross(X.derived_cast(), X_out.derived_cast(), detail::no_mutation{});
+    }
+
+    /**
+     * @brief write the crossed and mutated children of X to X_out in a single pass
+     *
+     * @tparam MUT mutation functor providing mutate() (see has_gene_mutation)
+     * @param X parents
+     * @param X_out children
+     * @param mutation_f mutation functor
+     */
+    template <class E, class O, class MUT, typename T = typename std::decay_t<O>::value_type,
+      typename = std::enable_if_t<has_gene_mutation<MUT, T>::value>>
+    void operator()(const xt::xexpression<E>& X, xt::xexpression<O>& X_out, MUT& mutation_f)
+    {
+      cross(X.derived_cast(), X_out.derived_cast(), detail::fused_mutation(mutation_f));
+    }
+
+  private:
+    template <class E, class O, class MUTATE, typename T = typename O::value_type>
+    void cross(const E& X, O& X_out, MUTATE&& mutate)
+    {
+      double swap_probability = _swap_probability;
+      detail::crossover_pairs(X, X_out, _crossover_rate, _rng, _calls++, _pool.get(),
+        [swap_probability](random_engine& gen, std::size_t)
+      {
+        return [swap_probability, &gen](const T* p1, const T* p2, T* c1, T* c2, std::size_t m, std::size_t)
+        {
+          double u[256];
+          fill_uniform(gen, u, m);
+          kernels::uniform_crossover(p1, p2, c1, c2, u, m, swap_probability);
+        };
+      }, mutate);
+    }
+
+    double _crossover_rate; ///< probability of crossing a pair
+    double _swap_probability; ///< probability of swapping a gene
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    rng _rng; ///< random number service of the functor
+    std::uint64_t _calls{ 0 }; ///< number of calls (substream of the random numbers)
+  };
+
+  /**
+   * @brief Functor for k-point crossover
+   *
+   * Consecutive rows of the mating pool are paired and crossed with probability
+   * crossoverrate. Every crossed pair draws k distinct cut points (at most 64 and at
+   * most D - 1) and exchanges every other segment (kernels::k_point_crossover).
+   */
+  struct Crossover_k_point
+  {
+    /**
+     * @brief Construct a new Crossover_k_point object
+     *
+     * @param crossoverrate probability of crossing a pair
+     * @param k number of cut points
+     * @param pool thread pool for crossing the pairs in parallel (nullptr for serial)
+     */
+    Crossover_k_point(double crossoverrate, std::size_t k = 2, std::shared_ptr<thread_pool> pool = nullptr) :
+      _crossover_rate{ crossoverrate }, _k{ std::min(k, std::size_t(max_points)) }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    template <class E>
+    auto operator()(const xt::xexpression<E>& X)->E
+    {
+      E _X_out(X.derived_cast());
+      (*this)(_X_out, _X_out);
+      return _X_out;
+    }
+
+    /**
+     * @brief write the children of X to X_out (X_out may be X itself)
+     *
+     * @tparam E xtensor type of parents
+     * @tparam O xtensor type of children (e.g. a row_block of a population buffer)
+     * @param X parents
+     * @param X_out children
+     */
+    template <class E, class O>
+    void operator()(const xt::xexpression<E>& X, xt::xexpression<O>& X_out)
+    {
+      cross(X.derived_cast(), X_out.derived_cast(), detail::no_mutation{});
+    }
+
+    /**
+     * @brief write the crossed and mutated children of X to X_out in a single pass
+     *
+     * @tparam MUT mutation functor providing mutate() (see has_gene_mutation)
+     * @param X parents
+     * @param X_out children
+     * @param mutation_f mutation functor
+     */
+    template <class E, class O, class MUT, typename T = typename std::decay_t<O>::value_type,
+      typename = std::enable_if_t<has_gene_mutation<MUT, T>::value>>
+    void operator()(const xt::xexpression<E>& X, xt::xexpression<O>& X_out, MUT& mutation_f)
+    {
+      cross(X.derived_cast(), X_out.derived_cast(), detail::fused_mutation(mutation_f));
+    }
+
+  private:
+    static constexpr std::size_t max_points = 64;
+
+    template <class E, class O, class MUTATE, typename T = typename O::value_type>
+    void cross(const E& X, O& X_out, MUTATE&& mutate)
+    {
+      std::size_t k_max = _k;
+      detail::crossover_pairs(X, X_out, _crossover_rate, _rng, _calls++, _pool.get(),
+        [k_max](random_engine& gen, std::size_t n)
+      {
+        std::array<std::size_t, max_points> points;
+        std::size_t k = n > 1 ? std::min(k_max, n - 1) : 0;
+        // Floyd's sampling of k distinct cut points in [1, n - 1]
+        std::size_t num_of_points{ 0 };
+        for (std::size_t m = n - 1 - k; k > 0 && m < n - 1; ++m)
+        {
+          std::size_t t = 1 + uniform_index(gen, m + 1);
+          bool found = std::find(points.begin(), points.begin() + num_of_points, t) != points.begin() + num_of_points;
+          points[num_of_points++] = found ? m + 1 : t;
+        }
+        std::sort(points.begin(), points.begin() + num_of_points);
+
+        return [points, num_of_points](const T* p1, const T* p2, T* c1, T* c2, std::size_t m, std::size_t j)
+        {
+          // cut points up to the block decide which parent the block starts with
+          std::size_t s = std::upper_bound(points.begin(), points.begin() + num_of_points, j) - points.begin();
+          std::array<std::size_t, max_points> local_points;
+          std::size_t num_of_local_points{ 0 };
+          for (std::size_t t = s; t < num_of_points && points[t] < j + m; ++t)
+          {
+            local_points[num_of_local_points++] = points[t] - j;
+          }
+          if (s % 2 == 1)
+          {
+            std::swap(p1, p2);
+          }
+          kernels::k_point_crossover(p1, p2, c1, c2, m, local_points.data(), num_of_local_points);
+        };
+      }, mutate);
+    }
+
+    double _crossover_rate; ///< probability of crossing a pair
+    std::size_t _k; ///< number of cut points
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    rng _rng; ///< random number service of the functor
+    std::uint64_t _calls{ 0 }; ///< number of calls (substream of the random numbers)
+  };
+
+}
+
+#endif
@@ -0,0 +1,794 @@
+/**
+ * @file de.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief templated header file with differential evolution and its strategy functors
+ *  (DE/rand/1/bin, DE/best/1/bin and DE/current-to-pbest/1 of JADE).
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __DE_HPP__
+#define __DE_HPP__
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+
+#include "functors.hpp"
+#include "initialisation.hpp"
+#include "kernels.hpp"
+#include "rng.hpp"
+#include "selection.hpp"
+#include "thread_pool.hpp"
+
+
+namespace xevo
+{
+
+  namespace detail
+  {
+    /**
+     * @brief rows taking part in the trial vector of one individual (see kernels::de_trial)
+     */
+    template <class T>
+    struct de_donor
+    {
+      const T* base;
+      const T* p;
+      const T* r1;
+      const T* r2;
+      T K;
+      T F;
+      double CR;
+    };
+
+    /**
+     * @brief uniform index in [0, n) different from the m indices in excluded
+     */
+    template <class URNG>
+    inline std::size_t de_index(URNG& gen, std::size_t n, const std::size_t* excluded, std::size_t m)
+    {
+      while (true)
+      {
+        std::size_t r = uniform_index(gen, n);
+        if (std::find(excluded, excluded + m, r) == excluded + m)
+        {
+          return r;
+        }
+      }
+    }
+
+    /**
+     * @brief rows of the archive in the value type of the population
+     */
+    template <class T>
+    inline const T* de_archive_rows(const std::vector<double>& archive, std::vector<T>& copy)
+    {
+      copy.assign(archive.begin(), archive.end());
+      return copy.data();
+    }
+
+    inline const double* de_archive_rows(const std::vector<double>& archive, std::vector<double>&)
+    {
+      return archive.data();
+    }
+
+    /**
+     * @brief build the whole trial population in one pass
+     *
+     * Row i draws its indices, its crossover mask and its j_rand from the stream
+     * (call, i), so the trials do not depend on the number of threads.
+     * donor(i, gen, d) fills the rows and the parameters of individual i.
+     *
+     * @param X population (contiguous row-major container, see has_row_major_data)
+     * @param trials output with the trial population (same shape as X)
+     * @param r random number service of the strategy
+     * @param call call number
+     * @param pool optional thread pool
+     * @param donor functor filling a de_donor
+     */
+    template <class E, class DONOR, typename T = typename std::decay_t<E>::value_type>
+    inline void de_trials(const E& X, E& trials, const rng& r, std::uint64_t call, thread_pool* pool, DONOR donor)
+    {
+      static_assert(has_row_major_data<E>::value, "differential evolution requires a contiguous row-major population");
+      std::size_t num_of_indiv = X.shape()[0];
+      std::size_t num_of_vars = X.shape()[1];
+
+      parallel_for_chunks(pool, num_of_indiv, [&](std::size_t first, std::size_t last)
+      {
+        std::vector<double> u(num_of_vars);
+        de_donor<T> d;
+        for (std::size_t i = first; i < last; ++i)
+        {
+          random_engine gen = r.stream(call, i);
+          donor(i, gen, d);
+          std::size_t j_rand = uniform_index(gen, num_of_vars);
+          fill_uniform(gen, u.data(), num_of_vars);
+          kernels::de_trial(kernels::row(trials, i), kernels::row(X, i), d.base, d.p, d.r1, d.r2, u.data(),
+            num_of_vars, d.K, d.F, d.CR, j_rand);
+        }
+      });
+    }
+
+    /**
+     * @brief greedy one-to-one replacement of the targets by their trials
+     *
+     * A trial replaces its target when it is at least as good. success(i) is called
+     * before row i is replaced.
+     */
+    template <class E, class F, class G, class SUCCESS>
+    inline void de_replace(E& X, F& Y, const E& trials, const G& Y_trial, bool maximise, SUCCESS success)
+    {
+      static_assert(has_row_major_data<E>::value, "differential evolution requires a contiguous row-major population");
+      std::size_t num_of_indiv = X.shape()[0];
+      std::size_t num_of_vars = X.shape()[1];
+      for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+      {
+        auto y = Y_trial(i);
+        if (maximise ? !(y < Y(i)) : !(Y(i) < y))
+        {
+          success(i);
+          const auto* t = kernels::row(trials, i);
+          std::copy(t, t + num_of_vars, kernels::row(X, i));
+          Y(i) = y;
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief DE/rand/1/bin strategy of differential evolution
+   *
+   * \f[ v_i = x_{r_1} + F \left( x_{r_2} - x_{r_3} \right) \f]
+   *
+   * with distinct random r_1, r_2, r_3 different from i, followed by binomial
+   * crossover with rate CR. Needs at least four individuals.
+   *
+   * R. Storn and K. Price, Differential evolution - a simple and efficient heuristic for
+   * global optimization over continuous spaces, Journal of Global Optimization, vol. 11,
+   * no. 4, pp. 341-359, 1997.
+   */
+  struct De_rand_1_bin
+  {
+    /**
+     * @brief Construct a new De_rand_1_bin object
+     *
+     * @param F scale factor of the difference vector
+     * @param CR crossover rate
+     * @param maximise true when larger fitness is better
+     * @param pool thread pool for building the trials in parallel (nullptr for serial)
+     */
+    explicit De_rand_1_bin(double F = 0.5, double CR = 0.9, bool maximise = false,
+      std::shared_ptr<thread_pool> pool = nullptr) :
+      _F{ F }, _CR{ CR }, _maximise{ maximise }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    /**
+     * @brief build the trial population
+     *
+     * @param X population
+     * @param trials output with the trial population (same shape as X)
+     */
+    template <class E, class F, typename T = typename std::decay_t<E>::value_type>
+    void operator()(const E& X, const F&, E& trials)
+    {
+      std::size_t num_of_indiv = X.shape()[0];
+      if (num_of_indiv < 4)
+      {
+        throw std::runtime_error("DE/rand/1 needs at least four individuals");
+      }
+
+      detail::de_trials(X, trials, _rng, _calls++, _pool.get(), [&](std::size_t i, random_engine& gen,
+        detail::de_donor<T>& d)
+      {
+        std::size_t r[4] = { i, 0, 0, 0 };
+        for (std::size_t k{ 1 }; k < 4; ++k)
+        {
+          r[k] = detail::de_index(gen, num_of_indiv, r, k);
+        }
+        d.base = kernels::row(X, r[1]);
+        d.p = d.base;
+        d.r1 = kernels::row(X, r[2]);
+        d.r2 = kernels::row(X, r[3]);
+        d.K = T(0);
+        d.F = static_cast<T>(_F);
+        d.CR = _CR;
+      });
+    }
+
+    /**
+     * @brief replace every individual by its trial when the trial is at least as good
+     *
+     * @param X population
+     * @param Y evaluations of the population
+     * @param trials trial population
+     * @param Y_trial evaluations of the trials
+     */
+    template <class E, class F, class G>
+    void select(E& X, F& Y, const E& trials, const G& Y_trial)
+    {
+      detail::de_replace(X, Y, trials, Y_trial, _maximise, [](std::size_t) {});
+    }
+
+  private:
+    double _F; ///< scale factor
+    double _CR; ///< crossover rate
+    bool _maximise;
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    rng _rng; ///< random number service of the functor
+    std::uint64_t _calls{ 0 }; ///< number of calls (substream of the random numbers)
+  };
+
+  /**
+   * @brief DE/best/1/bin strategy of differential evolution
+   *
+   * \f[ v_i = x_{best} + F \left( x_{r_1} - x_{r_2} \right) \f]
+   *
+   * with distinct random r_1, r_2 different from i, followed by binomial crossover with
+   * rate CR. Needs at least three individuals.
+   */
+  struct De_best_1_bin
+  {
+    /**
+     * @brief Construct a new De_best_1_bin object
+     *
+     * @param F scale factor of the difference vector
+     * @param CR crossover rate
+     * @param maximise true when larger fitness is better
+     * @param pool thread pool for building the trials in parallel (nullptr for serial)
+     */
+    explicit De_best_1_bin(double F = 0.5, double CR = 0.9, bool maximise = false,
+      std::shared_ptr<thread_pool> pool = nullptr) :
+      _F{ F }, _CR{ CR }, _maximise{ maximise }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    /**
+     * @brief build the trial population
+     *
+     * @param X population
+     * @param Y evaluations of the population
+     * @param trials output with the trial population (same shape as X)
+     */
+    template <class E, class F, typename T = typename std::decay_t<E>::value_type>
+    void operator()(const E& X, const F& Y, E& trials)
+    {
+      std::size_t num_of_indiv = X.shape()[0];
+      if (num_of_indiv < 3)
+      {
+        throw std::runtime_error("DE/best/1 needs at least three individuals");
+      }
+      top_k_indices(Y, 1, _maximise, _best);
+      const T* best = kernels::row(X, _best[0]);
+
+      detail::de_trials(X, trials, _rng, _calls++, _pool.get(), [&](std::size_t i, random_engine& gen,
+        detail::de_donor<T>& d)
+      {
+        std::size_t r[3] = { i, 0, 0 };
+        for (std::size_t k{ 1 }; k < 3; ++k)
+        {
+          r[k] = detail::de_index(gen, num_of_indiv, r, k);
+        }
+        d.base = best;
+        d.p = best;
+        d.r1 = kernels::row(X, r[1]);
+        d.r2 = kernels::row(X, r[2]);
+        d.K = T(0);
+        d.F = static_cast<T>(_F);
+        d.CR = _CR;
+      });
+    }
+
+    /**
+     * @brief replace every individual by its trial when the trial is at least as good
+     *
+     * @param X population
+     * @param Y evaluations of the population
+     * @param trials trial population
+     * @param Y_trial evaluations of the trials
+     */
+    template <class E, class F, class G>
+    void select(E& X, F& Y, const E& trials, const G& Y_trial)
+    {
+      detail::de_replace(X, Y, trials, Y_trial, _maximise, [](std::size_t) {});
+    }
+
+  private:
+    double _F; ///< scale factor
+    double _CR; ///< crossover rate
+    bool _maximise;
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    std::vector<std::size_t> _best; ///< index of the best individual
+    rng _rng; ///< random number service of the functor
+    std::uint64_t _calls{ 0 }; ///< number of calls (substream of the random numbers)
+  };
+
+  /**
+   * @brief DE/current-to-pbest/1 strategy with parameter adaptation (JADE)
+   *
+   * \f[ v_i = x_i + F_i \left( x_{pbest} - x_i \right) + F_i \left( x_{r_1} - \tilde{x}_{r_2} \right) \f]
+   *
+   * where x_pbest is one of the 100p% best individuals, r_1 is drawn from the population
+   * and r_2 from the population and the archive of replaced parents. Every individual
+   * draws F_i from a Cauchy distribution around mu_F and CR_i from a normal distribution
+   * around mu_CR; after the selection mu_CR moves towards the arithmetic mean and mu_F
+   * towards the Lehmer mean of the successful values with rate c. Needs at least three
+   * individuals.
+   *
+   * J. Zhang and A. C. Sanderson, JADE: Adaptive differential evolution with optional
+   * external archive, IEEE Transactions on Evolutionary Computation, vol. 13, no. 5,
+   * pp. 945-958, 2009.
+   */
+  struct De_current_to_pbest_1
+  {
+    /**
+     * @brief Construct a new De_current_to_pbest_1 object
+     *
+     * @param p fraction of the best individuals x_pbest is drawn from
+     * @param c adaptation rate of mu_F and mu_CR
+     * @param archive keep the replaced parents for the difference vectors
+     * @param maximise true when larger fitness is better
+     * @param pool thread pool for building the trials in parallel (nullptr for serial)
+     */
+    explicit De_current_to_pbest_1(double p = 0.05, double c = 0.1, bool archive = true, bool maximise = false,
+      std::shared_ptr<thread_pool> pool = nullptr) :
+      _p{ p }, _c{ c }, _use_archive{ archive }, _maximise{ maximise }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    /**
+     * @brief build the trial population
+     *
+     * @param X population
+     * @param Y evaluations of the population
+     * @param trials output with the trial population (same shape as X)
+     */
+    template <class E, class F, typename T = typename std::decay_t<E>::value_type>
+    void operator()(const E& X, const F& Y, E& trials)
+    {
+      std::size_t num_of_indiv = X.shape()[0];
+      std::size_t num_of_vars = X.shape()[1];
+      if (num_of_indiv < 3)
+      {
+        throw std::runtime_error("DE/current-to-pbest/1 needs at least three individuals");
+      }
+      std::size_t num_of_pbest = std::max<std::size_t>(1, static_cast<std::size_t>(std::round(_p * num_of_indiv)));
+      top_k_indices(Y, num_of_pbest, _maximise, _pbest);
+
+      _F.resize(num_of_indiv);
+      _CR.resize(num_of_indiv);
+      std::size_t num_of_archived = _archive.size() / std::max<std::size_t>(num_of_vars, 1);
+      std::vector<T> archive_copy;
+      const T* archive = detail::de_archive_rows(_archive, archive_copy);
+      const double pi = 3.141592653589793238462643383279502884;
+      _call = _calls++;
+
+      detail::de_trials(X, trials, _rng, _call, _pool.get(), [&](std::size_t i, random_engine& gen,
+        detail::de_donor<T>& d)
+      {
+        double scale{ 0.0 };
+        while (scale <= 0.0)
+        {
+          scale = _mu_F + 0.1 * std::tan(pi * (uniform01(gen) - 0.5));
+        }
+        double rate{ 0.0 };
+        fill_normal(gen, &rate, 1, _mu_CR, 0.1);
+        _F[i] = std::min(scale, 1.0);
+        _CR[i] = std::min(std::max(rate, 0.0), 1.0);
+
+        std::size_t r[3] = { i, 0, 0 };
+        r[1] = detail::de_index(gen, num_of_indiv, r, 1);
+        r[2] = detail::de_index(gen, num_of_indiv + num_of_archived, r, 2);
+
+        d.base = kernels::row(X, i);
+        d.p = kernels::row(X, _pbest[uniform_index(gen, num_of_pbest)]);
+        d.r1 = kernels::row(X, r[1]);
+        d.r2 = r[2] < num_of_indiv ? kernels::row(X, r[2]) :
+          archive + (r[2] - num_of_indiv) * num_of_vars;
+        d.K = static_cast<T>(_F[i]);
+        d.F = static_cast<T>(_F[i]);
+        d.CR = _CR[i];
+      });
+    }
+
+    /**
+     * @brief replace every individual by its trial when the trial is at least as good,
+     *  archive the replaced parents and adapt mu_F and mu_CR
+     *
+     * @param X population
+     * @param Y evaluations of the population
+     * @param trials trial population
+     * @param Y_trial evaluations of the trials
+     */
+    template <class E, class F, class G, typename T = typename std::decay_t<E>::value_type>
+    void select(E& X, F& Y, const E& trials, const G& Y_trial)
+    {
+      std::size_t num_of_indiv = X.shape()[0];
+      std::size_t num_of_vars = X.shape()[1];
+      random_engine gen = _rng.stream(_call, num_of_indiv);
+
+      double sum_CR{ 0.0 };
+      double sum_F{ 0.0 };
+      double sum_F2{ 0.0 };
+      std::size_t num_of_successes{ 0 };
+      detail::de_replace(X, Y, trials, Y_trial, _maximise, [&](std::size_t i)
+      {
+        sum_CR += _CR[i];
+        sum_F += _F[i];
+        sum_F2 += _F[i] * _F[i];
+        ++num_of_successes;
+
+        if (_use_archive)
+        {
+          const T* x = kernels::row(X, i);
+          if (_archive.size() < num_of_indiv * num_of_vars)
+          {
+            _archive.insert(_archive.end(), x, x + num_of_vars);
+          }
+          else
+          {
+            std::size_t k = uniform_index(gen, num_of_indiv);
+            std::copy(x, x + num_of_vars, _archive.begin() + k * num_of_vars);
+          }
+        }
+      });
+
+      if (num_of_successes > 0)
+      {
+        _mu_CR = (1.0 - _c) * _mu_CR + _c * sum_CR / double(num_of_successes);
+        _mu_F = (1.0 - _c) * _mu_F + _c * sum_F2 / sum_F;
+      }
+    }
+
+    /**
+     * @brief mean of the scale factors
+     *
+     * @return double
+     */
+    double mu_F() const
+    {
+      return _mu_F;
+    }
+
+    /**
+     * @brief mean of the crossover rates
+     *
+     * @return double
+     */
+    double mu_CR() const
+    {
+      return _mu_CR;
+    }
+
+  private:
+    double _p; ///< fraction of the best individuals
+    double _c; ///< adaptation rate
+    bool _use_archive; ///< keep the replaced parents
+    bool _maximise;
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    double _mu_F{ 0.5 }; ///< location of the scale factors
+    double _mu_CR{ 0.5 }; ///< mean of the crossover rates
+    std::vector<double> _F; ///< scale factor of every individual
+    std::vector<double> _CR; ///< crossover rate of every individual
+    std::vector<std::size_t> _pbest; ///< indices of the p best individuals
+    std::vector<double> _archive; ///< replaced parents (row-major)
+    rng _rng; ///< random number service of the functor
+    std::uint64_t _calls{ 0 }; ///< number of calls (substream of the random numbers)
+    std::uint64_t _call{ 0 }; ///< call of the last trial population
+  };
+
+  /**
+   * @brief class for differential evolution
+   *
+   * Every generation the strategy functor builds the whole trial population in one
+   * pass, the trials are evaluated as one batch by the objective function and every
+   * individual is replaced by its trial when the trial is at least as good. The
+   * population must be a contiguous row-major container (see has_row_major_data).
+   */
+  class de
+  {
+  public:
+
+    /**
+     * @brief method to initialise population for de
+     *
+     * @tparam E xtensor type for generating the initial population
+     * @tparam POP functor for generating the population
+     * @tparam PopArgs optional type of arguments for population functor
+     * @tparam T value type of xtensor
+     * @param X array of population
+     * @param popargs optional arguments for population functor
+     */
+    template<class E, class POP = Population, typename... PopArgs,
+      typename T = typename std::decay_t<E>::value_type>
+      void initialise(xt::xexpression<E>& X, std::tuple<PopArgs...> popargs = std::make_tuple())
+    {
+      initialise<E, POP>(X, std::move(popargs), std::index_sequence_for<PopArgs...>{});
+    }
+
+    /**
+     * @brief method to evolve the population by one generation
+     *
+     * @tparam E xtensor type of the population
+     * @tparam F xtensor type of the evaluations
+     * @tparam OBJ functor for objective function
+     * @tparam STRAT functor for the strategy
+     * @tparam StratArgs types of arguments for strategy functor
+     * @param X array with population at current evolution
+     * @param Y evaluations of the population (e.g. objective_f(X) after initialise), updated
+     * @param objective_f objective function
+     * @param stratargs arguments for strategy functor
+     */
+    template<class E, class F, class OBJ, class STRAT = De_rand_1_bin, typename... StratArgs>
+    void evolve(xt::xexpression<E>& X, xt::xexpression<F>& Y, OBJ objective_f, std::tuple<StratArgs...> stratargs)
+    {
+      evolve<E, F, OBJ, STRAT>(X, Y, objective_f, std::move(stratargs), std::index_sequence_for<StratArgs...>{});
+    }
+
+    /**
+     * @brief method to evolve the population by one generation
+     *
+     * @tparam E xtensor type of the population
+     * @tparam F xtensor type of the evaluations
+     * @tparam OBJ functor for objective function
+     * @tparam STRAT functor for the strategy
+     * @tparam TERM functor for termination
+     * @tparam StratArgs types of arguments for strategy functor
+     * @tparam TermArgs types of arguments for terminating functor
+     * @param X array with population at current evolution
+     * @param Y evaluations of the population (e.g. objective_f(X) after initialise), updated
+     * @param objective_f objective function
+     * @param stratargs arguments for strategy functor
+     * @param termargs arguments for terminating functor
+     *
+     * @return auto type from terminating functor, evaluated with the updated evaluations
+     */
+    template<class E, class F, class OBJ, class STRAT = De_rand_1_bin, class TERM = Terminate_gen_max,
+      typename... StratArgs, typename... TermArgs>
+    auto evolve(xt::xexpression<E>& X, xt::xexpression<F>& Y, OBJ objective_f, std::tuple<StratArgs...> stratargs,
+      std::tuple<TermArgs...> termargs)
+    {
+      evolve<E, F, OBJ, STRAT>(X, Y, objective_f, std::move(stratargs), std::index_sequence_for<StratArgs...>{});
+      return terminate<TERM>(X, Y, std::move(termargs), std::index_sequence_for<TermArgs...>{});
+    }
+
+  private:
+
+    template<class E, class POP = Population, typename... PopArgs, std::size_t... PIs,
+      typename T = typename std::decay_t<E>::value_type>
+      void initialise(xt::xexpression<E>& X, std::tuple<PopArgs...>&& popargs, std::index_sequence<PIs...>)
+    {
+      E& _X = X.derived_cast();
+      POP f_pop(std::get<PIs>(std::move(popargs))...);
+      f_pop(_X);
+    }
+
+    template<class E, class F, class OBJ, class STRAT, typename... StratArgs, std::size_t... SIs>
+    void evolve(xt::xexpression<E>& X, xt::xexpression<F>& Y, OBJ& objective_f, std::tuple<StratArgs...>&& stratargs,
+      std::index_sequence<SIs...>)
+    {
+      STRAT strategy_f(std::get<SIs>(std::move(stratargs))...);
+
+      E& population = X.derived_cast();
+      F& y = Y.derived_cast();
+      E trials(population);
+
+      strategy_f(population, y, trials);
+      auto y_trial = objective_f(trials);
+      strategy_f.select(population, y, trials, y_trial);
+    }
+
+    template<class TERM, class E, class F, typename... TermArgs, std::size_t... TIs>
+    auto terminate(xt::xexpression<E>& X, xt::xexpression<F>& Y, std::tuple<TermArgs...>&& termargs,
+      std::index_sequence<TIs...>)
+    {
+      TERM terminate_f(std::get<TIs>(std::move(termargs))...);
+      return terminate_f(X.derived_cast(), Y.derived_cast());
+    }
+
+  };
+
+  /**
+   * @brief stateful differential evolution solver
+   *
+   * Keeps the population, its evaluations, the trial buffer and the strategy functor
+   * (e.g. the adapted parameters and the archive of De_current_to_pbest_1) between
+   * generations. Every trial is evaluated exactly once.
+   *
+   * @tparam E xtensor type of the population (contiguous row-major container, see has_row_major_data)
+   * @tparam OBJ functor for objective function
+   * @tparam STRAT functor for the strategy
+   */
+  template<class E, class OBJ, class STRAT = De_rand_1_bin>
+  class de_state
+  {
+    static_assert(has_row_major_data<E>::value, "de_state requires a contiguous row-major population");
+
+  public:
+
+    using value_type = typename std::decay_t<E>::value_type;
+    using fitness_type = xt::xtensor<value_type, 1>;
+
+    /**
+     * @brief Construct a new de_state object
+     *
+     * @param X initial population
+     * @param objective_f objective function
+     * @param strategy_f functor for the strategy
+     */
+    de_state(const E& X, OBJ objective_f, STRAT strategy_f) :
+      _population(X), _trials(X), _objective_f{ std::move(objective_f) }, _strategy_f{ std::move(strategy_f) }
+    {
+
+    }
+
+    /**
+     * @brief evolve the population by one generation
+     */
+    void step()
+    {
+      if (!_evaluated)
+      {
+        evaluate(_population, _y);
+      }
+
+      _strategy_f(_population, _y, _trials);
+      evaluate(_trials, _y_trial);
+      _strategy_f.select(_population, _y, _trials, _y_trial);
+      ++_generation;
+    }
+
+    /**
+     * @brief evolve the population by one generation and apply a terminating functor
+     *
+     * @tparam TERM functor for termination
+     * @param terminate_f terminating functor
+     * @return auto type from terminating functor, evaluated with the stored evaluations
+     */
+    template<class TERM>
+    auto step(TERM terminate_f)
+    {
+      step();
+      return terminate_f(_population, _y);
+    }
+
+    /**
+     * @brief evolve the population for a number of generations
+     *
+     * @param generations number of generations
+     */
+    void run(std::size_t generations)
+    {
+      for (std::size_t i{ 0 }; i < generations; ++i)
+      {
+        step();
+      }
+    }
+
+    /**
+     * @brief current population
+     *
+     * @return const E&
+     */
+    const E& population() const
+    {
+      return _population;
+    }
+
+    /**
+     * @brief evaluations of the current population (evaluated on first access)
+     *
+     * @return const fitness_type&
+     */
+    const fitness_type& fitness()
+    {
+      if (!_evaluated)
+      {
+        evaluate(_population, _y);
+      }
+      return _y;
+    }
+
+    /**
+     * @brief strategy functor
+     *
+     * @return const STRAT&
+     */
+    const STRAT& strategy() const
+    {
+      return _strategy_f;
+    }
+
+    /**
+     * @brief number of generations evolved so far
+     *
+     * @return std::size_t
+     */
+    std::size_t generation() const
+    {
+      return _generation;
+    }
+
+    /**
+     * @brief number of individuals passed to the objective function so far
+     *
+     * @return std::size_t
+     */
+    std::size_t evaluations() const
+    {
+      return _evaluations;
+    }
+
+  private:
+
+    void evaluate(const E& X, fitness_type& Y)
+    {
+      std::size_t individual_size = X.shape()[0];
+      auto&& y = _objective_f(X);
+
+      if (Y.size() != individual_size)
+      {
+        std::array<std::size_t, 1> shape_y = { individual_size };
+        Y.resize(shape_y);
+      }
+      for (std::size_t i{ 0 }; i < individual_size; ++i)
+      {
+        Y(i) = y(i);
+      }
+
+      _evaluations += individual_size;
+      if (&Y == &_y)
+      {
+        _evaluated = true;
+      }
+    }
+
+    E _population; ///< current population
+    E _trials; ///< trial population
+    fitness_type _y; ///< evaluations of the current population
+    fitness_type _y_trial; ///< evaluations of the trials
+    OBJ _objective_f;
+    STRAT _strategy_f;
+    std::size_t _generation{ 0 };
+    std::size_t _evaluations{ 0 };
+    bool _evaluated{ false };
+  };
+
+  /**
+   * @brief helper to construct a de_state with deduced functor types
+   *
+   * @tparam E xtensor type of the population
+   * @tparam OBJ functor for objective function
+   * @tparam STRAT functor for the strategy
+   * @param X initial population
+   * @param objective_f objective function
+   * @param strategy_f functor for the strategy
+   * @return de_state<E, OBJ, STRAT>
+   */
+  template<class E, class OBJ, class STRAT>
+  auto make_de_state(const E& X, OBJ objective_f, STRAT strategy_f)
+  {
+    return de_state<E, OBJ, STRAT>(X, std::move(objective_f), std::move(strategy_f));
+  }
+
+}
+
+#endif
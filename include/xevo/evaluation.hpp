@@ -0,0 +1,403 @@
+/**
+ * @file evaluation.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief templated header file with functors that wrap objective functions.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __EVALUATION_HPP__
+#define __EVALUATION_HPP__
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+#include "xtensor/xview.hpp"
+
+#include "thread_pool.hpp"
+
+
+namespace xevo
+{
+
+  /**
+   * @brief Functor for evaluating an objective function in parallel
+   *
+   * The rows of the population are split in chunks of chunk_size individuals.
+   * Every chunk is evaluated by the wrapped objective on a thread pool and the
+   * results are gathered into a single fitness vector, so the wrapper can be
+   * passed wherever an OBJ functor is expected (ga::evolve, pso::evolve,
+   * pso_ga::evolve).
+   *
+   * The wrapped objective must evaluate every row independently of the other rows
+   * (e.g. xevo::Sphere, xevo::Rosenbrock) and must be safe to call concurrently.
+   * Objectives that scale the fitness with the population (e.g. xevo::Rosenbrock_scaled)
+   * give different results when they are evaluated in chunks.
+   *
+   * Copies of the functor share the same thread pool.
+   *
+   * @tparam OBJ functor type of the objective function
+   */
+  template <class OBJ>
+  struct Evaluate_parallel
+  {
+    /**
+     * @brief Construct a new Evaluate_parallel object
+     *
+     * @param objective_f objective function
+     * @param chunk_size number of individuals per task (0 splits the population in
+     *  four chunks per thread)
+     * @param num_threads number of threads (0 uses all hardware threads)
+     */
+    Evaluate_parallel(OBJ objective_f, std::size_t chunk_size = 0, std::size_t num_threads = 0) :
+      _objective_f{ std::move(objective_f) }, _chunk_size{ chunk_size },
+      _pool{ std::make_shared<thread_pool>(num_threads) }
+    {
+
+    }
+
+    /**
+     * @brief Construct a new Evaluate_parallel object on an existing thread pool
+     *
+     * @param objective_f objective function
+     * @param pool thread pool shared with other parallel parts of the algorithm
+     * @param chunk_size number of individuals per task (0 for automatic)
+     */
+    Evaluate_parallel(OBJ objective_f, std::shared_ptr<thread_pool> pool, std::size_t chunk_size = 0) :
+      _objective_f{ std::move(objective_f) }, _chunk_size{ chunk_size }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    /**
+     * @brief operator to evaluate the objective function
+     *
+     * @tparam E xtensor type of the population
+     * @tparam T value type of xtensor
+     * @param X population (one individual per row)
+     * @return xt::xtensor<T, 1> fitness of every individual
+     */
+    template <class E, typename T = typename std::decay_t<E>::value_type>
+    auto operator()(const xt::xexpression<E>& X)
+    {
+      const E& _X = X.derived_cast();
+      std::size_t num_of_indiv = _X.shape()[0];
+      std::array<std::size_t, 1> shape_y = { num_of_indiv };
+      xt::xtensor<T, 1> y(shape_y);
+
+      std::size_t chunk_size = chunk(num_of_indiv);
+      std::size_t num_of_chunks = (num_of_indiv + chunk_size - 1) / chunk_size;
+      OBJ& objective_f = _objective_f;
+
+      _pool->parallel_for(num_of_chunks, [&](std::size_t c)
+      {
+        std::size_t begin = c * chunk_size;
+        std::size_t end = std::min(begin + chunk_size, num_of_indiv);
+        xt::xtensor<T, 2> X_chunk = xt::view(_X, xt::range(begin, end), xt::all());
+        auto y_chunk = objective_f(X_chunk);
+        xt::view(y, xt::range(begin, end)) = y_chunk;
+      });
+
+      return y;
+    }
+
+    /**
+     * @brief thread pool used for the evaluation
+     *
+     * @return std::shared_ptr<thread_pool>
+     */
+    std::shared_ptr<thread_pool> pool() const
+    {
+      return _pool;
+    }
+
+  private:
+
+    std::size_t chunk(std::size_t num_of_indiv) const
+    {
+      if (_chunk_size > 0)
+      {
+        return _chunk_size;
+      }
+      std::size_t num_of_tasks = 4 * _pool->size();
+      return std::max<std::size_t>(1, (num_of_indiv + num_of_tasks - 1) / num_of_tasks);
+    }
+
+    OBJ _objective_f; ///< wrapped objective function
+    std::size_t _chunk_size; ///< number of individuals per task
+    std::shared_ptr<thread_pool> _pool; ///< thread pool shared between copies
+  };
+
+  /**
+   * @brief Functor for memoising the fitness of an objective function
+   *
+   * Individuals that survive a generation unchanged (elites, parents that are not
+   * crossed over or mutated) are looked up by a hash of their genes instead of being
+   * evaluated again. Only the rows that are not found in the cache are gathered in one
+   * batch and passed to the wrapped objective. Identical rows within the same
+   * population are evaluated once.
+   *
+   * The cache holds at most capacity individuals and evicts the least recently used
+   * one. As for Evaluate_parallel, the wrapped objective must evaluate every row
+   * independently of the other rows. Copies of the functor share the same cache,
+   * which is guarded by a mutex so they can be called concurrently (e.g. by the
+   * islands of island_ga). The lock is not held while the wrapped objective runs;
+   * an individual missed by two concurrent calls is evaluated by both.
+   *
+   * @tparam OBJ functor type of the objective function
+   * @tparam T value type of the stored genes and fitness
+   */
+  template <class OBJ, class T = double>
+  struct Evaluate_cached
+  {
+    /**
+     * @brief Construct a new Evaluate_cached object
+     *
+     * @param objective_f objective function
+     * @param capacity maximum number of cached individuals
+     */
+    Evaluate_cached(OBJ objective_f, std::size_t capacity = 4096) :
+      _objective_f{ std::move(objective_f) }, _cache{ std::make_shared<cache>(capacity) }
+    {
+
+    }
+
+    /**
+     * @brief operator to evaluate the objective function
+     *
+     * @tparam E xtensor type of the population
+     * @param X population (one individual per row)
+     * @return xt::xtensor<T, 1> fitness of every individual
+     */
+    template <class E>
+    auto operator()(const xt::xexpression<E>& X)
+    {
+      const E& _X = X.derived_cast();
+      cache& _c = *_cache;
+
+      auto shape = _X.shape();
+      std::size_t num_of_indiv = shape[0];
+      std::size_t num_of_vars = shape[1];
+      std::array<std::size_t, 1> shape_y = { num_of_indiv };
+      xt::xtensor<T, 1> y(shape_y);
+
+      std::vector<T> genes(num_of_vars);
+      std::vector<std::size_t> miss_rows;
+      std::vector<std::size_t> miss_hashes;
+      std::vector<std::pair<std::size_t, std::size_t>> duplicates; ///< (row, miss index)
+      std::unordered_map<std::size_t, std::size_t> batch; ///< hash -> miss index
+
+      std::unique_lock<std::mutex> lock(_c.mutex);
+      for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+      {
+        for (std::size_t j{ 0 }; j < num_of_vars; ++j)
+        {
+          genes[j] = static_cast<T>(_X(i, j));
+        }
+        std::size_t h = hash(genes);
+
+        auto found = _c.index.find(h);
+        if (found != _c.index.end() && found->second->genes == genes)
+        {
+          _c.entries.splice(_c.entries.begin(), _c.entries, found->second);
+          y(i) = found->second->fitness;
+          ++_c.hits;
+          continue;
+        }
+
+        auto in_batch = batch.find(h);
+        if (in_batch != batch.end() && same_row(_X, miss_rows[in_batch->second], genes))
+        {
+          duplicates.emplace_back(i, in_batch->second);
+          ++_c.hits;
+          continue;
+        }
+
+        batch[h] = miss_rows.size();
+        miss_rows.push_back(i);
+        miss_hashes.push_back(h);
+      }
+
+      if (miss_rows.empty())
+      {
+        return y;
+      }
+      lock.unlock();
+
+      xt::xtensor<T, 2> X_miss = xt::view(_X, xt::keep(miss_rows), xt::all());
+      auto y_miss = _objective_f(X_miss);
+
+      lock.lock();
+      _c.misses += miss_rows.size();
+
+      for (std::size_t k{ 0 }; k < miss_rows.size(); ++k)
+      {
+        std::size_t i = miss_rows[k];
+        y(i) = static_cast<T>(y_miss(k));
+        for (std::size_t j{ 0 }; j < num_of_vars; ++j)
+        {
+          genes[j] = static_cast<T>(_X(i, j));
+        }
+        insert(miss_hashes[k], genes, y(i));
+      }
+      for (const auto& d : duplicates)
+      {
+        y(d.first) = y(miss_rows[d.second]);
+      }
+
+      return y;
+    }
+
+    /**
+     * @brief number of individuals served from the cache
+     *
+     * @return std::size_t
+     */
+    std::size_t hits() const
+    {
+      std::lock_guard<std::mutex> lock(_cache->mutex);
+      return _cache->hits;
+    }
+
+    /**
+     * @brief number of individuals passed to the wrapped objective
+     *
+     * @return std::size_t
+     */
+    std::size_t misses() const
+    {
+      std::lock_guard<std::mutex> lock(_cache->mutex);
+      return _cache->misses;
+    }
+
+    /**
+     * @brief number of cached individuals
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const
+    {
+      std::lock_guard<std::mutex> lock(_cache->mutex);
+      return _cache->entries.size();
+    }
+
+    /**
+     * @brief remove all cached individuals and reset the counters
+     */
+    void clear()
+    {
+      std::lock_guard<std::mutex> lock(_cache->mutex);
+      _cache->entries.clear();
+      _cache->index.clear();
+      _cache->hits = 0;
+      _cache->misses = 0;
+    }
+
+  private:
+
+    struct entry
+    {
+      std::size_t hash;
+      std::vector<T> genes;
+      T fitness;
+    };
+
+    struct cache
+    {
+      explicit cache(std::size_t c) : capacity{ c }
+      {
+
+      }
+
+      std::size_t capacity;
+      std::list<entry> entries; ///< most recently used first
+      std::unordered_map<std::size_t, typename std::list<entry>::iterator> index;
+      std::size_t hits{ 0 };
+      std::size_t misses{ 0 };
+      std::mutex mutex; ///< guards the entries and the counters
+    };
+
+    /**
+     * @brief FNV-1a hash of the bytes of the genes
+     */
+    static std::size_t hash(const std::vector<T>& genes)
+    {
+      std::uint64_t h = 14695981039346656037ull;
+      for (T g : genes)
+      {
+        if (g == T(0))
+        {
+          g = T(0); // -0.0 and 0.0 hash equally
+        }
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &g, sizeof(T));
+        for (std::size_t b{ 0 }; b < sizeof(T); ++b)
+        {
+          h ^= bytes[b];
+          h *= 1099511628211ull;
+        }
+      }
+      return static_cast<std::size_t>(h);
+    }
+
+    template <class E>
+    static bool same_row(const E& X, std::size_t i, const std::vector<T>& genes)
+    {
+      for (std::size_t j{ 0 }; j < genes.size(); ++j)
+      {
+        if (static_cast<T>(X(i, j)) != genes[j])
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    void insert(std::size_t h, const std::vector<T>& genes, T fitness)
+    {
+      cache& _c = *_cache;
+      if (_c.capacity == 0)
+      {
+        return;
+      }
+
+      auto found = _c.index.find(h);
+      if (found != _c.index.end())
+      {
+        // hash collision with a different individual: replace it
+        found->second->genes = genes;
+        found->second->fitness = fitness;
+        _c.entries.splice(_c.entries.begin(), _c.entries, found->second);
+        return;
+      }
+
+      if (_c.entries.size() >= _c.capacity)
+      {
+        _c.index.erase(_c.entries.back().hash);
+        _c.entries.pop_back();
+      }
+      _c.entries.push_front(entry{ h, genes, fitness });
+      _c.index[h] = _c.entries.begin();
+    }
+
+    OBJ _objective_f; ///< wrapped objective function
+    std::shared_ptr<cache> _cache; ///< cache shared between copies
+  };
+
+}
+
+#endif
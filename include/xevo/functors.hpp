@@ -16,9 +16,15 @@
 #define __FUNCTORS_H__
 
 #include<iostream>
+#include <algorithm>
+#include <array>
+#include <numeric>
 #include <random>
 #include <iterator>
+#include <type_traits>
+#include <vector>
 
+#include "xtensor/xadapt.hpp"
 #include "xtensor/xarray.hpp"
 #include "xtensor/xtensor.hpp"
 #include "xtensor/xview.hpp"
@@ -26,10 +32,105 @@
 #include "xtensor/xsort.hpp"
 #include "xtensor/xio.hpp"
 
+#include "kernels.hpp"
+#include "rng.hpp"
+#include "selection.hpp"
+#include "topology.hpp"
+
 
 namespace xevo
 {
 
+  namespace detail
+  {
+    template <class E, class O>
+    inline bool same_object(const E& X, const O& X_out)
+    {
+      return static_cast<const void*>(&X) == static_cast<const void*>(&X_out);
+    }
+
+    /**
+     * @brief row-major copy of X, for functors working on rows through kernels::row when
+     * X has another layout (see has_row_major_data)
+     */
+    template <class E, typename T = typename std::decay_t<E>::value_type>
+    inline xt::xtensor<T, 2> row_major_copy(const E& X)
+    {
+      return X;
+    }
+
+    /**
+     * @brief copy row i of X to row k of X_out (element-wise, no temporaries)
+     */
+    template <class E, class O>
+    inline void copy_row(const E& X, std::size_t i, O& X_out, std::size_t k)
+    {
+      std::size_t num_of_vars = X.shape()[1];
+      for (std::size_t j{ 0 }; j < num_of_vars; ++j)
+      {
+        X_out(k, j) = X(i, j);
+      }
+    }
+
+    /**
+     * @brief copy the first rows of X to X_out (no-op when both are the same array)
+     */
+    template <class E, class O>
+    inline void copy_rows(const E& X, O& X_out)
+    {
+      if (same_object(X, X_out))
+      {
+        return;
+      }
+      std::size_t num_of_rows = X_out.shape()[0];
+      for (std::size_t i{ 0 }; i < num_of_rows; ++i)
+      {
+        copy_row(X, i, X_out, i);
+      }
+    }
+
+    /**
+     * @brief copy rows indices[0], indices[1], ... of X to rows 0, 1, ... of X_out
+     */
+    template <class E, class O>
+    inline void gather_rows(const E& X, const std::vector<std::size_t>& indices, O& X_out)
+    {
+      for (std::size_t k{ 0 }; k < indices.size(); ++k)
+      {
+        copy_row(X, indices[k], X_out, k);
+      }
+    }
+  }
+
+  /**
+   * @brief non-owning 2-D view over consecutive rows of a row-major population
+   *
+   * Functors that provide output overloads write into a row_block so that the
+   * algorithms can hand them a slice of a preallocated population buffer.
+   */
+  template <class T>
+  using row_block = decltype(xt::adapt(std::declval<T*>(), std::size_t(0), xt::no_ownership(),
+    std::declval<std::array<std::size_t, 2>>()));
+
+  /**
+   * @brief create a row_block over rows [first_row, first_row + num_of_rows) of X
+   *
+   * @tparam E xtensor container type (row-major, contiguous; see has_row_major_data)
+   * @param X population buffer
+   * @param first_row first row of the block
+   * @param num_of_rows number of rows of the block
+   * @return row_block<T>
+   */
+  template <class E, typename T = typename std::decay_t<E>::value_type>
+  inline row_block<T> make_row_block(E& X, std::size_t first_row, std::size_t num_of_rows)
+  {
+    static_assert(has_row_major_data<E>::value, "make_row_block requires a contiguous row-major container");
+    std::size_t num_of_vars = X.shape()[1];
+    std::array<std::size_t, 2> shape = { num_of_rows, num_of_vars };
+    T* first = static_cast<T*>(X.data() + X.data_offset() + first_row * num_of_vars);
+    return xt::adapt(first, num_of_rows * num_of_vars, xt::no_ownership(), shape);
+  }
+
   /**
    * @brief functor for generating initial population
    * 
@@ -64,17 +165,15 @@ namespace xevo
       T lower_limit = 0;
       T upper_limit = 1;
       std::size_t num_of_genes = _X.shape()[0];
-      uint64_t timeSeed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-      std::seed_seq ss{ uint32_t(timeSeed & 0xffffffff), uint32_t(timeSeed >> 32) };
-      std::mt19937_64 rng; // random generator
-      rng.seed(ss);
-      std::uniform_real_distribution<T> unif_dist(lower_limit, upper_limit);
 
-      for (auto i = 0; i < num_of_genes; ++i)
+      for (std::size_t i{ 0 }; i < num_of_genes; ++i)
       {
-        _X(i) = std::roundf(unif_dist(rng) * 100) / 100.0;
+        T u = lower_limit + (upper_limit - lower_limit) * static_cast<T>(uniform01(_gen));
+        _X(i) = std::roundf(u * 100) / 100.0;
       }
     }
+
+    random_engine _gen = make_random_engine(); ///< random engine of the functor
   };
   
   /**
@@ -109,49 +208,50 @@ namespace xevo
 
     }
 
-    template <class E, class F, typename T = typename std::decay_t<E>::value_type>
+    template <class E, class F>
     void operator()(xt::xexpression<E>& X, xt::xexpression<E>& XB,
      xt::xexpression<E>& V, xt::xexpression<F>& YB)
     {
-      E& _X = X.derived_cast();
-      E& _XBest = XB.derived_cast();
-      F& _YB = YB.derived_cast();
-      E& _V = V.derived_cast();
+      update(X.derived_cast(), XB.derived_cast(), V.derived_cast(), YB.derived_cast(), has_row_major_data<E>{});
+    }
+
+    private:
+
+    // other layouts: update a row-major copy of the velocity
+    template <class E, class F>
+    void update(E& X, E& XB, E& V, F& YB, std::false_type)
+    {
+      auto X_rows = detail::row_major_copy(X);
+      auto XB_rows = detail::row_major_copy(XB);
+      auto V_rows = detail::row_major_copy(V);
+      update(X_rows, XB_rows, V_rows, YB, std::true_type{});
+      V = V_rows;
+    }
+
+    template <class E, class F, typename T = typename std::decay_t<E>::value_type>
+    void update(E& _X, E& _XBest, E& _V, F& _YB, std::true_type)
+    {
       auto shape = _X.shape();
-      std::array<std::size_t, 1> shape_rand = { shape[0] };
-      F r1 = xt::random::rand<double>(shape_rand, 0.0, 1.0);
-      F r2 = xt::random::rand<double>(shape_rand, 0.0, 1.0);
+      // r1 = _r[i], r2 = _r[N + i]
+      _r.resize(2 * shape[0]);
+      fill_uniform(_gen, _r.data(), _r.size());
 
-      if (_minimise)
-      {
-        auto index_best = xt::argmin(_YB)();
-        auto gx_best = xt::view(_XBest, index_best, xt::all());
+      std::size_t index_best = _minimise ? xt::argmin(_YB)() : xt::argmax(_YB)();
+      const T* gx_best = kernels::row(_XBest, index_best);
 
-        for (std::size_t i{ 0 }; i < shape[0]; ++i)
-        {
-          xt::view(_V, i, xt::all()) = _w * xt::view(_V, i, xt::all()) + _c1 * r1(i) *
-            (xt::view(_XBest - _X, i, xt::all())) + _c2 * r2(i) * (gx_best - xt::view(_X, i, xt::all()));
-        }
-      }
-      else
+      for (std::size_t i{ 0 }; i < shape[0]; ++i)
       {
-        auto index_best = xt::argmax(_YB)();
-        auto gx_best = xt::view(_XBest, index_best, xt::all());
-
-        for (std::size_t i{ 0 }; i < shape[0]; ++i)
-        {
-          xt::view(_V, i, xt::all()) = _w * xt::view(_V, i, xt::all()) + _c1 * r1(i) *
-            (xt::view(_XBest - _X, i, xt::all())) + _c2 * r2(i) * (gx_best - xt::view(_X, i, xt::all()));
-        }
+        kernels::velocity_update(kernels::row(_V, i), kernels::row(_X, i), kernels::row(_XBest, i), gx_best,
+          shape[1], T(1), T(_w), T(_c1 * _r[i]), T(_c2 * _r[shape[0] + i]));
       }
-
     }
 
-    private:
     double _w;
     double _c1;
     double _c2;
     bool _minimise;
+    random_engine _gen = make_random_engine(); ///< random engine of the functor
+    std::vector<double> _r; ///< scratch: random factors r1 and r2
   };
 
   /**
@@ -171,87 +271,52 @@ namespace xevo
 
     }
 
-    template <class E, class F, typename T = typename std::decay_t<E>::value_type>
+    template <class E, class F>
     void operator()(xt::xexpression<E>& X, xt::xexpression<E>& XB,
      xt::xexpression<E>& V, xt::xexpression<F>& YB)
     {
-      E& _X = X.derived_cast();
-      E& _XBest = XB.derived_cast();
-      F& _YB = YB.derived_cast();
-      E& _V = V.derived_cast();
-      auto shape = _X.shape();
-      std::array<std::size_t, 1> shape_rand = { shape[0] };
-      F r1 = xt::random::rand<double>(shape_rand, 0.0, 1.0);
-      F r2 = xt::random::rand<double>(shape_rand, 0.0, 1.0);
+      update(X.derived_cast(), XB.derived_cast(), V.derived_cast(), YB.derived_cast(), has_row_major_data<E>{});
+    }
 
-      E gX_best(_XBest);
+    private:
 
-      if (_minimise)
-      {
-        for (std::size_t i{ 0 }; i < shape[0]; ++i)
-        {
-          T value_min = _YB(i);
-          for (std::size_t j{ 0 }; j < 2; ++j)
-          {
-            int index = i - 1 + j;
-            if (index == -1)
-            {
-              index = shape[0] - 1;
-            }
-            if (index == shape[0])
-            {
-              index = 0;
-            }
-            T _value = _YB(index);
-            if (_value < value_min)
-            {
-              value_min = _value;
-              xt::view(gX_best, i, xt::all()) = xt::view(_XBest, index, xt::all());
-            }
+    // other layouts: update a row-major copy of the velocity
+    template <class E, class F>
+    void update(E& X, E& XB, E& V, F& YB, std::false_type)
+    {
+      auto X_rows = detail::row_major_copy(X);
+      auto XB_rows = detail::row_major_copy(XB);
+      auto V_rows = detail::row_major_copy(V);
+      update(X_rows, XB_rows, V_rows, YB, std::true_type{});
+      V = V_rows;
+    }
 
-          }
-          xt::view(_V, i, xt::all()) = _w * xt::view(_V, i, xt::all()) + _c1 * r1(i) *
-            (xt::view(_XBest - _X, i, xt::all())) + _c2 * r2(i) * (xt::view(gX_best, i, xt::all()) - xt::view(_X, i, xt::all()));
-        }
-      }
-      else
-      {
-        for (std::size_t i{ 0 }; i < shape[0]; ++i)
-        {
-          T value_max = _YB(i);
-          for (std::size_t j{ 0 }; j < 2; ++j)
-          {
-            int index = i - 1 + j;
-            if (index == -1)
-            {
-              index = shape[0] - 1;
-            }
-            if (index == shape[0])
-            {
-              index = 0;
-            }
-            T _value = _YB(index);
-            if (_value > value_max)
-            {
-              value_max = _value;
-              xt::view(gX_best, i, xt::all()) = xt::view(_XBest, index, xt::all());
-            }
+    template <class E, class F, typename T = typename std::decay_t<E>::value_type>
+    void update(E& _X, E& _XBest, E& _V, F& _YB, std::true_type)
+    {
+      auto shape = _X.shape();
+      // r1 = _r[i], r2 = _r[N + i]
+      _r.resize(2 * shape[0]);
+      fill_uniform(_gen, _r.data(), _r.size());
 
-          }
-          xt::view(_V, i, xt::all()) = _w * xt::view(_V, i, xt::all()) + _c1 * r1(i) *
-            (xt::view(_XBest - _X, i, xt::all())) + _c2 * r2(i) * (xt::view(gX_best, i, xt::all()) - xt::view(_X, i, xt::all()));
-        }
+      // neighbourhood: left neighbour and the particle itself
+      ring_best_indices(_YB, 1, 2, _minimise, _best, _queue);
 
+      for (std::size_t i{ 0 }; i < shape[0]; ++i)
+      {
+        kernels::velocity_update(kernels::row(_V, i), kernels::row(_X, i), kernels::row(_XBest, i),
+          kernels::row(_XBest, _best[i]), shape[1], T(1), T(_w), T(_c1 * _r[i]), T(_c2 * _r[shape[0] + i]));
       }
-
-
     }
 
-    private:
     double _w;
     double _c1;
     double _c2;
     bool _minimise;
+    std::vector<std::size_t> _best; ///< neighbourhood best of every particle
+    std::vector<std::size_t> _queue; ///< scratch for the sliding window
+    random_engine _gen = make_random_engine(); ///< random engine of the functor
+    std::vector<double> _r; ///< scratch: random factors r1 and r2
   };
 
   /**
@@ -270,96 +335,132 @@ namespace xevo
   {
     Velocity_cf_ring_topology(double x, double c1, double c2,
       std::size_t neighborhood_size, bool minimise = true) : _x{ x },
-      _c1{ c1 }, _c2{ c2 }, _neighborhood_size{ neighborhood_size },
+      _c1{ c1 }, _c2{ c2 }, _topology{ neighborhood_size },
       _minimise{ minimise }
     {
 
     }
 
-    template <class E, class F, typename T = typename std::decay_t<E>::value_type>
+    template <class E, class F>
     void operator()(xt::xexpression<E>& X, xt::xexpression<E>& XB,
       xt::xexpression<E>& V, xt::xexpression<F>& YB)
     {
-      E& _X = X.derived_cast();
-      E& _XBest = XB.derived_cast();
-      F& _YB = YB.derived_cast();
-      E& _V = V.derived_cast();
-      auto shape = _X.shape();
-      std::array<std::size_t, 1> shape_rand = { shape[0] };
-      F r1 = xt::random::rand<double>(shape_rand, 0.0, 1.0);
-      F r2 = xt::random::rand<double>(shape_rand, 0.0, 1.0);
+      update(X.derived_cast(), XB.derived_cast(), V.derived_cast(), YB.derived_cast(), has_row_major_data<E>{});
+    }
 
-      E gX_best(_XBest);
+  private:
 
-      std::size_t _side_neighboors = std::ceil(_neighborhood_size / 2);
+    // other layouts: update a row-major copy of the velocity
+    template <class E, class F>
+    void update(E& X, E& XB, E& V, F& YB, std::false_type)
+    {
+      auto X_rows = detail::row_major_copy(X);
+      auto XB_rows = detail::row_major_copy(XB);
+      auto V_rows = detail::row_major_copy(V);
+      update(X_rows, XB_rows, V_rows, YB, std::true_type{});
+      V = V_rows;
+    }
 
-      if (_minimise)
-      {
-        for (std::size_t i{ 0 }; i < shape[0]; ++i)
-        {
-          T value_min = _YB(i);
-          for (std::size_t j{ 0 }; j < _neighborhood_size + 1; ++j)
-          {
-            int index = i - _side_neighboors + j;
-            if (index < 0)
-            {
-              index = shape[0] + index;
-            }
-            if (index >= shape[0])
-            {
-              index = index - shape[0];
-            }
-            T _value = _YB(index);
-            if (_value < value_min)
-            {
-              value_min = _value;
-              xt::view(gX_best, i, xt::all()) = xt::view(_XBest, index, xt::all());
-            }
+    template <class E, class F, typename T = typename std::decay_t<E>::value_type>
+    void update(E& _X, E& _XBest, E& _V, F& _YB, std::true_type)
+    {
+      auto shape = _X.shape();
+      // r1 = _r[i], r2 = _r[N + i]
+      _r.resize(2 * shape[0]);
+      fill_uniform(_gen, _r.data(), _r.size());
 
-          }
-          xt::view(_V, i, xt::all()) = _x * (xt::view(_V, i, xt::all()) + _c1 * r1(i) *
-            (xt::view(_XBest - _X, i, xt::all())) + _c2 * r2(i) * (xt::view(gX_best, i, xt::all()) - xt::view(_X, i, xt::all())));
-        }
-      }
-      else
+      _topology(_YB, _minimise, _best);
+
+      for (std::size_t i{ 0 }; i < shape[0]; ++i)
       {
-        for (std::size_t i{ 0 }; i < shape[0]; ++i)
-        {
-          T value_max = _YB(i);
-          for (std::size_t j{ 0 }; j < _neighborhood_size + 1; ++j)
-          {
-            int index = i - _side_neighboors + j;
-            if (index < 0)
-            {
-              index = shape[0] + index;
-            }
-            if (index >= shape[0])
-            {
-              index = index - shape[0];
-            }
-            T _value = _YB(index);
-            if (_value > value_max)
-            {
-              value_max = _value;
-              xt::view(gX_best, i, xt::all()) = xt::view(_XBest, index, xt::all());
-            }
+        kernels::velocity_update(kernels::row(_V, i), kernels::row(_X, i), kernels::row(_XBest, i),
+          kernels::row(_XBest, _best[i]), shape[1], T(_x), T(1), T(_c1 * _r[i]), T(_c2 * _r[shape[0] + i]));
+      }
+    }
 
-          }
-          xt::view(_V, i, xt::all()) = _x * (xt::view(_V, i, xt::all()) + _c1 * r1(i) *
-            (xt::view(_XBest - _X, i, xt::all())) + _c2 * r2(i) * (xt::view(gX_best, i, xt::all()) - xt::view(_X, i, xt::all())));
-        }
+    double _x;
+    double _c1;
+    double _c2;
+    Topology_ring _topology;
+    bool _minimise;
+    std::vector<std::size_t> _best; ///< neighbourhood best of every particle
+    random_engine _gen = make_random_engine(); ///< random engine of the functor
+    std::vector<double> _r; ///< scratch: random factors r1 and r2
+  };
 
-      }
+  /**
+   * @brief Functor to calculate the velocity with a configurable topology at the next iteration
+   *
+   *  \f[
+   *    V_{ij}^{t+1} = \chi \left( \omega V_{ij}^t + c_1 r_1^t \left( pbestX_{ij} - X_{ij}^t \right) +
+   *                    c_2 r_2^t \left( lbestX_{ij} - X_{ij}^t \right) \right)
+   *  \f]
+   *
+   * where lbestX is the best position within the neighbourhood of particle i given by
+   * the topology (xevo::Topology_ring, xevo::Topology_von_neumann, xevo::Topology_random).
+   *
+   * @tparam TOP topology functor with signature void(const F& YB, bool minimise, std::vector<std::size_t>& best)
+   */
+  template <class TOP>
+  struct Velocity_topology
+  {
+    Velocity_topology(double w, double c1, double c2, TOP topology, bool minimise = true, double x = 1.0) :
+      _w{ w }, _c1{ c1 }, _c2{ c2 }, _x{ x }, _topology{ std::move(topology) }, _minimise{ minimise }
+    {
 
+    }
 
+    template <class E, class F>
+    void operator()(xt::xexpression<E>& X, xt::xexpression<E>& XB,
+      xt::xexpression<E>& V, xt::xexpression<F>& YB)
+    {
+      update(X.derived_cast(), XB.derived_cast(), V.derived_cast(), YB.derived_cast(), has_row_major_data<E>{});
+    }
+
+    TOP& topology()
+    {
+      return _topology;
     }
 
   private:
-    double _x;
+
+    // other layouts: update a row-major copy of the velocity
+    template <class E, class F>
+    void update(E& X, E& XB, E& V, F& YB, std::false_type)
+    {
+      auto X_rows = detail::row_major_copy(X);
+      auto XB_rows = detail::row_major_copy(XB);
+      auto V_rows = detail::row_major_copy(V);
+      update(X_rows, XB_rows, V_rows, YB, std::true_type{});
+      V = V_rows;
+    }
+
+    template <class E, class F, typename T = typename std::decay_t<E>::value_type>
+    void update(E& _X, E& _XBest, E& _V, F& _YB, std::true_type)
+    {
+      auto shape = _X.shape();
+      // r1 = _r[i], r2 = _r[N + i]
+      _r.resize(2 * shape[0]);
+      fill_uniform(_gen, _r.data(), _r.size());
+
+      _topology(_YB, _minimise, _best);
+
+      for (std::size_t i{ 0 }; i < shape[0]; ++i)
+      {
+        kernels::velocity_update(kernels::row(_V, i), kernels::row(_X, i), kernels::row(_XBest, i),
+          kernels::row(_XBest, _best[i]), shape[1], T(_x), T(_w), T(_c1 * _r[i]), T(_c2 * _r[shape[0] + i]));
+      }
+    }
+
+    double _w;
     double _c1;
     double _c2;
-    std::size_t _neighborhood_size;
+    double _x;
+    TOP _topology;
     bool _minimise;
+    std::vector<std::size_t> _best; ///< neighbourhood best of every particle
+    random_engine _gen = make_random_engine(); ///< random engine of the functor
+    std::vector<double> _r; ///< scratch: random factors r1 and r2
   };
 
   /**
@@ -443,96 +544,56 @@ namespace xevo
   struct Position_pso_ga
   {
     Position_pso_ga(double w, double c1, double c2, std::size_t neighborhood_size, bool minimise = false) : _w{ w },
-      _c1{ c1 }, _c2{ c2 }, _neighborhood_size{ neighborhood_size }, _minimise{ minimise }
+      _c1{ c1 }, _c2{ c2 }, _topology{ neighborhood_size }, _minimise{ minimise }
     {
 
     }
 
-    template <class E, class F, typename T = typename std::decay_t<E>::value_type>
+    template <class E, class F>
     void operator()(xt::xexpression<E>& X, xt::xexpression<E>& Xm1,
       xt::xexpression<E>& A, xt::xexpression<F>& YB)
     {
-      E& _X = X.derived_cast();
-      E& _Xm1 = Xm1.derived_cast();
-      F& _YB = YB.derived_cast();
-      E& _A = A.derived_cast();
-      auto shape = _X.shape();
-      std::array<std::size_t, 1> shape_rand = { shape[0] };
-      F r1 = xt::random::rand<double>(shape_rand, 0.0, 1.0);
-      F r2 = xt::random::rand<double>(shape_rand, 0.0, 1.0);
+      update(X.derived_cast(), Xm1.derived_cast(), A.derived_cast(), YB.derived_cast(), has_row_major_data<E>{});
+    }
 
-      std::size_t _side_neighboors = std::ceil(_neighborhood_size / 2);
-      auto gx_best(_A);
+  private:
 
+    // other layouts: update a row-major copy of the position
+    template <class E, class F>
+    void update(E& X, E& Xm1, E& A, F& YB, std::false_type)
+    {
+      auto X_rows = detail::row_major_copy(X);
+      auto Xm1_rows = detail::row_major_copy(Xm1);
+      auto A_rows = detail::row_major_copy(A);
+      update(X_rows, Xm1_rows, A_rows, YB, std::true_type{});
+      X = X_rows;
+    }
 
-      if (_minimise)
-      {
-        for (std::size_t i{ 0 }; i < shape[0]; ++i)
-        {
-          T value_min = _YB(i);
-          for (std::size_t j{ 0 }; j < _neighborhood_size + 1; ++j)
-          {
-            int index = i - _side_neighboors + j;
-            if (index < 0)
-            {
-              index = shape[0] + index;
-            }
-            if (index >= shape[0])
-            {
-              index = index - shape[0];
-            }
-            T _value = _YB(index);
-            if (_value < value_min)
-            {
-              value_min = _value;
-              xt::view(gx_best, i, xt::all()) = xt::view(_A, index, xt::all());
-            }
+    template <class E, class F, typename T = typename std::decay_t<E>::value_type>
+    void update(E& _X, E& _Xm1, E& _A, F& _YB, std::true_type)
+    {
+      auto shape = _X.shape();
+      // r1 = _r[i], r2 = _r[N + i]
+      _r.resize(2 * shape[0]);
+      fill_uniform(_gen, _r.data(), _r.size());
 
-          }
+      _topology(_YB, _minimise, _best);
 
-          xt::view(_X, i, xt::all()) = xt::view(_X, i, xt::all()) +  _w * (xt::view(_X, i, xt::all()) - xt::view(_Xm1, i, xt::all())) +
-            _c1 * r1(i) *(xt::view(_A, i, xt::all()) - xt::view(_X, i, xt::all())) +
-            _c2 * r2(i) * (xt::view(gx_best, i, xt::all())  - xt::view(_X, i, xt::all()));
-        }
-      }
-      else
+      for (std::size_t i{ 0 }; i < shape[0]; ++i)
       {
-
-        for (std::size_t i{ 0 }; i < shape[0]; ++i)
-        {
-          T value_max = _YB(i);
-          for (std::size_t j{ 0 }; j < _neighborhood_size + 1; ++j)
-          {
-            int index = i - _side_neighboors + j;
-            if (index < 0)
-            {
-              index = shape[0] + index;
-            }
-            if (index >= shape[0])
-            {
-              index = index - shape[0];
-            }
-            T _value = _YB(index);
-            if (_value > value_max)
-            {
-              value_max = _value;
-              xt::view(gx_best, i, xt::all()) = xt::view(_A, index, xt::all());
-            }
-
-          }
-          xt::view(_X, i, xt::all()) = xt::view(_X, i, xt::all()) + _w * (xt::view(_X, i, xt::all()) - xt::view(_Xm1, i, xt::all())) +
-            _c1 * r1(i) * (xt::view(_A, i, xt::all()) - xt::view(_X, i, xt::all())) +
-            _c2 * r2(i) * (xt::view(gx_best, i, xt::all())  - xt::view(_X, i, xt::all()));
-        }
+        kernels::position_momentum_update(kernels::row(_X, i), kernels::row(_Xm1, i), kernels::row(_A, i),
+          kernels::row(_A, _best[i]), shape[1], T(_w), T(_c1 * _r[i]), T(_c2 * _r[shape[0] + i]));
       }
     }
 
-  private:
     double _w;
     double _c1;
     double _c2;
-    std::size_t _neighborhood_size;
+    Topology_ring _topology;
     bool _minimise;
+    std::vector<std::size_t> _best; ///< neighbourhood best of every particle
+    random_engine _gen = make_random_engine(); ///< random engine of the functor
+    std::vector<double> _r; ///< scratch: random factors r1 and r2
   };
 
   
@@ -587,67 +648,145 @@ namespace xevo
 
   /**
    * @brief functor to calculate individual selection with Roulette method.
-   * 
+   *
+   * Every draw picks individual i with probability \f$ Y_i / \sum_k Y_k \f$.
+   * The draws use a Walker alias table (xevo::alias_table), which is built in
+   * O(N) once per call, so no sorting of the population is needed and every
+   * draw costs O(1).
    */
   struct Roulette_selection
   {
+    Roulette_selection()
+    {
+
+    }
+
     template <class F, class E, typename T = typename std::decay_t<F>::value_type>
     auto operator()(const xt::xexpression<F>& X, const xt::xexpression<E>& Y)
     {
-      const E& _Y = Y.derived_cast();
       const F& _X = X.derived_cast();
 
-      auto _shape = _Y.shape();
-      std::size_t num_of_individuals = _shape[0];
-      E y_norm(_Y);
-      T _sum = xt::sum(_Y)();
-      E y_args_sort = xt::flip(xt::argsort(_Y), 0);
-      E y_sorted = xt::view(_Y, xt::keep(y_args_sort));
-      F X_sorted = xt::view(_X, xt::keep(y_args_sort), xt::all());
+      F X_out(_X);
+      (*this)(_X, Y, X_out);
+
+      return X_out;
+    }
 
-      for (auto i = 0; i < num_of_individuals; ++i)
+    /**
+     * @brief select X_out.shape()[0] individuals of X and write them to X_out
+     *
+     * @tparam F xtensor type of population
+     * @tparam E xtensor type of fitness
+     * @tparam O xtensor type of output (e.g. a row_block of a population buffer)
+     * @param X population
+     * @param Y fitness of population
+     * @param X_out selected individuals
+     */
+    template <class F, class E, class O>
+    void operator()(const xt::xexpression<F>& X, const xt::xexpression<E>& Y, xt::xexpression<O>& X_out)
+    {
+      const F& _X = X.derived_cast();
+      O& _X_out = X_out.derived_cast();
+
+      std::size_t num_of_draws = _X_out.shape()[0];
+      select_indices(Y, num_of_draws, _indices);
+      for (std::size_t i{ 0 }; i < num_of_draws; ++i)
       {
-        y_norm(i) = y_sorted(i) / _sum;
+        detail::copy_row(_X, _indices[i], _X_out, i);
       }
+    }
 
-      E y_cum_fitness = xt::cumsum(y_norm);
-      
-      std::random_device rd;
-      std::mt19937 gen(rd());
-      T min_value = 0;
-      T max_value = 1;
-      std::uniform_real_distribution<T> distribution(min_value, max_value);
-      
-      F X_out(_X);
-
-      for (std::size_t i{0}; i < num_of_individuals; ++i)
+    /**
+     * @brief draw num_of_draws indices of individuals
+     *
+     * @tparam E xtensor type of fitness
+     * @param Y fitness of population
+     * @param num_of_draws number of selected individuals
+     * @param indices output with the selected indices
+     */
+    template <class E>
+    void select_indices(const xt::xexpression<E>& Y, std::size_t num_of_draws, std::vector<std::size_t>& indices)
+    {
+      _table.build(Y.derived_cast());
+      indices.resize(num_of_draws);
+      for (std::size_t i{ 0 }; i < num_of_draws; ++i)
       {
-        T random_num = distribution(gen);
-        auto iter = std::lower_bound(y_cum_fitness.storage_cbegin(),
-         y_cum_fitness.storage_cend(),
-          random_num);
-        std::size_t dis = 0;
+        indices[i] = _table(_gen);
+      }
+    }
 
-        if (iter == y_cum_fitness.storage_cbegin())
-        {
-          dis = 0;
-        }
-        else if (iter == y_cum_fitness.storage_cend())
-        {
-          dis = std::distance(y_cum_fitness.storage_cbegin(),
-           y_cum_fitness.storage_cend()) - 1;
-        }
-        else
-        {
-          dis = std::distance(y_cum_fitness.storage_cbegin(), iter);
-        }
+  private:
+    random_engine _gen = make_random_engine(); ///< random engine of the functor
+    alias_table<double> _table; ///< alias table rebuilt every call
+    std::vector<std::size_t> _indices; ///< scratch: selected individuals
+  };
 
-        xt::view(X_out, i, xt::all()) = xt::view(X_sorted, dis, xt::all()); 
+  /**
+   * @brief functor to calculate individual selection with stochastic universal sampling.
+   *
+   * Same expected number of copies of every individual as Roulette_selection but with
+   * minimum spread, using a single random number and one sweep over the fitness
+   * (xevo::stochastic_universal_sampling).
+   */
+  struct Stochastic_universal_sampling
+  {
+    Stochastic_universal_sampling()
+    {
 
-      }
+    }
+
+    template <class F, class E, typename T = typename std::decay_t<F>::value_type>
+    auto operator()(const xt::xexpression<F>& X, const xt::xexpression<E>& Y)
+    {
+      const F& _X = X.derived_cast();
+
+      F X_out(_X);
+      (*this)(_X, Y, X_out);
 
       return X_out;
     }
+
+    /**
+     * @brief select X_out.shape()[0] individuals of X and write them to X_out
+     *
+     * @tparam F xtensor type of population
+     * @tparam E xtensor type of fitness
+     * @tparam O xtensor type of output (e.g. a row_block of a population buffer)
+     * @param X population
+     * @param Y fitness of population
+     * @param X_out selected individuals
+     */
+    template <class F, class E, class O>
+    void operator()(const xt::xexpression<F>& X, const xt::xexpression<E>& Y, xt::xexpression<O>& X_out)
+    {
+      const F& _X = X.derived_cast();
+      O& _X_out = X_out.derived_cast();
+
+      std::size_t num_of_draws = _X_out.shape()[0];
+      select_indices(Y, num_of_draws, _indices);
+      for (std::size_t i{ 0 }; i < num_of_draws; ++i)
+      {
+        detail::copy_row(_X, _indices[i], _X_out, i);
+      }
+    }
+
+    /**
+     * @brief draw num_of_draws indices of individuals
+     *
+     * @tparam E xtensor type of fitness
+     * @param Y fitness of population
+     * @param num_of_draws number of selected individuals
+     * @param indices output with the selected indices
+     */
+    template <class E>
+    void select_indices(const xt::xexpression<E>& Y, std::size_t num_of_draws, std::vector<std::size_t>& indices)
+    {
+      stochastic_universal_sampling(Y.derived_cast(), num_of_draws, _gen, indices);
+    }
+
+  private:
+    random_engine _gen = make_random_engine(); ///< random engine of the functor
+    std::vector<std::size_t> _indices; ///< scratch: selected individuals
   };
 
   /**
@@ -682,68 +821,65 @@ namespace xevo
     template <class E,
       typename T = typename std::decay_t<E>::value_type>
       auto operator()(const xt::xexpression<E>& X)->E
+    {
+      E _X_out(X.derived_cast());
+      (*this)(_X_out, _X_out);
+      return _X_out;
+    }
+
+    /**
+     * @brief write the children of X to X_out (X_out may be X itself)
+     *
+     * @tparam E xtensor type of parents
+     * @tparam O xtensor type of children (e.g. a row_block of a population buffer)
+     * @param X parents
+     * @param X_out children
+     */
+    template <class E, class O,
+      typename T = typename std::decay_t<E>::value_type>
+      void operator()(const xt::xexpression<E>& X, xt::xexpression<O>& X_out)
     {
       double alpha = 0.5;
       const E& _X = X.derived_cast();
-      E _X_out(_X);
+      O& _X_out = X_out.derived_cast();
+      detail::copy_rows(_X, _X_out);
 
       auto shape_X = _X.shape();
       std::size_t num_of_indiv = shape_X[0];
       std::size_t num_of_vars = shape_X[1];
-
-      std::array<std::size_t, 1> shape_rand_rc = { num_of_indiv };
-      auto random_rc = xt::random::rand<double>(shape_rand_rc, 0.0, 1.0);
-      std::vector<std::size_t> xover_inds;
-      for (auto i = 0; i < num_of_indiv; ++i)
+      if (num_of_vars == 0)
       {
-        if (random_rc(i) < _crossover_rate)
-        {
-          xover_inds.push_back(i);
-        }
+        return;
       }
 
-      std::size_t xover_size = xover_inds.size();
-      bool is_even = false;
-      if ((xover_size % 2) == 0)
+      _xover_inds.clear();
+      _xover_inds.reserve(num_of_indiv);
+      for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
       {
-        is_even = true;
+        if (uniform01(_gen) < _crossover_rate)
+        {
+          _xover_inds.push_back(i);
+        }
       }
 
-      std::array<std::size_t, 1> shape_rand_var = { xover_size };
-      auto random_index = xt::random::randint<std::size_t>(shape_rand_var, 0,
-        num_of_vars);
-      //auto random_index_x = xt::random::randint<std::size_t>(shape_rand_var, 0,
-      //  xover_size);
-      std::random_device rd;
-      std::mt19937 g(rd());
-
-      std::shuffle(xover_inds.begin(), xover_inds.end(), g);
+      random_shuffle(_xover_inds.begin(), _xover_inds.end(), _gen);
 
-      std::size_t run{ 0 };
-      if (is_even)
+      std::size_t num_of_pairs = _xover_inds.size() / 2;
+      for (std::size_t i{ 0 }; i < num_of_pairs; ++i)
       {
-        run = xover_size;
+        std::size_t x_k_index = _xover_inds[2 * i];
+        std::size_t y_k_index = _xover_inds[2 * i + 1];
+        std::size_t k = uniform_index(_gen, num_of_vars);
+        T x_k = alpha * _X(y_k_index, k) + (1 - alpha) * _X(x_k_index, k);
+        T y_k = alpha * _X(x_k_index, k) + (1 - alpha) * _X(y_k_index, k);
+        _X_out(x_k_index, k) = x_k;
+        _X_out(y_k_index, k) = y_k;
       }
-      else
-      {
-        run = xover_size - 1;
-      }
-      for (std::size_t i{ 0 }; i < (run / 2); ++i)
-      {
-        //std::size_t rd_x = random_index_x(2 * i);
-        //std::size_t rd_y = random_index_x(2 * i + 1);
-        std::size_t x_k_index = xover_inds[2 * i];
-        std::size_t y_k_index = xover_inds[2 * i + 1];
-        T x_k = alpha * _X(y_k_index, random_index(i)) + (1 - alpha) * _X(x_k_index, random_index(i));
-        T y_k = alpha * _X(x_k_index, random_index(i)) + (1 - alpha) * _X(y_k_index, random_index(i));
-        _X_out(x_k_index, random_index(i)) = x_k;
-        _X_out(y_k_index, random_index(i)) = y_k;
-      }
-
-      return _X_out;
     }
   private:
     double _crossover_rate; ///< cross over rate
+    random_engine _gen = make_random_engine(); ///< random engine of the functor
+    std::vector<std::size_t> _xover_inds; ///< scratch: individuals selected for crossover
   };
 
 
@@ -768,7 +904,11 @@ namespace xevo
    *   \bar{\delta_L} = (2u)^{1/(1+ \eta_m)} - 1, for \quad u \leq 0.5, \\
    *   \bar{\delta_R} = 1 - (2(1-u))^{1/(1+\eta_m)}, for \quad u > 0.5
    * \f]
-   * 
+   *
+   * Every gene is mutated with probability mr. The mutation sites are visited by
+   * drawing the geometric gaps between them, so the cost is proportional to the
+   * number of mutated genes (about mr N D) rather than to the size of the population,
+   * and the mutations are computed in batches with kernels::polynomial_mutation.
    */
   struct Mutation_polynomial
   {
@@ -785,50 +925,129 @@ namespace xevo
 
     template <class E, typename T = typename std::decay_t<E>::value_type>
     auto operator()(const xt::xexpression<E>& X)
+    {
+      E out(X.derived_cast());
+      (*this)(out, out);
+      return out;
+    }
+
+    /**
+     * @brief write the mutated X to X_out (X_out may be X itself for in-place mutation)
+     *
+     * The genes are mutated in one pass over the buffer of X_out when it is a contiguous
+     * row-major container (e.g. a row_block of a population buffer, see has_row_major_data),
+     * and on a row-major copy otherwise.
+     *
+     * @tparam E xtensor type of input population
+     * @tparam O xtensor type of output
+     * @param X population
+     * @param X_out mutated population
+     */
+    template <class E, class O>
+    void operator()(const xt::xexpression<E>& X, xt::xexpression<O>& X_out)
     {
       const E& _X = X.derived_cast();
-      E out(_X);
-      auto shape_input = _X.shape();
-      std::size_t total_lenth_of_gen = shape_input[0] * shape_input[1];
-      std::size_t num_mutations = static_cast<std::size_t>(floorl(_mutation_rate * total_lenth_of_gen));
-      std::array<std::size_t, 1> shape = { num_mutations };
-      auto random_num = xt::random::randint<std::size_t>(shape, 1, total_lenth_of_gen);
-
-      std::random_device rd;
-      std::mt19937 gen(rd());
-      std::uniform_real_distribution<T> distribution(0.0, 1.0);
-
-      for (std::size_t i{ 0 }; i < num_mutations; ++i)
+      O& out = X_out.derived_cast();
+      detail::copy_rows(_X, out);
+      mutate_rows(out, has_row_major_data<O>{});
+    }
+
+    /**
+     * @brief mutate the n contiguous genes starting at genes in place
+     *
+     * Every gene is mutated with probability mr. Instead of one uniform number per gene,
+     * the gaps between mutated genes are drawn from the geometric distribution, so the
+     * cost is proportional to the number of mutations. The geometric distribution is
+     * memoryless, so mutating a population row by row (or in blocks, see the fused
+     * crossover functors) has the same distribution as mutating it in one call.
+     *
+     * @tparam T type of genes
+     * @tparam URNG uniform random number generator (random_engine)
+     * @param genes first gene
+     * @param n number of genes
+     * @param gen random engine
+     */
+    template <class T, class URNG>
+    void mutate(T* genes, std::size_t n, URNG& gen) const
+    {
+      if (n == 0 || !(_mutation_rate > 0.0))
       {
-        std::size_t rn = random_num(i);
-        std::size_t num_genes = shape_input[1];
-        std::size_t index_i = (rn / num_genes) - 1;
-        std::size_t index_j = rn - index_i * num_genes - 1;
-        std::array<std::size_t, 1> shape_noise = { 1 };
+        return;
+      }
+
+      T exponent = static_cast<T>(1.0 / (1.0 + _eta_m));
+      // gap = floor(log(1 - u) / log(1 - mr)) ~ Geometric(mr)
+      double inv_log_q = _mutation_rate < 1.0 ? 1.0 / std::log1p(-_mutation_rate) : 0.0;
 
-        T p = _X(index_i, index_j);
-        T p_n{};
-        T u = distribution(gen);
+      constexpr std::size_t batch = 256;
+      double u[batch];
+      std::size_t sites[batch];
+      T values[batch];
+      // gaps drawn per batch: the expected number of sites with some slack
+      std::size_t num_of_gaps = std::min(batch, static_cast<std::size_t>(_mutation_rate * n) + 8);
 
-        if (u <= 0.5)
+      std::size_t position{ 0 };
+      bool done{ false };
+      while (!done)
+      {
+        // draw the gaps of a batch of sites
+        fill_uniform(gen, u, num_of_gaps);
+        for (std::size_t k{ 0 }; k < num_of_gaps; ++k)
         {
-          T delta = pow(2 * u, 1 / (1 + _eta_m)) - 1.0;
-          p_n = p + delta * (p);
+          u[k] = std::floor(std::log1p(-u[k]) * inv_log_q);
         }
-        else
+
+        std::size_t num_of_sites{ 0 };
+        for (std::size_t k{ 0 }; k < num_of_gaps; ++k)
         {
-          T delta = 1 - pow(2 * (1 - u), 1 / (1 + _eta_m));
-          p_n = p + delta * (1.0 - p);
+          if (u[k] >= static_cast<double>(n - position))
+          {
+            done = true;
+            break;
+          }
+          position += static_cast<std::size_t>(u[k]);
+          sites[num_of_sites++] = position++;
+          if (position >= n)
+          {
+            done = true;
+            break;
+          }
         }
 
-        out(index_i, index_j) = p_n;
+        // mutate the batch
+        for (std::size_t k{ 0 }; k < num_of_sites; ++k)
+        {
+          values[k] = genes[sites[k]];
+        }
+        fill_uniform(gen, u, num_of_sites);
+        kernels::polynomial_mutation(values, u, num_of_sites, exponent);
+        for (std::size_t k{ 0 }; k < num_of_sites; ++k)
+        {
+          genes[sites[k]] = values[k];
+        }
       }
-
-      return out;
     }
+
   private:
+
+    template <class O>
+    void mutate_rows(O& out, std::true_type)
+    {
+      mutate(out.data() + out.data_offset(), out.shape()[0] * out.shape()[1], _gen);
+    }
+
+    // other layouts: mutate a row-major copy
+    template <class O>
+    void mutate_rows(O& out, std::false_type)
+    {
+      auto out_rows = detail::row_major_copy(out);
+      mutate_rows(out_rows, std::true_type{});
+      out = out_rows;
+    }
+
     double _mutation_rate; ///< the mutation rate
     double _eta_m; ///< index parameter (usually \f$ \eta_m \in \left[ 20, 100 \right] \f$)
+    random_engine _gen = make_random_engine(); ///< random engine of the functor
   };
 
 
@@ -855,37 +1074,76 @@ namespace xevo
       auto operator()(const xt::xexpression<F>& X, const xt::xexpression<E>& Y)->F
     {
       const F& _X = X.derived_cast();
-      const E& _Y = Y.derived_cast();
 
-      std::vector<std::size_t> indices;
       auto shape = _X.shape();
       std::size_t no_of_indiv = shape[0];
       std::size_t no_of_vars = shape[1];
-      std::size_t no_of_elites = static_cast<std::size_t>(ceil(_elite_rate * no_of_indiv));
-      std::array<std::size_t, 2> shape_out = { no_of_elites, no_of_vars };
+      std::array<std::size_t, 2> shape_out = { elite_size(no_of_indiv), no_of_vars };
       F _X_out = xt::zeros<T>(shape_out);
-      if (_maximise)
-      {
-        auto args = xt::flip(xt::argsort(_Y), 0);
-        for (std::size_t i{ 0 }; i < no_of_elites; ++i)
-        {
-          xt::view(_X_out, i, xt::all()) = xt::view(_X, args(i), xt::all());
-        }
-      }
-      else
-      {
-        auto args = xt::argsort(_Y);
-        for (std::size_t i{ 0 }; i < no_of_elites; ++i)
-        {
-          xt::view(_X_out, i, xt::all()) = xt::view(_X, args(i), xt::all());
-        }
-      }
+
+      (*this)(_X, Y, _X_out);
 
       return _X_out;
     }
+
+    /**
+     * @brief number of elites for a population of no_of_indiv individuals
+     *
+     * @param no_of_indiv number of individuals
+     * @return std::size_t
+     */
+    std::size_t elite_size(std::size_t no_of_indiv) const
+    {
+      return static_cast<std::size_t>(ceil(_elite_rate * no_of_indiv));
+    }
+
+    /**
+     * @brief write the X_out.shape()[0] best individuals of X to X_out
+     *
+     * @tparam E xtensor type of fitness
+     * @tparam F xtensor type of population
+     * @tparam O xtensor type of output (e.g. a row_block of a population buffer)
+     * @param X population
+     * @param Y fitness of population
+     * @param X_out elite individuals, best first
+     */
+    template <class E, class F, class O,
+      typename T = typename std::decay_t<E>::value_type>
+      void operator()(const xt::xexpression<F>& X, const xt::xexpression<E>& Y, xt::xexpression<O>& X_out)
+    {
+      const F& _X = X.derived_cast();
+      const E& _Y = Y.derived_cast();
+      O& _X_out = X_out.derived_cast();
+
+      best_indices(_Y, _X_out.shape()[0], _order);
+      detail::gather_rows(_X, _order, _X_out);
+    }
+
+    /**
+     * @brief indices of the elite_size(N) best individuals, best first
+     *
+     * @tparam E xtensor type of fitness
+     * @param Y fitness of population
+     * @param indices output with the indices of the elites
+     */
+    template <class E>
+    void elite_indices(const xt::xexpression<E>& Y, std::vector<std::size_t>& indices)
+    {
+      const E& _Y = Y.derived_cast();
+      best_indices(_Y, elite_size(_Y.shape()[0]), indices);
+    }
+
   private:
+
+    template <class E>
+    void best_indices(const E& _Y, std::size_t no_of_elites, std::vector<std::size_t>& indices)
+    {
+      top_k_indices(_Y, no_of_elites, _maximise, indices);
+    }
+
     double _elite_rate; ///< elit rate
     bool _maximise;
+    std::vector<std::size_t> _order; ///< scratch: indices of the elites
   };
 
   /**
@@ -928,18 +1186,288 @@ namespace xevo
    */
   struct Terminate_tol
   {
+    /**
+     * @brief Construct a new Terminate_tol object
+     *
+     * @param maximise true when larger fitness is better
+     */
+    Terminate_tol(bool maximise = true) : _maximise{ maximise }
+    {
+
+    }
+
+    /**
+     * @brief best fitness of the population (single O(N) scan)
+     */
     template <class E, class F,
       typename T = typename std::decay_t<E>::value_type>
       T operator()(const xt::xexpression<F>& X, const xt::xexpression<E>& Y)
     {
-      const F& _X = X.derived_cast();
       const E& _Y = Y.derived_cast();
-      T best = _Y(0);
+      top_k_indices(_Y, 1, _maximise, _best);
+      T best = _Y(_best[0]);
       return best;
     }
 
+  private:
+    bool _maximise;
+    std::vector<std::size_t> _best; ///< scratch: index of the best individual
+  };
+
+  template <class... Ts>
+  struct make_void
+  {
+    using type = void;
+  };
+
+  template <class... Ts>
+  using void_t = typename make_void<Ts...>::type;
+
+  /**
+   * @brief trait checking that a selection functor returns indices
+   *  (void SEL::select_indices(Y, std::size_t num_of_draws, std::vector<std::size_t>& indices))
+   */
+  template <class SEL, class Y, class = void>
+  struct has_select_indices : std::false_type
+  {
+  };
+
+  template <class SEL, class Y>
+  struct has_select_indices<SEL, Y, void_t<decltype(std::declval<SEL&>().select_indices(std::declval<const Y&>(),
+    std::size_t(0), std::declval<std::vector<std::size_t>&>()))>> : std::true_type
+  {
+  };
+
+  /**
+   * @brief trait checking that an elitism functor returns indices
+   *  (void ELIT::elite_indices(Y, std::vector<std::size_t>& indices))
+   */
+  template <class ELIT, class Y, class = void>
+  struct has_elite_indices : std::false_type
+  {
+  };
+
+  template <class ELIT, class Y>
+  struct has_elite_indices<ELIT, Y, void_t<decltype(std::declval<ELIT&>().elite_indices(std::declval<const Y&>(),
+    std::declval<std::vector<std::size_t>&>()))>> : std::true_type
+  {
+  };
+
+  /**
+   * @brief trait checking that an elitism functor writes into a row_block
+   */
+  template <class E, class Y, class ELIT, class = void>
+  struct has_elitism_output : std::false_type
+  {
+  };
+
+  template <class E, class Y, class ELIT>
+  struct has_elitism_output<E, Y, ELIT, void_t<
+    decltype(std::declval<ELIT&>().elite_size(std::size_t(0))),
+    decltype(std::declval<ELIT&>()(std::declval<const E&>(), std::declval<const Y&>(),
+      std::declval<row_block<typename E::value_type>&>()))>> : std::true_type
+  {
+  };
+
+  template <class E, class Y, class ELIT, class = void>
+  struct has_elitism_indices_output : std::false_type
+  {
+  };
+
+  template <class E, class Y, class ELIT>
+  struct has_elitism_indices_output<E, Y, ELIT, void_t<
+    decltype(std::declval<ELIT&>().elite_size(std::size_t(0)))>> : has_elite_indices<ELIT, Y>
+  {
+  };
+
+  /**
+   * @brief trait checking that the ga functors can write a generation into preallocated buffers
+   *
+   * True when E is a contiguous row-major container (has_row_major_data), ELIT provides
+   * elite_size() and either elite_indices() or an overload writing into a row_block,
+   * and CROSS and MUT write into a row_block. Any selection functor
+   * qualifies: index returning functors (select_indices) are gathered straight into the
+   * mating buffer, the others go through select_rows. Algorithms use the trait to run
+   * without temporaries, and fall back to the value returning operators otherwise.
+   *
+   * @tparam E xtensor type of population
+   * @tparam Y xtensor type of fitness
+   */
+  template <class E, class Y, class ELIT, class SEL, class CROSS, class MUT, class = void>
+  struct has_output_operators : std::false_type
+  {
+  };
+
+  template <class E, class Y, class ELIT, class SEL, class CROSS, class MUT>
+  struct has_output_operators<E, Y, ELIT, SEL, CROSS, MUT, void_t<
+    std::enable_if_t<has_row_major_data<E>::value>,
+    std::enable_if_t<has_elitism_output<E, Y, ELIT>::value || has_elitism_indices_output<E, Y, ELIT>::value>,
+    decltype(std::declval<CROSS&>()(std::declval<const E&>(), std::declval<row_block<typename E::value_type>&>())),
+    decltype(std::declval<MUT&>()(std::declval<const row_block<typename E::value_type>&>(),
+      std::declval<row_block<typename E::value_type>&>()))>> : std::true_type
+  {
+  };
+
+  namespace detail
+  {
+    template <class SEL, class E, class Y, class O>
+    inline void select_rows(SEL& selection_f, const E& X, const Y& y, O& X_out,
+      std::vector<std::size_t>& indices, std::true_type)
+    {
+      selection_f.select_indices(y, X_out.shape()[0], indices);
+      gather_rows(X, indices, X_out);
+    }
+
+    template <class SEL, class E, class Y, class O>
+    inline auto select_rows_output(SEL& selection_f, const E& X, const Y& y, O& X_out, int)
+      -> decltype(selection_f(X, y, X_out), void())
+    {
+      selection_f(X, y, X_out);
+    }
+
+    template <class SEL, class E, class Y, class O>
+    inline void select_rows_output(SEL& selection_f, const E& X, const Y& y, O& X_out, long)
+    {
+      // value returning functor: keep the last rows as ga::evolve does
+      auto population_selection = selection_f(X, y);
+      std::size_t num_of_rows = X_out.shape()[0];
+      std::size_t first = population_selection.shape()[0] - num_of_rows;
+      for (std::size_t i{ 0 }; i < num_of_rows; ++i)
+      {
+        copy_row(population_selection, first + i, X_out, i);
+      }
+    }
+
+    template <class SEL, class E, class Y, class O>
+    inline void select_rows(SEL& selection_f, const E& X, const Y& y, O& X_out,
+      std::vector<std::size_t>&, std::false_type)
+    {
+      select_rows_output(selection_f, X, y, X_out, 0);
+    }
+
+    template <class ELIT, class E, class Y, class O>
+    inline void elite_rows(ELIT& elite_f, const E& X, const Y& y, O& X_out,
+      std::vector<std::size_t>& indices, std::true_type)
+    {
+      elite_f.elite_indices(y, indices);
+      gather_rows(X, indices, X_out);
+    }
+
+    template <class ELIT, class E, class Y, class O>
+    inline void elite_rows(ELIT& elite_f, const E& X, const Y& y, O& X_out,
+      std::vector<std::size_t>&, std::false_type)
+    {
+      elite_f(X, y, X_out);
+    }
+  }
+
+  /**
+   * @brief write X_out.shape()[0] selected individuals of X into X_out
+   *
+   * Adapter between the ga algorithms and the selection functors. Functors providing
+   * select_indices() are asked for indices, which are gathered once into X_out.
+   * Functors with an output overload write into X_out directly, and value returning
+   * functors are called as in ga::evolve and their last rows are copied.
+   *
+   * @param selection_f selection functor
+   * @param X population
+   * @param y fitness of population
+   * @param X_out mating pool
+   * @param indices scratch for the selected indices
+   */
+  template <class SEL, class E, class Y, class O>
+  inline void select_rows(SEL& selection_f, const E& X, const Y& y, O& X_out, std::vector<std::size_t>& indices)
+  {
+    detail::select_rows(selection_f, X, y, X_out, indices, has_select_indices<SEL, Y>{});
+  }
+
+  /**
+   * @brief write the elites of X into X_out
+   *
+   * Functors providing elite_indices() are asked for indices, which are gathered once
+   * into X_out; otherwise the output overload of the functor is used.
+   *
+   * @param elite_f elitism functor
+   * @param X population
+   * @param y fitness of population
+   * @param X_out elite individuals
+   * @param indices scratch for the elite indices
+   */
+  template <class ELIT, class E, class Y, class O>
+  inline void elite_rows(ELIT& elite_f, const E& X, const Y& y, O& X_out, std::vector<std::size_t>& indices)
+  {
+    detail::elite_rows(elite_f, X, y, X_out, indices, has_elite_indices<ELIT, Y>{});
+  }
+
+  /**
+   * @brief trait checking that MUT mutates a range of genes with a given engine
+   *
+   * Such functors provide mutate(T* genes, std::size_t n, random_engine& gen) const
+   * and can be fused into the crossover pass (see has_fused_variation).
+   */
+  template <class MUT, class T, class = void>
+  struct has_gene_mutation : std::false_type
+  {
+  };
+
+  template <class MUT, class T>
+  struct has_gene_mutation<MUT, T, void_t<decltype(std::declval<const MUT&>().mutate(
+    std::declval<T*>(), std::size_t(0), std::declval<random_engine&>()))>> : std::true_type
+  {
+  };
+
+  /**
+   * @brief trait checking that CROSS applies MUT in its own pass over the children
+   *
+   * True when CROSS provides operator()(X, X_out, mutation_f), which writes every child
+   * once, already mutated, instead of a crossover pass followed by a mutation pass.
+   *
+   * @tparam E xtensor type of the mating pool
+   */
+  template <class E, class CROSS, class MUT, class = void>
+  struct has_fused_variation : std::false_type
+  {
+  };
+
+  template <class E, class CROSS, class MUT>
+  struct has_fused_variation<E, CROSS, MUT, void_t<decltype(std::declval<CROSS&>()(std::declval<const E&>(),
+    std::declval<row_block<typename E::value_type>&>(), std::declval<MUT&>()))>> : std::true_type
+  {
   };
 
+  namespace detail
+  {
+    template <class CROSS, class MUT, class E, class O>
+    inline void vary_rows(CROSS& cross_f, MUT& mutation_f, const E& X, O& X_out, std::true_type)
+    {
+      cross_f(X, X_out, mutation_f);
+    }
+
+    template <class CROSS, class MUT, class E, class O>
+    inline void vary_rows(CROSS& cross_f, MUT& mutation_f, const E& X, O& X_out, std::false_type)
+    {
+      cross_f(X, X_out);
+      mutation_f(X_out, X_out);
+    }
+  }
+
+  /**
+   * @brief write the crossed and mutated children of the mating pool X into X_out
+   *
+   * Uses the fused pass of the crossover functor when available (has_fused_variation),
+   * otherwise crossover into X_out followed by mutation in place.
+   *
+   * @param cross_f crossover functor
+   * @param mutation_f mutation functor
+   * @param X mating pool
+   * @param X_out children
+   */
+  template <class CROSS, class MUT, class E, class O>
+  inline void vary_rows(CROSS& cross_f, MUT& mutation_f, const E& X, O& X_out)
+  {
+    detail::vary_rows(cross_f, mutation_f, X, X_out, has_fused_variation<E, CROSS, MUT>{});
+  }
+
 }
 
 #endif 
\ No newline at end of file
@@ -15,9 +15,14 @@
 #ifndef __GA_HPP__
 #define __GA_HPP__
 
+#include <vector>
+
 #include "xtensor/xtensor.hpp"
 
+#include "ask_tell.hpp"
+#include "crossover.hpp"
 #include "functors.hpp"
+#include "initialisation.hpp"
 
 
 namespace xevo
@@ -185,33 +190,8 @@ namespace xevo
       E& population = X.derived_cast();
       auto y = objective_f(population);
 
-      auto shape_of_population = population.shape();
-      std::size_t individual_size = shape_of_population[0];
-      std::size_t variable_size = shape_of_population[1];
-
-      //selection
-      E population_selection = selection_f(population, y);
-
-      // apply elitism
-      E elite_population = elite_f(population, y);
-      auto shape_of_elitism = elite_population.shape();
-      std::size_t elite_size = shape_of_elitism[0];
-
-      E mating_population = xt::view(population_selection,
-        xt::range(elite_size, individual_size));
-
-      // apply crossover
-      E population_cross = cross_f(mating_population);
-      auto shape_of_cross = population_cross.shape();
-      std::size_t cross_size = shape_of_cross[0];
-
-      // apply mutation
-      E population_mutated = mutation_f(population_cross);
-      auto shape_of_mutation = population_mutated.shape();
-      std::size_t mutation_size = shape_of_mutation[0];
-
-      population = xt::concatenate(xt::xtuple(elite_population,
-        population_mutated), 0);
+      using output_operators = has_output_operators<E, std::decay_t<decltype(y)>, ELIT, SEL, CROSS, MUT>;
+      next_generation(population, y, elite_f, selection_f, cross_f, mutation_f, output_operators{});
     }
 
     /**
@@ -265,39 +245,479 @@ namespace xevo
       E& population = X.derived_cast();
       auto y = objective_f(population);
 
+      using output_operators = has_output_operators<E, std::decay_t<decltype(y)>, ELIT, SEL, CROSS, MUT>;
+      next_generation(population, y, elite_f, selection_f, cross_f, mutation_f, output_operators{});
+
+      return terminate_f(population, objective_f(population));
+    }
+
+
+    /**
+     * @brief replace the population with the next generation
+     *
+     * The elites and the mating pool are gathered once from the population by index
+     * (see elite_rows and select_rows); crossover writes the children next to the
+     * elites and mutation is applied in place, or in the same pass when the
+     * crossover functor fuses it (see vary_rows). Only selected for contiguous
+     * row-major populations (see has_output_operators).
+     */
+    template<class E, class Y, class ELIT, class SEL, class CROSS, class MUT,
+      typename T = typename std::decay_t<E>::value_type>
+      void next_generation(E& population, const Y& y, ELIT& elite_f, SEL& selection_f, CROSS& cross_f,
+        MUT& mutation_f, std::true_type)
+    {
       auto shape_of_population = population.shape();
       std::size_t individual_size = shape_of_population[0];
-      std::size_t variable_size = shape_of_population[1];
+      std::size_t elite_size = std::min<std::size_t>(elite_f.elite_size(individual_size), individual_size);
+
+      std::array<std::size_t, 2> shape_offspring = { individual_size, shape_of_population[1] };
+      std::array<std::size_t, 2> shape_mating = { individual_size - elite_size, shape_of_population[1] };
+      E offspring = xt::empty<T>(shape_offspring);
+      E mating_population = xt::empty<T>(shape_mating);
+      std::vector<std::size_t> indices;
+
+      auto elite_population = make_row_block(offspring, 0, elite_size);
+      auto child_population = make_row_block(offspring, elite_size, individual_size - elite_size);
+
+      // apply elitism
+      elite_rows(elite_f, population, y, elite_population, indices);
+
+      //selection
+      select_rows(selection_f, population, y, mating_population, indices);
+
+      // apply crossover and mutation (a single pass when the functors are fused)
+      vary_rows(cross_f, mutation_f, mating_population, child_population);
+
+      population = std::move(offspring);
+    }
+
+    /**
+     * @brief replace the population with the next generation using the value returning operators
+     */
+    template<class E, class Y, class ELIT, class SEL, class CROSS, class MUT>
+    void next_generation(E& population, const Y& y, ELIT& elite_f, SEL& selection_f, CROSS& cross_f,
+      MUT& mutation_f, std::false_type)
+    {
+      std::size_t individual_size = population.shape()[0];
 
       //selection
       E population_selection = selection_f(population, y);
 
       // apply elitism
       E elite_population = elite_f(population, y);
-      auto shape_of_elitism = elite_population.shape();
-      std::size_t elite_size = shape_of_elitism[0];
+      std::size_t elite_size = elite_population.shape()[0];
 
       E mating_population = xt::view(population_selection,
         xt::range(elite_size, individual_size));
 
       // apply crossover
       E population_cross = cross_f(mating_population);
-      auto shape_of_cross = population_cross.shape();
-      std::size_t cross_size = shape_of_cross[0];
 
       // apply mutation
       E population_mutated = mutation_f(population_cross);
-      auto shape_of_mutation = population_mutated.shape();
-      std::size_t mutation_size = shape_of_mutation[0];
 
       population = xt::concatenate(xt::xtuple(elite_population,
         population_mutated), 0);
+    }
+
+  };
+
+  /**
+   * @brief stateful genetic algorithm solver
+   *
+   * In contrast to ga::evolve, which is stateless and evaluates the population at the
+   * beginning of every call (and again for the termination functor), ga_state keeps
+   * the population, its fitness, the functor instances and the generation counter
+   * between generations. Every individual is evaluated exactly once per generation.
+   *
+   * The population lives in two preallocated buffers that are swapped every
+   * generation. When the functors provide output overloads (see has_output_operators;
+   * the default functors do) elitism, selection, crossover and mutation write straight
+   * into the buffers and a steady-state generation performs no heap allocation apart
+   * from the ones made by the objective function. Elitism and selection functors that
+   * return indices (elite_indices, select_indices) are gathered once, straight into the
+   * offspring and the mating buffer. Otherwise the value returning operators are used
+   * as in ga::evolve. The buffers are only written through row blocks when E is a
+   * contiguous row-major container (has_row_major_data); other layouts also take the
+   * value returning path.
+   *
+   * @tparam E xtensor type of the population
+   * @tparam OBJ functor for objective function
+   * @tparam ELIT functor for elitism
+   * @tparam SEL functor for selection
+   * @tparam CROSS functor for crossover
+   * @tparam MUT functor for mutation
+   */
+  template<class E, class OBJ, class ELIT = Elitism, class SEL = Roulette_selection, class CROSS = Crossover,
+    class MUT = Mutation_polynomial>
+  class ga_state
+  {
+  public:
+
+    using value_type = typename std::decay_t<E>::value_type;
+    using fitness_type = xt::xtensor<value_type, 1>;
+    using output_operators = has_output_operators<E, fitness_type, ELIT, SEL, CROSS, MUT>;
+
+    /**
+     * @brief Construct a new ga_state object
+     *
+     * @param X initial population
+     * @param objective_f objective function
+     * @param elite_f functor for elitism
+     * @param selection_f functor for selection
+     * @param cross_f functor for crossover
+     * @param mutation_f functor for mutation
+     */
+    ga_state(const E& X, OBJ objective_f, ELIT elite_f, SEL selection_f, CROSS cross_f, MUT mutation_f) :
+      _populations{ { X, X } }, _objective_f{ std::move(objective_f) }, _elite_f{ std::move(elite_f) },
+      _selection_f{ std::move(selection_f) }, _cross_f{ std::move(cross_f) }, _mutation_f{ std::move(mutation_f) }
+    {
+      allocate(output_operators{});
+    }
+
+    /**
+     * @brief evolve the population by one generation
+     *
+     * The fitness of the current population is reused from the previous generation;
+     * only the new population is evaluated.
+     */
+    void step()
+    {
+      if (!_evaluated)
+      {
+        evaluate();
+      }
+
+      advance();
+      evaluate();
+    }
+
+    /**
+     * @brief evolve the population by one generation and apply a terminating functor
+     *
+     * @tparam TERM functor for termination
+     * @param terminate_f terminating functor
+     * @return auto type from terminating functor, evaluated with the stored fitness
+     */
+    template<class TERM>
+    auto step(TERM terminate_f)
+    {
+      step();
+      return terminate_f(population(), _y);
+    }
+
+    /**
+     * @brief evolve the population for a number of generations
+     *
+     * @param generations number of generations
+     */
+    void run(std::size_t generations)
+    {
+      for (std::size_t i{ 0 }; i < generations; ++i)
+      {
+        step();
+      }
+    }
+
+    /**
+     * @brief hand out up to max_rows individuals of the current generation for evaluation
+     *
+     * Ask/tell interface for objectives evaluated outside the solver (construct it with
+     * No_objective). The first call hands out the initial population; the first call
+     * after the fitness of a whole generation has been told breeds the next one. The
+     * batch is a view of the population buffer; an empty batch means that every
+     * individual of the generation is out and results are pending.
+     *
+     * @param max_rows maximum number of individuals
+     * @return ask_batch<value_type>
+     */
+    ask_batch<value_type> ask(std::size_t max_rows = std::numeric_limits<std::size_t>::max())
+    {
+      if (!_tracker.collecting())
+      {
+        if (_evaluated)
+        {
+          advance();
+        }
+        std::size_t individual_size = _populations[_current].shape()[0];
+        std::array<std::size_t, 1> shape_y = { individual_size };
+        _y.resize(shape_y);
+        _tracker.start(individual_size);
+      }
+      std::size_t first;
+      std::size_t num_of_rows = _tracker.hand_out(max_rows, first);
+      return ask_batch<value_type>(_generation, first, num_of_rows,
+        make_row_block(_populations[_current], first, num_of_rows));
+    }
+
+    /**
+     * @brief pass back the fitness of an individual handed out by ask()
+     *
+     * Results can be told in any order; the generation is complete (and fitness() is
+     * available) when every individual has been told.
+     *
+     * @param i row of the individual in the generation (ask_batch::indices)
+     * @param y fitness of the individual
+     */
+    void tell(std::size_t i, value_type y)
+    {
+      bool complete = _tracker.tell(i);
+      _y(i) = y;
+      ++_evaluations;
+      _evaluated = complete;
+    }
+
+    /**
+     * @brief pass back the fitness of several individuals handed out by ask()
+     *
+     * @tparam G container type of the fitness (indexed with [])
+     * @param indices rows of the individuals in the generation
+     * @param y fitness of the individuals, in the order of indices
+     */
+    template <class G>
+    void tell(const std::vector<std::size_t>& indices, const G& y)
+    {
+      for (std::size_t k{ 0 }; k < indices.size(); ++k)
+      {
+        tell(indices[k], value_type(y[k]));
+      }
+    }
+
+    /**
+     * @brief number of individuals handed out by ask() whose fitness has not been told
+     *
+     * @return std::size_t
+     */
+    std::size_t outstanding() const
+    {
+      return _tracker.outstanding();
+    }
+
+    /**
+     * @brief current population
+     *
+     * @return const E&
+     */
+    const E& population() const
+    {
+      return _populations[_current];
+    }
+
+    /**
+     * @brief fitness of the current population (evaluated on first access)
+     *
+     * @return const fitness_type&
+     */
+    const fitness_type& fitness()
+    {
+      if (!_evaluated)
+      {
+        evaluate();
+      }
+      return _y;
+    }
+
+    /**
+     * @brief replace individual i of the current population with row k of X
+     *
+     * Used to insert individuals of unknown fitness. The population is evaluated again
+     * before the next generation, so objective functions scaled by the population (e.g.
+     * Rosenbrock_scaled) stay consistent.
+     *
+     * @tparam F xtensor type of X
+     * @param i index of the replaced individual
+     * @param X individuals
+     * @param k row of X
+     */
+    template <class F>
+    void replace(std::size_t i, const F& X, std::size_t k)
+    {
+      detail::copy_row(X, k, _populations[_current], i);
+      _evaluated = false;
+    }
+
+    /**
+     * @brief replace individual i of the current population with row k of X of known fitness
+     *
+     * Used to insert migrants together with the fitness computed by the sending island
+     * (see island_ga), so the population is not evaluated again. The fitness values of
+     * different populations are compared directly, which requires an objective function
+     * that is not scaled by the population.
+     *
+     * @tparam F xtensor type of X
+     * @param i index of the replaced individual
+     * @param X individuals
+     * @param k row of X
+     * @param y fitness of row k of X
+     */
+    template <class F>
+    void replace(std::size_t i, const F& X, std::size_t k, value_type y)
+    {
+      detail::copy_row(X, k, _populations[_current], i);
+      if (_evaluated)
+      {
+        _y(i) = y;
+      }
+    }
+
+    /**
+     * @brief number of generations evolved so far
+     *
+     * @return std::size_t
+     */
+    std::size_t generation() const
+    {
+      return _generation;
+    }
+
+    /**
+     * @brief number of individuals passed to the objective function so far
+     *
+     * @return std::size_t
+     */
+    std::size_t evaluations() const
+    {
+      return _evaluations;
+    }
+
+  private:
+
+    void allocate(std::true_type)
+    {
+      auto shape = _populations[0].shape();
+      std::size_t elite_size = std::min<std::size_t>(_elite_f.elite_size(shape[0]), shape[0]);
+      std::array<std::size_t, 2> shape_mating = { shape[0] - elite_size, shape[1] };
+      _mating = xt::zeros<value_type>(shape_mating);
+    }
+
+    void allocate(std::false_type)
+    {
 
-      return terminate_f(population, objective_f(population));
     }
 
+    /**
+     * @brief write the next generation into the spare buffer using the output overloads
+     */
+    void next_generation(std::true_type)
+    {
+      const E& population = _populations[_current];
+      E& offspring = _populations[1 - _current];
+
+      std::size_t individual_size = population.shape()[0];
+      std::size_t elite_size = individual_size - _mating.shape()[0];
+
+      auto elite_population = make_row_block(offspring, 0, elite_size);
+      auto child_population = make_row_block(offspring, elite_size, individual_size - elite_size);
+
+      // apply elitism
+      elite_rows(_elite_f, population, _y, elite_population, _indices);
+
+      // selection of the mating pool (single gather into the crossover input)
+      select_rows(_selection_f, population, _y, _mating, _indices);
+
+      // apply crossover and mutation (a single pass when the functors are fused)
+      vary_rows(_cross_f, _mutation_f, _mating, child_population);
+    }
+
+    /**
+     * @brief compute the next generation with the value returning operators
+     */
+    void next_generation(std::false_type)
+    {
+      const E& population = _populations[_current];
+      std::size_t individual_size = population.shape()[0];
+
+      //selection
+      E population_selection = _selection_f(population, _y);
+
+      // apply elitism
+      E elite_population = _elite_f(population, _y);
+      std::size_t elite_size = elite_population.shape()[0];
+
+      E mating_population = xt::view(population_selection,
+        xt::range(elite_size, individual_size));
+
+      // apply crossover
+      E population_cross = _cross_f(mating_population);
+
+      // apply mutation
+      E population_mutated = _mutation_f(population_cross);
+
+      _populations[1 - _current] = xt::concatenate(xt::xtuple(elite_population,
+        population_mutated), 0);
+    }
+
+    /**
+     * @brief replace the population with the next generation (not evaluated yet)
+     */
+    void advance()
+    {
+      next_generation(output_operators{});
+      _current = 1 - _current;
+      _evaluated = false;
+      ++_generation;
+    }
+
+    void evaluate()
+    {
+      const E& population = _populations[_current];
+      std::size_t individual_size = population.shape()[0];
+      auto&& y = _objective_f(population);
+
+      if (_y.size() != individual_size)
+      {
+        std::array<std::size_t, 1> shape_y = { individual_size };
+        _y.resize(shape_y);
+      }
+      for (std::size_t i{ 0 }; i < individual_size; ++i)
+      {
+        _y(i) = y(i);
+      }
+
+      _evaluations += individual_size;
+      _evaluated = true;
+    }
+
+    std::array<E, 2> _populations; ///< current and next population
+    std::size_t _current{ 0 }; ///< index of the current population
+    E _mating; ///< mating pool (used with output overloads)
+    std::vector<std::size_t> _indices; ///< scratch for elite and selection indices
+    fitness_type _y; ///< fitness of the current population
+    OBJ _objective_f;
+    ELIT _elite_f;
+    SEL _selection_f;
+    CROSS _cross_f;
+    MUT _mutation_f;
+    std::size_t _generation{ 0 };
+    std::size_t _evaluations{ 0 };
+    bool _evaluated{ false };
+    ask_tell_tracker _tracker; ///< individuals handed out by ask()
   };
 
+  /**
+   * @brief helper to construct a ga_state with deduced functor types
+   *
+   * @tparam E xtensor type of the population
+   * @tparam OBJ functor for objective function
+   * @tparam ELIT functor for elitism
+   * @tparam SEL functor for selection
+   * @tparam CROSS functor for crossover
+   * @tparam MUT functor for mutation
+   * @param X initial population
+   * @param objective_f objective function
+   * @param elite_f functor for elitism
+   * @param selection_f functor for selection
+   * @param cross_f functor for crossover
+   * @param mutation_f functor for mutation
+   * @return ga_state<E, OBJ, ELIT, SEL, CROSS, MUT>
+   */
+  template<class E, class OBJ, class ELIT, class SEL, class CROSS, class MUT>
+  auto make_ga_state(const E& X, OBJ objective_f, ELIT elite_f, SEL selection_f, CROSS cross_f, MUT mutation_f)
+  {
+    return ga_state<E, OBJ, ELIT, SEL, CROSS, MUT>(X, std::move(objective_f), std::move(elite_f),
+      std::move(selection_f), std::move(cross_f), std::move(mutation_f));
+  }
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,549 @@
+/**
+ * @file initialisation.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief templated header file with functors generating the initial population
+ *  (Sobol, Halton, Latin hypercube and uniform).
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __INITIALISATION_HPP__
+#define __INITIALISATION_HPP__
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+
+#include "kernels.hpp"
+#include "rng.hpp"
+#include "thread_pool.hpp"
+
+
+namespace xevo
+{
+
+  namespace detail
+  {
+    /**
+     * @brief call generate(X), or generate a row-major population and copy it to X when X
+     * is not a contiguous row-major container (see has_row_major_data)
+     */
+    template <class E, class GEN>
+    inline void generate_rows(E& X, GEN&& generate, std::true_type)
+    {
+      generate(X);
+    }
+
+    template <class E, class GEN, typename T = typename std::decay_t<E>::value_type>
+    inline void generate_rows(E& X, GEN&& generate, std::false_type)
+    {
+      std::array<std::size_t, 2> shape = { X.shape()[0], X.shape()[1] };
+      xt::xtensor<T, 2> X_rows(shape);
+      generate(X_rows);
+      X = X_rows;
+    }
+
+    /**
+     * @brief centre of the cell of x on a grid of 2^bits cells in [0, 1)
+     */
+    template <class T>
+    inline T quantise(double x, double cells)
+    {
+      double k = std::min(std::floor(x * cells), cells - 1.0);
+      return static_cast<T>((k + 0.5) / cells);
+    }
+
+    /**
+     * @brief product of the polynomials a and b over GF(2) modulo p of degree s
+     */
+    inline std::uint64_t gf2_mulmod(std::uint64_t a, std::uint64_t b, std::uint64_t p, unsigned s)
+    {
+      std::uint64_t r{ 0 };
+      while (b != 0)
+      {
+        if (b & 1u)
+        {
+          r ^= a;
+        }
+        b >>= 1;
+        a <<= 1;
+        if ((a >> s) & 1u)
+        {
+          a ^= p;
+        }
+      }
+      return r;
+    }
+
+    /**
+     * @brief x^e modulo p of degree s over GF(2)
+     */
+    inline std::uint64_t gf2_powmod_x(std::uint64_t e, std::uint64_t p, unsigned s)
+    {
+      std::uint64_t base = s > 1 ? 2u : (2u ^ p);
+      std::uint64_t r{ 1 };
+      while (e != 0)
+      {
+        if (e & 1u)
+        {
+          r = gf2_mulmod(r, base, p, s);
+        }
+        base = gf2_mulmod(base, base, p, s);
+        e >>= 1;
+      }
+      return r;
+    }
+
+    /**
+     * @brief Sobol direction numbers of the first num_of_dims dimensions
+     *
+     * Dimension 0 is the van der Corput sequence. Dimension j > 0 uses the j-th primitive
+     * polynomial over GF(2) (by degree, then by coefficients), found by checking that x
+     * has order 2^s - 1, and odd initial direction numbers m_k < 2^k drawn from a fixed
+     * Philox stream, so the sequence is the same on every platform and run.
+     *
+     * @param num_of_dims number of dimensions
+     * @param v output with 32 direction numbers per dimension
+     */
+    inline void sobol_direction_numbers(std::size_t num_of_dims, std::vector<std::uint32_t>& v)
+    {
+      v.assign(32 * num_of_dims, 0u);
+      for (unsigned k{ 0 }; k < 32 && num_of_dims > 0; ++k)
+      {
+        v[k] = std::uint32_t(1) << (31 - k);
+      }
+
+      std::size_t dim{ 1 };
+      for (unsigned s{ 1 }; dim < num_of_dims && s < 32; ++s)
+      {
+        // prime factors of the order 2^s - 1 of the multiplicative group
+        std::uint64_t order = (std::uint64_t(1) << s) - 1;
+        std::vector<std::uint64_t> factors;
+        std::uint64_t rest = order;
+        for (std::uint64_t q{ 2 }; q * q <= rest; ++q)
+        {
+          if (rest % q == 0)
+          {
+            factors.push_back(q);
+            while (rest % q == 0)
+            {
+              rest /= q;
+            }
+          }
+        }
+        if (rest > 1)
+        {
+          factors.push_back(rest);
+        }
+
+        for (std::uint64_t p = (std::uint64_t(1) << s) | 1u; dim < num_of_dims && p < (std::uint64_t(1) << (s + 1));
+          p += 2)
+        {
+          bool primitive = gf2_powmod_x(order, p, s) == 1u;
+          for (std::size_t f{ 0 }; primitive && f < factors.size(); ++f)
+          {
+            primitive = gf2_powmod_x(order / factors[f], p, s) != 1u;
+          }
+          if (!primitive)
+          {
+            continue;
+          }
+
+          std::uint32_t* vd = v.data() + 32 * dim;
+          philox4x32 gen(0x736f626f6cu, dim);
+          for (unsigned k{ 1 }; k <= s && k <= 32; ++k)
+          {
+            std::uint32_t m = 2u * static_cast<std::uint32_t>(uniform_index(gen, std::size_t(1) << (k - 1))) + 1u;
+            vd[k - 1] = m << (32 - k);
+          }
+          for (unsigned k = s + 1; k <= 32; ++k)
+          {
+            std::uint32_t w = vd[k - s - 1] ^ (vd[k - s - 1] >> s);
+            for (unsigned i{ 1 }; i < s; ++i)
+            {
+              if ((p >> (s - i)) & 1u)
+              {
+                w ^= vd[k - i - 1];
+              }
+            }
+            vd[k - 1] = w;
+          }
+          ++dim;
+        }
+      }
+    }
+
+    /**
+     * @brief the first n prime numbers
+     */
+    inline void first_primes(std::size_t n, std::vector<std::uint32_t>& primes)
+    {
+      primes.clear();
+      for (std::uint32_t c{ 2 }; primes.size() < n; ++c)
+      {
+        bool prime{ true };
+        for (std::size_t i{ 0 }; i < primes.size() && primes[i] * primes[i] <= c; ++i)
+        {
+          if (c % primes[i] == 0)
+          {
+            prime = false;
+            break;
+          }
+        }
+        if (prime)
+        {
+          primes.push_back(c);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Functor generating the initial population from a Sobol sequence
+   *
+   * Individual i is the point i of the Sobol sequence in D dimensions, with genes
+   * quantised to the centres of 2^bits cells in [0, 1). With scrambling (default) every
+   * call applies a random digital shift per dimension, which keeps the low discrepancy
+   * of the point set and removes the point at the origin. The rows are generated in
+   * parallel chunks when a thread pool is given: the first point of a chunk is computed
+   * directly from its index and the rest with the Gray code recurrence.
+   *
+   * I. M. Sobol, On the distribution of points in a cube and the approximate evaluation
+   * of integrals, USSR Computational Mathematics and Mathematical Physics, vol. 7, no. 4,
+   * pp. 86-112, 1967.
+   */
+  struct Population_sobol
+  {
+    /**
+     * @brief Construct a new Population_sobol object
+     *
+     * @param bits resolution of the genes (1 to 32 bits)
+     * @param scramble apply a random digital shift per dimension
+     * @param pool thread pool for generating the rows in parallel (nullptr for serial)
+     */
+    explicit Population_sobol(unsigned bits = 32, bool scramble = true, std::shared_ptr<thread_pool> pool = nullptr) :
+      _bits{ std::min(std::max(bits, 1u), 32u) }, _scramble{ scramble }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    template <class E>
+    void operator()(xt::xexpression<E>& X)
+    {
+      detail::generate_rows(X.derived_cast(), [this](auto& X_rows) { generate(X_rows); }, has_row_major_data<E>{});
+    }
+
+  private:
+
+    template <class E, typename T = typename std::decay_t<E>::value_type>
+    void generate(E& _X)
+    {
+      std::size_t num_of_indiv = _X.shape()[0];
+      std::size_t num_of_vars = _X.shape()[1];
+
+      if (_directions.size() != 32 * num_of_vars)
+      {
+        detail::sobol_direction_numbers(num_of_vars, _directions);
+      }
+
+      std::vector<std::uint32_t> shift(num_of_vars, 0u);
+      if (_scramble)
+      {
+        random_engine gen = _rng.stream(_calls++, 0);
+        for (auto& s : shift)
+        {
+          s = gen();
+        }
+      }
+
+      double cells = std::ldexp(1.0, static_cast<int>(_bits));
+      unsigned drop = 32 - _bits;
+      const std::uint32_t* v = _directions.data();
+
+      parallel_for_chunks(_pool.get(), num_of_indiv, [&](std::size_t first, std::size_t last)
+      {
+        std::vector<std::uint32_t> x(shift);
+        std::uint64_t gray = std::uint64_t(first) ^ (std::uint64_t(first) >> 1);
+        for (unsigned k{ 0 }; k < 32; ++k)
+        {
+          if ((gray >> k) & 1u)
+          {
+            for (std::size_t j{ 0 }; j < num_of_vars; ++j)
+            {
+              x[j] ^= v[32 * j + k];
+            }
+          }
+        }
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+          T* genes = kernels::row(_X, i);
+          for (std::size_t j{ 0 }; j < num_of_vars; ++j)
+          {
+            genes[j] = static_cast<T>((double(x[j] >> drop) + 0.5) / cells);
+          }
+
+          // Gray code: the next point flips the direction of the lowest zero bit of i
+          unsigned c{ 0 };
+          while ((i >> c) & 1u)
+          {
+            ++c;
+          }
+          for (std::size_t j{ 0 }; c < 32 && j < num_of_vars; ++j)
+          {
+            x[j] ^= v[32 * j + c];
+          }
+        }
+      });
+    }
+
+    unsigned _bits; ///< resolution of the genes
+    bool _scramble; ///< random digital shift
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    std::vector<std::uint32_t> _directions; ///< direction numbers (32 per dimension)
+    rng _rng; ///< random number service of the functor
+    std::uint64_t _calls{ 0 }; ///< number of calls (substream of the random numbers)
+  };
+
+  /**
+   * @brief Functor generating the initial population from a Halton sequence
+   *
+   * Gene j of individual i is the radical inverse of i in the base of the j-th prime,
+   * quantised to the centres of 2^bits cells in [0, 1). With scrambling (default) every
+   * call draws a random linear digit scrambling d -> (a d + c) mod b per dimension, which
+   * breaks the correlation between the dimensions with large bases.
+   *
+   * J. H. Halton, On the efficiency of certain quasi-random sequences of points in evaluating
+   * multi-dimensional integrals, Numerische Mathematik, vol. 2, pp. 84-90, 1960.
+   */
+  struct Population_halton
+  {
+    /**
+     * @brief Construct a new Population_halton object
+     *
+     * @param bits resolution of the genes (1 to 32 bits)
+     * @param scramble apply a random linear digit scrambling per dimension
+     * @param pool thread pool for generating the rows in parallel (nullptr for serial)
+     */
+    explicit Population_halton(unsigned bits = 32, bool scramble = true, std::shared_ptr<thread_pool> pool = nullptr) :
+      _bits{ std::min(std::max(bits, 1u), 32u) }, _scramble{ scramble }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    template <class E>
+    void operator()(xt::xexpression<E>& X)
+    {
+      detail::generate_rows(X.derived_cast(), [this](auto& X_rows) { generate(X_rows); }, has_row_major_data<E>{});
+    }
+
+  private:
+
+    template <class E, typename T = typename std::decay_t<E>::value_type>
+    void generate(E& _X)
+    {
+      std::size_t num_of_indiv = _X.shape()[0];
+      std::size_t num_of_vars = _X.shape()[1];
+
+      if (_primes.size() != num_of_vars)
+      {
+        detail::first_primes(num_of_vars, _primes);
+      }
+
+      // digits needed to resolve 2^bits cells, and the scrambling of every dimension
+      double cells = std::ldexp(1.0, static_cast<int>(_bits));
+      std::vector<unsigned> num_of_digits(num_of_vars);
+      std::vector<std::uint32_t> a(num_of_vars, 1u);
+      std::vector<std::uint32_t> c(num_of_vars, 0u);
+      random_engine gen = _rng.stream(_calls++, 0);
+      for (std::size_t j{ 0 }; j < num_of_vars; ++j)
+      {
+        std::uint32_t b = _primes[j];
+        num_of_digits[j] = static_cast<unsigned>(std::ceil(_bits * std::log(2.0) / std::log(double(b))));
+        if (_scramble)
+        {
+          a[j] = 1u + static_cast<std::uint32_t>(uniform_index(gen, b - 1));
+          c[j] = static_cast<std::uint32_t>(uniform_index(gen, b));
+        }
+      }
+
+      parallel_for_chunks(_pool.get(), num_of_indiv, [&](std::size_t first, std::size_t last)
+      {
+        for (std::size_t i = first; i < last; ++i)
+        {
+          T* genes = kernels::row(_X, i);
+          for (std::size_t j{ 0 }; j < num_of_vars; ++j)
+          {
+            std::uint64_t b = _primes[j];
+            std::uint64_t n = i;
+            double inv_b = 1.0 / double(b);
+            double scale = inv_b;
+            double x{ 0.0 };
+            for (unsigned k{ 0 }; k < num_of_digits[j]; ++k)
+            {
+              std::uint64_t d = (a[j] * (n % b) + c[j]) % b;
+              x += double(d) * scale;
+              scale *= inv_b;
+              n /= b;
+            }
+            genes[j] = detail::quantise<T>(x, cells);
+          }
+        }
+      });
+    }
+
+    unsigned _bits; ///< resolution of the genes
+    bool _scramble; ///< random linear digit scrambling
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    std::vector<std::uint32_t> _primes; ///< base of every dimension
+    rng _rng; ///< random number service of the functor
+    std::uint64_t _calls{ 0 }; ///< number of calls (substream of the random numbers)
+  };
+
+  /**
+   * @brief Functor generating the initial population by Latin hypercube sampling
+   *
+   * Every gene range [0, 1) is split in N strata and every stratum holds exactly one
+   * individual: gene j of individual i is (P_j(i) + u) / N for a random permutation P_j
+   * of 0, ..., N - 1 and a uniform u, quantised to the centres of 2^bits cells. The
+   * columns are generated in parallel chunks when a thread pool is given, each from its
+   * own random stream.
+   *
+   * M. D. McKay, R. J. Beckman and W. J. Conover, A comparison of three methods for selecting
+   * values of input variables in the analysis of output from a computer code, Technometrics,
+   * vol. 21, no. 2, pp. 239-245, 1979.
+   */
+  struct Population_latin_hypercube
+  {
+    /**
+     * @brief Construct a new Population_latin_hypercube object
+     *
+     * @param bits resolution of the genes (1 to 32 bits)
+     * @param pool thread pool for generating the columns in parallel (nullptr for serial)
+     */
+    explicit Population_latin_hypercube(unsigned bits = 32, std::shared_ptr<thread_pool> pool = nullptr) :
+      _bits{ std::min(std::max(bits, 1u), 32u) }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    template <class E>
+    void operator()(xt::xexpression<E>& X)
+    {
+      detail::generate_rows(X.derived_cast(), [this](auto& X_rows) { generate(X_rows); }, has_row_major_data<E>{});
+    }
+
+  private:
+
+    template <class E, typename T = typename std::decay_t<E>::value_type>
+    void generate(E& _X)
+    {
+      std::size_t num_of_indiv = _X.shape()[0];
+      std::size_t num_of_vars = _X.shape()[1];
+      double cells = std::ldexp(1.0, static_cast<int>(_bits));
+      std::uint64_t call = _calls++;
+
+      parallel_for_chunks(_pool.get(), num_of_vars, [&](std::size_t first, std::size_t last)
+      {
+        std::vector<std::size_t> strata(num_of_indiv);
+        for (std::size_t j = first; j < last; ++j)
+        {
+          random_engine gen = _rng.stream(call, j);
+          for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+          {
+            strata[i] = i;
+          }
+          random_shuffle(strata.begin(), strata.end(), gen);
+          for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+          {
+            double x = (double(strata[i]) + uniform01(gen)) / double(num_of_indiv);
+            kernels::row(_X, i)[j] = detail::quantise<T>(x, cells);
+          }
+        }
+      });
+    }
+
+    unsigned _bits; ///< resolution of the genes
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    rng _rng; ///< random number service of the functor
+    std::uint64_t _calls{ 0 }; ///< number of calls (substream of the random numbers)
+  };
+
+  /**
+   * @brief Functor generating a uniformly distributed initial population
+   *
+   * Every individual is drawn from its own counter-based stream (see rng), so the
+   * rows can be generated in parallel chunks with a result independent of the number
+   * of threads. Genes are quantised to the centres of 2^bits cells in [0, 1).
+   */
+  struct Population_uniform
+  {
+    /**
+     * @brief Construct a new Population_uniform object
+     *
+     * @param bits resolution of the genes (1 to 32 bits)
+     * @param pool thread pool for generating the rows in parallel (nullptr for serial)
+     */
+    explicit Population_uniform(unsigned bits = 32, std::shared_ptr<thread_pool> pool = nullptr) :
+      _bits{ std::min(std::max(bits, 1u), 32u) }, _pool{ std::move(pool) }
+    {
+
+    }
+
+    template <class E>
+    void operator()(xt::xexpression<E>& X)
+    {
+      detail::generate_rows(X.derived_cast(), [this](auto& X_rows) { generate(X_rows); }, has_row_major_data<E>{});
+    }
+
+  private:
+
+    template <class E, typename T = typename std::decay_t<E>::value_type>
+    void generate(E& _X)
+    {
+      std::size_t num_of_indiv = _X.shape()[0];
+      std::size_t num_of_vars = _X.shape()[1];
+      double cells = std::ldexp(1.0, static_cast<int>(_bits));
+      std::uint64_t call = _calls++;
+
+      parallel_for_chunks(_pool.get(), num_of_indiv, [&](std::size_t first, std::size_t last)
+      {
+        double u[256];
+        for (std::size_t i = first; i < last; ++i)
+        {
+          random_engine gen = _rng.stream(call, i);
+          T* genes = kernels::row(_X, i);
+          for (std::size_t j{ 0 }; j < num_of_vars; j += 256)
+          {
+            std::size_t m = std::min<std::size_t>(256, num_of_vars - j);
+            fill_uniform(gen, u, m);
+            for (std::size_t k{ 0 }; k < m; ++k)
+            {
+              genes[j + k] = detail::quantise<T>(u[k], cells);
+            }
+          }
+        }
+      });
+    }
+
+    unsigned _bits; ///< resolution of the genes
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    rng _rng; ///< random number service of the functor
+    std::uint64_t _calls{ 0 }; ///< number of calls (substream of the random numbers)
+  };
+
+}
+
+#endif
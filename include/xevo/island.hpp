@@ -0,0 +1,497 @@
+/**
+ * @file island.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief templated header file with the island model genetic algorithm.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __ISLAND_HPP__
+#define __ISLAND_HPP__
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+
+#include "ga.hpp"
+#include "rng.hpp"
+#include "selection.hpp"
+#include "thread_pool.hpp"
+
+
+namespace xevo
+{
+
+  /**
+   * @brief topology of the migration between islands
+   */
+  enum class migration_topology
+  {
+    ring, ///< island i sends to island i + 1
+    fully_connected, ///< every island sends to every other island
+    random ///< every island sends to degree random islands (drawn at construction)
+  };
+
+  /**
+   * @brief parameters of the migration between islands
+   */
+  struct island_options
+  {
+    std::size_t migration_interval{ 10 }; ///< generations between two migrations of an island
+    std::size_t migrants{ 1 }; ///< number of best individuals sent over every edge
+    migration_topology topology{ migration_topology::ring }; ///< migration graph
+    std::size_t degree{ 2 }; ///< out-degree of the random topology
+    bool maximise{ true }; ///< larger fitness is better (as in Elitism)
+  };
+
+  /**
+   * @brief directed migration edges (source, target) between num_of_islands islands
+   *
+   * @param num_of_islands number of islands
+   * @param options migration parameters (topology and degree)
+   * @param edges output with the edges
+   */
+  inline void migration_edges(std::size_t num_of_islands, const island_options& options,
+    std::vector<std::pair<std::size_t, std::size_t>>& edges)
+  {
+    edges.clear();
+    if (num_of_islands > 1)
+    {
+      switch (options.topology)
+      {
+      case migration_topology::ring:
+        for (std::size_t i{ 0 }; i < num_of_islands; ++i)
+        {
+          edges.emplace_back(i, (i + 1) % num_of_islands);
+        }
+        break;
+      case migration_topology::fully_connected:
+        for (std::size_t i{ 0 }; i < num_of_islands; ++i)
+        {
+          for (std::size_t j{ 0 }; j < num_of_islands; ++j)
+          {
+            if (i != j)
+            {
+              edges.emplace_back(i, j);
+            }
+          }
+        }
+        break;
+      case migration_topology::random:
+      {
+        random_engine gen = make_random_engine();
+        std::size_t degree = std::min(options.degree, num_of_islands - 1);
+        std::vector<std::size_t> others(num_of_islands - 1);
+        for (std::size_t i{ 0 }; i < num_of_islands; ++i)
+        {
+          for (std::size_t j{ 0 }; j + 1 < num_of_islands; ++j)
+          {
+            others[j] = j < i ? j : j + 1;
+          }
+          random_shuffle(others.begin(), others.end(), gen);
+          for (std::size_t d{ 0 }; d < degree; ++d)
+          {
+            edges.emplace_back(i, others[d]);
+          }
+        }
+        break;
+      }
+      }
+    }
+  }
+
+  /**
+   * @brief single-producer single-consumer buffer holding the latest migrants of an edge
+   *
+   * Triple buffering: the sending island writes into its back slot and swaps it with the
+   * middle slot; the receiving island swaps its front slot with the middle slot when the
+   * middle slot holds migrants it has not seen. Both sides only perform an atomic exchange,
+   * so neither island ever waits for the other; migrants published twice before being
+   * received are overwritten by the newer ones. Every slot holds the migrants and their
+   * fitness.
+   *
+   * @tparam E xtensor type of the migrants
+   */
+  template <class E>
+  class migrant_buffer
+  {
+  public:
+
+    using value_type = typename E::value_type;
+    using fitness_type = xt::xtensor<value_type, 1>;
+
+    /**
+     * @brief allocate the three slots
+     *
+     * @param num_of_migrants number of migrants (rows)
+     * @param num_of_vars number of genes (columns)
+     */
+    void resize(std::size_t num_of_migrants, std::size_t num_of_vars)
+    {
+      std::array<std::size_t, 2> shape = { num_of_migrants, num_of_vars };
+      std::array<std::size_t, 1> shape_y = { num_of_migrants };
+      for (std::size_t s{ 0 }; s < 3; ++s)
+      {
+        _slots[s] = xt::zeros<value_type>(shape);
+        _fitness[s] = xt::zeros<value_type>(shape_y);
+      }
+    }
+
+    /**
+     * @brief slot written by the sending island
+     *
+     * @return E&
+     */
+    E& back()
+    {
+      return _slots[_back];
+    }
+
+    /**
+     * @brief fitness of the migrants of back()
+     *
+     * @return fitness_type&
+     */
+    fitness_type& back_fitness()
+    {
+      return _fitness[_back];
+    }
+
+    /**
+     * @brief hand the back slot over to the receiving island
+     */
+    void publish()
+    {
+      _back = _middle.exchange(_back | fresh, std::memory_order_acq_rel) & index_mask;
+    }
+
+    /**
+     * @brief take the latest published migrants, if not taken yet
+     *
+     * @return true when front() holds new migrants
+     */
+    bool acquire()
+    {
+      if (!(_middle.load(std::memory_order_relaxed) & fresh))
+      {
+        return false;
+      }
+      _front = _middle.exchange(_front, std::memory_order_acq_rel) & index_mask;
+      return true;
+    }
+
+    /**
+     * @brief slot read by the receiving island
+     *
+     * @return const E&
+     */
+    const E& front() const
+    {
+      return _slots[_front];
+    }
+
+    /**
+     * @brief fitness of the migrants of front()
+     *
+     * @return const fitness_type&
+     */
+    const fitness_type& front_fitness() const
+    {
+      return _fitness[_front];
+    }
+
+  private:
+    static constexpr unsigned fresh = 4u;
+    static constexpr unsigned index_mask = 3u;
+
+    std::array<E, 3> _slots; ///< back, middle and front slots
+    std::array<fitness_type, 3> _fitness; ///< fitness of the migrants of every slot
+    unsigned _back{ 0 }; ///< slot of the sender
+    unsigned _front{ 2 }; ///< slot of the receiver
+    alignas(64) std::atomic<unsigned> _middle{ 1 }; ///< shared slot (with the fresh flag)
+  };
+
+  namespace detail
+  {
+    template <class T, class TUPLE, std::size_t... Is>
+    inline T make_from_tuple(const TUPLE& args, std::index_sequence<Is...>)
+    {
+      return T(std::get<Is>(args)...);
+    }
+
+    template <class T, class... Args>
+    inline T make_from_tuple(const std::tuple<Args...>& args)
+    {
+      return make_from_tuple<T>(args, std::index_sequence_for<Args...>{});
+    }
+  }
+
+  /**
+   * @brief island model genetic algorithm
+   *
+   * M populations (islands) evolve as independent ga_state instances, each with its own
+   * copy of the objective function and its own ELIT, SEL, CROSS and MUT functors, built
+   * from the argument tuples as in ga::evolve (so every island draws from its own random
+   * streams). Every migration_interval generations an island sends its migrants best
+   * individuals over its out-edges of the migration topology, and replaces its worst
+   * individuals with the migrants received over its in-edges since its last migration.
+   *
+   * With a thread pool every island runs all its generations in one task; migrants are
+   * exchanged through lock-free buffers (migrant_buffer), so islands never wait for each
+   * other and the run scales with the number of cores up to M. The timing of the
+   * migrations then depends on the scheduling. Without a pool the islands are stepped
+   * in turn, generation by generation, which is deterministic.
+   *
+   * The copies of the objective function are called concurrently and must not share
+   * mutable state.
+   *
+   * @tparam E xtensor type of the population (row-major container)
+   * @tparam OBJ functor for objective function
+   * @tparam ELIT functor for elitism
+   * @tparam SEL functor for selection
+   * @tparam CROSS functor for crossover
+   * @tparam MUT functor for mutation
+   */
+  template<class E, class OBJ, class ELIT = Elitism, class SEL = Roulette_selection, class CROSS = Crossover,
+    class MUT = Mutation_polynomial>
+  class island_ga
+  {
+  public:
+
+    using island_type = ga_state<E, OBJ, ELIT, SEL, CROSS, MUT>;
+
+    /**
+     * @brief Construct a new island_ga object
+     *
+     * @tparam ElitArgs argument types for Elit functor
+     * @tparam SelArgs types of arguments for Selection functor
+     * @tparam CrossArgs types of arguments for cross over functor
+     * @tparam MutArgs types of arguments for mutation functor
+     * @param populations initial population of every island (same shape)
+     * @param objective_f objective function (copied to every island)
+     * @param elitargs arguments for elitism
+     * @param selargs arguments for selection
+     * @param crossargs arguments for crossover
+     * @param mutargs arguments for mutation
+     * @param options migration parameters
+     * @param pool thread pool running the islands (nullptr for serial execution)
+     */
+    template <typename... ElitArgs, typename... SelArgs, typename... CrossArgs, typename... MutArgs>
+    island_ga(const std::vector<E>& populations, const OBJ& objective_f, std::tuple<ElitArgs...> elitargs,
+      std::tuple<SelArgs...> selargs, std::tuple<CrossArgs...> crossargs, std::tuple<MutArgs...> mutargs,
+      island_options options = island_options{}, std::shared_ptr<thread_pool> pool = nullptr) :
+      _options{ options }, _pool{ std::move(pool) }
+    {
+      _options.migration_interval = std::max<std::size_t>(1, _options.migration_interval);
+      _islands.reserve(populations.size());
+      for (const E& X : populations)
+      {
+        _islands.emplace_back(X, objective_f, detail::make_from_tuple<ELIT>(elitargs),
+          detail::make_from_tuple<SEL>(selargs), detail::make_from_tuple<CROSS>(crossargs),
+          detail::make_from_tuple<MUT>(mutargs));
+      }
+      connect();
+    }
+
+    /**
+     * @brief evolve every island for a number of generations
+     *
+     * @param generations number of generations of every island
+     */
+    void run(std::size_t generations)
+    {
+      std::size_t num_of_islands = _islands.size();
+      if (_pool != nullptr && _pool->size() > 1)
+      {
+        _pool->parallel_for(num_of_islands, [&](std::size_t i)
+        {
+          for (std::size_t g{ 0 }; g < generations; ++g)
+          {
+            step(i);
+          }
+        });
+      }
+      else
+      {
+        for (std::size_t g{ 0 }; g < generations; ++g)
+        {
+          for (std::size_t i{ 0 }; i < num_of_islands; ++i)
+          {
+            step(i);
+          }
+        }
+      }
+    }
+
+    /**
+     * @brief number of islands
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const
+    {
+      return _islands.size();
+    }
+
+    /**
+     * @brief island i
+     *
+     * @param i index of the island
+     * @return island_type&
+     */
+    island_type& island(std::size_t i)
+    {
+      return _islands[i];
+    }
+
+    /**
+     * @brief island and row of the best individual over all islands
+     *
+     * The fitness values of different islands are compared directly, which requires an
+     * objective function that is not scaled by the population.
+     *
+     * @return std::pair<std::size_t, std::size_t> index of the island and of the individual
+     */
+    std::pair<std::size_t, std::size_t> best()
+    {
+      std::pair<std::size_t, std::size_t> best_index{ 0, 0 };
+      for (std::size_t i{ 0 }; i < _islands.size(); ++i)
+      {
+        const auto& y = _islands[i].fitness();
+        top_k_indices(y, 1, _options.maximise, _indices[i]);
+        const auto& y_best = _islands[best_index.first].fitness();
+        bool better = _options.maximise ? y(_indices[i][0]) > y_best(best_index.second) :
+          y(_indices[i][0]) < y_best(best_index.second);
+        if (i == 0 || better)
+        {
+          best_index = { i, _indices[i][0] };
+        }
+      }
+      return best_index;
+    }
+
+    /**
+     * @brief number of migrations performed by all islands so far
+     *
+     * @return std::size_t
+     */
+    std::size_t migrations() const
+    {
+      return _migrations.load();
+    }
+
+  private:
+
+    /**
+     * @brief build the migration edges and their buffers
+     */
+    void connect()
+    {
+      std::size_t num_of_islands = _islands.size();
+      _out_edges.assign(num_of_islands, {});
+      _in_edges.assign(num_of_islands, {});
+      _indices.assign(num_of_islands, {});
+      _fresh.assign(num_of_islands, {});
+
+      std::vector<std::pair<std::size_t, std::size_t>> edges;
+      migration_edges(num_of_islands, _options, edges);
+
+      std::size_t num_of_indiv = num_of_islands > 0 ? _islands[0].population().shape()[0] : 0;
+      std::size_t num_of_vars = num_of_islands > 0 ? _islands[0].population().shape()[1] : 0;
+      _num_of_migrants = std::min(_options.migrants, num_of_indiv);
+
+      // migrant_buffer holds an atomic: the vector is sized once and never moved
+      _buffers = std::vector<migrant_buffer<E>>(edges.size());
+      for (std::size_t e{ 0 }; e < edges.size(); ++e)
+      {
+        _buffers[e].resize(_num_of_migrants, num_of_vars);
+        _out_edges[edges[e].first].push_back(e);
+        _in_edges[edges[e].second].push_back(e);
+      }
+    }
+
+    /**
+     * @brief one generation of island i followed by its migration when due
+     */
+    void step(std::size_t i)
+    {
+      island_type& island = _islands[i];
+      island.step();
+      if (_num_of_migrants == 0 || island.generation() % _options.migration_interval != 0)
+      {
+        return;
+      }
+
+      std::vector<std::size_t>& indices = _indices[i];
+      const E& population = island.population();
+      const auto& y = island.fitness();
+
+      // emigration: the best individuals are copied to every out-edge
+      top_k_indices(y, _num_of_migrants, _options.maximise, indices);
+      for (std::size_t e : _out_edges[i])
+      {
+        E& migrants = _buffers[e].back();
+        auto& y_migrants = _buffers[e].back_fitness();
+        for (std::size_t k{ 0 }; k < indices.size(); ++k)
+        {
+          detail::copy_row(population, indices[k], migrants, k);
+          y_migrants(k) = y(indices[k]);
+        }
+        _buffers[e].publish();
+      }
+
+      // immigration: new migrants replace the worst individuals (at most half the island),
+      // with the fitness computed by the sending island
+      std::vector<std::size_t>& fresh = _fresh[i];
+      fresh.clear();
+      for (std::size_t e : _in_edges[i])
+      {
+        if (_buffers[e].acquire())
+        {
+          fresh.push_back(e);
+        }
+      }
+      if (!fresh.empty())
+      {
+        std::size_t num_of_replaced = std::min(fresh.size() * _num_of_migrants, population.shape()[0] / 2);
+        top_k_indices(island.fitness(), num_of_replaced, !_options.maximise, indices);
+        std::size_t r{ 0 };
+        for (std::size_t e : fresh)
+        {
+          const E& migrants = _buffers[e].front();
+          const auto& y_migrants = _buffers[e].front_fitness();
+          for (std::size_t k{ 0 }; k < _num_of_migrants && r < num_of_replaced; ++k)
+          {
+            island.replace(indices[r++], migrants, k, y_migrants(k));
+          }
+        }
+      }
+      _migrations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::vector<island_type> _islands; ///< populations and functors of the islands
+    island_options _options; ///< migration parameters
+    std::shared_ptr<thread_pool> _pool; ///< optional thread pool
+    std::vector<migrant_buffer<E>> _buffers; ///< one buffer per migration edge
+    std::vector<std::vector<std::size_t>> _out_edges; ///< edges leaving every island
+    std::vector<std::vector<std::size_t>> _in_edges; ///< edges entering every island
+    std::vector<std::vector<std::size_t>> _indices; ///< scratch of every island
+    std::vector<std::vector<std::size_t>> _fresh; ///< in-edges with new migrants (scratch of every island)
+    std::size_t _num_of_migrants{ 0 }; ///< migrants per edge
+    std::atomic<std::size_t> _migrations{ 0 }; ///< number of migrations
+  };
+
+}
+
+#endif
@@ -0,0 +1,325 @@
+/**
+ * @file kernels.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief header file with row kernels shared by the functors.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __KERNELS_HPP__
+#define __KERNELS_HPP__
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "xtensor/xlayout.hpp"
+
+
+namespace xevo
+{
+  /**
+   * @brief trait checking that E stores its elements in a contiguous row-major buffer
+   *
+   * True for containers, adaptors and contiguous views with a static row-major layout
+   * and a data() member. Column-major, dynamic layout and strided types are rejected,
+   * since their rows cannot be addressed as data() + data_offset() + i * num_of_vars.
+   */
+  template <class E, class = void>
+  struct has_row_major_data : std::false_type
+  {
+  };
+
+  template <class E>
+  struct has_row_major_data<E, std::enable_if_t<std::decay_t<E>::static_layout == xt::layout_type::row_major,
+    decltype(std::declval<E&>().data(), std::declval<E&>().data_offset(), void())>> : std::true_type
+  {
+  };
+
+  namespace kernels
+  {
+
+    /**
+     * @brief pointer to the first gene of row i of a row-major container
+     *
+     * @tparam E xtensor container type (row-major, contiguous; see has_row_major_data)
+     * @param X container
+     * @param i row index
+     * @return pointer to X(i, 0)
+     */
+    template <class E>
+    inline auto row(E& X, std::size_t i)
+    {
+      static_assert(has_row_major_data<E>::value, "kernels::row requires a contiguous row-major container");
+      return X.data() + X.data_offset() + i * X.shape()[1];
+    }
+
+    /**
+     * @brief direction of a particle for one gene
+     *
+     * \f[ \omega m + a \left( p_b - x \right) + b \left( l_b - x \right) \f]
+     */
+    template <class T>
+    inline T pso_direction(T w, T momentum, T a, T pbest, T b, T lbest, T x)
+    {
+      return w * momentum + a * (pbest - x) + b * (lbest - x);
+    }
+
+    /**
+     * @brief fused velocity update of one particle
+     *
+     * \f[ V_j = \chi \left( \omega V_j + a \left( pbest_j - X_j \right) + b \left( lbest_j - X_j \right) \right) \f]
+     *
+     * with \f$ a = c_1 r_1 \f$ and \f$ b = c_2 r_2 \f$. The rows are read once in a
+     * single streaming pass which the compiler vectorises.
+     *
+     * @param v velocity row (updated in place)
+     * @param x position row
+     * @param pbest personal best row
+     * @param lbest local (or global) best row
+     * @param n number of genes
+     */
+    template <class T>
+    inline void velocity_update(T* v, const T* x, const T* pbest, const T* lbest, std::size_t n,
+      T chi, T w, T a, T b)
+    {
+      for (std::size_t j{ 0 }; j < n; ++j)
+      {
+        v[j] = chi * pso_direction(w, v[j], a, pbest[j], b, lbest[j], x[j]);
+      }
+    }
+
+    /**
+     * @brief fused position update of one particle with momentum from the previous position
+     *
+     * \f[ X_j = X_j + \omega \left( X_j - X^{t-1}_j \right) + a \left( pbest_j - X_j \right) + b \left( lbest_j - X_j \right) \f]
+     *
+     * @param x position row (updated in place)
+     * @param xm1 previous position row
+     * @param pbest personal best row
+     * @param lbest local best row
+     * @param n number of genes
+     */
+    template <class T>
+    inline void position_momentum_update(T* x, const T* xm1, const T* pbest, const T* lbest, std::size_t n,
+      T w, T a, T b)
+    {
+      for (std::size_t j{ 0 }; j < n; ++j)
+      {
+        T xj = x[j];
+        x[j] = xj + pso_direction(w, xj - xm1[j], a, pbest[j], b, lbest[j], xj);
+      }
+    }
+
+    /**
+     * @brief polynomial mutation of n gathered genes
+     *
+     * \f[
+     *   p^{'} =
+     *   \begin{cases}
+     *     p + \left( (2u)^{e} - 1 \right) p, for \quad u \leq 0.5, \\
+     *     p + \left( 1 - (2(1-u))^{e} \right) (1 - p), for \quad u > 0.5
+     *   \end{cases}
+     * \f]
+     *
+     * The loop has no branches, so the compiler vectorises it and maps pow to the
+     * vector math library (e.g. with -O3 -ffast-math on glibc).
+     *
+     * @param p genes (updated in place)
+     * @param u uniform random numbers in [0, 1)
+     * @param n number of genes
+     * @param e exponent \f$ 1 / (1 + \eta_m) \f$
+     */
+    template <class T, class U>
+    inline void polynomial_mutation(T* p, const U* u, std::size_t n, T e)
+    {
+      for (std::size_t k{ 0 }; k < n; ++k)
+      {
+        T uk = static_cast<T>(u[k]);
+        bool left = uk <= T(0.5);
+        T d = std::pow(left ? T(2) * uk : T(2) * (T(1) - uk), e);
+        p[k] = left ? p[k] + (d - T(1)) * p[k] : p[k] + (T(1) - d) * (T(1) - p[k]);
+      }
+    }
+
+    /**
+     * @brief simulated binary crossover of two parent rows
+     *
+     * \f[
+     *   \beta_j =
+     *   \begin{cases}
+     *     (2u_j)^{1/(\eta_c + 1)}, for \quad u_j \leq 0.5, \\
+     *     \left( 1 / (2(1-u_j)) \right)^{1/(\eta_c + 1)}, for \quad u_j > 0.5
+     *   \end{cases}
+     * \f]
+     *
+     * \f[ c^1_j = \frac{1}{2} \left( (1 + \beta_j) p^1_j + (1 - \beta_j) p^2_j \right), \quad
+     *     c^2_j = \frac{1}{2} \left( (1 - \beta_j) p^1_j + (1 + \beta_j) p^2_j \right) \f]
+     *
+     * K. Deb and R. B. Agrawal, Simulated binary crossover for continuous search space,
+     * Complex Systems, vol. 9, no. 2, pp. 115-148, 1995.
+     *
+     * The children may alias the parents.
+     *
+     * @param p1 first parent
+     * @param p2 second parent
+     * @param c1 first child
+     * @param c2 second child
+     * @param u uniform random numbers in [0, 1), one per gene
+     * @param n number of genes
+     * @param e exponent \f$ 1 / (\eta_c + 1) \f$
+     */
+    template <class T, class U>
+    inline void sbx_crossover(const T* p1, const T* p2, T* c1, T* c2, const U* u, std::size_t n, T e)
+    {
+      for (std::size_t j{ 0 }; j < n; ++j)
+      {
+        T uj = static_cast<T>(u[j]);
+        T base = uj <= T(0.5) ? T(2) * uj : T(1) / (T(2) * (T(1) - uj));
+        T beta = std::pow(base, e);
+        T a = p1[j];
+        T b = p2[j];
+        c1[j] = T(0.5) * ((T(1) + beta) * a + (T(1) - beta) * b);
+        c2[j] = T(0.5) * ((T(1) - beta) * a + (T(1) + beta) * b);
+      }
+    }
+
+    /**
+     * @brief blend crossover (BLX-alpha) of two parent rows
+     *
+     * Every child gene is drawn uniformly from
+     * \f$ \left[ \min(p^1_j, p^2_j) - \alpha d_j, \max(p^1_j, p^2_j) + \alpha d_j \right] \f$
+     * with \f$ d_j = |p^1_j - p^2_j| \f$. The children may alias the parents.
+     *
+     * @param p1 first parent
+     * @param p2 second parent
+     * @param c1 first child
+     * @param c2 second child
+     * @param u1 uniform random numbers for the first child, one per gene
+     * @param u2 uniform random numbers for the second child, one per gene
+     * @param n number of genes
+     * @param alpha extension of the interval
+     */
+    template <class T, class U>
+    inline void blend_crossover(const T* p1, const T* p2, T* c1, T* c2, const U* u1, const U* u2,
+      std::size_t n, T alpha)
+    {
+      for (std::size_t j{ 0 }; j < n; ++j)
+      {
+        T a = p1[j];
+        T b = p2[j];
+        T low = a < b ? a : b;
+        T d = a < b ? b - a : a - b;
+        T start = low - alpha * d;
+        T width = (T(1) + T(2) * alpha) * d;
+        c1[j] = start + static_cast<T>(u1[j]) * width;
+        c2[j] = start + static_cast<T>(u2[j]) * width;
+      }
+    }
+
+    /**
+     * @brief uniform crossover of two parent rows
+     *
+     * Gene j is swapped between the children when \f$ u_j < p_{swap} \f$.
+     * The children may alias the parents.
+     *
+     * @param p1 first parent
+     * @param p2 second parent
+     * @param c1 first child
+     * @param c2 second child
+     * @param u uniform random numbers in [0, 1), one per gene
+     * @param n number of genes
+     * @param swap_probability probability of swapping a gene
+     */
+    template <class T, class U>
+    inline void uniform_crossover(const T* p1, const T* p2, T* c1, T* c2, const U* u, std::size_t n,
+      U swap_probability)
+    {
+      for (std::size_t j{ 0 }; j < n; ++j)
+      {
+        T a = p1[j];
+        T b = p2[j];
+        bool swap = u[j] < swap_probability;
+        c1[j] = swap ? b : a;
+        c2[j] = swap ? a : b;
+      }
+    }
+
+    /**
+     * @brief k-point crossover of two parent rows
+     *
+     * The genes between the sorted cut points points[0] < points[1] < ... are taken
+     * alternately from the first and the second parent. The children may alias the
+     * parents.
+     *
+     * @param p1 first parent
+     * @param p2 second parent
+     * @param c1 first child
+     * @param c2 second child
+     * @param n number of genes
+     * @param points sorted cut points in (0, n)
+     * @param k number of cut points
+     */
+    template <class T>
+    inline void k_point_crossover(const T* p1, const T* p2, T* c1, T* c2, std::size_t n,
+      const std::size_t* points, std::size_t k)
+    {
+      std::size_t first{ 0 };
+      for (std::size_t s{ 0 }; s <= k; ++s)
+      {
+        std::size_t last = s < k ? points[s] : n;
+        bool swap = (s % 2) == 1;
+        for (std::size_t j = first; j < last; ++j)
+        {
+          T a = p1[j];
+          T b = p2[j];
+          c1[j] = swap ? b : a;
+          c2[j] = swap ? a : b;
+        }
+        first = last;
+      }
+    }
+
+    /**
+     * @brief trial vector of differential evolution with binomial crossover
+     *
+     * \f[ t_j = \begin{cases} b_j + K \left( p_j - b_j \right) + F \left( r^1_j - r^2_j \right) &
+     *   u_j < CR \ \text{or} \ j = j_{rand} \\ x_j & \text{otherwise} \end{cases} \f]
+     *
+     * DE/rand/1 and DE/best/1 use K = 0; DE/current-to-pbest/1 uses b = x and K = F.
+     *
+     * @param t trial row
+     * @param x target row
+     * @param b base row
+     * @param p row the base moves towards (e.g. one of the p best)
+     * @param r1 first row of the difference
+     * @param r2 second row of the difference
+     * @param u uniform random numbers in [0, 1), one per gene
+     * @param n number of genes
+     * @param K weight of p - b
+     * @param F weight of the difference r1 - r2
+     * @param CR crossover rate
+     * @param j_rand gene always taken from the mutant
+     */
+    template <class T, class U>
+    inline void de_trial(T* t, const T* x, const T* b, const T* p, const T* r1, const T* r2, const U* u,
+      std::size_t n, T K, T F, U CR, std::size_t j_rand)
+    {
+      for (std::size_t j{ 0 }; j < n; ++j)
+      {
+        T v = b[j] + K * (p[j] - b[j]) + F * (r1[j] - r2[j]);
+        t[j] = (u[j] < CR || j == j_rand) ? v : x[j];
+      }
+    }
+
+  }
+}
+
+#endif
@@ -0,0 +1,732 @@
+/**
+ * @file nsga2.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief templated header file with the multi-objective NSGA-II, non-dominated sorting
+ *  and crowding distance.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __NSGA2_HPP__
+#define __NSGA2_HPP__
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+
+#include "crossover.hpp"
+#include "functors.hpp"
+#include "initialisation.hpp"
+#include "rng.hpp"
+
+
+namespace xevo
+{
+
+  /**
+   * @brief true when row a of Y dominates row b (no worse in every objective, better in one)
+   *
+   * @tparam F xtensor type of the evaluations (N x M)
+   * @param Y evaluations
+   * @param a first row
+   * @param b second row
+   * @param maximise true when larger objectives are better
+   * @return bool
+   */
+  template <class F>
+  inline bool dominates(const F& Y, std::size_t a, std::size_t b, bool maximise = false)
+  {
+    std::size_t num_of_objectives = Y.shape()[1];
+    bool better{ false };
+    for (std::size_t m{ 0 }; m < num_of_objectives; ++m)
+    {
+      auto ya = Y(a, m);
+      auto yb = Y(b, m);
+      if (maximise ? ya < yb : yb < ya)
+      {
+        return false;
+      }
+      better = better || ya != yb;
+    }
+    return better;
+  }
+
+  /**
+   * @brief rank of every row of Y in the non-dominated fronts (0 for the Pareto front)
+   *
+   * Efficient non-dominated sort with binary search (ENS-BS): the rows are visited in
+   * lexicographic order, so no row can be dominated by a later one, and every row goes
+   * to the first front that does not dominate it. The fronts are nested (a row not
+   * dominated by front k is not dominated by front k + 1), which makes the binary search
+   * valid. For two objectives a front dominates a row exactly when its last row does,
+   * which gives O(N log N); otherwise the members of a front are checked from the last.
+   *
+   * X. Zhang, Y. Tian, R. Cheng and Y. Jin, An efficient approach to nondominated sorting
+   * for evolutionary multiobjective optimization, IEEE Transactions on Evolutionary
+   * Computation, vol. 19, no. 2, pp. 201-213, 2015.
+   *
+   * @tparam F xtensor type of the evaluations (N x M)
+   * @param Y evaluations
+   * @param maximise true when larger objectives are better
+   * @param rank output with the front of every row
+   * @return std::size_t number of fronts
+   */
+  template <class F>
+  inline std::size_t non_dominated_sort(const F& Y, bool maximise, std::vector<std::size_t>& rank)
+  {
+    std::size_t num_of_indiv = Y.shape()[0];
+    std::size_t num_of_objectives = Y.shape()[1];
+    rank.assign(num_of_indiv, 0);
+
+    std::vector<std::size_t> order(num_of_indiv);
+    for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+    {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&Y, num_of_objectives, maximise](std::size_t a, std::size_t b)
+    {
+      for (std::size_t m{ 0 }; m < num_of_objectives; ++m)
+      {
+        auto ya = Y(a, m);
+        auto yb = Y(b, m);
+        if (ya != yb)
+        {
+          return maximise ? ya > yb : ya < yb;
+        }
+      }
+      return a < b;
+    });
+
+    std::vector<std::vector<std::size_t>> fronts;
+    auto front_dominates = [&](std::size_t k, std::size_t p)
+    {
+      const std::vector<std::size_t>& front = fronts[k];
+      if (num_of_objectives == 2)
+      {
+        return dominates(Y, front.back(), p, maximise);
+      }
+      for (std::size_t q = front.size(); q > 0; --q)
+      {
+        if (dominates(Y, front[q - 1], p, maximise))
+        {
+          return true;
+        }
+      }
+      return false;
+    };
+
+    for (std::size_t p : order)
+    {
+      std::size_t low{ 0 };
+      std::size_t high = fronts.size();
+      while (low < high)
+      {
+        std::size_t middle = low + (high - low) / 2;
+        if (front_dominates(middle, p))
+        {
+          low = middle + 1;
+        }
+        else
+        {
+          high = middle;
+        }
+      }
+      if (low == fronts.size())
+      {
+        fronts.emplace_back();
+      }
+      fronts[low].push_back(p);
+      rank[p] = low;
+    }
+    return fronts.size();
+  }
+
+  /**
+   * @brief crowding distance of the rows of one front
+   *
+   * For every objective the values of the front are gathered and sorted once; the
+   * distances are accumulated with a contiguous loop over the sorted values. The
+   * extreme rows of every objective get an infinite distance.
+   *
+   * @tparam F xtensor type of the evaluations (N x M)
+   * @param Y evaluations
+   * @param front rows of the front
+   * @param distance output indexed by row (resized to N; only the rows of the front are written)
+   */
+  template <class F>
+  inline void crowding_distance(const F& Y, const std::vector<std::size_t>& front, std::vector<double>& distance)
+  {
+    std::size_t num_of_indiv = Y.shape()[0];
+    std::size_t num_of_objectives = Y.shape()[1];
+    std::size_t n = front.size();
+    distance.resize(num_of_indiv);
+    for (std::size_t i : front)
+    {
+      distance[i] = 0.0;
+    }
+    if (n < 3)
+    {
+      for (std::size_t i : front)
+      {
+        distance[i] = std::numeric_limits<double>::infinity();
+      }
+      return;
+    }
+
+    std::vector<std::size_t> order(n);
+    std::vector<double> values(n);
+    std::vector<double> increment(n);
+    for (std::size_t m{ 0 }; m < num_of_objectives; ++m)
+    {
+      for (std::size_t k{ 0 }; k < n; ++k)
+      {
+        order[k] = k;
+      }
+      std::sort(order.begin(), order.end(), [&Y, &front, m](std::size_t a, std::size_t b)
+      {
+        return Y(front[a], m) < Y(front[b], m);
+      });
+      for (std::size_t k{ 0 }; k < n; ++k)
+      {
+        values[k] = double(Y(front[order[k]], m));
+      }
+
+      double range = values[n - 1] - values[0];
+      double scale = range > 0.0 ? 1.0 / range : 0.0;
+      for (std::size_t k{ 1 }; k + 1 < n; ++k)
+      {
+        increment[k] = (values[k + 1] - values[k - 1]) * scale;
+      }
+      for (std::size_t k{ 1 }; k + 1 < n; ++k)
+      {
+        distance[front[order[k]]] += increment[k];
+      }
+      distance[front[order[0]]] = std::numeric_limits<double>::infinity();
+      distance[front[order[n - 1]]] = std::numeric_limits<double>::infinity();
+    }
+  }
+
+  /**
+   * @brief Functor for the selection of NSGA-II
+   *
+   * mating() fills the mating pool by binary tournaments on the front (lower wins) and
+   * the crowding distance (larger wins) of the rows; survivors() picks the rows of the
+   * next population from the parents and the children, front by front, breaking the
+   * last front by crowding distance.
+   */
+  struct Selection_nsga2
+  {
+    /**
+     * @brief Construct a new Selection_nsga2 object
+     *
+     * @param maximise true when larger objectives are better
+     */
+    explicit Selection_nsga2(bool maximise = false) : _maximise{ maximise }
+    {
+
+    }
+
+    /**
+     * @brief fill X_out with rows of X won in binary tournaments
+     *
+     * @tparam E xtensor type of the population
+     * @tparam F xtensor type of the evaluations (N x M)
+     * @tparam O xtensor type of the mating pool
+     * @param X population
+     * @param Y evaluations of the population
+     * @param X_out mating pool (as many rows as X)
+     */
+    template <class E, class F, class O>
+    void mating(const E& X, const F& Y, O& X_out)
+    {
+      std::size_t num_of_indiv = X.shape()[0];
+      rank_and_crowding(Y);
+
+      random_engine gen = _rng.stream(_calls++, 0);
+      for (std::size_t k{ 0 }; k < num_of_indiv; ++k)
+      {
+        std::size_t a = uniform_index(gen, num_of_indiv);
+        std::size_t b = uniform_index(gen, num_of_indiv);
+        detail::copy_row(X, wins(b, a) ? b : a, X_out, k);
+      }
+    }
+
+    /**
+     * @brief the n rows of Y forming the next population
+     *
+     * @tparam F xtensor type of the evaluations (parents and children)
+     * @param Y evaluations
+     * @param n number of survivors
+     * @param indices output with the rows of the survivors
+     */
+    template <class F>
+    void survivors(const F& Y, std::size_t n, std::vector<std::size_t>& indices)
+    {
+      std::size_t num_of_fronts = non_dominated_sort(Y, _maximise, _rank);
+      std::size_t num_of_rows = _rank.size();
+      n = std::min(n, num_of_rows);
+
+      _fronts.resize(num_of_fronts);
+      for (auto& front : _fronts)
+      {
+        front.clear();
+      }
+      for (std::size_t i{ 0 }; i < num_of_rows; ++i)
+      {
+        _fronts[_rank[i]].push_back(i);
+      }
+
+      indices.clear();
+      for (std::size_t f{ 0 }; f < num_of_fronts && indices.size() < n; ++f)
+      {
+        std::vector<std::size_t>& front = _fronts[f];
+        if (indices.size() + front.size() <= n)
+        {
+          indices.insert(indices.end(), front.begin(), front.end());
+          continue;
+        }
+        crowding_distance(Y, front, _crowding);
+        std::size_t missing = n - indices.size();
+        std::partial_sort(front.begin(), front.begin() + missing, front.end(), [this](std::size_t a, std::size_t b)
+        {
+          return _crowding[a] > _crowding[b] || (_crowding[a] == _crowding[b] && a < b);
+        });
+        indices.insert(indices.end(), front.begin(), front.begin() + missing);
+      }
+    }
+
+    /**
+     * @brief rows of the Pareto front of Y
+     *
+     * @tparam F xtensor type of the evaluations (N x M)
+     * @param Y evaluations
+     * @param indices output with the non-dominated rows
+     */
+    template <class F>
+    void pareto_front(const F& Y, std::vector<std::size_t>& indices)
+    {
+      non_dominated_sort(Y, _maximise, _rank);
+      indices.clear();
+      for (std::size_t i{ 0 }; i < _rank.size(); ++i)
+      {
+        if (_rank[i] == 0)
+        {
+          indices.push_back(i);
+        }
+      }
+    }
+
+  private:
+
+    template <class F>
+    void rank_and_crowding(const F& Y)
+    {
+      std::size_t num_of_fronts = non_dominated_sort(Y, _maximise, _rank);
+      _fronts.resize(num_of_fronts);
+      for (auto& front : _fronts)
+      {
+        front.clear();
+      }
+      for (std::size_t i{ 0 }; i < _rank.size(); ++i)
+      {
+        _fronts[_rank[i]].push_back(i);
+      }
+      for (const auto& front : _fronts)
+      {
+        crowding_distance(Y, front, _crowding);
+      }
+    }
+
+    bool wins(std::size_t a, std::size_t b) const
+    {
+      return _rank[a] < _rank[b] || (_rank[a] == _rank[b] && _crowding[a] > _crowding[b]);
+    }
+
+    bool _maximise;
+    std::vector<std::size_t> _rank; ///< front of every row
+    std::vector<double> _crowding; ///< crowding distance of every row
+    std::vector<std::vector<std::size_t>> _fronts; ///< rows of every front
+    rng _rng; ///< random number service of the functor
+    std::uint64_t _calls{ 0 }; ///< number of calls (substream of the random numbers)
+  };
+
+  namespace detail
+  {
+    /**
+     * @brief one NSGA-II generation on preallocated buffers
+     *
+     * Mating pool, children by crossover and mutation, evaluation of the children as one
+     * batch, and survival of N rows out of the parents and the children.
+     */
+    template <class E, class F, class OBJ, class SEL, class CROSS, class MUT>
+    inline std::size_t nsga2_generation(E& population, F& Y, E& mating, E& offspring, F& Y_offspring,
+      F& Y_combined, std::vector<std::size_t>& indices, OBJ& objective_f, SEL& selection_f, CROSS& cross_f,
+      MUT& mutation_f)
+    {
+      std::size_t num_of_indiv = population.shape()[0];
+      std::size_t num_of_objectives = Y.shape()[1];
+
+      selection_f.mating(population, Y, mating);
+      vary_rows(cross_f, mutation_f, mating, offspring);
+
+      auto&& y = objective_f(offspring);
+      if (y.shape()[0] != num_of_indiv || y.shape()[1] != num_of_objectives)
+      {
+        throw std::runtime_error("The objective function should return an N x M array");
+      }
+      std::array<std::size_t, 2> shape_y = { num_of_indiv, num_of_objectives };
+      std::array<std::size_t, 2> shape_combined = { 2 * num_of_indiv, num_of_objectives };
+      if (Y_offspring.shape()[0] != num_of_indiv || Y_offspring.shape()[1] != num_of_objectives)
+      {
+        Y_offspring.resize(shape_y);
+      }
+      if (Y_combined.shape()[0] != 2 * num_of_indiv || Y_combined.shape()[1] != num_of_objectives)
+      {
+        Y_combined.resize(shape_combined);
+      }
+      for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+      {
+        for (std::size_t m{ 0 }; m < num_of_objectives; ++m)
+        {
+          Y_offspring(i, m) = y(i, m);
+          Y_combined(i, m) = Y(i, m);
+          Y_combined(num_of_indiv + i, m) = y(i, m);
+        }
+      }
+
+      selection_f.survivors(Y_combined, num_of_indiv, indices);
+
+      // survivors from the parents keep their rows when possible; the others fill the gaps
+      std::vector<char> kept(num_of_indiv, 0);
+      std::vector<std::size_t> children;
+      for (std::size_t k : indices)
+      {
+        if (k < num_of_indiv)
+        {
+          kept[k] = 1;
+        }
+        else
+        {
+          children.push_back(k - num_of_indiv);
+        }
+      }
+      std::size_t c{ 0 };
+      for (std::size_t i{ 0 }; i < num_of_indiv && c < children.size(); ++i)
+      {
+        if (kept[i])
+        {
+          continue;
+        }
+        std::size_t k = children[c++];
+        copy_row(offspring, k, population, i);
+        for (std::size_t m{ 0 }; m < num_of_objectives; ++m)
+        {
+          Y(i, m) = Y_offspring(k, m);
+        }
+      }
+      return num_of_indiv;
+    }
+  }
+
+  /**
+   * @brief class for the multi-objective NSGA-II
+   *
+   * The objective function returns an N x M array with the M objectives of every
+   * individual. The variation reuses the crossover and mutation functors of ga.
+   *
+   * K. Deb, A. Pratap, S. Agarwal and T. Meyarivan, A fast and elitist multiobjective
+   * genetic algorithm: NSGA-II, IEEE Transactions on Evolutionary Computation, vol. 6,
+   * no. 2, pp. 182-197, 2002.
+   */
+  class nsga2
+  {
+  public:
+
+    /**
+     * @brief method to initialise population for nsga2
+     *
+     * @tparam E xtensor type for generating the initial population
+     * @tparam POP functor for generating the population
+     * @tparam PopArgs optional type of arguments for population functor
+     * @tparam T value type of xtensor
+     * @param X array of population
+     * @param popargs optional arguments for population functor
+     */
+    template<class E, class POP = Population, typename... PopArgs,
+      typename T = typename std::decay_t<E>::value_type>
+      void initialise(xt::xexpression<E>& X, std::tuple<PopArgs...> popargs = std::make_tuple())
+    {
+      initialise<E, POP>(X, std::move(popargs), std::index_sequence_for<PopArgs...>{});
+    }
+
+    /**
+     * @brief method to evolve the population by one generation
+     *
+     * @tparam E xtensor type of the population
+     * @tparam F xtensor type of the evaluations (N x M)
+     * @tparam OBJ functor for objective function (returns N x M)
+     * @tparam SEL functor for selection
+     * @tparam CROSS functor for crossover
+     * @tparam MUT functor for mutation
+     * @tparam SelArgs types of arguments for selection functor
+     * @tparam CrossArgs types of arguments for crossover functor
+     * @tparam MutArgs types of arguments for mutation functor
+     * @param X array with population at current evolution
+     * @param Y evaluations of the population (e.g. objective_f(X) after initialise), updated
+     * @param objective_f objective function
+     * @param selargs arguments for selection functor
+     * @param crossargs arguments for crossover functor
+     * @param mutargs arguments for mutation functor
+     */
+    template<class E, class F, class OBJ, class SEL = Selection_nsga2, class CROSS = Crossover,
+      class MUT = Mutation_polynomial, typename... SelArgs, typename... CrossArgs, typename... MutArgs>
+    void evolve(xt::xexpression<E>& X, xt::xexpression<F>& Y, OBJ objective_f, std::tuple<SelArgs...> selargs,
+      std::tuple<CrossArgs...> crossargs, std::tuple<MutArgs...> mutargs)
+    {
+      evolve<E, F, OBJ, SEL, CROSS, MUT>(X, Y, objective_f, std::move(selargs), std::move(crossargs),
+        std::move(mutargs), std::index_sequence_for<SelArgs...>{}, std::index_sequence_for<CrossArgs...>{},
+        std::index_sequence_for<MutArgs...>{});
+    }
+
+  private:
+
+    template<class E, class POP = Population, typename... PopArgs, std::size_t... PIs,
+      typename T = typename std::decay_t<E>::value_type>
+      void initialise(xt::xexpression<E>& X, std::tuple<PopArgs...>&& popargs, std::index_sequence<PIs...>)
+    {
+      E& _X = X.derived_cast();
+      POP f_pop(std::get<PIs>(std::move(popargs))...);
+      f_pop(_X);
+    }
+
+    template<class E, class F, class OBJ, class SEL, class CROSS, class MUT, typename... SelArgs,
+      typename... CrossArgs, typename... MutArgs, std::size_t... SIs, std::size_t... CXIs, std::size_t... MIs>
+    void evolve(xt::xexpression<E>& X, xt::xexpression<F>& Y, OBJ& objective_f, std::tuple<SelArgs...>&& selargs,
+      std::tuple<CrossArgs...>&& crossargs, std::tuple<MutArgs...>&& mutargs, std::index_sequence<SIs...>,
+      std::index_sequence<CXIs...>, std::index_sequence<MIs...>)
+    {
+      SEL selection_f(std::get<SIs>(std::move(selargs))...);
+      CROSS cross_f(std::get<CXIs>(std::move(crossargs))...);
+      MUT mutation_f(std::get<MIs>(std::move(mutargs))...);
+
+      E& population = X.derived_cast();
+      F& y = Y.derived_cast();
+      E mating(population);
+      E offspring(population);
+      F y_offspring(y);
+      F y_combined;
+      std::vector<std::size_t> indices;
+
+      detail::nsga2_generation(population, y, mating, offspring, y_offspring, y_combined, indices, objective_f,
+        selection_f, cross_f, mutation_f);
+    }
+
+  };
+
+  /**
+   * @brief stateful NSGA-II solver
+   *
+   * Keeps the population, its N x M evaluations, the mating and children buffers and
+   * the functor instances between generations. Every child is evaluated exactly once.
+   *
+   * @tparam E xtensor type of the population
+   * @tparam OBJ functor for objective function (returns N x M)
+   * @tparam SEL functor for selection
+   * @tparam CROSS functor for crossover
+   * @tparam MUT functor for mutation
+   */
+  template<class E, class OBJ, class SEL = Selection_nsga2, class CROSS = Crossover, class MUT = Mutation_polynomial>
+  class nsga2_state
+  {
+  public:
+
+    using value_type = typename std::decay_t<E>::value_type;
+    using fitness_type = xt::xtensor<value_type, 2>;
+
+    /**
+     * @brief Construct a new nsga2_state object
+     *
+     * @param X initial population
+     * @param objective_f objective function
+     * @param selection_f functor for selection
+     * @param cross_f functor for crossover
+     * @param mutation_f functor for mutation
+     */
+    nsga2_state(const E& X, OBJ objective_f, SEL selection_f, CROSS cross_f, MUT mutation_f) :
+      _population(X), _mating(X), _offspring(X), _objective_f{ std::move(objective_f) },
+      _selection_f{ std::move(selection_f) }, _cross_f{ std::move(cross_f) }, _mutation_f{ std::move(mutation_f) }
+    {
+
+    }
+
+    /**
+     * @brief evolve the population by one generation
+     */
+    void step()
+    {
+      if (!_evaluated)
+      {
+        evaluate();
+      }
+      _evaluations += detail::nsga2_generation(_population, _y, _mating, _offspring, _y_offspring, _y_combined,
+        _indices, _objective_f, _selection_f, _cross_f, _mutation_f);
+      ++_generation;
+    }
+
+    /**
+     * @brief evolve the population by one generation and apply a terminating functor
+     *
+     * The functor is taken by reference, so functors with a history (e.g.
+     * Terminate_hypervolume) keep it between the calls.
+     *
+     * @tparam TERM functor for termination
+     * @param terminate_f terminating functor
+     * @return auto type from terminating functor, evaluated with the stored evaluations
+     */
+    template<class TERM>
+    auto step(TERM&& terminate_f)
+    {
+      step();
+      return terminate_f(_population, _y);
+    }
+
+    /**
+     * @brief evolve the population for a number of generations
+     *
+     * @param generations number of generations
+     */
+    void run(std::size_t generations)
+    {
+      for (std::size_t i{ 0 }; i < generations; ++i)
+      {
+        step();
+      }
+    }
+
+    /**
+     * @brief current population
+     *
+     * @return const E&
+     */
+    const E& population() const
+    {
+      return _population;
+    }
+
+    /**
+     * @brief evaluations of the current population (evaluated on first access)
+     *
+     * @return const fitness_type& (N x M)
+     */
+    const fitness_type& fitness()
+    {
+      if (!_evaluated)
+      {
+        evaluate();
+      }
+      return _y;
+    }
+
+    /**
+     * @brief rows of the current population on the Pareto front
+     *
+     * @return std::vector<std::size_t>
+     */
+    std::vector<std::size_t> pareto_front()
+    {
+      std::vector<std::size_t> indices;
+      _selection_f.pareto_front(fitness(), indices);
+      return indices;
+    }
+
+    /**
+     * @brief number of generations evolved so far
+     *
+     * @return std::size_t
+     */
+    std::size_t generation() const
+    {
+      return _generation;
+    }
+
+    /**
+     * @brief number of individuals passed to the objective function so far
+     *
+     * @return std::size_t
+     */
+    std::size_t evaluations() const
+    {
+      return _evaluations;
+    }
+
+  private:
+
+    void evaluate()
+    {
+      std::size_t individual_size = _population.shape()[0];
+      auto&& y = _objective_f(_population);
+      std::size_t num_of_objectives = y.shape()[1];
+
+      std::array<std::size_t, 2> shape_y = { individual_size, num_of_objectives };
+      _y.resize(shape_y);
+      for (std::size_t i{ 0 }; i < individual_size; ++i)
+      {
+        for (std::size_t m{ 0 }; m < num_of_objectives; ++m)
+        {
+          _y(i, m) = y(i, m);
+        }
+      }
+
+      _evaluations += individual_size;
+      _evaluated = true;
+    }
+
+    E _population; ///< current population
+    E _mating; ///< mating pool
+    E _offspring; ///< children
+    fitness_type _y; ///< evaluations of the current population
+    fitness_type _y_offspring; ///< evaluations of the children
+    fitness_type _y_combined; ///< evaluations of parents and children
+    std::vector<std::size_t> _indices; ///< survivors (scratch)
+    OBJ _objective_f;
+    SEL _selection_f;
+    CROSS _cross_f;
+    MUT _mutation_f;
+    std::size_t _generation{ 0 };
+    std::size_t _evaluations{ 0 };
+    bool _evaluated{ false };
+  };
+
+  /**
+   * @brief helper to construct an nsga2_state with deduced functor types
+   *
+   * @param X initial population
+   * @param objective_f objective function
+   * @param selection_f functor for selection
+   * @param cross_f functor for crossover
+   * @param mutation_f functor for mutation
+   * @return nsga2_state<E, OBJ, SEL, CROSS, MUT>
+   */
+  template<class E, class OBJ, class SEL, class CROSS, class MUT>
+  auto make_nsga2_state(const E& X, OBJ objective_f, SEL selection_f, CROSS cross_f, MUT mutation_f)
+  {
+    return nsga2_state<E, OBJ, SEL, CROSS, MUT>(X, std::move(objective_f), std::move(selection_f),
+      std::move(cross_f), std::move(mutation_f));
+  }
+
+}
+
+#endif
@@ -0,0 +1,1051 @@
+/**
+ * @file pareto.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief templated header file with the bounded Pareto archive, the hypervolume
+ *  indicator and the hypervolume terminating functor.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __PARETO_HPP__
+#define __PARETO_HPP__
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+
+#include "nsga2.hpp"
+
+
+namespace xevo
+{
+  namespace detail
+  {
+    /**
+     * @brief true when a is no worse than b in every objective (minimisation)
+     */
+    template <class T>
+    inline bool weakly_dominates(const T* a, const T* b, std::size_t num_of_objectives)
+    {
+      for (std::size_t m{ 0 }; m < num_of_objectives; ++m)
+      {
+        if (b[m] < a[m])
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    /**
+     * @brief true when a is no worse than b in every objective and better in one (minimisation)
+     */
+    template <class T>
+    inline bool dominates(const T* a, const T* b, std::size_t num_of_objectives)
+    {
+      bool better{ false };
+      for (std::size_t m{ 0 }; m < num_of_objectives; ++m)
+      {
+        if (b[m] < a[m])
+        {
+          return false;
+        }
+        better = better || a[m] < b[m];
+      }
+      return better;
+    }
+
+    /**
+     * @brief appends a point to a row-major set, keeping the set mutually non-dominated
+     *
+     * @param point point with num_of_objectives values
+     * @param points row-major set (capacity for one more row)
+     * @param n number of rows of the set, updated
+     */
+    template <class T>
+    inline void append_non_dominated(const T* point, T* points, std::size_t& n, std::size_t num_of_objectives)
+    {
+      std::size_t k{ 0 };
+      while (k < n)
+      {
+        T* other = points + k * num_of_objectives;
+        if (weakly_dominates(other, point, num_of_objectives))
+        {
+          return;
+        }
+        if (weakly_dominates(point, other, num_of_objectives))
+        {
+          --n;
+          std::copy(points + n * num_of_objectives, points + (n + 1) * num_of_objectives, other);
+        }
+        else
+        {
+          ++k;
+        }
+      }
+      std::copy(point, point + num_of_objectives, points + n * num_of_objectives);
+      ++n;
+    }
+  }
+
+  /**
+   * @brief Hypervolume indicator
+   *
+   * The objectives are converted to minimisation and the rows that are not strictly
+   * better than the reference point in every objective are dropped. Two objectives
+   * are handled by a sort and a sweep, three by a sweep on the last objective over
+   * a staircase of the first two (both O(N log N) for the sort plus the sweep), and
+   * more objectives by WFG: the points are sorted worst first on the last objective,
+   * so that the limit set of every point shares its last objective and the exclusive
+   * hypervolumes are computed one dimension down. Scratch buffers are kept between
+   * calls, so evaluating the indicator every generation does not allocate.
+   *
+   * @tparam T value type
+   */
+  template <class T = double>
+  class hypervolume
+  {
+  public:
+    /**
+     * @brief Construct a new hypervolume object
+     *
+     * @param reference reference point, one value per objective
+     * @param maximise true when larger objectives are better
+     */
+    hypervolume(std::vector<T> reference, bool maximise = false) :
+      _reference(std::move(reference)), _maximise{ maximise }
+    {
+      if (_reference.empty())
+      {
+        throw std::runtime_error("hypervolume: empty reference point");
+      }
+      _minimised = _reference;
+      if (_maximise)
+      {
+        for (T& r : _minimised)
+        {
+          r = -r;
+        }
+      }
+      std::size_t num_of_objectives = _reference.size();
+      _order.resize(num_of_objectives + 1);
+      _sorted.resize(num_of_objectives + 1);
+      _limited.resize(num_of_objectives + 1);
+      _point.resize(num_of_objectives + 1);
+    }
+
+    /**
+     * @brief hypervolume of the rows of a matrix
+     *
+     * @tparam F xtensor type of the evaluations (N x M)
+     * @param Y evaluations
+     * @return T
+     */
+    template <class F>
+    T operator()(const F& Y)
+    {
+      std::size_t num_of_objectives = _reference.size();
+      if (Y.shape()[1] != num_of_objectives)
+      {
+        throw std::runtime_error("hypervolume: the evaluations do not match the reference point");
+      }
+
+      std::size_t num_of_points = Y.shape()[0];
+      _points.resize((num_of_points + 1) * num_of_objectives);
+      _point[0].resize(num_of_objectives);
+      std::size_t n{ 0 };
+      for (std::size_t i{ 0 }; i < num_of_points; ++i)
+      {
+        for (std::size_t m{ 0 }; m < num_of_objectives; ++m)
+        {
+          _point[0][m] = _maximise ? -T(Y(i, m)) : T(Y(i, m));
+        }
+        add(_point[0].data(), n);
+      }
+      return wfg(_points.data(), n, num_of_objectives);
+    }
+
+    /**
+     * @brief hypervolume of row-major points
+     *
+     * @param points num_of_points x M values
+     * @param num_of_points number of points
+     * @return T
+     */
+    T operator()(const T* points, std::size_t num_of_points)
+    {
+      std::size_t num_of_objectives = _reference.size();
+      _points.resize((num_of_points + 1) * num_of_objectives);
+      _point[0].resize(num_of_objectives);
+      std::size_t n{ 0 };
+      for (std::size_t i{ 0 }; i < num_of_points; ++i)
+      {
+        for (std::size_t m{ 0 }; m < num_of_objectives; ++m)
+        {
+          T y = points[i * num_of_objectives + m];
+          _point[0][m] = _maximise ? -y : y;
+        }
+        add(_point[0].data(), n);
+      }
+      return wfg(_points.data(), n, num_of_objectives);
+    }
+
+    /**
+     * @brief reference point
+     *
+     * @return const std::vector<T>&
+     */
+    const std::vector<T>& reference() const
+    {
+      return _reference;
+    }
+
+  private:
+
+    void add(const T* point, std::size_t& n)
+    {
+      std::size_t num_of_objectives = _minimised.size();
+      for (std::size_t m{ 0 }; m < num_of_objectives; ++m)
+      {
+        if (!(point[m] < _minimised[m]))
+        {
+          return;
+        }
+      }
+      detail::append_non_dominated(point, _points.data(), n, num_of_objectives);
+    }
+
+    T inclusive(const T* point, std::size_t num_of_objectives) const
+    {
+      T volume{ 1 };
+      for (std::size_t m{ 0 }; m < num_of_objectives; ++m)
+      {
+        volume *= _minimised[m] - point[m];
+      }
+      return volume;
+    }
+
+    T wfg(const T* points, std::size_t n, std::size_t num_of_objectives)
+    {
+      if (n == 0)
+      {
+        return T(0);
+      }
+      if (n == 1)
+      {
+        return inclusive(points, num_of_objectives);
+      }
+      if (num_of_objectives == 1)
+      {
+        T best = points[0];
+        for (std::size_t i{ 1 }; i < n; ++i)
+        {
+          best = std::min(best, points[i]);
+        }
+        return _minimised[0] - best;
+      }
+      if (num_of_objectives == 2)
+      {
+        return sweep_2d(points, n);
+      }
+      if (num_of_objectives == 3)
+      {
+        return sweep_3d(points, n);
+      }
+
+      std::size_t last = num_of_objectives - 1;
+      auto& order = _order[num_of_objectives];
+      order.resize(n);
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        order[i] = i;
+      }
+      std::sort(order.begin(), order.end(), [points, num_of_objectives, last](std::size_t a, std::size_t b)
+      {
+        return points[b * num_of_objectives + last] < points[a * num_of_objectives + last];
+      });
+      auto& sorted = _sorted[num_of_objectives];
+      sorted.resize(n * num_of_objectives);
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        std::copy(points + order[i] * num_of_objectives, points + (order[i] + 1) * num_of_objectives,
+          sorted.begin() + i * num_of_objectives);
+      }
+
+      auto& limited = _limited[num_of_objectives];
+      auto& point = _point[num_of_objectives];
+      limited.resize(n * last);
+      point.resize(last);
+      T volume{ 0 };
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        const T* p = sorted.data() + i * num_of_objectives;
+        std::size_t k{ 0 };
+        for (std::size_t j{ i + 1 }; j < n; ++j)
+        {
+          const T* q = sorted.data() + j * num_of_objectives;
+          for (std::size_t m{ 0 }; m < last; ++m)
+          {
+            point[m] = std::max(p[m], q[m]);
+          }
+          detail::append_non_dominated(point.data(), limited.data(), k, last);
+        }
+        volume += (_minimised[last] - p[last]) * (inclusive(p, last) - wfg(limited.data(), k, last));
+      }
+      return volume;
+    }
+
+    T sweep_2d(const T* points, std::size_t n)
+    {
+      auto& order = _order[2];
+      order.resize(n);
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        order[i] = i;
+      }
+      std::sort(order.begin(), order.end(), [points](std::size_t a, std::size_t b)
+      {
+        return points[2 * a] < points[2 * b] || (points[2 * a] == points[2 * b] && points[2 * a + 1] < points[2 * b + 1]);
+      });
+
+      T area{ 0 };
+      T height = _minimised[1];
+      for (std::size_t i : order)
+      {
+        const T* p = points + 2 * i;
+        if (p[1] < height)
+        {
+          area += (_minimised[0] - p[0]) * (height - p[1]);
+          height = p[1];
+        }
+      }
+      return area;
+    }
+
+    T sweep_3d(const T* points, std::size_t n)
+    {
+      auto& order = _order[3];
+      order.resize(n);
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        order[i] = i;
+      }
+      std::sort(order.begin(), order.end(), [points](std::size_t a, std::size_t b)
+      {
+        return points[3 * a + 2] < points[3 * b + 2];
+      });
+
+      // staircase of the first two objectives: x increasing, y decreasing
+      auto& stair = _stair;
+      stair.clear();
+      auto contribution = [&stair, this](std::size_t k)
+      {
+        T next = k + 1 < stair.size() ? stair[k + 1].first : _minimised[0];
+        return (next - stair[k].first) * (_minimised[1] - stair[k].second);
+      };
+
+      T area{ 0 };
+      T volume{ 0 };
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        const T* p = points + 3 * order[i];
+        std::pair<T, T> xy(p[0], p[1]);
+        auto upper = std::upper_bound(stair.begin(), stair.end(), xy, [](const std::pair<T, T>& a, const std::pair<T, T>& b)
+        {
+          return a.first < b.first;
+        });
+        bool covered = upper != stair.begin() && std::prev(upper)->second <= xy.second;
+        if (!covered)
+        {
+          auto lower = std::lower_bound(stair.begin(), stair.end(), xy, [](const std::pair<T, T>& a, const std::pair<T, T>& b)
+          {
+            return a.first < b.first;
+          });
+          std::size_t first = std::size_t(lower - stair.begin());
+          std::size_t last = first;
+          while (last < stair.size() && stair[last].second >= xy.second)
+          {
+            ++last;
+          }
+          if (first > 0)
+          {
+            area -= contribution(first - 1);
+          }
+          for (std::size_t k{ first }; k < last; ++k)
+          {
+            area -= contribution(k);
+          }
+          stair.erase(stair.begin() + first, stair.begin() + last);
+          stair.insert(stair.begin() + first, xy);
+          area += contribution(first);
+          if (first > 0)
+          {
+            area += contribution(first - 1);
+          }
+        }
+        T next = i + 1 < n ? points[3 * order[i + 1] + 2] : _minimised[2];
+        volume += area * (next - p[2]);
+      }
+      return volume;
+    }
+
+    std::vector<T> _reference; ///< reference point
+    std::vector<T> _minimised; ///< reference point for minimisation
+    bool _maximise;
+    std::vector<T> _points; ///< filtered points (scratch)
+    std::vector<std::vector<std::size_t>> _order; ///< sort order per number of objectives (scratch)
+    std::vector<std::vector<T>> _sorted; ///< sorted points per number of objectives (scratch)
+    std::vector<std::vector<T>> _limited; ///< limit sets per number of objectives (scratch)
+    std::vector<std::vector<T>> _point; ///< single point per number of objectives (scratch)
+    std::vector<std::pair<T, T>> _stair; ///< staircase of the 3d sweep (scratch)
+  };
+
+  /**
+   * @brief Bounded archive of non-dominated points (ND-tree)
+   *
+   * The points are kept in the leaves of an ND-tree whose nodes store an ideal and
+   * a nadir point of their subtree. On insertion a node is skipped when the new point
+   * can neither dominate nor be dominated by its bounds, rejected when its nadir
+   * weakly dominates the new point and emptied when the new point weakly dominates its
+   * ideal, so the dominance checks touch O(log n) nodes on average. A full leaf is
+   * split around far apart seeds. When the archive grows past its capacity the point
+   * with the smallest crowding distance is dropped; the extreme points are always kept.
+   *
+   * @tparam T value type
+   */
+  template <class T = double>
+  class pareto_archive
+  {
+  public:
+    /**
+     * @brief Construct a new pareto_archive object
+     *
+     * @param num_of_objectives number of objectives
+     * @param num_of_vars number of variables stored with every point (can be zero)
+     * @param capacity maximum number of points
+     * @param maximise true when larger objectives are better
+     * @param leaf_size maximum number of points of a leaf
+     * @param branching number of children of a split leaf (zero: number of objectives + 1)
+     */
+    pareto_archive(std::size_t num_of_objectives, std::size_t num_of_vars, std::size_t capacity, bool maximise = false,
+      std::size_t leaf_size = 20, std::size_t branching = 0) :
+      _num_of_objectives{ num_of_objectives }, _num_of_vars{ num_of_vars }, _capacity{ capacity },
+      _maximise{ maximise }, _leaf_size{ std::max<std::size_t>(leaf_size, 2) },
+      _branching{ branching == 0 ? num_of_objectives + 1 : std::max<std::size_t>(branching, 2) }
+    {
+      if (num_of_objectives == 0 || capacity == 0)
+      {
+        throw std::runtime_error("pareto_archive: the number of objectives and the capacity must be positive");
+      }
+      std::array<std::size_t, 2> shape_keys = { capacity + 1, num_of_objectives };
+      std::array<std::size_t, 2> shape_genes = { capacity + 1, num_of_vars };
+      _keys.resize(shape_keys);
+      _genes.resize(shape_genes);
+      _candidate.resize(num_of_objectives);
+      clear();
+    }
+
+    /**
+     * @brief remove all points
+     */
+    void clear()
+    {
+      _nodes.clear();
+      _free_nodes.clear();
+      _leaf_of.assign(_capacity + 1, npos);
+      _free_slots.resize(_capacity + 1);
+      for (std::size_t s{ 0 }; s < _capacity + 1; ++s)
+      {
+        _free_slots[s] = _capacity - s;
+      }
+      _root = npos;
+      _size = 0;
+    }
+
+    /**
+     * @brief insert a point
+     *
+     * @param y objectives of the point
+     * @param x variables of the point (ignored when the archive stores no variables)
+     * @return true when the point is kept in the archive
+     */
+    bool insert(const T* y, const T* x)
+    {
+      for (std::size_t m{ 0 }; m < _num_of_objectives; ++m)
+      {
+        _candidate[m] = _maximise ? -y[m] : y[m];
+      }
+
+      if (_root != npos)
+      {
+        if (!update(_root, _candidate.data()))
+        {
+          return false;
+        }
+        if (empty(_root))
+        {
+          _nodes[_root].leaf = true;
+        }
+      }
+      else
+      {
+        _root = new_node(npos);
+      }
+
+      std::size_t slot = _free_slots.back();
+      _free_slots.pop_back();
+      std::copy(_candidate.begin(), _candidate.end(), _keys.data() + slot * _num_of_objectives);
+      for (std::size_t j{ 0 }; j < _num_of_vars; ++j)
+      {
+        _genes(slot, j) = x[j];
+      }
+      place(slot);
+      ++_size;
+
+      if (_size > _capacity)
+      {
+        truncate();
+      }
+      return _leaf_of[slot] != npos;
+    }
+
+    /**
+     * @brief insert the rows of a population
+     *
+     * @tparam E xtensor type of the population
+     * @tparam F xtensor type of the evaluations (N x M)
+     * @param X population
+     * @param Y evaluations
+     * @return std::size_t number of rows kept in the archive
+     */
+    template <class E, class F>
+    std::size_t insert(const xt::xexpression<E>& X, const xt::xexpression<F>& Y)
+    {
+      const E& _X = X.derived_cast();
+      const F& _Y = Y.derived_cast();
+      std::size_t num_of_indiv = _Y.shape()[0];
+      if (_Y.shape()[1] != _num_of_objectives || (_num_of_vars > 0 && _X.shape()[1] != _num_of_vars))
+      {
+        throw std::runtime_error("pareto_archive: the population does not match the archive");
+      }
+
+      std::vector<T> y(_num_of_objectives);
+      std::vector<T> x(_num_of_vars);
+      std::size_t kept{ 0 };
+      for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+      {
+        for (std::size_t m{ 0 }; m < _num_of_objectives; ++m)
+        {
+          y[m] = T(_Y(i, m));
+        }
+        for (std::size_t j{ 0 }; j < _num_of_vars; ++j)
+        {
+          x[j] = T(_X(i, j));
+        }
+        kept += insert(y.data(), x.data()) ? 1 : 0;
+      }
+      return kept;
+    }
+
+    /**
+     * @brief number of points
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const
+    {
+      return _size;
+    }
+
+    /**
+     * @brief maximum number of points
+     *
+     * @return std::size_t
+     */
+    std::size_t capacity() const
+    {
+      return _capacity;
+    }
+
+    /**
+     * @brief objectives of the points
+     *
+     * @return xt::xtensor<T, 2> (size x M), same row order as genes()
+     */
+    xt::xtensor<T, 2> objectives() const
+    {
+      xt::xtensor<T, 2> Y;
+      std::array<std::size_t, 2> shape = { _size, _num_of_objectives };
+      Y.resize(shape);
+      std::size_t i{ 0 };
+      for (std::size_t s{ 0 }; s < _capacity + 1; ++s)
+      {
+        if (_leaf_of[s] != npos)
+        {
+          for (std::size_t m{ 0 }; m < _num_of_objectives; ++m)
+          {
+            Y(i, m) = _maximise ? -_keys(s, m) : _keys(s, m);
+          }
+          ++i;
+        }
+      }
+      return Y;
+    }
+
+    /**
+     * @brief variables of the points
+     *
+     * @return xt::xtensor<T, 2> (size x num_of_vars), same row order as objectives()
+     */
+    xt::xtensor<T, 2> genes() const
+    {
+      xt::xtensor<T, 2> X;
+      std::array<std::size_t, 2> shape = { _size, _num_of_vars };
+      X.resize(shape);
+      std::size_t i{ 0 };
+      for (std::size_t s{ 0 }; s < _capacity + 1; ++s)
+      {
+        if (_leaf_of[s] != npos)
+        {
+          for (std::size_t j{ 0 }; j < _num_of_vars; ++j)
+          {
+            X(i, j) = _genes(s, j);
+          }
+          ++i;
+        }
+      }
+      return X;
+    }
+
+  private:
+
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    struct node
+    {
+      std::vector<T> ideal;
+      std::vector<T> nadir;
+      std::vector<std::size_t> children; ///< nodes (internal node)
+      std::vector<std::size_t> slots; ///< points (leaf)
+      std::size_t parent;
+      bool leaf;
+    };
+
+    const T* key(std::size_t slot) const
+    {
+      return _keys.data() + slot * _num_of_objectives;
+    }
+
+    bool empty(std::size_t id) const
+    {
+      return _nodes[id].slots.empty() && _nodes[id].children.empty();
+    }
+
+    std::size_t new_node(std::size_t parent)
+    {
+      std::size_t id;
+      if (_free_nodes.empty())
+      {
+        id = _nodes.size();
+        _nodes.emplace_back();
+      }
+      else
+      {
+        id = _free_nodes.back();
+        _free_nodes.pop_back();
+      }
+      node& nd = _nodes[id];
+      nd.ideal.assign(_num_of_objectives, T(0));
+      nd.nadir.assign(_num_of_objectives, T(0));
+      nd.children.clear();
+      nd.slots.clear();
+      nd.parent = parent;
+      nd.leaf = true;
+      return id;
+    }
+
+    void free_slot(std::size_t slot)
+    {
+      _leaf_of[slot] = npos;
+      _free_slots.push_back(slot);
+      --_size;
+    }
+
+    // frees the points and the descendants of a node, which is left empty
+    void clear_node(std::size_t id)
+    {
+      for (std::size_t slot : _nodes[id].slots)
+      {
+        free_slot(slot);
+      }
+      _nodes[id].slots.clear();
+      for (std::size_t child : _nodes[id].children)
+      {
+        clear_node(child);
+        _free_nodes.push_back(child);
+      }
+      _nodes[id].children.clear();
+    }
+
+    // removes the points of the subtree dominated by the candidate; false when the candidate is dominated
+    bool update(std::size_t id, const T* candidate)
+    {
+      std::size_t num_of_objectives = _num_of_objectives;
+      if (detail::weakly_dominates(_nodes[id].nadir.data(), candidate, num_of_objectives))
+      {
+        return false;
+      }
+      if (detail::weakly_dominates(candidate, _nodes[id].ideal.data(), num_of_objectives))
+      {
+        clear_node(id);
+        return true;
+      }
+      if (!detail::weakly_dominates(_nodes[id].ideal.data(), candidate, num_of_objectives) &&
+        !detail::weakly_dominates(candidate, _nodes[id].nadir.data(), num_of_objectives))
+      {
+        return true;
+      }
+
+      if (_nodes[id].leaf)
+      {
+        auto& slots = _nodes[id].slots;
+        std::size_t k{ 0 };
+        while (k < slots.size())
+        {
+          const T* point = key(slots[k]);
+          if (detail::weakly_dominates(point, candidate, num_of_objectives))
+          {
+            return false;
+          }
+          if (detail::dominates(candidate, point, num_of_objectives))
+          {
+            free_slot(slots[k]);
+            slots[k] = slots.back();
+            slots.pop_back();
+          }
+          else
+          {
+            ++k;
+          }
+        }
+        return true;
+      }
+
+      for (std::size_t k{ 0 }; k < _nodes[id].children.size(); ++k)
+      {
+        if (!update(_nodes[id].children[k], candidate))
+        {
+          return false;
+        }
+      }
+      auto& children = _nodes[id].children;
+      std::size_t k{ 0 };
+      while (k < children.size())
+      {
+        if (empty(children[k]))
+        {
+          _free_nodes.push_back(children[k]);
+          children[k] = children.back();
+          children.pop_back();
+        }
+        else
+        {
+          ++k;
+        }
+      }
+      return true;
+    }
+
+    void extend_bounds(std::size_t id, const T* point)
+    {
+      node& nd = _nodes[id];
+      if (empty(id))
+      {
+        std::copy(point, point + _num_of_objectives, nd.ideal.begin());
+        std::copy(point, point + _num_of_objectives, nd.nadir.begin());
+        return;
+      }
+      for (std::size_t m{ 0 }; m < _num_of_objectives; ++m)
+      {
+        nd.ideal[m] = std::min(nd.ideal[m], point[m]);
+        nd.nadir[m] = std::max(nd.nadir[m], point[m]);
+      }
+    }
+
+    T distance_to_middle(std::size_t id, const T* point) const
+    {
+      const node& nd = _nodes[id];
+      T distance{ 0 };
+      for (std::size_t m{ 0 }; m < _num_of_objectives; ++m)
+      {
+        T d = point[m] - (nd.ideal[m] + nd.nadir[m]) / T(2);
+        distance += d * d;
+      }
+      return distance;
+    }
+
+    T distance(const T* a, const T* b) const
+    {
+      T d2{ 0 };
+      for (std::size_t m{ 0 }; m < _num_of_objectives; ++m)
+      {
+        d2 += (a[m] - b[m]) * (a[m] - b[m]);
+      }
+      return d2;
+    }
+
+    // descends to the leaf with the closest middle point, extending the bounds on the way
+    void place(std::size_t slot)
+    {
+      const T* point = key(slot);
+      std::size_t id = _root;
+      while (!_nodes[id].leaf)
+      {
+        extend_bounds(id, point);
+        const auto& children = _nodes[id].children;
+        std::size_t closest = children[0];
+        T closest_distance = distance_to_middle(closest, point);
+        for (std::size_t k{ 1 }; k < children.size(); ++k)
+        {
+          T d = distance_to_middle(children[k], point);
+          if (d < closest_distance)
+          {
+            closest_distance = d;
+            closest = children[k];
+          }
+        }
+        id = closest;
+      }
+      extend_bounds(id, point);
+      _nodes[id].slots.push_back(slot);
+      _leaf_of[slot] = id;
+      if (_nodes[id].slots.size() > _leaf_size)
+      {
+        split(id);
+      }
+    }
+
+    // turns a full leaf into an internal node with leaves grown around far apart seeds
+    void split(std::size_t id)
+    {
+      std::vector<std::size_t> slots;
+      slots.swap(_nodes[id].slots);
+      _nodes[id].leaf = false;
+      std::size_t n = slots.size();
+
+      // first seed: largest average distance to the other points
+      std::size_t first{ 0 };
+      T first_distance{ -1 };
+      for (std::size_t a{ 0 }; a < n; ++a)
+      {
+        T sum{ 0 };
+        for (std::size_t b{ 0 }; b < n; ++b)
+        {
+          sum += distance(key(slots[a]), key(slots[b]));
+        }
+        if (sum > first_distance)
+        {
+          first_distance = sum;
+          first = a;
+        }
+      }
+
+      // next seeds: farthest from the seeds chosen so far
+      std::size_t num_of_children = std::min(_branching, n);
+      std::vector<std::size_t> seeds{ first };
+      std::vector<T> nearest(n, std::numeric_limits<T>::max());
+      while (seeds.size() < num_of_children)
+      {
+        std::size_t last = seeds.back();
+        std::size_t farthest{ 0 };
+        T farthest_distance{ -1 };
+        for (std::size_t a{ 0 }; a < n; ++a)
+        {
+          nearest[a] = std::min(nearest[a], distance(key(slots[a]), key(slots[last])));
+          if (nearest[a] > farthest_distance)
+          {
+            farthest_distance = nearest[a];
+            farthest = a;
+          }
+        }
+        seeds.push_back(farthest);
+      }
+
+      std::vector<std::size_t> children(num_of_children);
+      for (std::size_t c{ 0 }; c < num_of_children; ++c)
+      {
+        children[c] = new_node(id);
+      }
+      _nodes[id].children = children;
+      for (std::size_t a{ 0 }; a < n; ++a)
+      {
+        std::size_t closest{ 0 };
+        T closest_distance = std::numeric_limits<T>::max();
+        for (std::size_t c{ 0 }; c < num_of_children; ++c)
+        {
+          T d = distance(key(slots[a]), key(slots[seeds[c]]));
+          if (d < closest_distance)
+          {
+            closest_distance = d;
+            closest = c;
+          }
+        }
+        std::size_t leaf = children[closest];
+        extend_bounds(leaf, key(slots[a]));
+        _nodes[leaf].slots.push_back(slots[a]);
+        _leaf_of[slots[a]] = leaf;
+      }
+    }
+
+    // drops a point and the nodes left empty above it; the bounds are kept as they are
+    void remove(std::size_t slot)
+    {
+      std::size_t id = _leaf_of[slot];
+      auto& slots = _nodes[id].slots;
+      slots.erase(std::find(slots.begin(), slots.end(), slot));
+      free_slot(slot);
+      while (id != _root && empty(id))
+      {
+        std::size_t parent = _nodes[id].parent;
+        auto& children = _nodes[parent].children;
+        children.erase(std::find(children.begin(), children.end(), id));
+        _free_nodes.push_back(id);
+        id = parent;
+      }
+      if (empty(_root))
+      {
+        _nodes[_root].leaf = true;
+      }
+    }
+
+    // drops the most crowded point
+    void truncate()
+    {
+      _live.clear();
+      for (std::size_t s{ 0 }; s < _capacity + 1; ++s)
+      {
+        if (_leaf_of[s] != npos)
+        {
+          _live.push_back(s);
+        }
+      }
+      crowding_distance(_keys, _live, _crowding);
+      std::size_t crowded = _live[0];
+      for (std::size_t s : _live)
+      {
+        if (_crowding[s] < _crowding[crowded])
+        {
+          crowded = s;
+        }
+      }
+      remove(crowded);
+    }
+
+    std::size_t _num_of_objectives;
+    std::size_t _num_of_vars;
+    std::size_t _capacity;
+    bool _maximise;
+    std::size_t _leaf_size;
+    std::size_t _branching;
+    xt::xtensor<T, 2> _keys; ///< objectives for minimisation, one row per slot
+    xt::xtensor<T, 2> _genes; ///< variables, one row per slot
+    std::vector<std::size_t> _leaf_of; ///< leaf holding every slot (npos when free)
+    std::vector<std::size_t> _free_slots;
+    std::vector<node> _nodes;
+    std::vector<std::size_t> _free_nodes;
+    std::size_t _root;
+    std::size_t _size;
+    std::vector<T> _candidate; ///< point being inserted (scratch)
+    std::vector<std::size_t> _live; ///< occupied slots (scratch)
+    std::vector<double> _crowding; ///< crowding distances (scratch)
+  };
+
+  template <class T>
+  constexpr std::size_t pareto_archive<T>::npos;
+
+  /**
+   * @brief Functor for terminating a multi-objective algorithm when the hypervolume
+   *  of the evaluations stagnates
+   *
+   * Returns true while the hypervolume improved by more than tol within the last
+   * patience calls. The functor keeps its history, so it is passed by reference
+   * (e.g. nsga2_state::step(terminate_f)).
+   */
+  struct Terminate_hypervolume
+  {
+    /**
+     * @brief Construct a new Terminate_hypervolume object
+     *
+     * @param reference reference point, one value per objective
+     * @param patience number of calls without improvement before terminating
+     * @param tol smallest improvement of the hypervolume
+     * @param maximise true when larger objectives are better
+     */
+    Terminate_hypervolume(std::vector<double> reference, std::size_t patience = 10, double tol = 1e-008,
+      bool maximise = false) :
+      _hypervolume(std::move(reference), maximise), _patience{ patience }, _tol{ tol }
+    {
+
+    }
+
+    template <class E, class F>
+    bool operator()(const xt::xexpression<F>&, const xt::xexpression<E>& Y)
+    {
+      const E& _Y = Y.derived_cast();
+      _value = _hypervolume(_Y);
+      if (_value > _best + _tol)
+      {
+        _best = _value;
+        _stalled = 0;
+      }
+      else
+      {
+        ++_stalled;
+      }
+      return _stalled < _patience;
+    }
+
+    /**
+     * @brief hypervolume of the last evaluations
+     *
+     * @return double
+     */
+    double value() const
+    {
+      return _value;
+    }
+
+    /**
+     * @brief number of calls since the last improvement
+     *
+     * @return std::size_t
+     */
+    std::size_t stalled() const
+    {
+      return _stalled;
+    }
+
+  private:
+    hypervolume<double> _hypervolume;
+    std::size_t _patience;
+    double _tol;
+    double _value{ 0.0 };
+    double _best{ -std::numeric_limits<double>::infinity() };
+    std::size_t _stalled{ 0 };
+  };
+}
+
+#endif
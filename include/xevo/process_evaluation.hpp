@@ -0,0 +1,715 @@
+/**
+ * @file process_evaluation.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief header file with the evaluation of objective functions by local worker processes.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __PROCESS_EVALUATION_HPP__
+#define __PROCESS_EVALUATION_HPP__
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(__APPLE__)
+#include <crt_externs.h>
+#else
+extern char** environ;
+#endif
+
+#include "xtensor/xtensor.hpp"
+
+#define XEVO_HAS_PROCESS_EVALUATION
+
+
+namespace xevo
+{
+
+  /**
+   * @brief magic number of the evaluation frames ("XEVO" in little endian)
+   */
+  constexpr std::uint32_t evaluation_frame_magic = 0x4f564558u;
+
+  /**
+   * @brief header of the frames exchanged with evaluation worker processes
+   *
+   * A request is the header followed by num_of_rows * num_of_cols doubles (the candidates,
+   * one per row). The reply repeats the tag and num_of_rows with num_of_cols = 1, followed
+   * by num_of_rows doubles (the fitness of the candidates in the same order). All fields
+   * are in the byte order of the host. A worker reads requests from its standard input and
+   * writes the replies to its standard output, one reply per request; diagnostics go to
+   * the standard error.
+   */
+  struct evaluation_frame_header
+  {
+    std::uint32_t magic{ evaluation_frame_magic };
+    std::uint32_t tag{ 0 }; ///< identifier of the request, repeated by the reply
+    std::uint32_t num_of_rows{ 0 }; ///< number of candidates
+    std::uint32_t num_of_cols{ 0 }; ///< number of genes (1 in the replies)
+  };
+
+  namespace detail
+  {
+    /**
+     * @brief read n bytes from a blocking descriptor
+     *
+     * @return false at the end of the file
+     */
+    inline bool read_all(int fd, void* data, std::size_t n)
+    {
+      char* p = static_cast<char*>(data);
+      while (n > 0)
+      {
+        ssize_t r = ::read(fd, p, n);
+        if (r < 0 && errno == EINTR)
+        {
+          continue;
+        }
+        if (r <= 0)
+        {
+          return false;
+        }
+        p += r;
+        n -= static_cast<std::size_t>(r);
+      }
+      return true;
+    }
+
+    /**
+     * @brief environment passed on to the worker processes
+     */
+    inline char** environment()
+    {
+#if defined(__APPLE__)
+      return *_NSGetEnviron();
+#else
+      return environ;
+#endif
+    }
+
+    /**
+     * @brief write n bytes to a blocking descriptor
+     *
+     * @return false when the descriptor is closed
+     */
+    inline bool write_all(int fd, const void* data, std::size_t n)
+    {
+      const char* p = static_cast<const char*>(data);
+      while (n > 0)
+      {
+        ssize_t r = ::write(fd, p, n);
+        if (r < 0 && errno == EINTR)
+        {
+          continue;
+        }
+        if (r <= 0)
+        {
+          return false;
+        }
+        p += r;
+        n -= static_cast<std::size_t>(r);
+      }
+      return true;
+    }
+  }
+
+  /**
+   * @brief main loop of an evaluation worker process
+   *
+   * Reads requests until the end of in_fd, evaluates every request with objective_f
+   * (called with an xt::xtensor<double, 2> holding the candidates) and writes the
+   * replies to out_fd. The main function of a worker executable for process_pool is
+   * typically a single call of serve_evaluations.
+   *
+   * @tparam OBJ functor for objective function
+   * @param objective_f objective function
+   * @param in_fd descriptor of the requests
+   * @param out_fd descriptor of the replies
+   * @return std::size_t number of evaluated requests
+   */
+  template <class OBJ>
+  std::size_t serve_evaluations(OBJ objective_f, int in_fd = STDIN_FILENO, int out_fd = STDOUT_FILENO)
+  {
+    std::size_t num_of_requests{ 0 };
+    evaluation_frame_header header;
+    std::vector<double> y_reply;
+    while (detail::read_all(in_fd, &header, sizeof(header)))
+    {
+      if (header.magic != evaluation_frame_magic)
+      {
+        throw std::runtime_error("serve_evaluations: invalid frame");
+      }
+      std::array<std::size_t, 2> shape = { header.num_of_rows, header.num_of_cols };
+      xt::xtensor<double, 2> X(shape);
+      if (!detail::read_all(in_fd, X.data(), X.size() * sizeof(double)))
+      {
+        throw std::runtime_error("serve_evaluations: truncated frame");
+      }
+
+      auto&& y = objective_f(X);
+      y_reply.resize(header.num_of_rows);
+      for (std::size_t i{ 0 }; i < y_reply.size(); ++i)
+      {
+        y_reply[i] = static_cast<double>(y(i));
+      }
+
+      header.num_of_cols = 1;
+      if (!detail::write_all(out_fd, &header, sizeof(header)) ||
+        !detail::write_all(out_fd, y_reply.data(), y_reply.size() * sizeof(double)))
+      {
+        throw std::runtime_error("serve_evaluations: the reply could not be written");
+      }
+      ++num_of_requests;
+    }
+    return num_of_requests;
+  }
+
+  /**
+   * @brief parameters of a process_pool
+   */
+  struct process_pool_options
+  {
+    std::size_t num_workers{ 4 }; ///< number of worker processes
+    std::size_t batch_size{ 0 }; ///< candidates per request (0 splits the population evenly over the workers)
+    double timeout{ 0.0 }; ///< seconds a worker may take for a request (0 waits forever)
+    std::size_t max_retries{ 2 }; ///< times a request is sent again after its worker crashed or timed out
+  };
+
+  /**
+   * @brief pool of long-lived local processes evaluating an objective function
+   *
+   * Every worker runs command (e.g. an executable calling serve_evaluations, or any
+   * program reading and writing evaluation frames) with its standard input and output
+   * connected to a unix-domain socket. evaluate() splits the candidates in requests of
+   * options().batch_size rows, gives one request at a time to every idle worker and
+   * collects the replies as they arrive, so slow and fast workers overlap. A worker that exits, breaks the frame format or exceeds
+   * options().timeout is killed and started again, and its request is sent again;
+   * evaluate() throws when a request fails more than options().max_retries times.
+   *
+   * Workers are started on first use and stopped (end of file on their standard input)
+   * when the pool is destroyed. Calls of evaluate() from several threads are serialised.
+   */
+  class process_pool
+  {
+  public:
+
+    /**
+     * @brief Construct a new process_pool object
+     *
+     * @param command executable (looked up in PATH) and its arguments
+     * @param options number of workers, batching, timeout and retries
+     */
+    explicit process_pool(std::vector<std::string> command, process_pool_options options = process_pool_options{}) :
+      _command{ std::move(command) }, _options{ options }
+    {
+      if (_command.empty())
+      {
+        throw std::runtime_error("process_pool: empty command");
+      }
+      _options.num_workers = std::max<std::size_t>(_options.num_workers, 1);
+      _workers.resize(_options.num_workers);
+      for (std::string& argument : _command)
+      {
+        _argv.push_back(&argument[0]);
+      }
+      _argv.push_back(nullptr);
+    }
+
+    process_pool(const process_pool&) = delete;
+    process_pool& operator=(const process_pool&) = delete;
+
+    ~process_pool()
+    {
+      shutdown();
+    }
+
+    /**
+     * @brief evaluate the rows of X with the workers
+     *
+     * @tparam E xtensor type of the candidates (one per row)
+     * @tparam Y xtensor type of the fitness
+     * @param X candidates
+     * @param y output with the fitness of every row of X
+     */
+    template <class E, class Y>
+    void evaluate(const E& X, Y& y)
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      std::size_t num_of_indiv = X.shape()[0];
+      std::size_t num_of_vars = X.shape()[1];
+      if (num_of_indiv == 0)
+      {
+        return;
+      }
+
+      std::size_t batch_size = _options.batch_size > 0 ? _options.batch_size :
+        (num_of_indiv + _workers.size() - 1) / _workers.size();
+      std::vector<request> requests;
+      for (std::size_t first{ 0 }; first < num_of_indiv; first += batch_size)
+      {
+        requests.push_back(request{ first, std::min(batch_size, num_of_indiv - first), ++_tag, 0 });
+      }
+      std::deque<std::size_t> pending;
+      for (std::size_t r{ 0 }; r < requests.size(); ++r)
+      {
+        pending.push_back(r);
+      }
+
+      try
+      {
+        std::size_t num_of_completed{ 0 };
+        std::vector<pollfd> fds;
+        std::vector<std::size_t> polled;
+        while (num_of_completed < requests.size())
+        {
+          for (std::size_t w{ 0 }; w < _workers.size() && !pending.empty(); ++w)
+          {
+            if (!_workers[w].busy)
+            {
+              dispatch(_workers[w], pending.front(), requests[pending.front()], X, num_of_vars);
+              pending.pop_front();
+            }
+          }
+
+          fds.clear();
+          polled.clear();
+          for (std::size_t w{ 0 }; w < _workers.size(); ++w)
+          {
+            worker& wk = _workers[w];
+            if (wk.busy)
+            {
+              short events = wk.out_pos < wk.out.size() ? short(POLLIN | POLLOUT) : short(POLLIN);
+              fds.push_back(pollfd{ wk.fd, events, 0 });
+              polled.push_back(w);
+            }
+          }
+
+          if (::poll(fds.data(), static_cast<nfds_t>(fds.size()), poll_timeout()) < 0 && errno != EINTR)
+          {
+            throw std::runtime_error("process_pool: poll failed");
+          }
+
+          auto now = std::chrono::steady_clock::now();
+          for (std::size_t k{ 0 }; k < fds.size(); ++k)
+          {
+            worker& wk = _workers[polled[k]];
+            request& r = requests[wk.request];
+            bool failed{ false };
+            if (fds[k].revents & POLLOUT)
+            {
+              failed = !send_some(wk);
+            }
+            if (!failed && (fds[k].revents & (POLLIN | POLLHUP | POLLERR)))
+            {
+              failed = !receive_some(wk);
+              if (!failed && wk.in_pos == wk.in.size())
+              {
+                failed = !store_reply(wk, r, y);
+                if (!failed)
+                {
+                  wk.busy = false;
+                  ++num_of_completed;
+                  continue;
+                }
+              }
+            }
+            if (!failed && _options.timeout > 0.0 && now >= wk.deadline)
+            {
+              failed = true;
+              ++_timeouts;
+            }
+            if (failed)
+            {
+              stop(wk);
+              if (++r.attempts > _options.max_retries)
+              {
+                throw std::runtime_error("process_pool: a worker crashed or timed out " +
+                  std::to_string(r.attempts) + " times on the rows " + std::to_string(r.first) + " to " +
+                  std::to_string(r.first + r.num_of_rows - 1));
+              }
+              pending.push_front(wk.request);
+            }
+          }
+        }
+      }
+      catch (...)
+      {
+        // replies of the abandoned requests would be read by the next evaluation
+        for (worker& wk : _workers)
+        {
+          if (wk.busy)
+          {
+            stop(wk);
+          }
+        }
+        throw;
+      }
+    }
+
+    /**
+     * @brief number of worker processes
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const
+    {
+      return _workers.size();
+    }
+
+    /**
+     * @brief parameters of the pool
+     *
+     * @return const process_pool_options&
+     */
+    const process_pool_options& options() const
+    {
+      return _options;
+    }
+
+    /**
+     * @brief number of workers started again after a crash or a timeout
+     *
+     * @return std::size_t
+     */
+    std::size_t restarts() const
+    {
+      return _restarts;
+    }
+
+    /**
+     * @brief number of requests that exceeded options().timeout
+     *
+     * @return std::size_t
+     */
+    std::size_t timeouts() const
+    {
+      return _timeouts;
+    }
+
+  private:
+
+    struct request
+    {
+      std::size_t first; ///< first row of the request
+      std::size_t num_of_rows;
+      std::uint32_t tag;
+      std::size_t attempts; ///< failed attempts so far
+    };
+
+    struct worker
+    {
+      pid_t pid{ -1 };
+      int fd{ -1 }; ///< socket connected to the standard input and output of the worker
+      bool started{ false }; ///< the worker has been started before
+      bool busy{ false };
+      std::size_t request{ 0 }; ///< request in progress
+      std::vector<char> out; ///< frame of the request
+      std::size_t out_pos{ 0 }; ///< bytes of out sent
+      std::vector<char> in; ///< frame of the reply
+      std::size_t in_pos{ 0 }; ///< bytes of in received
+      std::chrono::steady_clock::time_point deadline;
+    };
+
+    void start(worker& wk)
+    {
+      int fds[2];
+      if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+      {
+        throw std::runtime_error("process_pool: socketpair failed");
+      }
+      // descriptors of the other workers must not leak into the new one
+      ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+      ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+      int on{ 1 };
+      ::setsockopt(fds[0], SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+      // posix_spawn (unlike fork) is safe while other threads hold locks
+      posix_spawn_file_actions_t actions;
+      posix_spawn_file_actions_init(&actions);
+      posix_spawn_file_actions_adddup2(&actions, fds[1], STDIN_FILENO);
+      posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+      pid_t pid{ -1 };
+      int error = ::posix_spawnp(&pid, _argv[0], &actions, nullptr, _argv.data(), detail::environment());
+      posix_spawn_file_actions_destroy(&actions);
+      ::close(fds[1]);
+      if (error != 0)
+      {
+        ::close(fds[0]);
+        throw std::runtime_error("process_pool: cannot start " + _command[0] + " (" + std::strerror(error) + ")");
+      }
+      ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+      wk.pid = pid;
+      wk.fd = fds[0];
+      if (wk.started)
+      {
+        ++_restarts;
+      }
+      wk.started = true;
+    }
+
+    static void stop(worker& wk)
+    {
+      if (wk.fd >= 0)
+      {
+        ::close(wk.fd);
+        wk.fd = -1;
+      }
+      if (wk.pid > 0)
+      {
+        ::kill(wk.pid, SIGKILL);
+        ::waitpid(wk.pid, nullptr, 0);
+        wk.pid = -1;
+      }
+      wk.busy = false;
+    }
+
+    void shutdown()
+    {
+      for (worker& wk : _workers)
+      {
+        if (wk.fd >= 0)
+        {
+          ::close(wk.fd);
+          wk.fd = -1;
+        }
+      }
+      // workers exit at the end of their input; the ones that do not are killed
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+      for (worker& wk : _workers)
+      {
+        while (wk.pid > 0 && ::waitpid(wk.pid, nullptr, WNOHANG) == 0)
+        {
+          if (std::chrono::steady_clock::now() >= deadline)
+          {
+            stop(wk);
+            break;
+          }
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        wk.pid = -1;
+      }
+    }
+
+    template <class E>
+    void dispatch(worker& wk, std::size_t r, const request& req, const E& X, std::size_t num_of_vars)
+    {
+      if (wk.pid < 0)
+      {
+        start(wk);
+      }
+
+      evaluation_frame_header header;
+      header.tag = req.tag;
+      header.num_of_rows = static_cast<std::uint32_t>(req.num_of_rows);
+      header.num_of_cols = static_cast<std::uint32_t>(num_of_vars);
+
+      wk.out.resize(sizeof(header) + req.num_of_rows * num_of_vars * sizeof(double));
+      std::memcpy(wk.out.data(), &header, sizeof(header));
+      char* genes = wk.out.data() + sizeof(header);
+      for (std::size_t i{ 0 }; i < req.num_of_rows; ++i)
+      {
+        for (std::size_t j{ 0 }; j < num_of_vars; ++j)
+        {
+          double x = static_cast<double>(X(req.first + i, j));
+          std::memcpy(genes, &x, sizeof(double));
+          genes += sizeof(double);
+        }
+      }
+      wk.out_pos = 0;
+      wk.in.resize(sizeof(header) + req.num_of_rows * sizeof(double));
+      wk.in_pos = 0;
+      wk.request = r;
+      wk.busy = true;
+      wk.deadline = std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(_options.timeout));
+    }
+
+    static bool send_some(worker& wk)
+    {
+#ifdef MSG_NOSIGNAL
+      const int flags = MSG_NOSIGNAL;
+#else
+      const int flags = 0;
+#endif
+      while (wk.out_pos < wk.out.size())
+      {
+        ssize_t r = ::send(wk.fd, wk.out.data() + wk.out_pos, wk.out.size() - wk.out_pos, flags);
+        if (r < 0)
+        {
+          return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        wk.out_pos += static_cast<std::size_t>(r);
+      }
+      return true;
+    }
+
+    static bool receive_some(worker& wk)
+    {
+      while (wk.in_pos < wk.in.size())
+      {
+        ssize_t r = ::recv(wk.fd, wk.in.data() + wk.in_pos, wk.in.size() - wk.in_pos, 0);
+        if (r == 0)
+        {
+          return false;
+        }
+        if (r < 0)
+        {
+          return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        wk.in_pos += static_cast<std::size_t>(r);
+      }
+      return true;
+    }
+
+    template <class Y>
+    static bool store_reply(const worker& wk, const request& req, Y& y)
+    {
+      evaluation_frame_header header;
+      std::memcpy(&header, wk.in.data(), sizeof(header));
+      if (header.magic != evaluation_frame_magic || header.tag != req.tag ||
+        header.num_of_rows != req.num_of_rows || header.num_of_cols != 1)
+      {
+        return false;
+      }
+      const char* fitness = wk.in.data() + sizeof(header);
+      for (std::size_t i{ 0 }; i < req.num_of_rows; ++i)
+      {
+        double y_i;
+        std::memcpy(&y_i, fitness + i * sizeof(double), sizeof(double));
+        y(req.first + i) = static_cast<typename Y::value_type>(y_i);
+      }
+      return true;
+    }
+
+    int poll_timeout() const
+    {
+      if (_options.timeout <= 0.0)
+      {
+        return -1;
+      }
+      auto now = std::chrono::steady_clock::now();
+      auto wait = std::chrono::steady_clock::duration::max();
+      for (const worker& wk : _workers)
+      {
+        if (wk.busy)
+        {
+          wait = std::min(wait, wk.deadline - now);
+        }
+      }
+      auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(wait).count() + 1;
+      return static_cast<int>(std::max<decltype(ms)>(ms, 0));
+    }
+
+    std::vector<std::string> _command;
+    std::vector<char*> _argv; ///< command for execvp
+    process_pool_options _options;
+    std::vector<worker> _workers;
+    std::uint32_t _tag{ 0 }; ///< tag of the last request
+    std::size_t _restarts{ 0 };
+    std::size_t _timeouts{ 0 };
+    std::mutex _mutex; ///< serialises evaluate()
+  };
+
+  /**
+   * @brief Functor for evaluating an objective function with local worker processes
+   *
+   * Wraps a process_pool so that external executables can be passed wherever an OBJ
+   * functor is expected (ga_state, pso_state, Evaluate_cached, ...). The candidates are
+   * sent to the workers in requests of options.batch_size rows and evaluated concurrently.
+   * Copies of the functor share the same pool.
+   */
+  struct Evaluate_process
+  {
+    /**
+     * @brief Construct a new Evaluate_process object and its pool of workers
+     *
+     * @param command worker executable and its arguments
+     * @param options number of workers, batching, timeout and retries
+     */
+    Evaluate_process(std::vector<std::string> command, process_pool_options options = process_pool_options{}) :
+      _pool{ std::make_shared<process_pool>(std::move(command), options) }
+    {
+
+    }
+
+    /**
+     * @brief Construct a new Evaluate_process object on an existing pool of workers
+     *
+     * @param pool pool of worker processes
+     */
+    explicit Evaluate_process(std::shared_ptr<process_pool> pool) : _pool{ std::move(pool) }
+    {
+
+    }
+
+    /**
+     * @brief operator to evaluate the objective function
+     *
+     * @tparam E xtensor type of the population
+     * @tparam T value type of xtensor
+     * @param X population (one individual per row)
+     * @return xt::xtensor<T, 1> fitness of every individual
+     */
+    template <class E, typename T = typename std::decay_t<E>::value_type>
+    auto operator()(const xt::xexpression<E>& X)
+    {
+      const E& _X = X.derived_cast();
+      std::array<std::size_t, 1> shape_y = { _X.shape()[0] };
+      xt::xtensor<T, 1> y(shape_y);
+      _pool->evaluate(_X, y);
+      return y;
+    }
+
+    /**
+     * @brief pool of worker processes used for the evaluation
+     *
+     * @return std::shared_ptr<process_pool>
+     */
+    std::shared_ptr<process_pool> pool() const
+    {
+      return _pool;
+    }
+
+  private:
+    std::shared_ptr<process_pool> _pool; ///< pool shared between copies
+  };
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,704 @@
+/**
+ * @file process_island.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief header file with the island model over processes sharing POSIX shared memory.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __PROCESS_ISLAND_HPP__
+#define __PROCESS_ISLAND_HPP__
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "xtensor/xtensor.hpp"
+
+#include "ga.hpp"
+#include "island.hpp"
+#include "kernels.hpp"
+#include "pso.hpp"
+#include "rng.hpp"
+#include "selection.hpp"
+
+#define XEVO_HAS_PROCESS_ISLANDS
+
+
+namespace xevo
+{
+
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "process islands need lock-free 64-bit atomics");
+
+  /**
+   * @brief POSIX shared memory region shared with the processes forked after its creation
+   *
+   * The region is created with shm_open and unlinked at once, so it has no name left
+   * in the file system and is released when the last process holding it unmaps it.
+   */
+  class shared_memory
+  {
+  public:
+
+    /**
+     * @brief create and map a zero filled region
+     *
+     * @param size size in bytes
+     */
+    explicit shared_memory(std::size_t size) : _size{ std::max<std::size_t>(size, 1) }
+    {
+      std::string name = "/xevo_" + std::to_string(static_cast<long>(getpid())) + "_" +
+        std::to_string(counter()++);
+      int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+      if (fd < 0)
+      {
+        throw std::runtime_error("shm_open failed for " + name);
+      }
+      shm_unlink(name.c_str());
+      if (ftruncate(fd, static_cast<off_t>(_size)) != 0)
+      {
+        close(fd);
+        throw std::runtime_error("ftruncate failed for " + name);
+      }
+      void* data = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      if (data == MAP_FAILED)
+      {
+        throw std::runtime_error("mmap failed for " + name);
+      }
+      _data = static_cast<char*>(data);
+    }
+
+    shared_memory(const shared_memory&) = delete;
+    shared_memory& operator=(const shared_memory&) = delete;
+
+    ~shared_memory()
+    {
+      munmap(_data, _size);
+    }
+
+    /**
+     * @brief first byte of the region
+     *
+     * @return char*
+     */
+    char* data() const
+    {
+      return _data;
+    }
+
+    /**
+     * @brief size of the region in bytes
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const
+    {
+      return _size;
+    }
+
+  private:
+    static std::atomic<unsigned>& counter()
+    {
+      static std::atomic<unsigned> c{ 0 };
+      return c;
+    }
+
+    char* _data{ nullptr };
+    std::size_t _size;
+  };
+
+  /**
+   * @brief outcome of one island process
+   */
+  struct process_island_result
+  {
+    std::size_t island{ 0 }; ///< index of the island
+    int exit_status{ 0 }; ///< exit status (1 when the worker threw, -1 when killed by a signal)
+    bool has_best{ false }; ///< the island published a best individual
+    double fitness{ 0.0 }; ///< fitness of the best individual
+    std::vector<double> genes; ///< genes of the best individual
+  };
+
+  namespace detail
+  {
+    inline std::size_t align_to_cache_line(std::size_t n)
+    {
+      return (n + 63) / 64 * 64;
+    }
+
+    /**
+     * @brief head and tail of a single-producer single-consumer ring in shared memory
+     */
+    struct shm_ring_header
+    {
+      alignas(64) std::atomic<std::uint64_t> head{ 0 }; ///< written by the sending island
+      alignas(64) std::atomic<std::uint64_t> tail{ 0 }; ///< written by the receiving island
+    };
+
+    /**
+     * @brief best individual published by an island (guarded by a spin lock)
+     */
+    struct shm_best_header
+    {
+      alignas(64) std::atomic<unsigned> lock{ 0 };
+      std::atomic<std::uint64_t> version{ 0 }; ///< number of updates (0: nothing published)
+      double fitness{ 0.0 };
+    };
+  }
+
+  class island_channel;
+
+  /**
+   * @brief island model over local processes
+   *
+   * run() forks one process per island; every process runs the worker (typically a
+   * ga_state or pso_state loop calling exchange()), so objective functions with global
+   * state never share an address space. The islands communicate through one POSIX shared
+   * memory region holding
+   *
+   * - a lock-free single-producer single-consumer ring buffer of migrants per edge of the
+   *   migration topology (a full ring drops new migrants; no island ever waits), and
+   * - the best individual published by every island, from which the global best is read.
+   *
+   * The launcher waits for every process and collects the best individual of every island.
+   * Thread pools must be created inside the worker, as threads do not survive fork().
+   * Every process derives its own global seed (see xevo::seed) from the seed of the
+   * launcher and the island index, so the functors built inside the worker draw different
+   * numbers on every island, and the same numbers on every run after the same seed.
+   * Functors built before run() and captured by the worker draw the same numbers on
+   * every island.
+   */
+  class process_islands
+  {
+  public:
+
+    /**
+     * @brief Construct a new process_islands object and its shared memory
+     *
+     * @param num_of_islands number of island processes
+     * @param num_of_vars number of genes of an individual
+     * @param options migration parameters (topology, degree, migrants, maximise)
+     * @param capacity number of migrants every ring buffer can hold
+     */
+    process_islands(std::size_t num_of_islands, std::size_t num_of_vars, island_options options = island_options{},
+      std::size_t capacity = 64) :
+      _num_of_islands{ num_of_islands }, _num_of_vars{ num_of_vars }, _options{ options },
+      _capacity{ std::max<std::size_t>(capacity, 1) }
+    {
+      std::vector<std::pair<std::size_t, std::size_t>> edges;
+      migration_edges(num_of_islands, _options, edges);
+      _num_of_edges = edges.size();
+      _out_edges.assign(num_of_islands, {});
+      _in_edges.assign(num_of_islands, {});
+      for (std::size_t e{ 0 }; e < edges.size(); ++e)
+      {
+        _out_edges[edges[e].first].push_back(e);
+        _in_edges[edges[e].second].push_back(e);
+      }
+
+      // layout: rings (header and slots), then best records (header and genes)
+      _slot_size = (num_of_vars + 1) * sizeof(double);
+      _ring_size = sizeof(detail::shm_ring_header) + detail::align_to_cache_line(_capacity * _slot_size);
+      _best_size = sizeof(detail::shm_best_header) + detail::align_to_cache_line(num_of_vars * sizeof(double));
+      _best_offset = edges.size() * _ring_size;
+      _memory.reset(new shared_memory(_best_offset + num_of_islands * _best_size));
+
+      for (std::size_t e{ 0 }; e < edges.size(); ++e)
+      {
+        new (_memory->data() + e * _ring_size) detail::shm_ring_header();
+      }
+      for (std::size_t i{ 0 }; i < num_of_islands; ++i)
+      {
+        new (_memory->data() + _best_offset + i * _best_size) detail::shm_best_header();
+      }
+    }
+
+    /**
+     * @brief fork one process per island running worker(channel) and wait for all of them
+     *
+     * @tparam WORKER callable with signature void(island_channel&)
+     * @param worker body of an island process
+     * @return std::vector<process_island_result> outcome of every island
+     */
+    template <class WORKER>
+    std::vector<process_island_result> run(WORKER worker);
+
+    /**
+     * @brief number of islands
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const
+    {
+      return _num_of_islands;
+    }
+
+    /**
+     * @brief number of genes of an individual
+     *
+     * @return std::size_t
+     */
+    std::size_t num_of_vars() const
+    {
+      return _num_of_vars;
+    }
+
+    /**
+     * @brief migration parameters
+     *
+     * @return const island_options&
+     */
+    const island_options& options() const
+    {
+      return _options;
+    }
+
+    /**
+     * @brief best individual published by island i
+     *
+     * @tparam T type of genes
+     * @param i index of the island
+     * @param genes output with num_of_vars() genes
+     * @param fitness output with the fitness
+     * @return true when island i has published an individual
+     */
+    template <class T>
+    bool best(std::size_t i, T* genes, double& fitness) const
+    {
+      detail::shm_best_header* header = best_header(i);
+      if (header->version.load(std::memory_order_acquire) == 0)
+      {
+        return false;
+      }
+      lock(header);
+      const double* source = best_genes(i);
+      for (std::size_t j{ 0 }; j < _num_of_vars; ++j)
+      {
+        genes[j] = static_cast<T>(source[j]);
+      }
+      fitness = header->fitness;
+      unlock(header);
+      return true;
+    }
+
+    /**
+     * @brief best individual published by any island
+     *
+     * @tparam T type of genes
+     * @param genes output with num_of_vars() genes
+     * @param fitness output with the fitness
+     * @return true when an island has published an individual
+     */
+    template <class T>
+    bool global_best(T* genes, double& fitness) const
+    {
+      std::vector<double> candidate(_num_of_vars);
+      bool found{ false };
+      for (std::size_t i{ 0 }; i < _num_of_islands; ++i)
+      {
+        double y{ 0.0 };
+        if (best(i, candidate.data(), y) && (!found || better(y, fitness)))
+        {
+          std::copy(candidate.begin(), candidate.end(), genes);
+          fitness = y;
+          found = true;
+        }
+      }
+      return found;
+    }
+
+  private:
+    friend class island_channel;
+
+    bool better(double a, double b) const
+    {
+      return _options.maximise ? a > b : a < b;
+    }
+
+    detail::shm_ring_header* ring_header(std::size_t e) const
+    {
+      return reinterpret_cast<detail::shm_ring_header*>(_memory->data() + e * _ring_size);
+    }
+
+    double* ring_slot(std::size_t e, std::uint64_t position) const
+    {
+      char* slots = _memory->data() + e * _ring_size + sizeof(detail::shm_ring_header);
+      return reinterpret_cast<double*>(slots + (position % _capacity) * _slot_size);
+    }
+
+    detail::shm_best_header* best_header(std::size_t i) const
+    {
+      return reinterpret_cast<detail::shm_best_header*>(_memory->data() + _best_offset + i * _best_size);
+    }
+
+    double* best_genes(std::size_t i) const
+    {
+      return reinterpret_cast<double*>(_memory->data() + _best_offset + i * _best_size +
+        sizeof(detail::shm_best_header));
+    }
+
+    static void lock(detail::shm_best_header* header)
+    {
+      while (header->lock.exchange(1u, std::memory_order_acquire) != 0u)
+      {
+        sched_yield();
+      }
+    }
+
+    static void unlock(detail::shm_best_header* header)
+    {
+      header->lock.store(0u, std::memory_order_release);
+    }
+
+    void reset()
+    {
+      for (std::size_t e{ 0 }; e < _num_of_edges; ++e)
+      {
+        ring_header(e)->head.store(0);
+        ring_header(e)->tail.store(0);
+      }
+      for (std::size_t i{ 0 }; i < _num_of_islands; ++i)
+      {
+        best_header(i)->version.store(0);
+      }
+    }
+
+    std::size_t _num_of_islands;
+    std::size_t _num_of_vars;
+    island_options _options;
+    std::size_t _capacity; ///< migrants per ring
+    std::size_t _num_of_edges{ 0 }; ///< number of rings
+    std::size_t _slot_size{ 0 }; ///< bytes per migrant (fitness and genes)
+    std::size_t _ring_size{ 0 }; ///< bytes per ring
+    std::size_t _best_size{ 0 }; ///< bytes per best record
+    std::size_t _best_offset{ 0 }; ///< offset of the best records
+    std::vector<std::vector<std::size_t>> _out_edges; ///< rings written by every island
+    std::vector<std::vector<std::size_t>> _in_edges; ///< rings read by every island
+    std::unique_ptr<shared_memory> _memory; ///< rings and best records
+  };
+
+  /**
+   * @brief view of the shared memory from inside an island process
+   */
+  class island_channel
+  {
+  public:
+
+    island_channel(process_islands& islands, std::size_t island) : _islands{ islands }, _island{ island }
+    {
+
+    }
+
+    /**
+     * @brief index of this island
+     *
+     * @return std::size_t
+     */
+    std::size_t island() const
+    {
+      return _island;
+    }
+
+    /**
+     * @brief number of islands
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const
+    {
+      return _islands.size();
+    }
+
+    /**
+     * @brief migration parameters
+     *
+     * @return const island_options&
+     */
+    const island_options& options() const
+    {
+      return _islands.options();
+    }
+
+    /**
+     * @brief send a migrant over every out-edge
+     *
+     * @tparam T type of genes
+     * @param genes num_of_vars genes
+     * @param fitness fitness of the migrant
+     * @return std::size_t number of edges whose ring had room for the migrant
+     */
+    template <class T>
+    std::size_t send(const T* genes, double fitness)
+    {
+      std::size_t num_of_sent{ 0 };
+      for (std::size_t e : _islands._out_edges[_island])
+      {
+        detail::shm_ring_header* header = _islands.ring_header(e);
+        std::uint64_t head = header->head.load(std::memory_order_relaxed);
+        if (head - header->tail.load(std::memory_order_acquire) >= _islands._capacity)
+        {
+          continue;
+        }
+        double* slot = _islands.ring_slot(e, head);
+        slot[0] = fitness;
+        for (std::size_t j{ 0 }; j < _islands._num_of_vars; ++j)
+        {
+          slot[j + 1] = static_cast<double>(genes[j]);
+        }
+        header->head.store(head + 1, std::memory_order_release);
+        ++num_of_sent;
+      }
+      return num_of_sent;
+    }
+
+    /**
+     * @brief take the oldest migrant waiting on the in-edges (visited in turn)
+     *
+     * @tparam T type of genes
+     * @param genes output with num_of_vars genes
+     * @param fitness output with the fitness of the migrant
+     * @return true when a migrant was taken
+     */
+    template <class T>
+    bool receive(T* genes, double& fitness)
+    {
+      const auto& in_edges = _islands._in_edges[_island];
+      for (std::size_t n{ 0 }; n < in_edges.size(); ++n)
+      {
+        std::size_t e = in_edges[(_next_edge + n) % in_edges.size()];
+        detail::shm_ring_header* header = _islands.ring_header(e);
+        std::uint64_t tail = header->tail.load(std::memory_order_relaxed);
+        if (tail == header->head.load(std::memory_order_acquire))
+        {
+          continue;
+        }
+        const double* slot = _islands.ring_slot(e, tail);
+        fitness = slot[0];
+        for (std::size_t j{ 0 }; j < _islands._num_of_vars; ++j)
+        {
+          genes[j] = static_cast<T>(slot[j + 1]);
+        }
+        header->tail.store(tail + 1, std::memory_order_release);
+        _next_edge = (_next_edge + n + 1) % in_edges.size();
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * @brief publish the best individual of this island (kept only when it improves)
+     *
+     * @tparam T type of genes
+     * @param genes num_of_vars genes
+     * @param fitness fitness of the individual
+     */
+    template <class T>
+    void publish_best(const T* genes, double fitness)
+    {
+      detail::shm_best_header* header = _islands.best_header(_island);
+      process_islands::lock(header);
+      if (header->version.load(std::memory_order_relaxed) == 0 || _islands.better(fitness, header->fitness))
+      {
+        double* target = _islands.best_genes(_island);
+        for (std::size_t j{ 0 }; j < _islands._num_of_vars; ++j)
+        {
+          target[j] = static_cast<double>(genes[j]);
+        }
+        header->fitness = fitness;
+        header->version.fetch_add(1, std::memory_order_release);
+      }
+      process_islands::unlock(header);
+    }
+
+    /**
+     * @brief best individual published by any island
+     *
+     * @tparam T type of genes
+     * @param genes output with num_of_vars genes
+     * @param fitness output with the fitness
+     * @return true when an island has published an individual
+     */
+    template <class T>
+    bool global_best(T* genes, double& fitness) const
+    {
+      return _islands.global_best(genes, fitness);
+    }
+
+  private:
+    process_islands& _islands;
+    std::size_t _island;
+    std::size_t _next_edge{ 0 }; ///< in-edge visited first by the next receive
+  };
+
+  template <class WORKER>
+  std::vector<process_island_result> process_islands::run(WORKER worker)
+  {
+    reset();
+    // buffered output would otherwise be written by every child again
+    std::fflush(nullptr);
+
+    std::vector<pid_t> pids;
+    pids.reserve(_num_of_islands);
+    for (std::size_t i{ 0 }; i < _num_of_islands; ++i)
+    {
+      pid_t pid = fork();
+      if (pid == 0)
+      {
+        // the child inherits the seed and the identifier counter of the launcher
+        seed(detail::mix64(detail::globals().seed.load() ^ detail::mix64(i)));
+        int status{ 0 };
+        try
+        {
+          island_channel channel(*this, i);
+          worker(channel);
+        }
+        catch (...)
+        {
+          status = 1;
+        }
+        std::fflush(nullptr);
+        _exit(status);
+      }
+      if (pid < 0)
+      {
+        for (pid_t started : pids)
+        {
+          waitpid(started, nullptr, 0);
+        }
+        throw std::runtime_error("fork failed for island " + std::to_string(i));
+      }
+      pids.push_back(pid);
+    }
+
+    std::vector<process_island_result> results(_num_of_islands);
+    for (std::size_t i{ 0 }; i < _num_of_islands; ++i)
+    {
+      int status{ 0 };
+      waitpid(pids[i], &status, 0);
+      process_island_result& result = results[i];
+      result.island = i;
+      result.exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+      result.genes.resize(_num_of_vars);
+      result.has_best = best(i, result.genes.data(), result.fitness);
+    }
+    return results;
+  }
+
+  /**
+   * @brief migration step of a ga_state running in an island process
+   *
+   * Sends the options().migrants best individuals over the out-edges, publishes the best
+   * one, and replaces the worst individuals (at most half of the population) with the
+   * migrants waiting on the in-edges. The migrants keep the fitness computed by their
+   * island, so the population is not evaluated again. Objective functions scaled by the
+   * population (e.g. Rosenbrock_scaled) give fitness values that cannot be compared
+   * between islands.
+   *
+   * @param channel channel of the island process
+   * @param state state of the island
+   */
+  template <class E, class OBJ, class ELIT, class SEL, class CROSS, class MUT>
+  inline void exchange(island_channel& channel, ga_state<E, OBJ, ELIT, SEL, CROSS, MUT>& state)
+  {
+    bool maximise = channel.options().maximise;
+    const auto& y = state.fitness();
+    const E& population = state.population();
+    std::size_t num_of_indiv = population.shape()[0];
+    std::size_t num_of_vars = population.shape()[1];
+    std::vector<std::size_t> indices;
+
+    top_k_indices(y, channel.options().migrants, maximise, indices);
+    for (std::size_t i : indices)
+    {
+      channel.send(kernels::row(population, i), static_cast<double>(y(i)));
+    }
+    if (!indices.empty())
+    {
+      channel.publish_best(kernels::row(population, indices[0]), static_cast<double>(y(indices[0])));
+    }
+
+    std::array<std::size_t, 2> shape = { 1, num_of_vars };
+    E migrant = xt::zeros<typename E::value_type>(shape);
+    double y_migrant{ 0.0 };
+    top_k_indices(y, num_of_indiv / 2, !maximise, indices);
+    for (std::size_t r{ 0 }; r < indices.size() && channel.receive(kernels::row(migrant, 0), y_migrant); ++r)
+    {
+      state.replace(indices[r], migrant, 0, static_cast<typename E::value_type>(y_migrant));
+    }
+  }
+
+  /**
+   * @brief migration step of a pso_state running in an island process
+   *
+   * Sends the options().migrants best personal best positions over the out-edges,
+   * publishes the best one, and gives the migrants waiting on the in-edges to the
+   * particles with the worst personal best when the migrant is better. Set
+   * options().maximise to false for minimising swarms.
+   *
+   * @param channel channel of the island process
+   * @param state state of the swarm
+   */
+  template <class E, class F, class OBJ, class POS, class VEL, class SEL>
+  inline void exchange(island_channel& channel, pso_state<E, F, OBJ, POS, VEL, SEL>& state)
+  {
+    bool maximise = channel.options().maximise;
+    const F& y_best = state.fitness_best();
+    const E& position_best = state.position_best();
+    std::size_t num_of_indiv = position_best.shape()[0];
+    std::size_t num_of_vars = position_best.shape()[1];
+    std::vector<std::size_t> indices;
+
+    top_k_indices(y_best, channel.options().migrants, maximise, indices);
+    for (std::size_t i : indices)
+    {
+      channel.send(kernels::row(position_best, i), static_cast<double>(y_best(i)));
+    }
+    if (!indices.empty())
+    {
+      channel.publish_best(kernels::row(position_best, indices[0]), static_cast<double>(y_best(indices[0])));
+    }
+
+    std::array<std::size_t, 2> shape = { 1, num_of_vars };
+    E migrant = xt::zeros<typename E::value_type>(shape);
+    double y_migrant{ 0.0 };
+    top_k_indices(y_best, num_of_indiv / 2, !maximise, indices);
+    for (std::size_t r{ 0 }; r < indices.size() && channel.receive(kernels::row(migrant, 0), y_migrant); ++r)
+    {
+      std::size_t i = indices[r];
+      if (maximise ? y_migrant > y_best(i) : y_migrant < y_best(i))
+      {
+        state.replace_best(i, migrant, 0, static_cast<typename F::value_type>(y_migrant));
+      }
+    }
+  }
+
+}
+
+#endif
+
+#endif
@@ -17,7 +17,9 @@
 
 #include "xtensor/xtensor.hpp"
 
+#include "ask_tell.hpp"
 #include "functors.hpp"
+#include "initialisation.hpp"
 
 
 namespace xevo
@@ -318,6 +320,287 @@ template<class E, class POS = Population, class VEL = Velocity_zero, typename...
  }
 
 };
+
+/**
+ * @brief stateful particle swarm optimisation solver
+ *
+ * pso_state keeps the swarm (positions, velocities, personal bests), the fitness of
+ * the current positions, the functor instances and the generation counter between
+ * generations. The positions are evaluated exactly once per generation, whereas the
+ * terminating overload of pso::evolve evaluates them twice.
+ *
+ * @tparam E xtensor type for positions and velocities
+ * @tparam F xtensor type for evaluations
+ * @tparam OBJ Functor type for objective function evaluation
+ * @tparam POS Functor type for position evaluation
+ * @tparam VEL Functor type for velocity evaluation
+ * @tparam SEL Functor type for selection best evaluation
+ */
+template<class E, class F, class OBJ, class POS = Position, class VEL = Velocity, class SEL = Selection_best_pso>
+class pso_state
+{
+public:
+
+ /**
+  * @brief Construct a new pso_state object
+  *
+  * @param X initial positions of the swarm
+  * @param XB initial best positions of the individuals comprising the swarm
+  * @param YB initial best evaluations of the individuals comprising the swarm
+  * @param V initial velocities of the swarm
+  * @param objective_f functor for objective function evaluation
+  * @param pos_f functor for position evaluation
+  * @param vel_f functor for velocity evaluation
+  * @param sel_f functor for selection best evaluation
+  */
+ pso_state(const E& X, const E& XB, const F& YB, const E& V, OBJ objective_f, POS pos_f, VEL vel_f, SEL sel_f) :
+  _position(X), _position_best(XB), _y_best(YB), _velocity(V), _objective_f{ std::move(objective_f) },
+  _pos_f{ std::move(pos_f) }, _vel_f{ std::move(vel_f) }, _sel_f{ std::move(sel_f) }
+ {
+
+ }
+
+ /**
+  * @brief evolve the swarm by one generation
+  *
+  * The evaluation of the current positions is reused from the previous generation;
+  * only the updated positions are evaluated.
+  */
+ void step()
+ {
+   if (!_evaluated)
+   {
+     evaluate();
+   }
+
+   advance();
+   evaluate();
+ }
+
+ /**
+  * @brief evolve the swarm by one generation and apply a terminating functor
+  *
+  * @tparam TERM Functor type for termination of pso
+  * @param terminate_f terminating functor
+  * @return auto type from terminating functor, evaluated with the stored evaluations
+  */
+ template<class TERM>
+ auto step(TERM terminate_f)
+ {
+   step();
+   return terminate_f(_position, _y);
+ }
+
+ /**
+  * @brief evolve the swarm for a number of generations
+  *
+  * @param generations number of generations
+  */
+ void run(std::size_t generations)
+ {
+   for (std::size_t i{ 0 }; i < generations; ++i)
+   {
+     step();
+   }
+ }
+
+ /**
+  * @brief hand out up to max_rows positions of the current generation for evaluation
+  *
+  * Ask/tell interface for objectives evaluated outside the solver (construct it with
+  * No_objective). The first call hands out the initial positions; the first call after
+  * the evaluations of a whole generation have been told moves the swarm. The batch is a
+  * view of the positions; an empty batch means that every position of the generation
+  * is out and results are pending.
+  *
+  * @param max_rows maximum number of positions
+  * @return ask_batch<typename E::value_type>
+  */
+ ask_batch<typename E::value_type> ask(std::size_t max_rows = std::numeric_limits<std::size_t>::max())
+ {
+   if (!_tracker.collecting())
+   {
+     if (_evaluated)
+     {
+       advance();
+     }
+     std::size_t num_of_indiv = _position.shape()[0];
+     std::array<std::size_t, 1> shape_y = { num_of_indiv };
+     _y.resize(shape_y);
+     _tracker.start(num_of_indiv);
+   }
+   std::size_t first;
+   std::size_t num_of_rows = _tracker.hand_out(max_rows, first);
+   return ask_batch<typename E::value_type>(_generation, first, num_of_rows,
+     make_row_block(_position, first, num_of_rows));
+ }
+
+ /**
+  * @brief pass back the evaluation of a position handed out by ask()
+  *
+  * Results can be told in any order; the generation is complete (and fitness() is
+  * available) when every position has been told.
+  *
+  * @param i row of the position in the generation (ask_batch::indices)
+  * @param y evaluation of the position
+  */
+ void tell(std::size_t i, typename F::value_type y)
+ {
+   bool complete = _tracker.tell(i);
+   _y(i) = y;
+   ++_evaluations;
+   _evaluated = complete;
+ }
+
+ /**
+  * @brief pass back the evaluations of several positions handed out by ask()
+  *
+  * @tparam G container type of the evaluations (indexed with [])
+  * @param indices rows of the positions in the generation
+  * @param y evaluations of the positions, in the order of indices
+  */
+ template <class G>
+ void tell(const std::vector<std::size_t>& indices, const G& y)
+ {
+   for (std::size_t k{ 0 }; k < indices.size(); ++k)
+   {
+     tell(indices[k], typename F::value_type(y[k]));
+   }
+ }
+
+ /**
+  * @brief number of positions handed out by ask() whose evaluation has not been told
+  *
+  * @return std::size_t
+  */
+ std::size_t outstanding() const
+ {
+   return _tracker.outstanding();
+ }
+
+ const E& position() const
+ {
+   return _position;
+ }
+
+ const E& position_best() const
+ {
+   return _position_best;
+ }
+
+ const F& fitness_best() const
+ {
+   return _y_best;
+ }
+
+ const E& velocity() const
+ {
+   return _velocity;
+ }
+
+ /**
+  * @brief evaluations of the current positions (evaluated on first access)
+  *
+  * @return const F&
+  */
+ const F& fitness()
+ {
+   if (!_evaluated)
+   {
+     evaluate();
+   }
+   return _y;
+ }
+
+ /**
+  * @brief replace the best position of particle i with row k of X
+  *
+  * Used to insert migrants (e.g. the best position of another swarm); the particle is
+  * attracted to the new best position from the next generation on.
+  *
+  * @tparam G xtensor type of X
+  * @param i index of the particle
+  * @param X positions
+  * @param k row of X
+  * @param y evaluation of row k of X
+  */
+ template <class G>
+ void replace_best(std::size_t i, const G& X, std::size_t k, typename F::value_type y)
+ {
+   std::size_t num_of_vars = _position_best.shape()[1];
+   for (std::size_t j{ 0 }; j < num_of_vars; ++j)
+   {
+     _position_best(i, j) = X(k, j);
+   }
+   _y_best(i) = y;
+ }
+
+ std::size_t generation() const
+ {
+   return _generation;
+ }
+
+ /**
+  * @brief number of individuals passed to the objective function so far
+  *
+  * @return std::size_t
+  */
+ std::size_t evaluations() const
+ {
+   return _evaluations;
+ }
+
+private:
+
+ /**
+  * @brief move the swarm (the new positions are not evaluated yet)
+  */
+ void advance()
+ {
+   _sel_f(_position, _position_best, _y, _y_best);
+
+   _vel_f(_position, _position_best, _velocity, _y_best);
+
+   _pos_f(_position, _velocity);
+
+   _evaluated = false;
+   ++_generation;
+ }
+
+ void evaluate()
+ {
+   _y = _objective_f(_position);
+   _evaluations += _position.shape()[0];
+   _evaluated = true;
+ }
+
+ E _position;
+ E _position_best;
+ F _y_best;
+ E _velocity;
+ F _y; ///< evaluations of the current positions
+ OBJ _objective_f;
+ POS _pos_f;
+ VEL _vel_f;
+ SEL _sel_f;
+ std::size_t _generation{ 0 };
+ std::size_t _evaluations{ 0 };
+ bool _evaluated{ false };
+ ask_tell_tracker _tracker; ///< positions handed out by ask()
+};
+
+/**
+ * @brief helper to construct a pso_state with deduced functor types
+ *
+ * @return pso_state<E, F, OBJ, POS, VEL, SEL>
+ */
+template<class E, class F, class OBJ, class POS, class VEL, class SEL>
+auto make_pso_state(const E& X, const E& XB, const F& YB, const E& V, OBJ objective_f, POS pos_f, VEL vel_f, SEL sel_f)
+{
+  return pso_state<E, F, OBJ, POS, VEL, SEL>(X, XB, YB, V, std::move(objective_f), std::move(pos_f),
+   std::move(vel_f), std::move(sel_f));
+}
+
 }
 
 #endif
\ No newline at end of file
@@ -17,7 +17,9 @@
 
 #include "xtensor/xtensor.hpp"
 
+#include "ask_tell.hpp"
 #include "functors.hpp"
+#include "initialisation.hpp"
 
 
 namespace xevo
@@ -119,7 +121,7 @@ namespace xevo
      *
      */
     template<class E, class F, class OBJ, class POS = Position_pso_ga, class SEL = Selection_best_pso_ga,
-      class MUT = Mutation_functor_polynomial, class TERM = Terminate_gen_max,
+      class MUT = Mutation_polynomial, class TERM = Terminate_gen_max,
       typename... PosArgs, typename... SelArgs, typename... MutArgs, typename... TermArgs,
       typename T = typename std::decay_t<E>::value_type>
       auto evolve(xt::xexpression<E>& X, xt::xexpression<E>& Xm1, xt::xexpression<F>& YB,
@@ -185,7 +187,7 @@ namespace xevo
      * @param mutargs tuple with arguments for velocity functor
      */
     template<class E, class F, class OBJ, class POS = Position_pso_ga, class SEL = Selection_best_pso_ga,
-      class MUT = Mutation_functor_polynomial, typename... PosArgs, typename... SelArgs, typename... MutArgs,
+      class MUT = Mutation_polynomial, typename... PosArgs, typename... SelArgs, typename... MutArgs,
       std::size_t... PIs, std::size_t... SIs, std::size_t... MIs,
       typename T = typename std::decay_t<E>::value_type>
       void evolve(xt::xexpression<E>& X, xt::xexpression<E>& Xm1, xt::xexpression<F>& YB,
@@ -213,7 +215,7 @@ namespace xevo
 
       sel_f(position, archive, y, y_best);
 
-      mutation_f(position);
+      position = mutation_f(position);
 
       position_m1 = position;
 
@@ -249,7 +251,7 @@ namespace xevo
      * @param termargs tuple with arguments for termination functor
      */
     template<class E, class F, class OBJ, class POS = Position_pso_ga, class SEL = Selection_best_pso_ga,
-      class MUT = Mutation_functor_polynomial, class TERM = Terminate_gen_max,
+      class MUT = Mutation_polynomial, class TERM = Terminate_gen_max,
       typename... PosArgs, typename... SelArgs, typename... MutArgs, typename... TermArgs,
       std::size_t... PIs, std::size_t... SIs, std::size_t... MIs, std::size_t... TIs,
       typename T = typename std::decay_t<E>::value_type>
@@ -265,7 +267,7 @@ namespace xevo
       TERM terminate_f(std::get<TIs>(std::move(termargs))...);
 
       E& position = X.derived_cast();
-      E& position_m1 = XB.derived_cast();
+      E& position_m1 = Xm1.derived_cast();
       F& y_best = YB.derived_cast();
       E& archive = A.derived_cast();
 
@@ -279,7 +281,7 @@ namespace xevo
 
       sel_f(position, archive, y, y_best);
 
-      mutation_f(position);
+      position = mutation_f(position);
 
       position_m1 = position;
 
@@ -287,6 +289,248 @@ namespace xevo
     }
 
   };
+
+  /**
+   * @brief stateful hybrid pso (pso ea) solver
+   *
+   * pso_ga_state keeps the swarm, the archive, the evaluations of the current
+   * positions, the functor instances and the generation counter between generations.
+   * The positions are evaluated exactly once per generation and the terminating
+   * functor reuses that evaluation.
+   *
+   * @tparam E xtensor type for positions and archive
+   * @tparam F xtensor type for evaluations
+   * @tparam OBJ Functor type for objective function evaluation
+   * @tparam POS Functor type for position evaluation
+   * @tparam SEL Functor type for selection evaluation
+   * @tparam MUT Functor type for mutation evaluation
+   */
+  template<class E, class F, class OBJ, class POS = Position_pso_ga, class SEL = Selection_best_pso_ga,
+    class MUT = Mutation_polynomial>
+  class pso_ga_state
+  {
+  public:
+
+    /**
+     * @brief Construct a new pso_ga_state object
+     *
+     * @param X initial positions of the swarm
+     * @param Xm1 previous positions (one generation back) of the swarm
+     * @param YB best evaluations of the individuals comprising the swarm
+     * @param A archived positions of the swarm individuals
+     * @param objective_f functor for objective function evaluation
+     * @param pos_f functor for position evaluation
+     * @param sel_f functor for selection evaluation
+     * @param mutation_f functor for mutation evaluation
+     */
+    pso_ga_state(const E& X, const E& Xm1, const F& YB, const E& A, OBJ objective_f, POS pos_f,
+      SEL sel_f, MUT mutation_f) :
+      _position(X), _position_m1(Xm1), _y_best(YB), _archive(A), _objective_f{ std::move(objective_f) },
+      _pos_f{ std::move(pos_f) }, _sel_f{ std::move(sel_f) }, _mutation_f{ std::move(mutation_f) }
+    {
+
+    }
+
+    /**
+     * @brief evolve the swarm by one generation
+     */
+    void step()
+    {
+      _pos_f(_position, _position_m1, _archive, _y_best);
+
+      evaluate();
+
+      finish();
+    }
+
+    /**
+     * @brief evolve the swarm by one generation and apply a terminating functor
+     *
+     * @tparam TERM Functor type for termination
+     * @param terminate_f terminating functor
+     * @return auto type from terminating functor, evaluated with the stored evaluations
+     */
+    template<class TERM>
+    auto step(TERM terminate_f)
+    {
+      step();
+      return terminate_f(_position, _y);
+    }
+
+    /**
+     * @brief evolve the swarm for a number of generations
+     *
+     * @param generations number of generations
+     */
+    void run(std::size_t generations)
+    {
+      for (std::size_t i{ 0 }; i < generations; ++i)
+      {
+        step();
+      }
+    }
+
+    /**
+     * @brief hand out up to max_rows positions of the current generation for evaluation
+     *
+     * Ask/tell interface for objectives evaluated outside the solver (construct it with
+     * No_objective). The first call of a generation moves the swarm. The batch is a view
+     * of the positions; an empty batch means that every position of the generation is
+     * out and results are pending.
+     *
+     * @param max_rows maximum number of positions
+     * @return ask_batch<typename E::value_type>
+     */
+    ask_batch<typename E::value_type> ask(std::size_t max_rows = std::numeric_limits<std::size_t>::max())
+    {
+      if (!_tracker.collecting())
+      {
+        _pos_f(_position, _position_m1, _archive, _y_best);
+        std::size_t num_of_indiv = _position.shape()[0];
+        std::array<std::size_t, 1> shape_y = { num_of_indiv };
+        _y.resize(shape_y);
+        _tracker.start(num_of_indiv);
+      }
+      std::size_t first;
+      std::size_t num_of_rows = _tracker.hand_out(max_rows, first);
+      return ask_batch<typename E::value_type>(_generation, first, num_of_rows,
+        make_row_block(_position, first, num_of_rows));
+    }
+
+    /**
+     * @brief pass back the evaluation of a position handed out by ask()
+     *
+     * Results can be told in any order; when every position of the generation has been
+     * told, the archive is updated and the swarm is mutated as in step().
+     *
+     * @param i row of the position in the generation (ask_batch::indices)
+     * @param y evaluation of the position
+     */
+    void tell(std::size_t i, typename F::value_type y)
+    {
+      bool complete = _tracker.tell(i);
+      _y(i) = y;
+      ++_evaluations;
+      if (complete)
+      {
+        finish();
+      }
+    }
+
+    /**
+     * @brief pass back the evaluations of several positions handed out by ask()
+     *
+     * @tparam G container type of the evaluations (indexed with [])
+     * @param indices rows of the positions in the generation
+     * @param y evaluations of the positions, in the order of indices
+     */
+    template <class G>
+    void tell(const std::vector<std::size_t>& indices, const G& y)
+    {
+      for (std::size_t k{ 0 }; k < indices.size(); ++k)
+      {
+        tell(indices[k], typename F::value_type(y[k]));
+      }
+    }
+
+    /**
+     * @brief number of positions handed out by ask() whose evaluation has not been told
+     *
+     * @return std::size_t
+     */
+    std::size_t outstanding() const
+    {
+      return _tracker.outstanding();
+    }
+
+    const E& position() const
+    {
+      return _position;
+    }
+
+    const E& archive() const
+    {
+      return _archive;
+    }
+
+    const F& fitness_best() const
+    {
+      return _y_best;
+    }
+
+    /**
+     * @brief evaluations of the positions of the last generation
+     *
+     * @return const F&
+     */
+    const F& fitness() const
+    {
+      return _y;
+    }
+
+    std::size_t generation() const
+    {
+      return _generation;
+    }
+
+    /**
+     * @brief number of individuals passed to the objective function so far
+     *
+     * @return std::size_t
+     */
+    std::size_t evaluations() const
+    {
+      return _evaluations;
+    }
+
+  private:
+
+    void evaluate()
+    {
+      _y = _objective_f(_position);
+      _evaluations += _position.shape()[0];
+    }
+
+    /**
+     * @brief update the archive with the evaluated positions and mutate the swarm
+     */
+    void finish()
+    {
+      _sel_f(_position, _archive, _y, _y_best);
+
+      _position = _mutation_f(_position);
+
+      _position_m1 = _position;
+
+      ++_generation;
+    }
+
+    E _position;
+    E _position_m1;
+    F _y_best;
+    E _archive;
+    F _y; ///< evaluations of the current positions
+    OBJ _objective_f;
+    POS _pos_f;
+    SEL _sel_f;
+    MUT _mutation_f;
+    std::size_t _generation{ 0 };
+    std::size_t _evaluations{ 0 };
+    ask_tell_tracker _tracker; ///< positions handed out by ask()
+  };
+
+  /**
+   * @brief helper to construct a pso_ga_state with deduced functor types
+   *
+   * @return pso_ga_state<E, F, OBJ, POS, SEL, MUT>
+   */
+  template<class E, class F, class OBJ, class POS, class SEL, class MUT>
+  auto make_pso_ga_state(const E& X, const E& Xm1, const F& YB, const E& A, OBJ objective_f, POS pos_f,
+    SEL sel_f, MUT mutation_f)
+  {
+    return pso_ga_state<E, F, OBJ, POS, SEL, MUT>(X, Xm1, YB, A, std::move(objective_f), std::move(pos_f),
+      std::move(sel_f), std::move(mutation_f));
+  }
 }
 
 #endif
@@ -0,0 +1,435 @@
+/**
+ * @file rng.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief header file with the counter-based random number generation used by xevo.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __RNG_HPP__
+#define __RNG_HPP__
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <utility>
+
+
+namespace xevo
+{
+
+  /**
+   * @brief Philox4x32-10 counter-based random engine
+   *
+   * Every block of four 32-bit numbers is a pure function of a 128-bit counter and a
+   * 64-bit key, so any position of any stream can be computed directly: streams do not
+   * share state, can be created cheaply in every task and give the same numbers
+   * whatever the number of threads. The two high words of the counter hold the stream
+   * number, the two low words the block index within the stream.
+   *
+   * J. K. Salmon, M. A. Moraes, R. O. Dror and D. E. Shaw, Parallel random numbers: as easy as
+   * 1, 2, 3, Proceedings of the International Conference for High Performance Computing,
+   * Networking, Storage and Analysis (SC11), 2011.
+   *
+   * The engine satisfies the UniformRandomBitGenerator requirements.
+   */
+  class philox4x32
+  {
+  public:
+
+    using result_type = std::uint32_t;
+    using counter_type = std::array<std::uint32_t, 4>;
+    using key_type = std::array<std::uint32_t, 2>;
+
+    /**
+     * @brief Construct a new philox4x32 engine
+     *
+     * @param key key of the engine (the seed)
+     * @param stream stream number
+     */
+    explicit philox4x32(std::uint64_t key = 0, std::uint64_t stream = 0) :
+      _key{ { static_cast<std::uint32_t>(key), static_cast<std::uint32_t>(key >> 32) } },
+      _counter{ { 0, 0, static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32) } }
+    {
+
+    }
+
+    static constexpr result_type min()
+    {
+      return 0;
+    }
+
+    static constexpr result_type max()
+    {
+      return 0xffffffffu;
+    }
+
+    result_type operator()()
+    {
+      if (_index == 4)
+      {
+        _buffer = block(_counter, _key);
+        increment();
+        _index = 0;
+      }
+      return _buffer[_index++];
+    }
+
+    /**
+     * @brief skip n numbers
+     *
+     * @param n number of skipped numbers
+     */
+    void discard(unsigned long long n)
+    {
+      while (n > 0 && _index < 4)
+      {
+        ++_index;
+        --n;
+      }
+      std::uint64_t blocks = n / 4;
+      std::uint64_t position = (std::uint64_t(_counter[1]) << 32 | _counter[0]) + blocks;
+      _counter[0] = static_cast<std::uint32_t>(position);
+      _counter[1] = static_cast<std::uint32_t>(position >> 32);
+      for (unsigned long long i{ 0 }; i < n % 4; ++i)
+      {
+        (*this)();
+      }
+    }
+
+    /**
+     * @brief write the next n numbers of the stream to out
+     *
+     * Whole blocks are computed directly from their counters, a loop without
+     * dependencies between iterations which the compiler vectorises.
+     *
+     * @param out output buffer
+     * @param n number of numbers
+     */
+    void generate(result_type* out, std::size_t n)
+    {
+      std::size_t i{ 0 };
+      while (i < n && _index < 4)
+      {
+        out[i++] = _buffer[_index++];
+      }
+
+      std::size_t num_of_blocks = (n - i) / 4;
+      std::uint64_t position = std::uint64_t(_counter[1]) << 32 | _counter[0];
+      for (std::size_t b{ 0 }; b < num_of_blocks; ++b)
+      {
+        std::uint64_t p = position + b;
+        counter_type counter = { { static_cast<std::uint32_t>(p), static_cast<std::uint32_t>(p >> 32),
+          _counter[2], _counter[3] } };
+        counter_type r = block(counter, _key);
+        out[i + 4 * b] = r[0];
+        out[i + 4 * b + 1] = r[1];
+        out[i + 4 * b + 2] = r[2];
+        out[i + 4 * b + 3] = r[3];
+      }
+      position += num_of_blocks;
+      _counter[0] = static_cast<std::uint32_t>(position);
+      _counter[1] = static_cast<std::uint32_t>(position >> 32);
+      i += 4 * num_of_blocks;
+
+      while (i < n)
+      {
+        out[i++] = (*this)();
+      }
+    }
+
+    /**
+     * @brief the Philox4x32-10 bijection
+     *
+     * @param counter counter
+     * @param key key
+     * @return counter_type four random 32-bit numbers
+     */
+    static counter_type block(counter_type counter, key_type key)
+    {
+      for (int round{ 0 }; round < 10; ++round)
+      {
+        if (round > 0)
+        {
+          key[0] += 0x9E3779B9u;
+          key[1] += 0xBB67AE85u;
+        }
+        std::uint64_t p0 = std::uint64_t(0xD2511F53u) * counter[0];
+        std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * counter[2];
+        counter = { { static_cast<std::uint32_t>(p1 >> 32) ^ counter[1] ^ key[0], static_cast<std::uint32_t>(p1),
+          static_cast<std::uint32_t>(p0 >> 32) ^ counter[3] ^ key[1], static_cast<std::uint32_t>(p0) } };
+      }
+      return counter;
+    }
+
+  private:
+
+    void increment()
+    {
+      if (++_counter[0] == 0)
+      {
+        ++_counter[1];
+      }
+    }
+
+    key_type _key;
+    counter_type _counter;
+    counter_type _buffer{};
+    std::size_t _index{ 4 };
+  };
+
+  /**
+   * @brief random engine used by the xevo functors
+   */
+  using random_engine = philox4x32;
+
+  namespace detail
+  {
+    /**
+     * @brief splitmix64 finaliser, used to spread stream numbers over the counter space
+     */
+    inline std::uint64_t mix64(std::uint64_t x)
+    {
+      x += 0x9E3779B97F4A7C15ull;
+      x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+      x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+      return x ^ (x >> 31);
+    }
+
+    struct rng_globals
+    {
+      std::atomic<std::uint64_t> seed;
+      std::atomic<std::uint64_t> next_id{ 0 };
+
+      rng_globals() : seed{ (std::uint64_t(std::random_device{}()) << 32) | std::random_device{}() }
+      {
+
+      }
+    };
+
+    inline rng_globals& globals()
+    {
+      static rng_globals g;
+      return g;
+    }
+  }
+
+  /**
+   * @brief seed the random numbers of every functor constructed afterwards
+   *
+   * Without a call to seed the global seed is drawn once from std::random_device.
+   * After seed(s) the functors are numbered again from zero, so a program that
+   * constructs its functors in the same order reproduces its results bit by bit.
+   *
+   * @param s global seed
+   */
+  inline void seed(std::uint64_t s)
+  {
+    detail::globals().seed.store(s);
+    detail::globals().next_id.store(0);
+  }
+
+  /**
+   * @brief random number service of a functor (or of any other component)
+   *
+   * An rng holds a seed and an identifier and hands out independent engines with
+   * stream(a, b); a and b are typically the call (generation) number and the task,
+   * pair or individual number. The numbers drawn by a task therefore only depend on
+   * the seed and the task, not on the thread executing it.
+   */
+  class rng
+  {
+  public:
+
+    /**
+     * @brief Construct a new rng with the global seed and the next free identifier
+     */
+    rng() : _seed{ detail::globals().seed.load() }, _id{ detail::globals().next_id.fetch_add(1) }
+    {
+
+    }
+
+    /**
+     * @brief Construct a new rng with an explicit seed and identifier
+     *
+     * @param seed seed
+     * @param id identifier
+     */
+    rng(std::uint64_t seed, std::uint64_t id) : _seed{ seed }, _id{ id }
+    {
+
+    }
+
+    /**
+     * @brief independent engine for the substream (a, b)
+     *
+     * @param a first substream number (e.g. call number)
+     * @param b second substream number (e.g. individual number)
+     * @return random_engine
+     */
+    random_engine stream(std::uint64_t a = 0, std::uint64_t b = 0) const
+    {
+      std::uint64_t stream = detail::mix64(detail::mix64(detail::mix64(_id) ^ a) ^ b);
+      return random_engine(_seed, stream);
+    }
+
+    std::uint64_t seed() const
+    {
+      return _seed;
+    }
+
+    std::uint64_t id() const
+    {
+      return _id;
+    }
+
+  private:
+    std::uint64_t _seed;
+    std::uint64_t _id;
+  };
+
+  /**
+   * @brief engine for a functor (stream 0 of a new rng)
+   *
+   * @return random_engine
+   */
+  inline random_engine make_random_engine()
+  {
+    return rng().stream();
+  }
+
+  /**
+   * @brief uniform number in [0, 1) with 53 random bits
+   *
+   * Unlike std::uniform_real_distribution the result is specified, so runs are
+   * reproducible across standard libraries.
+   *
+   * @tparam URNG 32-bit uniform random bit generator
+   * @param gen engine
+   * @return double
+   */
+  template <class URNG>
+  inline double uniform01(URNG& gen)
+  {
+    std::uint64_t a = std::uint64_t(gen()) >> 5;
+    std::uint64_t b = std::uint64_t(gen()) >> 6;
+    return (double(a) * 67108864.0 + double(b)) * (1.0 / 9007199254740992.0);
+  }
+
+  /**
+   * @brief uniform index in [0, n)
+   *
+   * @tparam URNG 32-bit uniform random bit generator
+   * @param gen engine
+   * @param n number of indices (> 0)
+   * @return std::size_t
+   */
+  template <class URNG>
+  inline std::size_t uniform_index(URNG& gen, std::size_t n)
+  {
+    std::size_t i = static_cast<std::size_t>(uniform01(gen) * double(n));
+    return i < n ? i : n - 1;
+  }
+
+  /**
+   * @brief Fisher-Yates shuffle driven by uniform_index
+   *
+   * @tparam IT random access iterator
+   * @tparam URNG 32-bit uniform random bit generator
+   * @param first first element
+   * @param last end of the range
+   * @param gen engine
+   */
+  template <class IT, class URNG>
+  inline void random_shuffle(IT first, IT last, URNG& gen)
+  {
+    auto n = static_cast<std::size_t>(std::distance(first, last));
+    for (std::size_t i = n; i > 1; --i)
+    {
+      std::size_t j = uniform_index(gen, i);
+      using std::swap;
+      swap(first[i - 1], first[j]);
+    }
+  }
+
+  /**
+   * @brief fill out with n uniform numbers in [low, high)
+   *
+   * The raw numbers are generated in blocks (philox4x32::generate) and converted
+   * in a separate loop, so both loops vectorise.
+   *
+   * @tparam T floating point type
+   * @param gen engine
+   * @param out output buffer
+   * @param n number of values
+   * @param low lower limit
+   * @param high upper limit
+   */
+  template <class T>
+  inline void fill_uniform(random_engine& gen, T* out, std::size_t n, T low = T(0), T high = T(1))
+  {
+    constexpr std::size_t batch = 256;
+    std::uint32_t raw[2 * batch];
+    T scale = high - low;
+    for (std::size_t first{ 0 }; first < n; first += batch)
+    {
+      std::size_t m = std::min(batch, n - first);
+      gen.generate(raw, 2 * m);
+      for (std::size_t i{ 0 }; i < m; ++i)
+      {
+        std::uint64_t a = std::uint64_t(raw[2 * i]) >> 5;
+        std::uint64_t b = std::uint64_t(raw[2 * i + 1]) >> 6;
+        double u = (double(a) * 67108864.0 + double(b)) * (1.0 / 9007199254740992.0);
+        out[first + i] = low + scale * static_cast<T>(u);
+      }
+    }
+  }
+
+  /**
+   * @brief fill out with n normal numbers (Box-Muller transform)
+   *
+   * @tparam T floating point type
+   * @param gen engine
+   * @param out output buffer
+   * @param n number of values
+   * @param mean mean
+   * @param stddev standard deviation
+   */
+  template <class T>
+  inline void fill_normal(random_engine& gen, T* out, std::size_t n, T mean = T(0), T stddev = T(1))
+  {
+    constexpr std::size_t batch = 256;
+    double u[batch];
+    const double two_pi = 6.283185307179586476925286766559;
+    for (std::size_t first{ 0 }; first < n; first += batch)
+    {
+      std::size_t m = std::min(batch, n - first);
+      std::size_t m_even = m + (m % 2);
+      fill_uniform(gen, u, m_even);
+      for (std::size_t i{ 0 }; i < m; i += 2)
+      {
+        double r = std::sqrt(-2.0 * std::log(1.0 - u[i]));
+        double theta = two_pi * u[i + 1];
+        out[first + i] = mean + stddev * static_cast<T>(r * std::cos(theta));
+        if (i + 1 < m)
+        {
+          out[first + i + 1] = mean + stddev * static_cast<T>(r * std::sin(theta));
+        }
+      }
+    }
+  }
+
+}
+
+#endif
@@ -0,0 +1,295 @@
+/**
+ * @file selection.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief header file with index based selection (top-k, fitness proportionate sampling).
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __SELECTION_HPP__
+#define __SELECTION_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "rng.hpp"
+
+
+namespace xevo
+{
+
+  /**
+   * @brief indices of the k best individuals, best first
+   *
+   * The selection costs O(N) for k = 1 (linear scan), O(N log k) for small k
+   * (bounded heap holding the k best seen so far) and O(N + k log k) otherwise
+   * (std::nth_element followed by a sort of the k best), instead of sorting the
+   * whole fitness vector. Ties are broken by the lower index, so the result does
+   * not depend on the algorithm used.
+   *
+   * @tparam F xtensor type of evaluations
+   * @param Y evaluations of the individuals
+   * @param k number of requested individuals (clamped to N)
+   * @param maximise true when larger values are better
+   * @param indices output with the indices of the k best individuals
+   */
+  template <class F>
+  inline void top_k_indices(const F& Y, std::size_t k, bool maximise, std::vector<std::size_t>& indices)
+  {
+    std::size_t num_of_indiv = Y.shape()[0];
+    k = std::min(k, num_of_indiv);
+
+    // strict weak ordering: a is better than b
+    auto better = [&Y, maximise](std::size_t a, std::size_t b)
+    {
+      if (Y(a) == Y(b))
+      {
+        return a < b;
+      }
+      return maximise ? Y(a) > Y(b) : Y(a) < Y(b);
+    };
+
+    if (k == 0)
+    {
+      indices.clear();
+    }
+    else if (k == 1)
+    {
+      std::size_t best{ 0 };
+      for (std::size_t i{ 1 }; i < num_of_indiv; ++i)
+      {
+        if (better(i, best))
+        {
+          best = i;
+        }
+      }
+      indices.assign(1, best);
+    }
+    else if (k <= 64)
+    {
+      // max-heap with respect to better: the worst of the k kept is on top
+      indices.clear();
+      for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+      {
+        if (indices.size() < k)
+        {
+          indices.push_back(i);
+          std::push_heap(indices.begin(), indices.end(), better);
+        }
+        else if (better(i, indices.front()))
+        {
+          std::pop_heap(indices.begin(), indices.end(), better);
+          indices.back() = i;
+          std::push_heap(indices.begin(), indices.end(), better);
+        }
+      }
+      std::sort_heap(indices.begin(), indices.end(), better);
+    }
+    else
+    {
+      indices.resize(num_of_indiv);
+      std::size_t i{ 0 };
+      std::generate(indices.begin(), indices.end(), [&i]() { return i++; });
+      std::nth_element(indices.begin(), indices.begin() + (k - 1), indices.end(), better);
+      std::sort(indices.begin(), indices.begin() + k, better);
+      indices.resize(k);
+    }
+  }
+
+  /**
+   * @brief Walker alias table for sampling individuals proportionally to their weight
+   *
+   * The table is built with Vose's method in O(N) and every draw costs O(1)
+   * (one uniform number, one comparison). Negative weights are treated as zero;
+   * when all weights are zero every individual is equally likely.
+   *
+   * M. D. Vose, A linear algorithm for generating random numbers with a given distribution,
+   * IEEE Transactions on Software Engineering, vol. 17, no. 9, pp. 972-975, Sep 1991.
+   *
+   * @tparam T floating point type of the probabilities
+   */
+  template <class T = double>
+  class alias_table
+  {
+  public:
+
+    /**
+     * @brief build the table from the weights Y(0), ..., Y(N - 1)
+     *
+     * @tparam F xtensor type of weights (e.g. the fitness)
+     * @param Y weights of the individuals
+     */
+    template <class F>
+    void build(const F& Y)
+    {
+      std::size_t num_of_indiv = Y.shape()[0];
+      _prob.resize(num_of_indiv);
+      _alias.resize(num_of_indiv);
+      _small.clear();
+      _large.clear();
+      _small.reserve(num_of_indiv);
+      _large.reserve(num_of_indiv);
+
+      T sum = 0;
+      for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+      {
+        sum += weight(Y(i));
+      }
+
+      for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+      {
+        // probabilities scaled so that the mean is one
+        _prob[i] = sum > T(0) ? weight(Y(i)) * T(num_of_indiv) / sum : T(1);
+        _alias[i] = i;
+        if (_prob[i] < T(1))
+        {
+          _small.push_back(i);
+        }
+        else
+        {
+          _large.push_back(i);
+        }
+      }
+
+      while (!_small.empty() && !_large.empty())
+      {
+        std::size_t s = _small.back();
+        _small.pop_back();
+        std::size_t l = _large.back();
+
+        _alias[s] = l;
+        _prob[l] -= T(1) - _prob[s];
+        if (_prob[l] < T(1))
+        {
+          _large.pop_back();
+          _small.push_back(l);
+        }
+      }
+
+      // leftovers are one up to round-off
+      for (std::size_t i : _small)
+      {
+        _prob[i] = T(1);
+      }
+      for (std::size_t i : _large)
+      {
+        _prob[i] = T(1);
+      }
+    }
+
+    /**
+     * @brief draw one index
+     *
+     * @tparam URNG uniform random number generator
+     * @param gen random engine
+     * @return std::size_t index of the drawn individual
+     */
+    template <class URNG>
+    std::size_t operator()(URNG& gen) const
+    {
+      T x = static_cast<T>(uniform01(gen)) * T(_prob.size());
+      std::size_t i = std::min(static_cast<std::size_t>(x), _prob.size() - 1);
+      return (x - T(i)) < _prob[i] ? i : _alias[i];
+    }
+
+    /**
+     * @brief number of individuals in the table
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const
+    {
+      return _prob.size();
+    }
+
+  private:
+
+    static T weight(T y)
+    {
+      return y > T(0) ? y : T(0);
+    }
+
+    std::vector<T> _prob; ///< probability of keeping the column
+    std::vector<std::size_t> _alias; ///< alias of every column
+    std::vector<std::size_t> _small; ///< scratch for the build
+    std::vector<std::size_t> _large; ///< scratch for the build
+  };
+
+  /**
+   * @brief stochastic universal sampling of num_of_draws individuals
+   *
+   * A single random offset places num_of_draws equally spaced pointers on the
+   * cumulative weights, which are swept once (O(N + num_of_draws)). The indices
+   * come out ordered by individual; they are shuffled so that consecutive entries
+   * can be used as mating pairs. Negative weights are treated as zero.
+   *
+   * J. E. Baker, Reducing bias and inefficiency in the selection algorithm, Proceedings of
+   * the Second International Conference on Genetic Algorithms, pp. 14-21, 1987.
+   *
+   * @tparam F xtensor type of weights (e.g. the fitness)
+   * @tparam URNG uniform random number generator
+   * @param Y weights of the individuals
+   * @param num_of_draws number of selected individuals
+   * @param gen random engine
+   * @param indices output with the selected indices
+   */
+  template <class F, class URNG>
+  inline void stochastic_universal_sampling(const F& Y, std::size_t num_of_draws, URNG& gen,
+    std::vector<std::size_t>& indices)
+  {
+    using T = double;
+    std::size_t num_of_indiv = Y.shape()[0];
+    indices.resize(num_of_draws);
+    if (num_of_draws == 0 || num_of_indiv == 0)
+    {
+      indices.clear();
+      return;
+    }
+
+    auto weight = [&Y](std::size_t i) { return Y(i) > 0 ? T(Y(i)) : T(0); };
+
+    T sum = 0;
+    for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+    {
+      sum += weight(i);
+    }
+
+    if (!(sum > T(0)))
+    {
+      // no information in the weights: equally spaced indices
+      for (std::size_t k{ 0 }; k < num_of_draws; ++k)
+      {
+        indices[k] = (k * num_of_indiv) / num_of_draws;
+      }
+    }
+    else
+    {
+      T step = sum / T(num_of_draws);
+      T pointer = uniform01(gen) * step;
+
+      std::size_t i{ 0 };
+      T cum_weight = weight(0);
+      for (std::size_t k{ 0 }; k < num_of_draws; ++k)
+      {
+        while (cum_weight <= pointer && i + 1 < num_of_indiv)
+        {
+          cum_weight += weight(++i);
+        }
+        indices[k] = i;
+        pointer += step;
+      }
+    }
+
+    random_shuffle(indices.begin(), indices.end(), gen);
+  }
+
+}
+
+#endif
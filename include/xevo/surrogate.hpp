@@ -0,0 +1,611 @@
+/**
+ * @file surrogate.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief header file with surrogate models for pre-screening candidates of expensive objectives.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __SURROGATE_HPP__
+#define __SURROGATE_HPP__
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "xtensor/xtensor.hpp"
+#include "xtensor/xview.hpp"
+
+#include "selection.hpp"
+
+
+namespace xevo
+{
+
+  namespace detail
+  {
+    /**
+     * @brief dot product with four partial sums (the additions of a single sum form a
+     * dependency chain)
+     */
+    template <class T>
+    inline T dot(const T* a, const T* b, std::size_t n)
+    {
+      T s0{ 0 }, s1{ 0 }, s2{ 0 }, s3{ 0 };
+      std::size_t j{ 0 };
+      for (; j + 4 <= n; j += 4)
+      {
+        s0 += a[j] * b[j];
+        s1 += a[j + 1] * b[j + 1];
+        s2 += a[j + 2] * b[j + 2];
+        s3 += a[j + 3] * b[j + 3];
+      }
+      for (; j < n; ++j)
+      {
+        s0 += a[j] * b[j];
+      }
+      return (s0 + s1) + (s2 + s3);
+    }
+  }
+
+  /**
+   * @brief parameters of a gaussian_process
+   */
+  struct gaussian_process_options
+  {
+    std::size_t capacity{ 1000 }; ///< maximum number of samples (the oldest sample is dropped when full)
+    double length_scale{ 0.0 }; ///< length scale of the kernel (0 sets it from the first batch of samples)
+    double regularisation{ 1e-8 }; ///< noise added to the diagonal of the kernel matrix
+  };
+
+  /**
+   * @brief Gaussian process regression with a squared exponential kernel, updated incrementally
+   *
+   * The prediction is the posterior mean mu + k(x)^T K^-1 (y - mu), where mu is the mean of
+   * the samples and K the kernel matrix of the samples (unit signal variance plus
+   * options().regularisation on the diagonal). The Cholesky factor L of K is never
+   * recomputed:
+   *
+   * - a new sample appends the row [L^-1 k, d] to L (O(n^2));
+   * - dropping the oldest sample when the model is full is a rank-one update of the
+   *   trailing factor with the dropped column (O(n^2)).
+   *
+   * The weights K^-1 (y - mu) are solved again (O(n^2)) on the first prediction after a
+   * change, so a prediction costs O(n D). A sample that is (numerically) a duplicate of
+   * the stored ones is skipped. L is stored packed, so the model needs n^2 / 2 values of
+   * T for n samples.
+   *
+   * @tparam T value type of samples and predictions
+   */
+  template <class T = double>
+  class gaussian_process
+  {
+  public:
+
+    /**
+     * @brief Construct a new gaussian_process object
+     *
+     * @param num_of_vars number of inputs
+     * @param options capacity, length scale and regularisation
+     */
+    explicit gaussian_process(std::size_t num_of_vars, gaussian_process_options options = gaussian_process_options{}) :
+      _num_of_vars{ num_of_vars }, _options{ options }
+    {
+      _options.capacity = std::max<std::size_t>(_options.capacity, 1);
+      if (_options.length_scale > 0.0)
+      {
+        set_length_scale(_options.length_scale);
+      }
+    }
+
+    /**
+     * @brief add the rows of X with their evaluations y to the samples
+     *
+     * @tparam E xtensor type of the samples (one per row)
+     * @tparam F xtensor type of the evaluations
+     * @param X samples
+     * @param y evaluations of the samples
+     * @return std::size_t number of samples added (duplicates are skipped)
+     */
+    template <class E, class F>
+    std::size_t insert(const E& X, const F& y)
+    {
+      std::size_t num_of_rows = X.shape()[0];
+      if (num_of_rows > 0 && X.shape()[1] != _num_of_vars)
+      {
+        throw std::runtime_error("gaussian_process: the samples have " + std::to_string(X.shape()[1]) +
+          " variables instead of " + std::to_string(_num_of_vars));
+      }
+      if (_inv_length_scale2 <= 0.0 && num_of_rows > 0)
+      {
+        set_length_scale(spread(X));
+      }
+
+      std::size_t num_of_added{ 0 };
+      std::vector<T> x(_num_of_vars);
+      for (std::size_t i{ 0 }; i < num_of_rows; ++i)
+      {
+        for (std::size_t j{ 0 }; j < _num_of_vars; ++j)
+        {
+          x[j] = static_cast<T>(X(i, j));
+        }
+        num_of_added += append(x.data(), static_cast<T>(y(i))) ? 1 : 0;
+      }
+      return num_of_added;
+    }
+
+    /**
+     * @brief predict the evaluations of the rows of X
+     *
+     * @tparam E xtensor type of the candidates (one per row)
+     * @tparam F xtensor type of the predictions
+     * @param X candidates
+     * @param y output with the prediction for every row of X
+     */
+    template <class E, class F>
+    void predict(const E& X, F& y)
+    {
+      solve();
+      std::size_t num_of_rows = X.shape()[0];
+      std::size_t n = size();
+      std::vector<T> x(_num_of_vars);
+      for (std::size_t i{ 0 }; i < num_of_rows; ++i)
+      {
+        for (std::size_t j{ 0 }; j < _num_of_vars; ++j)
+        {
+          x[j] = static_cast<T>(X(i, j));
+        }
+        T prediction = _mean;
+        for (std::size_t s{ 0 }; s < n; ++s)
+        {
+          prediction += _alpha[s] * kernel(x.data(), sample(s));
+        }
+        y(i) = prediction;
+      }
+    }
+
+    /**
+     * @brief number of stored samples
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const
+    {
+      return _y.size();
+    }
+
+    /**
+     * @brief number of inputs
+     *
+     * @return std::size_t
+     */
+    std::size_t num_of_vars() const
+    {
+      return _num_of_vars;
+    }
+
+    /**
+     * @brief length scale of the kernel (0 before the first sample)
+     *
+     * @return double
+     */
+    double length_scale() const
+    {
+      return _inv_length_scale2 > 0.0 ? 1.0 / std::sqrt(2.0 * _inv_length_scale2) : 0.0;
+    }
+
+    /**
+     * @brief remove every sample (the length scale is kept)
+     */
+    void clear()
+    {
+      _x.clear();
+      _y.clear();
+      _L.clear();
+      _solved = false;
+    }
+
+  private:
+
+    static std::size_t packed(std::size_t i, std::size_t j)
+    {
+      return i * (i + 1) / 2 + j;
+    }
+
+    const T* sample(std::size_t s) const
+    {
+      return _x.data() + s * _num_of_vars;
+    }
+
+    T kernel(const T* a, const T* b) const
+    {
+      T r2{ 0 };
+      for (std::size_t j{ 0 }; j < _num_of_vars; ++j)
+      {
+        T d = a[j] - b[j];
+        r2 += d * d;
+      }
+      return std::exp(-static_cast<T>(_inv_length_scale2) * r2);
+    }
+
+    void set_length_scale(double length_scale)
+    {
+      length_scale = length_scale > 0.0 ? length_scale : 1.0;
+      _inv_length_scale2 = 1.0 / (2.0 * length_scale * length_scale);
+    }
+
+    /**
+     * @brief root mean square distance of the rows of X to their centroid
+     */
+    template <class E>
+    double spread(const E& X) const
+    {
+      std::size_t num_of_rows = X.shape()[0];
+      double sum_of_squares{ 0.0 };
+      for (std::size_t j{ 0 }; j < _num_of_vars; ++j)
+      {
+        double mean{ 0.0 };
+        for (std::size_t i{ 0 }; i < num_of_rows; ++i)
+        {
+          mean += static_cast<double>(X(i, j));
+        }
+        mean /= static_cast<double>(num_of_rows);
+        for (std::size_t i{ 0 }; i < num_of_rows; ++i)
+        {
+          double d = static_cast<double>(X(i, j)) - mean;
+          sum_of_squares += d * d;
+        }
+      }
+      return std::sqrt(sum_of_squares / static_cast<double>(num_of_rows));
+    }
+
+    /**
+     * @brief append a sample and the row [L^-1 k, d] to the Cholesky factor
+     */
+    bool append(const T* x, T y)
+    {
+      if (size() == _options.capacity)
+      {
+        drop_oldest();
+      }
+
+      std::size_t n = size();
+      std::vector<T>& l = _scratch;
+      l.resize(n + 1);
+      for (std::size_t s{ 0 }; s < n; ++s)
+      {
+        l[s] = kernel(x, sample(s));
+      }
+      // forward substitution L l = k
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        const T* L_i = _L.data() + packed(i, 0);
+        l[i] = (l[i] - detail::dot(L_i, l.data(), i)) / L_i[i];
+      }
+      T d2 = T(1) + static_cast<T>(_options.regularisation) - detail::dot(l.data(), l.data(), n);
+      // posterior variance below the noise (e.g. a duplicate): K would become singular
+      if (!(d2 > 2 * static_cast<T>(_options.regularisation)))
+      {
+        return false;
+      }
+      l[n] = std::sqrt(d2);
+
+      _L.insert(_L.end(), l.begin(), l.end());
+      _x.insert(_x.end(), x, x + _num_of_vars);
+      _y.push_back(y);
+      _solved = false;
+      return true;
+    }
+
+    /**
+     * @brief remove the first sample
+     *
+     * Without the first row and column, the trailing factor L22 of L must satisfy
+     * L22' L22'^T = L22 L22^T + v v^T, with v the first column of L below the diagonal:
+     * a rank-one update by Givens rotations. Rotation k is found on row k, so the rows
+     * are updated in one pass while they are shifted to the front of the storage. With
+     * c = r / L_kk and s = v_k / L_kk (c^2 = 1 + s^2), rotation k maps (L_ik, v_i) to
+     * ((L_ik + s v_i) / c, (v_i - s L_ik) / c). The rotations of a row form a dependency
+     * chain through v_i, so blocks of rows are rotated together.
+     */
+    void drop_oldest()
+    {
+      constexpr std::size_t block = 8;
+      std::size_t m = size() - 1;
+      std::vector<T>& rotations = _scratch; ///< (s, 1 / c) of every row
+      rotations.resize(2 * m);
+      std::vector<T> old_rows;
+
+      for (std::size_t i0{ 0 }; i0 < m; i0 += block)
+      {
+        std::size_t num_of_rows = std::min(block, m - i0);
+        // rows i0 + 1, ... of L (the new rows are written over them)
+        old_rows.assign(_L.begin() + packed(i0 + 1, 0), _L.begin() + packed(i0 + num_of_rows + 1, 0));
+        const T* old_row[block];
+        T* new_row[block];
+        T v[block];
+        for (std::size_t b{ 0 }; b < num_of_rows; ++b)
+        {
+          old_row[b] = old_rows.data() + packed(i0 + b + 1, 0) - packed(i0 + 1, 0);
+          new_row[b] = _L.data() + packed(i0 + b, 0);
+          v[b] = old_row[b][0];
+        }
+
+        for (std::size_t k{ 0 }; k < i0; ++k)
+        {
+          T s = rotations[2 * k];
+          T c_inv = rotations[2 * k + 1];
+          for (std::size_t b{ 0 }; b < num_of_rows; ++b)
+          {
+            T L_bk = old_row[b][k + 1];
+            new_row[b][k] = (L_bk + s * v[b]) * c_inv;
+            v[b] = (v[b] - s * L_bk) * c_inv;
+          }
+        }
+
+        for (std::size_t b{ 0 }; b < num_of_rows; ++b)
+        {
+          std::size_t i = i0 + b;
+          for (std::size_t k{ i0 }; k < i; ++k)
+          {
+            T L_ik = old_row[b][k + 1];
+            new_row[b][k] = (L_ik + rotations[2 * k] * v[b]) * rotations[2 * k + 1];
+            v[b] = (v[b] - rotations[2 * k] * L_ik) * rotations[2 * k + 1];
+          }
+          T L_ii = old_row[b][i + 1];
+          T r = std::sqrt(L_ii * L_ii + v[b] * v[b]);
+          rotations[2 * i] = v[b] / L_ii;
+          rotations[2 * i + 1] = L_ii / r;
+          new_row[b][i] = r;
+        }
+      }
+      _L.resize(packed(m, 0));
+
+      _x.erase(_x.begin(), _x.begin() + _num_of_vars);
+      _y.erase(_y.begin());
+      _solved = false;
+    }
+
+    /**
+     * @brief solve L L^T alpha = y - mean
+     */
+    void solve()
+    {
+      if (_solved)
+      {
+        return;
+      }
+      std::size_t n = size();
+      _mean = T(0);
+      for (T y : _y)
+      {
+        _mean += y;
+      }
+      _mean = n > 0 ? _mean / static_cast<T>(n) : T(0);
+
+      _alpha.resize(n);
+      for (std::size_t i{ 0 }; i < n; ++i)
+      {
+        const T* L_i = _L.data() + packed(i, 0);
+        _alpha[i] = (_y[i] - _mean - detail::dot(L_i, _alpha.data(), i)) / L_i[i];
+      }
+      for (std::size_t i{ n }; i-- > 0;)
+      {
+        T sum = _alpha[i];
+        for (std::size_t j{ i + 1 }; j < n; ++j)
+        {
+          sum -= _L[packed(j, i)] * _alpha[j];
+        }
+        _alpha[i] = sum / _L[packed(i, i)];
+      }
+      _solved = true;
+    }
+
+    std::size_t _num_of_vars;
+    gaussian_process_options _options;
+    double _inv_length_scale2{ 0.0 }; ///< 1 / (2 length_scale^2)
+    std::vector<T> _x; ///< samples (row-major)
+    std::vector<T> _y; ///< evaluations of the samples
+    std::vector<T> _L; ///< Cholesky factor of the kernel matrix (packed lower triangle)
+    std::vector<T> _alpha; ///< weights of the kernel functions
+    std::vector<T> _scratch;
+    T _mean{ 0 }; ///< mean of the evaluations
+    bool _solved{ false }; ///< _alpha and _mean are up to date
+  };
+
+  /**
+   * @brief fitness given to the candidates that are not evaluated by the objective
+   */
+  enum class screened_fitness
+  {
+    prediction, ///< the prediction of the surrogate
+    worst_evaluated, ///< the worst fitness of the evaluated candidates
+    excluded ///< the worst representable fitness (never replaces a stored best, e.g. in pso_state)
+  };
+
+  /**
+   * @brief parameters of Evaluate_surrogate
+   */
+  struct surrogate_options
+  {
+    double fraction{ 0.25 }; ///< fraction of the candidates evaluated by the objective
+    std::size_t min_samples{ 0 }; ///< samples before the pre-screening starts (0 for 2 D + 1)
+    bool maximise{ true }; ///< true when larger fitness is better
+    screened_fitness screened{ screened_fitness::prediction }; ///< fitness of the screened out candidates
+    gaussian_process_options model; ///< parameters of the surrogate model
+  };
+
+  /**
+   * @brief Functor for pre-screening candidates of an expensive objective with a surrogate
+   *
+   * Every candidate is scored on a gaussian_process fitted on all the candidates
+   * evaluated so far; only the ceil(options.fraction * N) best scored candidates are
+   * passed to the wrapped objective (in one batch) and added to the model. The other
+   * candidates get the surrogate prediction (or a worst fitness, see
+   * surrogate_options::screened). Until the model holds options.min_samples samples every
+   * candidate is evaluated. The functor can be passed wherever an OBJ functor is expected
+   * (ga_state, pso_state, ...); set options.maximise to false for minimising algorithms.
+   *
+   * Wrapping Evaluate_cached or Evaluate_process inside it avoids evaluating unchanged
+   * individuals again and spreads the selected candidates over worker processes. As for
+   * Evaluate_cached, the wrapped objective must evaluate every row independently of the
+   * other rows. Copies of the functor share the same model.
+   *
+   * @tparam OBJ functor type of the objective function
+   * @tparam T value type of the model
+   */
+  template <class OBJ, class T = double>
+  struct Evaluate_surrogate
+  {
+    /**
+     * @brief Construct a new Evaluate_surrogate object
+     *
+     * @param objective_f objective function
+     * @param num_of_vars number of genes of a candidate
+     * @param options fraction, direction and surrogate model parameters
+     */
+    Evaluate_surrogate(OBJ objective_f, std::size_t num_of_vars, surrogate_options options = surrogate_options{}) :
+      _objective_f{ std::move(objective_f) },
+      _state{ std::make_shared<state>(num_of_vars, options) }
+    {
+
+    }
+
+    /**
+     * @brief operator to evaluate the objective function
+     *
+     * @tparam E xtensor type of the population
+     * @param X population (one individual per row)
+     * @return xt::xtensor<T, 1> fitness (or prediction) of every individual
+     */
+    template <class E>
+    auto operator()(const xt::xexpression<E>& X)
+    {
+      const E& _X = X.derived_cast();
+      state& _s = *_state;
+      std::size_t num_of_indiv = _X.shape()[0];
+      std::array<std::size_t, 1> shape_y = { num_of_indiv };
+      xt::xtensor<T, 1> y(shape_y);
+      if (num_of_indiv == 0)
+      {
+        return y;
+      }
+
+      std::size_t min_samples = _s.options.min_samples > 0 ? _s.options.min_samples : 2 * _s.model.num_of_vars() + 1;
+      if (_s.model.size() < min_samples)
+      {
+        auto y_all = _objective_f(_X);
+        for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+        {
+          y(i) = static_cast<T>(y_all(i));
+        }
+        _s.model.insert(_X, y);
+        _s.evaluations += num_of_indiv;
+        return y;
+      }
+
+      _s.model.predict(_X, y);
+      std::size_t num_of_selected = static_cast<std::size_t>(std::ceil(_s.options.fraction *
+        static_cast<double>(num_of_indiv)));
+      num_of_selected = std::min(std::max<std::size_t>(num_of_selected, 1), num_of_indiv);
+      top_k_indices(y, num_of_selected, _s.options.maximise, _s.indices);
+
+      xt::xtensor<T, 2> X_selected = xt::view(_X, xt::keep(_s.indices), xt::all());
+      auto y_selected = _objective_f(X_selected);
+
+      std::array<std::size_t, 1> shape_selected = { num_of_selected };
+      xt::xtensor<T, 1> y_true(shape_selected);
+      T y_worst = static_cast<T>(y_selected(0));
+      for (std::size_t k{ 0 }; k < num_of_selected; ++k)
+      {
+        y_true(k) = static_cast<T>(y_selected(k));
+        y_worst = _s.options.maximise ? std::min(y_worst, y_true(k)) : std::max(y_worst, y_true(k));
+      }
+      _s.model.insert(X_selected, y_true);
+
+      if (_s.options.screened != screened_fitness::prediction)
+      {
+        if (_s.options.screened == screened_fitness::excluded)
+        {
+          y_worst = _s.options.maximise ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max();
+        }
+        for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+        {
+          y(i) = y_worst;
+        }
+      }
+      for (std::size_t k{ 0 }; k < num_of_selected; ++k)
+      {
+        y(_s.indices[k]) = y_true(k);
+      }
+
+      _s.evaluations += num_of_selected;
+      _s.screened += num_of_indiv - num_of_selected;
+      return y;
+    }
+
+    /**
+     * @brief number of candidates passed to the wrapped objective
+     *
+     * @return std::size_t
+     */
+    std::size_t evaluations() const
+    {
+      return _state->evaluations;
+    }
+
+    /**
+     * @brief number of candidates scored only on the surrogate
+     *
+     * @return std::size_t
+     */
+    std::size_t screened() const
+    {
+      return _state->screened;
+    }
+
+    /**
+     * @brief surrogate model
+     *
+     * @return gaussian_process<T>&
+     */
+    gaussian_process<T>& model() const
+    {
+      return _state->model;
+    }
+
+  private:
+
+    struct state
+    {
+      state(std::size_t num_of_vars, const surrogate_options& o) : options{ o }, model{ num_of_vars, o.model }
+      {
+
+      }
+
+      surrogate_options options;
+      gaussian_process<T> model;
+      std::vector<std::size_t> indices; ///< candidates passed to the objective
+      std::size_t evaluations{ 0 };
+      std::size_t screened{ 0 };
+    };
+
+    OBJ _objective_f; ///< wrapped objective function
+    std::shared_ptr<state> _state; ///< model shared between copies
+  };
+
+}
+
+#endif
@@ -0,0 +1,289 @@
+/**
+ * @file thread_pool.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief header file with a fork-join thread pool used by the parallel parts of xevo.
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __THREAD_POOL_HPP__
+#define __THREAD_POOL_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#ifdef XEVO_ENABLE_THREADS
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+
+namespace xevo
+{
+
+  /**
+   * @brief fork-join thread pool
+   *
+   * The pool keeps its workers alive between calls so that the cost of a
+   * generation is not dominated by thread creation. Work is submitted with
+   * parallel_for, which blocks until every task has been executed; the calling
+   * thread takes part in the execution.
+   *
+   * When xevo is configured without ENABLE_THREADS (XEVO_ENABLE_THREADS is not
+   * defined) the pool has a single thread and parallel_for runs serially.
+   */
+  class thread_pool
+  {
+  public:
+
+    /**
+     * @brief Construct a new thread pool
+     *
+     * @param num_threads number of threads including the calling thread
+     *  (0 uses std::thread::hardware_concurrency())
+     */
+    explicit thread_pool(std::size_t num_threads = 0)
+    {
+#ifdef XEVO_ENABLE_THREADS
+      if (num_threads == 0)
+      {
+        num_threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+      }
+      _num_threads = num_threads;
+      _workers.reserve(num_threads - 1);
+      for (std::size_t i{ 1 }; i < num_threads; ++i)
+      {
+        _workers.emplace_back([this]() { worker_loop(); });
+      }
+#else
+      _num_threads = 1;
+#endif
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool()
+    {
+#ifdef XEVO_ENABLE_THREADS
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+      }
+      _job_cv.notify_all();
+      for (auto& worker : _workers)
+      {
+        worker.join();
+      }
+#endif
+    }
+
+    /**
+     * @brief number of threads (including the calling thread)
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const
+    {
+      return _num_threads;
+    }
+
+    /**
+     * @brief execute f(i) for every i in [0, num_tasks) and wait for completion
+     *
+     * Tasks are handed out dynamically, one index at a time, so uneven task
+     * costs are balanced across the workers. The first exception thrown by a
+     * task is rethrown on the calling thread. Calls made from inside a task of
+     * the same pool run serially.
+     *
+     * @tparam FUNC callable type with signature void(std::size_t)
+     * @param num_tasks number of tasks
+     * @param f callable invoked with the task index
+     */
+    template <class FUNC>
+    void parallel_for(std::size_t num_tasks, FUNC&& f)
+    {
+      if (num_tasks == 0)
+      {
+        return;
+      }
+#ifdef XEVO_ENABLE_THREADS
+      if (_workers.empty() || num_tasks == 1 || current_pool() == this)
+      {
+        for (std::size_t i{ 0 }; i < num_tasks; ++i)
+        {
+          f(i);
+        }
+        return;
+      }
+
+      using func_type = std::remove_reference_t<FUNC>;
+
+      std::lock_guard<std::mutex> submit_lock(_submit_mutex);
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _task_context = const_cast<void*>(static_cast<const void*>(std::addressof(f)));
+        _task_call = [](void* context, std::size_t i) { (*static_cast<func_type*>(context))(i); };
+        _num_tasks = num_tasks;
+        _next_task.store(0);
+        _pending = _workers.size();
+        _error = nullptr;
+        ++_job_id;
+      }
+      _job_cv.notify_all();
+
+      // nested calls made by the tasks of the calling thread run serially too
+      thread_pool* caller_pool = current_pool();
+      current_pool() = this;
+      run_tasks();
+      current_pool() = caller_pool;
+
+      std::exception_ptr error;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done_cv.wait(lock, [this]() { return _pending == 0; });
+        _task_context = nullptr;
+        _task_call = nullptr;
+        error = _error;
+        _error = nullptr;
+      }
+      if (error)
+      {
+        std::rethrow_exception(error);
+      }
+#else
+      for (std::size_t i{ 0 }; i < num_tasks; ++i)
+      {
+        f(i);
+      }
+#endif
+    }
+
+  private:
+
+#ifdef XEVO_ENABLE_THREADS
+    /**
+     * @brief pool whose tasks the current thread is executing (nullptr otherwise)
+     *
+     * @return thread_pool*&
+     */
+    static thread_pool*& current_pool()
+    {
+      static thread_local thread_pool* pool = nullptr;
+      return pool;
+    }
+
+    void run_tasks()
+    {
+      while (true)
+      {
+        std::size_t i = _next_task.fetch_add(1);
+        if (i >= _num_tasks)
+        {
+          break;
+        }
+        try
+        {
+          _task_call(_task_context, i);
+        }
+        catch (...)
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          if (!_error)
+          {
+            _error = std::current_exception();
+          }
+        }
+      }
+    }
+
+    void worker_loop()
+    {
+      current_pool() = this;
+      std::size_t job_seen{ 0 };
+      while (true)
+      {
+        {
+          std::unique_lock<std::mutex> lock(_mutex);
+          _job_cv.wait(lock, [this, job_seen]() { return _stop || _job_id != job_seen; });
+          if (_stop)
+          {
+            return;
+          }
+          job_seen = _job_id;
+        }
+
+        run_tasks();
+
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          if (--_pending == 0)
+          {
+            _done_cv.notify_one();
+          }
+        }
+      }
+    }
+
+    std::vector<std::thread> _workers;
+    std::mutex _submit_mutex; ///< serialises concurrent submitters
+    std::mutex _mutex;
+    std::condition_variable _job_cv;
+    std::condition_variable _done_cv;
+    void* _task_context{ nullptr };
+    void (*_task_call)(void*, std::size_t) { nullptr };
+    std::size_t _num_tasks{ 0 };
+    std::atomic<std::size_t> _next_task{ 0 };
+    std::size_t _pending{ 0 };
+    std::size_t _job_id{ 0 };
+    std::exception_ptr _error;
+    bool _stop{ false };
+#endif
+    std::size_t _num_threads{ 1 };
+  };
+
+  /**
+   * @brief execute f(first, last) on contiguous chunks covering [0, n)
+   *
+   * With a pool of more than one thread the range is split in up to
+   * 4 * pool->size() chunks executed with parallel_for; otherwise (or when
+   * pool is nullptr) f(0, n) is called on the calling thread.
+   *
+   * @tparam FUNC callable type with signature void(std::size_t, std::size_t)
+   * @param pool thread pool (may be nullptr)
+   * @param n size of the range
+   * @param f callable invoked with the bounds of every chunk
+   */
+  template <class FUNC>
+  inline void parallel_for_chunks(thread_pool* pool, std::size_t n, FUNC&& f)
+  {
+    if (pool == nullptr || pool->size() < 2 || n < 2)
+    {
+      if (n > 0)
+      {
+        f(std::size_t(0), n);
+      }
+      return;
+    }
+    std::size_t num_of_chunks = std::min(n, 4 * pool->size());
+    pool->parallel_for(num_of_chunks, [&](std::size_t c)
+    {
+      f(c * n / num_of_chunks, (c + 1) * n / num_of_chunks);
+    });
+  }
+
+}
+
+#endif
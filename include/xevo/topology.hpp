@@ -0,0 +1,301 @@
+/**
+ * @file topology.hpp
+ * @author Georgios E. Ragkousis (giorgosragos@gmail.com)
+ * @brief header file with swarm topologies (neighbourhood best of every particle).
+ * @version @PROJECT_NUMBER
+ * @date 2020-07
+ *
+ * Distributed under the terms of the BSD 3-Clause License.
+ *
+ * The full license is in the file LICENSE, distributed with this software.
+ *
+ * @copyright Copyright (c) 2020, Georgios E. Ragkousis
+ *
+ */
+#ifndef __TOPOLOGY_HPP__
+#define __TOPOLOGY_HPP__
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "rng.hpp"
+
+
+namespace xevo
+{
+
+  /**
+   * @brief index of the best individual of every circular window of YB
+   *
+   * The window of individual i consists of the window individuals starting side
+   * positions to the left of i (with periodic wrapping). The minimum (or maximum)
+   * of every window is found with a monotonic queue, so the cost is O(N)
+   * independently of the window size. On ties the right-most individual is kept.
+   *
+   * @tparam F xtensor type of evaluations
+   * @param YB best evaluations of the individuals
+   * @param side number of neighbours on the left of i
+   * @param window size of the window (including i)
+   * @param minimise true for minimisation problems
+   * @param best output with the index of the best neighbour of every individual
+   * @param queue scratch buffer (kept by the caller to avoid allocations)
+   */
+  template <class F>
+  inline void ring_best_indices(const F& YB, std::size_t side, std::size_t window, bool minimise,
+    std::vector<std::size_t>& best, std::vector<std::size_t>& queue)
+  {
+    std::size_t num_of_indiv = YB.shape()[0];
+    best.resize(num_of_indiv);
+    if (num_of_indiv == 0 || window == 0)
+    {
+      std::size_t i{ 0 };
+      std::generate(best.begin(), best.end(), [&i]() { return i++; });
+      return;
+    }
+    side = side % num_of_indiv;
+
+    std::size_t extended_size = num_of_indiv + window - 1;
+    queue.resize(extended_size);
+    std::size_t head{ 0 };
+    std::size_t tail{ 0 };
+
+    auto index_of = [&](std::size_t t) { return (t + num_of_indiv - side) % num_of_indiv; };
+    auto not_worse = [&](std::size_t a, std::size_t b)
+    {
+      return minimise ? !(YB(a) > YB(b)) : !(YB(a) < YB(b));
+    };
+
+    for (std::size_t t{ 0 }; t < extended_size; ++t)
+    {
+      std::size_t index = index_of(t);
+      // drop queued individuals that can no longer be the best of any window
+      while (tail > head && not_worse(index, index_of(queue[tail - 1])))
+      {
+        --tail;
+      }
+      queue[tail++] = t;
+
+      if (t + 1 >= window)
+      {
+        std::size_t first = t + 1 - window;
+        while (queue[head] < first)
+        {
+          ++head;
+        }
+        best[first] = index_of(queue[head]);
+      }
+    }
+  }
+
+  /**
+   * @brief neighbourhoods stored as a compressed sparse row (CSR) adjacency
+   *
+   * The neighbours of individual i are neighbours[offsets[i]], ...,
+   * neighbours[offsets[i + 1] - 1].
+   */
+  struct Adjacency_csr
+  {
+    std::vector<std::size_t> offsets; ///< size N + 1
+    std::vector<std::size_t> neighbours; ///< concatenated neighbour lists
+
+    std::size_t size() const
+    {
+      return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+
+    /**
+     * @brief index of the best neighbour of every individual
+     *
+     * @tparam F xtensor type of evaluations
+     * @param YB best evaluations of the individuals
+     * @param minimise true for minimisation problems
+     * @param best output with the index of the best neighbour of every individual
+     */
+    template <class F>
+    void best_indices(const F& YB, bool minimise, std::vector<std::size_t>& best) const
+    {
+      std::size_t num_of_indiv = size();
+      best.resize(num_of_indiv);
+      for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+      {
+        std::size_t b = i;
+        for (std::size_t k = offsets[i]; k < offsets[i + 1]; ++k)
+        {
+          std::size_t index = neighbours[k];
+          if (minimise ? YB(index) < YB(b) : YB(index) > YB(b))
+          {
+            b = index;
+          }
+        }
+        best[i] = b;
+      }
+    }
+  };
+
+  /**
+   * @brief ring topology: every particle is informed by its neighborhood_size nearest
+   *  neighbours on the ring (half on each side)
+   *
+   * The neighbourhood best is computed with a sliding window in O(N).
+   */
+  struct Topology_ring
+  {
+    Topology_ring(std::size_t neighborhood_size) : _neighborhood_size{ neighborhood_size }
+    {
+
+    }
+
+    template <class F>
+    void operator()(const F& YB, bool minimise, std::vector<std::size_t>& best)
+    {
+      std::size_t side = _neighborhood_size / 2;
+      ring_best_indices(YB, side, _neighborhood_size + 1, minimise, best, _queue);
+    }
+
+  private:
+    std::size_t _neighborhood_size;
+    std::vector<std::size_t> _queue; ///< scratch for the sliding window
+  };
+
+  /**
+   * @brief von Neumann topology: every particle is informed by its four neighbours
+   *  (left, right, up, down) on a toroidal lattice
+   *
+   * The particles are laid out row-wise on a lattice with the given number of
+   * columns (0 uses the nearest integer to \f$ \sqrt{N} \f$). Left and right wrap
+   * within a lattice row, up and down wrap over the swarm.
+   */
+  struct Topology_von_neumann
+  {
+    Topology_von_neumann(std::size_t columns = 0) : _columns{ columns }
+    {
+
+    }
+
+    template <class F>
+    void operator()(const F& YB, bool minimise, std::vector<std::size_t>& best)
+    {
+      std::size_t num_of_indiv = YB.shape()[0];
+      if (_adjacency.size() != num_of_indiv)
+      {
+        build(num_of_indiv);
+      }
+      _adjacency.best_indices(YB, minimise, best);
+    }
+
+    const Adjacency_csr& adjacency() const
+    {
+      return _adjacency;
+    }
+
+  private:
+
+    void build(std::size_t num_of_indiv)
+    {
+      std::size_t columns = _columns;
+      if (columns == 0)
+      {
+        columns = std::max<std::size_t>(1, static_cast<std::size_t>(std::lround(std::sqrt(double(num_of_indiv)))));
+      }
+      columns = std::min(columns, std::max<std::size_t>(1, num_of_indiv));
+
+      _adjacency.offsets.assign(1, 0);
+      _adjacency.neighbours.clear();
+      _adjacency.neighbours.reserve(4 * num_of_indiv);
+      for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+      {
+        std::size_t row_first = (i / columns) * columns;
+        std::size_t row_length = std::min(columns, num_of_indiv - row_first);
+        std::size_t col = i - row_first;
+        _adjacency.neighbours.push_back(row_first + (col + row_length - 1) % row_length);
+        _adjacency.neighbours.push_back(row_first + (col + 1) % row_length);
+        _adjacency.neighbours.push_back((i + num_of_indiv - columns % num_of_indiv) % num_of_indiv);
+        _adjacency.neighbours.push_back((i + columns) % num_of_indiv);
+        _adjacency.offsets.push_back(_adjacency.neighbours.size());
+      }
+    }
+
+    std::size_t _columns;
+    Adjacency_csr _adjacency;
+  };
+
+  /**
+   * @brief random k-regular (dynamic) topology: every particle is informed by k particles
+   *  drawn at random and informs exactly k particles
+   *
+   * The neighbour lists are built from k random permutations of the swarm, so both
+   * the in- and out-degree of every particle are k. They are redrawn every period
+   * calls (period = 0 keeps the first draw, which gives a static random topology).
+   * Call rewire() to redraw them on demand, e.g. after a generation without
+   * improvement of the global best.
+   */
+  struct Topology_random
+  {
+    Topology_random(std::size_t k, std::size_t period = 0) : _k{ k }, _period{ period }
+    {
+
+    }
+
+    template <class F>
+    void operator()(const F& YB, bool minimise, std::vector<std::size_t>& best)
+    {
+      std::size_t num_of_indiv = YB.shape()[0];
+      if (_adjacency.size() != num_of_indiv || _rewire || (_period > 0 && _calls % _period == 0))
+      {
+        build(num_of_indiv);
+        _rewire = false;
+      }
+      ++_calls;
+      _adjacency.best_indices(YB, minimise, best);
+    }
+
+    /**
+     * @brief redraw the neighbour lists before the next call
+     */
+    void rewire()
+    {
+      _rewire = true;
+    }
+
+    const Adjacency_csr& adjacency() const
+    {
+      return _adjacency;
+    }
+
+  private:
+
+    void build(std::size_t num_of_indiv)
+    {
+      _permutation.resize(num_of_indiv);
+      _adjacency.neighbours.resize(_k * num_of_indiv);
+      _adjacency.offsets.resize(num_of_indiv + 1);
+      for (std::size_t i{ 0 }; i <= num_of_indiv; ++i)
+      {
+        _adjacency.offsets[i] = i * _k;
+      }
+      for (std::size_t m{ 0 }; m < _k; ++m)
+      {
+        std::size_t i{ 0 };
+        std::generate(_permutation.begin(), _permutation.end(), [&i]() { return i++; });
+        random_shuffle(_permutation.begin(), _permutation.end(), _gen);
+        for (i = 0; i < num_of_indiv; ++i)
+        {
+          _adjacency.neighbours[i * _k + m] = _permutation[i];
+        }
+      }
+    }
+
+    std::size_t _k;
+    std::size_t _period;
+    std::size_t _calls{ 0 };
+    bool _rewire{ false };
+    random_engine _gen = make_random_engine(); ///< random engine of the topology
+    std::vector<std::size_t> _permutation; ///< scratch for the random permutations
+    Adjacency_csr _adjacency;
+  };
+
+}
+
+#endif
@@ -0,0 +1,67 @@
+// Evaluation worker process for test_process_evaluation.cpp.
+//
+// The fitness of a candidate is the sum of its squared genes. Options:
+//   --crash-after N  exit without a reply on request N + 1 of the process
+//   --hang-above V   never reply to a request with a gene greater than V
+//   --sleep-ms M     wait M milliseconds before every reply
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "xevo/process_evaluation.hpp"
+
+int main(int argc, char* argv[])
+{
+  long crash_after{ -1 };
+  double hang_above{ 0.0 };
+  bool hang{ false };
+  long sleep_ms{ 0 };
+  for (int a{ 1 }; a + 1 < argc; a += 2)
+  {
+    if (std::strcmp(argv[a], "--crash-after") == 0)
+    {
+      crash_after = std::atol(argv[a + 1]);
+    }
+    else if (std::strcmp(argv[a], "--hang-above") == 0)
+    {
+      hang_above = std::atof(argv[a + 1]);
+      hang = true;
+    }
+    else if (std::strcmp(argv[a], "--sleep-ms") == 0)
+    {
+      sleep_ms = std::atol(argv[a + 1]);
+    }
+  }
+
+  long num_of_requests{ 0 };
+  xevo::serve_evaluations([&](const xt::xtensor<double, 2>& X)
+  {
+    if (num_of_requests++ == crash_after)
+    {
+      std::_Exit(3);
+    }
+    std::array<std::size_t, 1> shape_y = { X.shape()[0] };
+    xt::xtensor<double, 1> y(shape_y);
+    for (std::size_t i{ 0 }; i < X.shape()[0]; ++i)
+    {
+      y(i) = 0.0;
+      for (std::size_t j{ 0 }; j < X.shape()[1]; ++j)
+      {
+        if (hang && X(i, j) > hang_above)
+        {
+          while (true)
+          {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+          }
+        }
+        y(i) += X(i, j) * X(i, j);
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+    return y;
+  });
+  return 0;
+}
@@ -0,0 +1,96 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "gtest/gtest.h"
+
+#include "xevo/ga.hpp"
+
+namespace
+{
+  std::atomic<std::size_t> allocation_count{ 0 };
+
+  /**
+   * @brief row-wise objective writing into a buffer owned by the functor
+   *
+   * Returning a reference keeps the objective itself free of allocations so
+   * that only the allocations of the generation loop are counted.
+   */
+  struct Sphere_buffered
+  {
+    template <class E>
+    const xt::xtensor<double, 1>& operator()(const xt::xexpression<E>& X)
+    {
+      const E& _X = X.derived_cast();
+      std::size_t num_of_indiv = _X.shape()[0];
+      std::size_t num_of_vars = _X.shape()[1];
+      if (_y.size() != num_of_indiv)
+      {
+        std::array<std::size_t, 1> shape_y = { num_of_indiv };
+        _y.resize(shape_y);
+      }
+      for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+      {
+        double sum{ 0.0 };
+        for (std::size_t j{ 0 }; j < num_of_vars; ++j)
+        {
+          double x = 2.0 * _X(i, j) - 1.0;
+          sum += x * x;
+        }
+        _y(i) = 1.0 / (1.0 + sum);
+      }
+      return _y;
+    }
+
+    xt::xtensor<double, 1> _y;
+  };
+}
+
+// Count every allocation made through operator new. xsimd aligned allocators
+// bypass operator new, so the population below uses std::allocator.
+void* operator new(std::size_t size)
+{
+  ++allocation_count;
+  if (void* p = std::malloc(size == 0 ? 1 : size))
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+TEST(allocation, ga_state_steady_state_generation)
+{
+  using xtensor_x_type = xt::xarray<double, xt::layout_type::row_major, std::allocator<double>>;
+  using state_type = xevo::ga_state<xtensor_x_type, Sphere_buffered>;
+
+  static_assert(state_type::output_operators::value, "default ga functors should provide output overloads");
+
+  std::array<std::size_t, 2> shape = { 200, 10 };
+  xtensor_x_type X = xt::zeros<double>(shape);
+
+  xevo::ga genetic_algorithm;
+  genetic_algorithm.initialise(X);
+
+  state_type state(X, Sphere_buffered{}, xevo::Elitism(0.05), xevo::Roulette_selection{},
+    xevo::Crossover(0.8), xevo::Mutation_polynomial(0.1, 60.0));
+
+  // warm up: scratch buffers grow to their final size
+  state.run(2);
+
+  std::size_t allocations_before = allocation_count.load();
+  state.run(20);
+  std::size_t allocations_after = allocation_count.load();
+
+  EXPECT_EQ(allocations_after - allocations_before, 0);
+  EXPECT_EQ(state.generation(), 22);
+}
@@ -0,0 +1,189 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+#include "xevo/ga.hpp"
+#include "xevo/pso.hpp"
+#include "xevo/pso_ga.hpp"
+#include "xevo/rng.hpp"
+#include "xevo/analytical_functions.hpp"
+
+#include "xtensor/xio.hpp"
+
+namespace
+{
+  /**
+   * @brief evaluate the generations of a solver through ask/tell
+   *
+   * Every generation is asked for in batches of batch_size rows and told back in a
+   * shuffled order, half of it as a batch and the rest one row at a time.
+   */
+  template <class S, class OBJ>
+  void ask_tell_cycles(S& state, OBJ objective_f, std::size_t cycles, std::size_t batch_size)
+  {
+    std::mt19937 g(42);
+    for (std::size_t c{ 0 }; c < cycles; ++c)
+    {
+      std::vector<std::size_t> indices;
+      std::vector<double> y;
+      while (true)
+      {
+        // a batch is a view of the population: ask for the next one in a new object
+        auto batch = state.ask(batch_size);
+        if (batch.size() == 0)
+        {
+          break;
+        }
+        auto y_batch = objective_f(batch.X);
+        for (std::size_t k{ 0 }; k < batch.size(); ++k)
+        {
+          indices.push_back(batch.indices[k]);
+          y.push_back(y_batch(k));
+        }
+      }
+
+      std::vector<std::size_t> order(indices.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::shuffle(order.begin(), order.end(), g);
+
+      std::size_t half = order.size() / 2;
+      std::vector<std::size_t> indices_half;
+      std::vector<double> y_half;
+      for (std::size_t k{ 0 }; k < half; ++k)
+      {
+        indices_half.push_back(indices[order[k]]);
+        y_half.push_back(y[order[k]]);
+      }
+      state.tell(indices_half, y_half);
+      EXPECT_EQ(state.outstanding(), order.size() - half);
+
+      for (std::size_t k{ half }; k < order.size(); ++k)
+      {
+        state.tell(indices[order[k]], y[order[k]]);
+      }
+      EXPECT_EQ(state.outstanding(), 0);
+    }
+  }
+}
+
+TEST(ask_tell, ga_state_matches_run)
+{
+  std::array<std::size_t, 2> shape = { 40, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+
+  xevo::ga genetic_algorithm;
+  genetic_algorithm.initialise(X);
+
+  std::size_t num_generations = 20;
+
+  xevo::seed(1);
+  auto state = xevo::make_ga_state(X, xevo::Sphere{}, xevo::Elitism(0.05),
+    xevo::Roulette_selection{}, xevo::Crossover(0.8), xevo::Mutation_polynomial(0.1, 60.0));
+  state.run(num_generations);
+
+  xevo::seed(1);
+  auto state_at = xevo::make_ga_state(X, xevo::No_objective{}, xevo::Elitism(0.05),
+    xevo::Roulette_selection{}, xevo::Crossover(0.8), xevo::Mutation_polynomial(0.1, 60.0));
+  // the initial population and one population per generation
+  ask_tell_cycles(state_at, xevo::Sphere{}, num_generations + 1, 7);
+
+  EXPECT_EQ(state_at.generation(), state.generation());
+  EXPECT_EQ(state_at.evaluations(), state.evaluations());
+  EXPECT_EQ(state_at.population(), state.population());
+  EXPECT_EQ(state_at.fitness(), state.fitness());
+}
+
+TEST(ask_tell, pso_state_matches_run)
+{
+  std::array<std::size_t, 2> shape = { 30, 2 };
+  std::array<std::size_t, 1> shape_y = { 30 };
+
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xt::xarray<double> V = xt::zeros<double>(shape);
+
+  xevo::pso pso_algorithm;
+  pso_algorithm.initialise<xt::xarray<double>, xevo::Population>(X);
+  pso_algorithm.initialise<xt::xarray<double>, xevo::Velocity_zero>(V);
+
+  xt::xarray<double> XB(X);
+  xt::xarray<double> YB = xt::ones<double>(shape_y) * std::numeric_limits<double>::max();
+
+  std::size_t num_generations = 20;
+
+  xevo::seed(1);
+  auto state = xevo::make_pso_state(X, XB, YB, V, xevo::Sphere{}, xevo::Position{},
+    xevo::Velocity(0.5, 0.8, 0.9), xevo::Selection_best_pso{});
+  state.run(num_generations);
+
+  xevo::seed(1);
+  auto state_at = xevo::make_pso_state(X, XB, YB, V, xevo::No_objective{}, xevo::Position{},
+    xevo::Velocity(0.5, 0.8, 0.9), xevo::Selection_best_pso{});
+  ask_tell_cycles(state_at, xevo::Sphere{}, num_generations + 1, 8);
+
+  EXPECT_EQ(state_at.generation(), state.generation());
+  EXPECT_EQ(state_at.evaluations(), state.evaluations());
+  EXPECT_EQ(state_at.position(), state.position());
+  EXPECT_EQ(state_at.position_best(), state.position_best());
+}
+
+TEST(ask_tell, pso_ga_state_matches_run)
+{
+  std::array<std::size_t, 2> shape = { 30, 2 };
+
+  xt::xarray<double> X = xt::zeros<double>(shape);
+
+  xevo::Sphere objective_f;
+
+  xevo::pso_ga pso_ga_algorithm;
+  pso_ga_algorithm.initialise(X);
+  xt::xarray<double> A(X);
+  xt::xarray<double> Xm1(X);
+  xt::xarray<double> YB = objective_f(A);
+
+  std::size_t num_generations = 20;
+
+  xevo::seed(1);
+  auto state = xevo::make_pso_ga_state(X, Xm1, YB, A, xevo::Sphere{},
+    xevo::Position_pso_ga(0.5, 2.1, 2.1, 20, true), xevo::Selection_best_pso_ga(true),
+    xevo::Mutation_polynomial(0.0, 50.0));
+  state.run(num_generations);
+
+  xevo::seed(1);
+  auto state_at = xevo::make_pso_ga_state(X, Xm1, YB, A, xevo::No_objective{},
+    xevo::Position_pso_ga(0.5, 2.1, 2.1, 20, true), xevo::Selection_best_pso_ga(true),
+    xevo::Mutation_polynomial(0.0, 50.0));
+  ask_tell_cycles(state_at, xevo::Sphere{}, num_generations, 30);
+
+  EXPECT_EQ(state_at.generation(), state.generation());
+  EXPECT_EQ(state_at.evaluations(), state.evaluations());
+  EXPECT_EQ(state_at.position(), state.position());
+  EXPECT_EQ(state_at.archive(), state.archive());
+}
+
+TEST(ask_tell, invalid_tell_throws)
+{
+  std::array<std::size_t, 2> shape = { 10, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+
+  xevo::ga genetic_algorithm;
+  genetic_algorithm.initialise(X);
+
+  auto state = xevo::make_ga_state(X, xevo::No_objective{}, xevo::Elitism(0.05),
+    xevo::Roulette_selection{}, xevo::Crossover(0.8), xevo::Mutation_polynomial(0.1, 60.0));
+
+  auto batch = state.ask(4);
+  EXPECT_EQ(batch.size(), 4);
+  EXPECT_EQ(state.outstanding(), 4);
+
+  // row 5 has not been asked for
+  EXPECT_THROW(state.tell(5, 1.0), std::runtime_error);
+
+  state.tell(2, 1.0);
+  EXPECT_THROW(state.tell(2, 1.0), std::runtime_error);
+  EXPECT_EQ(state.outstanding(), 3);
+
+  // the generation is incomplete and the objective cannot be called
+  EXPECT_THROW(state.fitness(), std::runtime_error);
+}
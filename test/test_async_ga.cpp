@@ -0,0 +1,116 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "xtensor/xio.hpp"
+#include "xtensor/xreducer.hpp"
+
+#include "xevo/async_ga.hpp"
+#include "xevo/ga.hpp"
+
+namespace
+{
+  // positive fitness growing with the genes; the evaluation time varies by 10x with the first gene
+  struct Slow_sum_of_genes
+  {
+    template <class E>
+    auto operator()(const xt::xexpression<E>& X)
+    {
+      const E& _X = X.derived_cast();
+      if (_sleep)
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(100 + int(900.0 * _X(0, 0))));
+      }
+      if (_X(0, 0) < 0.0 || (_failures != nullptr && _failures->fetch_sub(1) > 0))
+      {
+        throw std::runtime_error("negative gene");
+      }
+      return xt::eval(xt::sum(_X, { 1 }));
+    }
+
+    bool _sleep;
+    std::atomic<int>* _failures = nullptr; ///< number of evaluations that throw
+  };
+}
+
+TEST(async_ga, improves_population)
+{
+  std::array<std::size_t, 2> shape = { 20, 4 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xevo::ga genetic_algorithm;
+  genetic_algorithm.initialise(X);
+
+  auto pool = std::make_shared<xevo::thread_pool>(4);
+  for (auto replacement : { xevo::replacement_policy::worst, xevo::replacement_policy::tournament })
+  {
+    xevo::async_ga_options options;
+    options.replacement = replacement;
+    auto state = xevo::make_async_ga_state(X, Slow_sum_of_genes{ true }, xevo::Roulette_selection{},
+      xevo::Crossover_sbx(0.9), xevo::Mutation_polynomial(0.25, 20.0), options, pool);
+
+    auto y_initial = state.fitness();
+    state.run(200);
+    state.run(200);
+    EXPECT_EQ(state.evaluations(), 20u + 400u);
+    EXPECT_GT(state.replacements(), 0u);
+
+    // the offspring only replace individuals that are not better
+    auto y = state.fitness();
+    EXPECT_GE(xt::amin(y)(), xt::amin(y_initial)());
+    EXPECT_GT(xt::mean(y)(), xt::mean(y_initial)());
+
+    // the stored fitness belongs to the stored individuals
+    xt::xarray<double> y_check = xt::sum(state.population(), { 1 });
+    EXPECT_TRUE(xt::allclose(y, y_check));
+  }
+}
+
+TEST(async_ga, serial_run)
+{
+  std::array<std::size_t, 2> shape = { 10, 3 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xevo::ga genetic_algorithm;
+  genetic_algorithm.initialise(X);
+
+  auto state = xevo::make_async_ga_state(X, Slow_sum_of_genes{ false }, xevo::Roulette_selection{},
+    xevo::Crossover_sbx(0.9), xevo::Mutation_polynomial(0.25, 20.0));
+  state.run(100);
+
+  EXPECT_EQ(state.threads(), 1u);
+  EXPECT_EQ(state.evaluations(), 110u);
+}
+
+TEST(async_ga, rethrows_objective_error)
+{
+  std::array<std::size_t, 2> shape = { 8, 2 };
+  xt::xarray<double> X = 0.5 * xt::ones<double>(shape);
+  X(3, 0) = -1.0;
+
+  auto state = xevo::make_async_ga_state(X, Slow_sum_of_genes{ false }, xevo::Roulette_selection{},
+    xevo::Crossover_sbx(0.9), xevo::Mutation_polynomial(0.25, 20.0), xevo::async_ga_options{},
+    std::make_shared<xevo::thread_pool>(3));
+  EXPECT_THROW(state.run(10), std::runtime_error);
+}
+
+TEST(async_ga, valid_after_objective_error)
+{
+  std::array<std::size_t, 2> shape = { 8, 2 };
+  xt::xarray<double> X = 0.5 * xt::ones<double>(shape);
+
+  // the first evaluation throws
+  std::atomic<int> failures{ 1 };
+  Slow_sum_of_genes objective_f{ false, &failures };
+  auto state = xevo::make_async_ga_state(X, objective_f, xevo::Roulette_selection{},
+    xevo::Crossover_sbx(0.9), xevo::Mutation_polynomial(0.25, 20.0), xevo::async_ga_options{},
+    std::make_shared<xevo::thread_pool>(3));
+  EXPECT_THROW(state.run(10), std::runtime_error);
+
+  // the failed rows of the initial population are evaluated by the next run
+  state.run(10);
+  EXPECT_EQ(state.evaluations(), 8u + 10u);
+  xt::xarray<double> y_check = xt::sum(state.population(), { 1 });
+  EXPECT_TRUE(xt::allclose(state.fitness(), y_check));
+}
@@ -0,0 +1,101 @@
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <thread>
+
+#include "xtensor/xio.hpp"
+#include "xtensor/xreducer.hpp"
+
+#include "xevo/async_pso.hpp"
+#include "xevo/pso.hpp"
+#include "xevo/analytical_functions.hpp"
+
+TEST(async_pso, run_sphere)
+{
+  std::array<std::size_t, 2> shape = { 30, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xt::xarray<double> V = xt::zeros<double>(shape);
+
+  xevo::pso pso_algorithm;
+  pso_algorithm.initialise<xt::xarray<double>, xevo::Population>(X);
+  pso_algorithm.initialise<xt::xarray<double>, xevo::Velocity_zero>(V);
+
+  auto pool = std::make_shared<xevo::thread_pool>(4);
+  for (std::size_t block_size : { 1, 4 })
+  {
+    xevo::async_pso_options options;
+    options.block_size = block_size;
+    auto state = xevo::make_async_pso_state(X, V, xevo::Sphere{}, 0.5, 0.8, 0.9, options, pool);
+
+    state.run(1500);
+    state.run(1500);
+    EXPECT_GE(state.evaluations(), 3000u);
+    EXPECT_LT(state.evaluations(), 3000u + 2u * 4u * block_size);
+
+    std::vector<double> x_best;
+    double y_best = state.best(x_best);
+    EXPECT_NEAR(0.5, x_best[0], 1e-004);
+    EXPECT_NEAR(0.5, x_best[1], 1e-004);
+
+    // the global best is the best of the personal best slots
+    EXPECT_DOUBLE_EQ(y_best, xt::amin(state.fitness_best())());
+  }
+}
+
+TEST(async_pso, threads_outnumber_blocks)
+{
+  std::array<std::size_t, 2> shape = { 6, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xt::xarray<double> V = xt::zeros<double>(shape);
+
+  xevo::pso pso_algorithm;
+  pso_algorithm.initialise<xt::xarray<double>, xevo::Population>(X);
+  pso_algorithm.initialise<xt::xarray<double>, xevo::Velocity_zero>(V);
+
+  // three blocks of two particles: the tasks are limited to the blocks
+  xevo::async_pso_options options;
+  options.block_size = 2;
+  auto state = xevo::make_async_pso_state(X, V, xevo::Sphere{}, 0.5, 0.8, 0.9, options,
+    std::make_shared<xevo::thread_pool>(8));
+  EXPECT_EQ(state.threads(), 3u);
+
+  state.run(600);
+  EXPECT_GE(state.evaluations(), 600u);
+  EXPECT_LT(state.evaluations(), 600u + 2u * 3u);
+}
+
+TEST(async_pso, best_record_is_consistent)
+{
+  std::size_t num_of_vars = 32;
+  xevo::best_record<double> record(num_of_vars);
+  EXPECT_EQ(record.version(), 0u);
+
+  std::vector<std::thread> threads;
+  std::vector<int> torn(4, 0);
+  for (std::size_t t{ 0 }; t < 4; ++t)
+  {
+    threads.emplace_back([&, t]()
+    {
+      std::vector<double> x(num_of_vars);
+      for (std::size_t k{ 0 }; k < 5000; ++k)
+      {
+        double y = 1e006 - double(4 * k + t);
+        std::fill(x.begin(), x.end(), y);
+        record.offer(x.data(), y);
+
+        // every gene of a record equals its evaluation
+        double y_read;
+        record.read(x.data(), y_read);
+        torn[t] += std::any_of(x.begin(), x.end(), [y_read](double v) { return v != y_read; }) ? 1 : 0;
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_EQ(torn, std::vector<int>(4, 0));
+  EXPECT_DOUBLE_EQ(record.fitness(), 1e006 - double(4 * 4999 + 3));
+  EXPECT_EQ(record.version() % 2, 0u);
+}
@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+
+#include "xevo/de.hpp"
+#include "xevo/analytical_functions.hpp"
+
+#include "xtensor/xio.hpp"
+#include "xtensor/xsort.hpp"
+
+TEST(de, void_evolve_sphere)
+{
+  std::array<std::size_t, 2> shape = { 20, 2 };
+
+  for (int strategy{ 0 }; strategy < 3; ++strategy)
+  {
+    xt::xarray<double> X = xt::zeros<double>(shape);
+    xevo::de differential_evolution;
+    differential_evolution.initialise(X);
+    xt::xarray<double> Y = xevo::Sphere{}(X);
+
+    for (std::size_t i{ 0 }; i < 200; ++i)
+    {
+      if (strategy == 0)
+      {
+        differential_evolution.evolve(X, Y, xevo::Sphere{}, std::make_tuple());
+      }
+      else if (strategy == 1)
+      {
+        differential_evolution.evolve<xt::xarray<double>, xt::xarray<double>, xevo::Sphere, xevo::De_best_1_bin>(
+          X, Y, xevo::Sphere{}, std::make_tuple(0.5, 0.9));
+      }
+      else
+      {
+        differential_evolution.evolve<xt::xarray<double>, xt::xarray<double>, xevo::Sphere,
+          xevo::De_current_to_pbest_1>(X, Y, xevo::Sphere{}, std::make_tuple(0.1));
+      }
+    }
+
+    auto x_best = xt::view(X, xt::argmin(Y)(), xt::all());
+    EXPECT_NEAR(0.5, x_best(0), 1e-006);
+    EXPECT_NEAR(0.5, x_best(1), 1e-006);
+  }
+}
+
+TEST(de, auto_evolve_tol)
+{
+  std::array<std::size_t, 2> shape = { 20, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xevo::de differential_evolution;
+  differential_evolution.initialise(X);
+  xt::xarray<double> Y = xevo::Sphere{}(X);
+
+  double best{ 0.0 };
+  for (std::size_t i{ 0 }; i < 200; ++i)
+  {
+    best = differential_evolution.evolve<xt::xarray<double>, xt::xarray<double>, xevo::Sphere, xevo::De_rand_1_bin,
+      xevo::Terminate_tol>(X, Y, xevo::Sphere{}, std::make_tuple(), std::make_tuple(false));
+  }
+  EXPECT_NEAR(1.0, best, 1e-010);
+}
+
+TEST(de, state_run_rosenbrock_jade)
+{
+  std::array<std::size_t, 2> shape = { 30, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xevo::de differential_evolution;
+  differential_evolution.initialise(X);
+
+  auto state = xevo::make_de_state(X, xevo::Rosenbrock{}, xevo::De_current_to_pbest_1{});
+  std::size_t num_generations = 300;
+  state.run(num_generations);
+
+  EXPECT_EQ(state.evaluations(), 30 * (num_generations + 1));
+
+  auto x_best = xt::view(state.population(), xt::argmin(state.fitness())(), xt::all());
+  EXPECT_NEAR(0.666, x_best(0), 1e-003);
+  EXPECT_NEAR(0.666, x_best(1), 1e-003);
+}
+
+TEST(de, threads_do_not_change_the_result)
+{
+  std::array<std::size_t, 2> shape = { 40, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xevo::de differential_evolution;
+  differential_evolution.initialise(X);
+
+  xevo::seed(3);
+  auto serial = xevo::make_de_state(X, xevo::Rastriginsfcn{}, xevo::De_current_to_pbest_1{});
+  serial.run(50);
+
+  xevo::seed(3);
+  auto threaded = xevo::make_de_state(X, xevo::Rastriginsfcn{},
+    xevo::De_current_to_pbest_1(0.05, 0.1, true, false, std::make_shared<xevo::thread_pool>(4)));
+  threaded.run(50);
+
+  EXPECT_EQ(serial.population(), threaded.population());
+  EXPECT_EQ(serial.strategy().mu_F(), threaded.strategy().mu_F());
+}
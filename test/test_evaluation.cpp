@@ -0,0 +1,184 @@
+#include <atomic>
+
+#include "gtest/gtest.h"
+
+#include "xevo/evaluation.hpp"
+#include "xevo/pso.hpp"
+#include "xevo/analytical_functions.hpp"
+
+#include "xtensor/xbuilder.hpp"
+#include "xtensor/xio.hpp"
+
+
+TEST(thread_pool, parallel_for)
+{
+  xevo::thread_pool pool(4);
+
+  std::vector<std::size_t> values(1000, 0);
+  pool.parallel_for(values.size(), [&](std::size_t i) { values[i] = i; });
+
+  std::size_t sum{ 0 };
+  for (auto v : values)
+  {
+    sum += v;
+  }
+
+  EXPECT_EQ(sum, 499500);
+}
+
+TEST(thread_pool, nested_parallel_for)
+{
+  xevo::thread_pool pool(2);
+
+  // tasks running on the calling thread and on the worker call back into the pool
+  std::vector<std::size_t> values(8 * 100, 0);
+  pool.parallel_for(8, [&](std::size_t i)
+  {
+    pool.parallel_for(100, [&](std::size_t j) { values[i * 100 + j] = i * 100 + j; });
+  });
+
+  std::size_t sum{ 0 };
+  for (auto v : values)
+  {
+    sum += v;
+  }
+
+  EXPECT_EQ(sum, 319600);
+}
+
+TEST(evaluation, parallel_equals_serial)
+{
+  std::array<std::size_t, 2> shape = { 103, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+
+  xevo::Population pop_f;
+  pop_f(X);
+
+  xevo::Sphere objective_f;
+  xevo::Evaluate_parallel<xevo::Sphere> objective_parallel_f(objective_f, 7, 3);
+
+  auto y = objective_f(X);
+  auto y_parallel = objective_parallel_f(X);
+
+  EXPECT_TRUE(xt::allclose(y, y_parallel));
+}
+
+TEST(evaluation, parallel_view)
+{
+  std::array<std::size_t, 2> shape = { 103, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+
+  xevo::Population pop_f;
+  pop_f(X);
+
+  // chunks of a view are evaluated on row-major copies
+  auto X_view = xt::view(X, xt::range(0, 50), xt::all());
+  xevo::Sphere objective_f;
+  xevo::Evaluate_parallel<xevo::Sphere> objective_parallel_f(objective_f, 7, 3);
+
+  auto y = objective_f(X_view);
+  auto y_parallel = objective_parallel_f(X_view);
+
+  EXPECT_TRUE(xt::allclose(y, y_parallel));
+}
+
+TEST(evaluation, pso_parallel_sphere)
+{
+  std::array<std::size_t, 2> shape = { 30, 2 };
+  std::array<std::size_t, 1> shape_y = { 30 };
+
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xt::xarray<double> V = xt::zeros<double>(shape);
+  double max_double_value = std::numeric_limits<double>::max();
+
+  xevo::Evaluate_parallel<xevo::Sphere> objective_f(xevo::Sphere{}, 4);
+
+  xevo::pso pso_algorithm;
+  pso_algorithm.initialise<xt::xarray<double>, xevo::Population>(X);
+  pso_algorithm.initialise<xt::xarray<double>, xevo::Velocity_zero>(V);
+
+  xt::xarray<double> XB(X);
+  xt::xarray<double> YB = xt::ones<double>(shape_y) * max_double_value;
+
+  std::size_t num_generations = 100;
+  for (auto i{ 0 }; i < num_generations; ++i)
+  {
+    pso_algorithm.evolve(X, XB, YB, V, objective_f, std::make_tuple(),
+      std::make_tuple(0.5, 0.8, 0.9), std::make_tuple());
+  }
+
+  auto y_args_sort = xt::argsort(YB);
+  auto x_best = xt::view(XB, y_args_sort(0), xt::all());
+
+  EXPECT_NEAR(0.5, x_best(0), 1e-006);
+  EXPECT_NEAR(0.5, x_best(1), 1e-006);
+}
+
+TEST(evaluation, cached_hits_and_misses)
+{
+  // distinct individuals (0, 1), (2, 3), ...
+  xt::xarray<double> X = xt::arange<double>(40);
+  X.reshape({ 20, 2 });
+  // duplicate individual within the same population
+  xt::view(X, 1, xt::all()) = xt::view(X, 0, xt::all());
+
+  xevo::Sphere objective_f;
+  xevo::Evaluate_cached<xevo::Sphere> objective_cached_f(objective_f, 15);
+
+  auto y = objective_f(X);
+  auto y_cached = objective_cached_f(X);
+
+  EXPECT_TRUE(xt::allclose(y, y_cached));
+  EXPECT_EQ(objective_cached_f.misses(), 19);
+  EXPECT_EQ(objective_cached_f.hits(), 1);
+  EXPECT_EQ(objective_cached_f.size(), 15);
+
+  // the 15 most recent individuals are served from the cache
+  auto y_cached_2 = objective_cached_f(xt::eval(xt::view(X, xt::range(5, 20), xt::all())));
+
+  EXPECT_TRUE(xt::allclose(xt::view(y, xt::range(5, 20)), y_cached_2));
+  EXPECT_EQ(objective_cached_f.misses(), 19);
+  EXPECT_EQ(objective_cached_f.hits(), 16);
+}
+
+TEST(evaluation, cached_view)
+{
+  xt::xarray<double> X = xt::arange<double>(40);
+  X.reshape({ 20, 2 });
+
+  // missed rows of a view are evaluated on a row-major copy
+  auto X_view = xt::view(X, xt::range(5, 20), xt::all());
+  xevo::Sphere objective_f;
+  xevo::Evaluate_cached<xevo::Sphere> objective_cached_f(objective_f, 15);
+
+  auto y = objective_f(X_view);
+  auto y_cached = objective_cached_f(X_view);
+
+  EXPECT_TRUE(xt::allclose(y, y_cached));
+  EXPECT_EQ(objective_cached_f.misses(), 15);
+}
+
+TEST(evaluation, cached_concurrent_copies)
+{
+  xevo::Sphere objective_f;
+  xevo::Evaluate_cached<xevo::Sphere> objective_cached_f(objective_f, 64);
+  xevo::thread_pool pool(4);
+
+  // copies share the cache and are called from several threads
+  std::atomic<std::size_t> num_of_errors{ 0 };
+  pool.parallel_for(100, [&](std::size_t t)
+  {
+    auto cached_f = objective_cached_f;
+    xt::xarray<double> X = xt::arange<double>(double(t % 10), double(t % 10 + 20));
+    X.reshape({ 10, 2 });
+    auto y = objective_f(X);
+    auto y_cached = cached_f(X);
+    if (!xt::allclose(y, y_cached))
+    {
+      ++num_of_errors;
+    }
+  });
+
+  EXPECT_EQ(num_of_errors, 0u);
+  EXPECT_EQ(objective_cached_f.hits() + objective_cached_f.misses(), 100u * 10u);
+}
@@ -1,7 +1,11 @@
 #include "gtest/gtest.h"
 
 #include "xtensor/xio.hpp"
+#include "xtensor/xmanipulation.hpp"
+#include "xtensor/xrandom.hpp"
 
+#include "xevo/crossover.hpp"
+#include "xevo/initialisation.hpp"
 #include "xevo/functors.hpp"
 
 TEST(functors, population)
@@ -45,4 +49,433 @@ TEST(functors, Terminate_gen_max)
   run = term_f2(X, Y);
 
   EXPECT_FALSE(run);
-}
\ No newline at end of file
+}
+
+TEST(functors, ring_best_indices)
+{
+  std::size_t num_of_indiv = 25;
+  std::array<std::size_t, 1> shape_y = { num_of_indiv };
+  xt::xarray<double> YB = xt::random::randint<int>(shape_y, 0, 5);
+
+  std::vector<std::size_t> best;
+  std::vector<std::size_t> queue;
+  for (std::size_t window : { 1, 2, 5, 9, 30 })
+  {
+    std::size_t side = window / 2;
+    xevo::ring_best_indices(YB, side, window, true, best, queue);
+
+    for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+    {
+      // brute force scan of the neighbourhood
+      double y_best = YB((i + num_of_indiv - side) % num_of_indiv);
+      for (std::size_t j{ 0 }; j < window; ++j)
+      {
+        y_best = std::min(y_best, YB((i + num_of_indiv - side + j) % num_of_indiv));
+      }
+      EXPECT_DOUBLE_EQ(YB(best[i]), y_best);
+    }
+  }
+}
+
+TEST(functors, topologies)
+{
+  xt::xarray<double> YB = xt::arange<double>(12);
+  std::vector<std::size_t> best;
+
+  xevo::Topology_von_neumann von_neumann(4);
+  von_neumann(YB, false, best);
+  // particle 5 is on row 1, column 1: neighbours 4, 6, 1, 9
+  EXPECT_EQ(best[5], 9u);
+  EXPECT_EQ(von_neumann.adjacency().neighbours.size(), 48u);
+
+  xevo::Topology_random random(3, 1);
+  random(YB, true, best);
+  std::vector<std::size_t> in_degree(12, 0);
+  for (std::size_t n : random.adjacency().neighbours)
+  {
+    ++in_degree[n];
+  }
+  for (std::size_t i{ 0 }; i < 12; ++i)
+  {
+    EXPECT_EQ(in_degree[i], 3u);
+    // the best is the minimum over the particle and its neighbour list
+    const auto& adjacency = random.adjacency();
+    double y_best = YB(i);
+    for (std::size_t k = adjacency.offsets[i]; k < adjacency.offsets[i + 1]; ++k)
+    {
+      y_best = std::min(y_best, YB(adjacency.neighbours[k]));
+    }
+    EXPECT_DOUBLE_EQ(YB(best[i]), y_best);
+  }
+
+  // ring of 4 neighbours: the minimum over the window [i - 2, i + 2]
+  xt::xarray<double> YB_ring = { 7.0, 3.0, 9.0, 4.0, 11.0, 0.0, 8.0, 6.0, 10.0, 2.0, 5.0, 1.0 };
+  xevo::Topology_ring ring(4);
+  ring(YB_ring, true, best);
+  for (std::size_t i{ 0 }; i < 12; ++i)
+  {
+    double y_best = YB_ring((i + 10) % 12);
+    for (std::size_t j{ 1 }; j < 5; ++j)
+    {
+      y_best = std::min(y_best, YB_ring((i + 10 + j) % 12));
+    }
+    EXPECT_DOUBLE_EQ(YB_ring(best[i]), y_best);
+    EXPECT_LE((best[i] + 12 - (i + 10) % 12) % 12, 4u);
+  }
+}
+
+TEST(functors, selection_indices)
+{
+  xt::xarray<double> Y = { 1.0, 2.0, 3.0, 0.0, 4.0 };
+  std::vector<std::size_t> indices;
+
+  // stochastic universal sampling: every individual gets its expected number of copies
+  xevo::Stochastic_universal_sampling sus_f;
+  sus_f.select_indices(Y, 10, indices);
+  std::vector<std::size_t> copies(5, 0);
+  for (std::size_t i : indices)
+  {
+    ++copies[i];
+  }
+  EXPECT_EQ(copies[0], 1u);
+  EXPECT_EQ(copies[1], 2u);
+  EXPECT_EQ(copies[2], 3u);
+  EXPECT_EQ(copies[3], 0u);
+  EXPECT_EQ(copies[4], 4u);
+
+  // roulette: frequencies follow the fitness
+  xevo::Roulette_selection roulette_f;
+  std::size_t num_of_draws = 100000;
+  roulette_f.select_indices(Y, num_of_draws, indices);
+  std::vector<double> frequency(5, 0.0);
+  for (std::size_t i : indices)
+  {
+    frequency[i] += 1.0 / num_of_draws;
+  }
+  for (std::size_t i{ 0 }; i < 5; ++i)
+  {
+    EXPECT_NEAR(frequency[i], Y(i) / 10.0, 0.01);
+  }
+}
+
+namespace
+{
+  // selection functor with the value returning operator only
+  struct Selection_reverse
+  {
+    template <class F, class E>
+    F operator()(const xt::xexpression<F>& X, const xt::xexpression<E>&)
+    {
+      return xt::flip(X.derived_cast(), 0);
+    }
+  };
+}
+
+TEST(functors, index_pipeline)
+{
+  xt::xarray<double> X = { { 0.0, 0.0 }, { 1.0, 1.0 }, { 2.0, 2.0 }, { 3.0, 3.0 } };
+  xt::xarray<double> Y = { 3.0, 1.0, 4.0, 2.0 };
+  std::vector<std::size_t> indices;
+
+  xevo::Elitism elite_f(0.5);
+  elite_f.elite_indices(Y, indices);
+  ASSERT_EQ(indices.size(), 2u);
+  EXPECT_EQ(indices[0], 2u);
+  EXPECT_EQ(indices[1], 0u);
+
+  xt::xarray<double> X_elite = xt::zeros<double>({ 2, 2 });
+  xevo::elite_rows(elite_f, X, Y, X_elite, indices);
+  EXPECT_DOUBLE_EQ(X_elite(0, 0), 2.0);
+  EXPECT_DOUBLE_EQ(X_elite(1, 0), 0.0);
+
+  // value returning functors go through the adapter: the last rows are kept
+  Selection_reverse selection_f;
+  xt::xarray<double> X_mating = xt::zeros<double>({ 3, 2 });
+  xevo::select_rows(selection_f, X, Y, X_mating, indices);
+  EXPECT_DOUBLE_EQ(X_mating(0, 0), 2.0);
+  EXPECT_DOUBLE_EQ(X_mating(2, 0), 0.0);
+
+  using output_operators = xevo::has_output_operators<xt::xarray<double>, xt::xarray<double>,
+    xevo::Elitism, Selection_reverse, xevo::Crossover, xevo::Mutation_polynomial>;
+  EXPECT_TRUE(output_operators::value);
+
+  // rows of column-major populations are not contiguous: the value path is used
+  using column_major_type = xt::xarray<double, xt::layout_type::column_major>;
+  EXPECT_TRUE((xevo::has_row_major_data<xt::xtensor<double, 2>>::value));
+  EXPECT_FALSE((xevo::has_row_major_data<column_major_type>::value));
+  using output_operators_column_major = xevo::has_output_operators<column_major_type, xt::xarray<double>,
+    xevo::Elitism, Selection_reverse, xevo::Crossover, xevo::Mutation_polynomial>;
+  EXPECT_FALSE(output_operators_column_major::value);
+}
+
+TEST(functors, velocity_column_major)
+{
+  using column_major_type = xt::xarray<double, xt::layout_type::column_major>;
+  std::array<std::size_t, 2> shape = { 6, 3 };
+  xt::xarray<double> genes = xt::arange<double>(18.0);
+  genes.reshape(shape);
+  xt::xtensor<double, 2> X = genes;
+  xt::xtensor<double, 2> XB = 0.5 * X + 1.0;
+  xt::xtensor<double, 2> V = 0.1 * X;
+  xt::xtensor<double, 1> YB = { 3.0, 1.0, 4.0, 0.5, 5.0, 2.0 };
+  column_major_type X_c = X;
+  column_major_type XB_c = XB;
+  column_major_type V_c = V;
+
+  // baseline formula with pbest = X: V_ij = w V_ij + c2 r2_i (gbest_j - X_ij), gbest is row 3
+  column_major_type X_pb = X;
+  xevo::Velocity social_f(0.5, 0.0, 1.0);
+  social_f(X_c, X_pb, V_c, YB);
+  for (std::size_t i{ 0 }; i < shape[0]; ++i)
+  {
+    if (i == 3)
+    {
+      continue;
+    }
+    double r2 = (V_c(i, 0) - 0.5 * V(i, 0)) / (X(3, 0) - X(i, 0));
+    EXPECT_GE(r2, 0.0);
+    EXPECT_LT(r2, 1.0);
+    for (std::size_t j{ 0 }; j < shape[1]; ++j)
+    {
+      EXPECT_NEAR(V_c(i, j), 0.5 * V(i, j) + r2 * (X(3, j) - X(i, j)), 1e-12);
+    }
+  }
+  for (std::size_t j{ 0 }; j < shape[1]; ++j)
+  {
+    EXPECT_DOUBLE_EQ(V_c(3, j), 0.5 * V(3, j));
+  }
+
+  // same random factors as on the row-major population
+  V_c = V;
+  xevo::seed(5);
+  xevo::Velocity velocity_f(0.5, 0.8, 0.9);
+  velocity_f(X, XB, V, YB);
+  xevo::seed(5);
+  xevo::Velocity velocity_c_f(0.5, 0.8, 0.9);
+  velocity_c_f(X_c, XB_c, V_c, YB);
+  for (std::size_t i{ 0 }; i < shape[0]; ++i)
+  {
+    for (std::size_t j{ 0 }; j < shape[1]; ++j)
+    {
+      EXPECT_DOUBLE_EQ(V_c(i, j), V(i, j));
+      EXPECT_DOUBLE_EQ(X_c(i, j), X(i, j));
+    }
+  }
+  EXPECT_NE(V(0, 0), 0.0);
+}
+
+TEST(functors, top_k_indices)
+{
+  std::array<std::size_t, 1> shape_y = { 500 };
+  xt::xarray<double> Y = xt::random::randint<int>(shape_y, 0, 100);
+
+  for (std::size_t k : { 1, 5, 64, 65, 200 })
+  {
+    std::vector<std::size_t> indices;
+    xevo::top_k_indices(Y, k, false, indices);
+    ASSERT_EQ(indices.size(), k);
+
+    std::vector<std::size_t> reference(500);
+    std::iota(reference.begin(), reference.end(), std::size_t(0));
+    std::stable_sort(reference.begin(), reference.end(),
+      [&Y](std::size_t a, std::size_t b) { return Y(a) < Y(b); });
+    reference.resize(k);
+    EXPECT_EQ(indices, reference);
+  }
+
+  xevo::Terminate_tol term_f(false);
+  EXPECT_DOUBLE_EQ(term_f(Y, Y), *std::min_element(Y.begin(), Y.end()));
+}
+
+TEST(functors, mutation_polynomial_rate)
+{
+  std::array<std::size_t, 2> shape = { 100, 1000 };
+  xt::xarray<double> X = 0.5 * xt::ones<double>(shape);
+
+  xevo::Mutation_polynomial mutation_f(0.01, 20.0);
+  mutation_f(X, X);
+
+  std::size_t num_of_mutations{ 0 };
+  for (double x : X)
+  {
+    EXPECT_GE(x, 0.0);
+    EXPECT_LE(x, 1.0);
+    num_of_mutations += (x != 0.5);
+  }
+  // binomial with mean 1000 and standard deviation ~31.5
+  EXPECT_NEAR(static_cast<double>(num_of_mutations), 1000.0, 150.0);
+
+  xevo::Mutation_polynomial no_mutation_f(0.0, 20.0);
+  xt::xarray<double> Y = no_mutation_f(X);
+  EXPECT_TRUE(Y == X);
+
+  // a strided view: only the genes of the view are mutated
+  std::array<std::size_t, 2> shape_strided = { 10, 10 };
+  xt::xarray<double> Z = 0.5 * xt::ones<double>(shape_strided);
+  auto Z_even = xt::view(Z, xt::all(), xt::range(0, 10, 2));
+  xevo::Mutation_polynomial all_genes_f(1.0, 20.0);
+  all_genes_f(Z_even, Z_even);
+  for (std::size_t i{ 0 }; i < 10; ++i)
+  {
+    for (std::size_t j{ 0 }; j < 10; ++j)
+    {
+      EXPECT_EQ(Z(i, j) != 0.5, j % 2 == 0);
+    }
+  }
+}
+
+TEST(functors, crossover_kernels)
+{
+  std::array<std::size_t, 2> shape = { 21, 300 };
+  xt::xarray<double> X = xt::random::rand<double>(shape);
+  xt::xarray<double> X_out = xt::zeros<double>(shape);
+  auto pool = std::make_shared<xevo::thread_pool>(4);
+
+  // uniform and k-point children exchange genes of their parents
+  xevo::Crossover_uniform uniform_f(1.0, 0.5, pool);
+  xevo::Crossover_k_point k_point_f(1.0, 3);
+  for (int c{ 0 }; c < 2; ++c)
+  {
+    c == 0 ? uniform_f(X, X_out) : k_point_f(X, X_out);
+    for (std::size_t i{ 0 }; i < 10; ++i)
+    {
+      for (std::size_t j{ 0 }; j < 300; ++j)
+      {
+        bool kept = X_out(2 * i, j) == X(2 * i, j) && X_out(2 * i + 1, j) == X(2 * i + 1, j);
+        bool swapped = X_out(2 * i, j) == X(2 * i + 1, j) && X_out(2 * i + 1, j) == X(2 * i, j);
+        EXPECT_TRUE(kept || swapped);
+      }
+    }
+    // odd last row is copied
+    EXPECT_DOUBLE_EQ(X_out(20, 0), X(20, 0));
+  }
+
+  // SBX keeps the mean of every pair of genes
+  xevo::Crossover_sbx sbx_f(1.0, 15.0, pool);
+  sbx_f(X, X_out);
+  for (std::size_t i{ 0 }; i < 10; ++i)
+  {
+    for (std::size_t j{ 0 }; j < 300; ++j)
+    {
+      EXPECT_NEAR(X_out(2 * i, j) + X_out(2 * i + 1, j), X(2 * i, j) + X(2 * i + 1, j), 1e-12);
+    }
+  }
+
+  // the children do not depend on the number of threads
+  xevo::seed(3);
+  xevo::Crossover_blx blx_parallel_f(0.9, 0.5, pool);
+  xevo::seed(3);
+  xevo::Crossover_blx blx_serial_f(0.9, 0.5);
+  EXPECT_TRUE(blx_parallel_f(X) == blx_serial_f(X));
+
+  using output_operators = xevo::has_output_operators<xt::xarray<double>, xt::xarray<double>,
+    xevo::Elitism, xevo::Roulette_selection, xevo::Crossover_sbx, xevo::Mutation_polynomial>;
+  EXPECT_TRUE(output_operators::value);
+}
+
+TEST(functors, fused_variation)
+{
+  using E = xt::xarray<double>;
+  EXPECT_TRUE((xevo::has_fused_variation<E, xevo::Crossover_sbx, xevo::Mutation_polynomial>::value));
+  EXPECT_FALSE((xevo::has_fused_variation<E, xevo::Crossover, xevo::Mutation_polynomial>::value));
+
+  // uniform crossover of equal parents only exposes the mutated genes
+  std::array<std::size_t, 2> shape = { 101, 1000 };
+  E X = 0.5 * xt::ones<double>(shape);
+  E X_out = xt::zeros<double>(shape);
+
+  xevo::Crossover_uniform cross_f(1.0, 0.5, std::make_shared<xevo::thread_pool>(4));
+  xevo::Mutation_polynomial mutation_f(0.01, 20.0);
+  xevo::vary_rows(cross_f, mutation_f, X, X_out);
+
+  std::size_t num_of_mutations{ 0 };
+  for (double x : X_out)
+  {
+    EXPECT_GE(x, 0.0);
+    EXPECT_LE(x, 1.0);
+    num_of_mutations += (x != 0.5);
+  }
+  // binomial with mean 1010 and standard deviation ~31.6
+  EXPECT_NEAR(static_cast<double>(num_of_mutations), 1010.0, 150.0);
+}
+
+TEST(functors, population_initialisers)
+{
+  std::size_t num_of_indiv = 128;
+  std::size_t num_of_vars = 20;
+  std::array<std::size_t, 2> shape = { num_of_indiv, num_of_vars };
+  auto pool = std::make_shared<xevo::thread_pool>(4);
+
+  // every gene range has one individual per stratum of width 1 / N
+  auto is_stratified = [&](const xt::xarray<double>& X)
+  {
+    for (std::size_t j{ 0 }; j < num_of_vars; ++j)
+    {
+      std::vector<std::size_t> count(num_of_indiv, 0);
+      for (std::size_t i{ 0 }; i < num_of_indiv; ++i)
+      {
+        if (!(X(i, j) > 0.0 && X(i, j) < 1.0))
+        {
+          return false;
+        }
+        ++count[static_cast<std::size_t>(X(i, j) * num_of_indiv)];
+      }
+      if (std::any_of(count.begin(), count.end(), [](std::size_t c) { return c != 1; }))
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xevo::Population_sobol sobol_f(32, true, pool);
+  sobol_f(X);
+  EXPECT_TRUE(is_stratified(X));
+
+  xevo::Population_latin_hypercube lhs_f(32, pool);
+  lhs_f(X);
+  EXPECT_TRUE(is_stratified(X));
+
+  // Halton in bases 2 and 3 without scrambling
+  xevo::Population_halton halton_f(32, false);
+  halton_f(X);
+  EXPECT_NEAR(X(1, 0), 0.5, 1e-9);
+  EXPECT_NEAR(X(1, 1), 1.0 / 3.0, 1e-9);
+  EXPECT_NEAR(X(5, 1), 7.0 / 9.0, 1e-9);
+
+  // resolution of 4 bits: genes are centres of 16 cells
+  xevo::Population_uniform uniform_f(4, pool);
+  uniform_f(X);
+  for (double x : X)
+  {
+    EXPECT_DOUBLE_EQ(std::fmod(x * 16.0, 1.0), 0.5);
+  }
+
+  // the population does not depend on the number of threads
+  xevo::seed(11);
+  xevo::Population_uniform uniform_parallel_f(32, pool);
+  xevo::seed(11);
+  xevo::Population_uniform uniform_serial_f(32);
+  xt::xarray<double> X_parallel = xt::zeros<double>(shape);
+  xt::xarray<double> X_serial = xt::zeros<double>(shape);
+  uniform_parallel_f(X_parallel);
+  uniform_serial_f(X_serial);
+  EXPECT_TRUE(X_parallel == X_serial);
+
+  // column-major populations hold the same individuals
+  xt::xarray<double, xt::layout_type::column_major> X_column = xt::zeros<double>(shape);
+  xevo::Population_halton halton_column_f(32, false);
+  halton_column_f(X_column);
+  halton_f(X);
+  EXPECT_TRUE(X_column == X);
+  EXPECT_NEAR(X_column(5, 1), 7.0 / 9.0, 1e-9);
+  sobol_f(X_column);
+  EXPECT_TRUE(is_stratified(X_column));
+  lhs_f(X_column);
+  EXPECT_TRUE(is_stratified(X_column));
+  xevo::seed(11);
+  xevo::Population_uniform uniform_column_f(32, pool);
+  uniform_column_f(X_column);
+  EXPECT_TRUE(X_column == X_serial);
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "gtest/gtest.h"
 
 #include "xevo/ga.hpp"
@@ -167,3 +169,160 @@ TEST(ga, Rastriginsfcn_scaled_void_evolve)
 
 }
 
+
+TEST(ga, state_run)
+{
+  std::array<std::size_t, 2> shape = { 40, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+
+  xevo::ga genetic_algorithm;
+  genetic_algorithm.initialise(X);
+
+  auto state = xevo::make_ga_state(X, xevo::Rosenbrock_scaled{}, xevo::Elitism(0.05),
+    xevo::Roulette_selection{}, xevo::Crossover(0.8), xevo::Mutation_polynomial(0.1, 60.0));
+
+  std::size_t num_generations = 300;
+  bool run{ true };
+  while (run)
+  {
+    run = state.step(xevo::Terminate_gen_max(num_generations, state.generation()));
+  }
+
+  // one evaluation for the initial population and one per generation
+  EXPECT_EQ(state.generation(), num_generations + 1);
+  EXPECT_EQ(state.evaluations(), 40 * (num_generations + 2));
+
+  double best_x1 = 0.666;
+  double best_x2 = 0.666;
+
+  EXPECT_NEAR(best_x1, state.population()(0, 0), 1e-003);
+  EXPECT_NEAR(best_x2, state.population()(0, 1), 1e-003);
+}
+
+TEST(ga, state_run_fused_variation)
+{
+  std::array<std::size_t, 2> shape = { 40, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+
+  xevo::ga genetic_algorithm;
+  genetic_algorithm.initialise(X);
+
+  // SBX with polynomial mutation in the same pass over the children
+  auto state = xevo::make_ga_state(X, xevo::Rosenbrock_scaled{}, xevo::Elitism(0.05),
+    xevo::Roulette_selection{}, xevo::Crossover_sbx(0.9, 15.0), xevo::Mutation_polynomial(0.1, 60.0));
+
+  std::size_t num_generations = 300;
+  bool run{ true };
+  while (run)
+  {
+    run = state.step(xevo::Terminate_gen_max(num_generations, state.generation()));
+  }
+
+  double best_x1 = 0.666;
+  double best_x2 = 0.666;
+
+  EXPECT_NEAR(best_x1, state.population()(0, 0), 1e-002);
+  EXPECT_NEAR(best_x2, state.population()(0, 1), 1e-002);
+}
+
+TEST(ga, state_column_major)
+{
+  using xtensor_x_type = xt::xarray<double, xt::layout_type::column_major>;
+  using state_type = xevo::ga_state<xtensor_x_type, xevo::Rosenbrock_scaled>;
+
+  // the rows of a column-major population are not contiguous: no row blocks
+  static_assert(!state_type::output_operators::value, "column-major populations take the value path");
+
+  std::array<std::size_t, 2> shape = { 40, 3 };
+  xtensor_x_type X = xt::zeros<double>(shape);
+
+  xevo::ga genetic_algorithm;
+  genetic_algorithm.initialise(X);
+
+  state_type state(X, xevo::Rosenbrock_scaled{}, xevo::Elitism(0.05), xevo::Roulette_selection{},
+    xevo::Crossover(0.8), xevo::Mutation_polynomial(0.1, 60.0));
+
+  for (std::size_t g{ 0 }; g < 10; ++g)
+  {
+    state.step();
+    auto y = state.fitness();
+    std::size_t best = std::max_element(y.begin(), y.end()) - y.begin();
+    xtensor_x_type x_best = xt::view(state.population(), xt::range(best, best + 1), xt::all());
+
+    // the best individual is carried over gene by gene as the first elite
+    state.step();
+    for (std::size_t j{ 0 }; j < shape[1]; ++j)
+    {
+      EXPECT_DOUBLE_EQ(state.population()(0, j), x_best(0, j));
+    }
+  }
+}
+
+TEST(ga, state_column_major_sbx)
+{
+  using xtensor_x_type = xt::xarray<double, xt::layout_type::column_major>;
+  using state_type = xevo::ga_state<xtensor_x_type, xevo::Rosenbrock_scaled, xevo::Elitism,
+    xevo::Roulette_selection, xevo::Crossover_sbx>;
+
+  std::array<std::size_t, 2> shape = { 41, 3 };
+  xt::xtensor<double, 2> X_rows = xt::zeros<double>(shape);
+
+  xevo::ga genetic_algorithm;
+  genetic_algorithm.initialise(X_rows);
+  xtensor_x_type X = X_rows;
+
+  // the row kernels give the same children as on a row-major population
+  xevo::seed(7);
+  xevo::Crossover_sbx cross_rows_f(1.0);
+  auto children_rows = cross_rows_f(X_rows);
+  xevo::seed(7);
+  xevo::Crossover_sbx cross_f(1.0);
+  auto children = cross_f(X);
+  bool crossed{ false };
+  for (std::size_t i{ 0 }; i < shape[0]; ++i)
+  {
+    for (std::size_t j{ 0 }; j < shape[1]; ++j)
+    {
+      EXPECT_DOUBLE_EQ(children(i, j), children_rows(i, j));
+      crossed = crossed || children(i, j) != X(i, j);
+    }
+  }
+  EXPECT_TRUE(crossed);
+
+  state_type state(X, xevo::Rosenbrock_scaled{}, xevo::Elitism(0.05), xevo::Roulette_selection{},
+    xevo::Crossover_sbx(0.8), xevo::Mutation_polynomial(0.1, 60.0));
+
+  for (std::size_t g{ 0 }; g < 10; ++g)
+  {
+    state.step();
+    auto y = state.fitness();
+    std::size_t best = std::max_element(y.begin(), y.end()) - y.begin();
+    xtensor_x_type x_best = xt::view(state.population(), xt::range(best, best + 1), xt::all());
+
+    state.step();
+    for (std::size_t j{ 0 }; j < shape[1]; ++j)
+    {
+      EXPECT_DOUBLE_EQ(state.population()(0, j), x_best(0, j));
+    }
+  }
+}
+
+TEST(ga, sobol_initialise)
+{
+  std::array<std::size_t, 2> shape = { 40, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+
+  xevo::ga genetic_algorithm;
+  genetic_algorithm.initialise<xt::xarray<double>, xevo::Population_sobol>(X, std::make_tuple(16u));
+
+  std::size_t num_generations = 300;
+  for (std::size_t i{ 0 }; i < num_generations; ++i)
+  {
+    genetic_algorithm.evolve(X, xevo::Rosenbrock_scaled{}, std::make_tuple(0.05),
+      std::make_tuple(),
+      std::make_tuple(0.8), std::make_tuple(0.1, 60.0));
+  }
+
+  EXPECT_NEAR(0.666, X(0, 0), 1e-003);
+  EXPECT_NEAR(0.666, X(0, 1), 1e-003);
+}
@@ -0,0 +1,81 @@
+#include "gtest/gtest.h"
+
+#include "xtensor/xio.hpp"
+#include "xtensor/xreducer.hpp"
+
+#include "xevo/island.hpp"
+#include "xevo/analytical_functions.hpp"
+
+namespace
+{
+  // positive fitness growing with the genes
+  struct Sum_of_genes
+  {
+    template <class E>
+    auto operator()(const xt::xexpression<E>& X)
+    {
+      return xt::eval(xt::sum(X.derived_cast(), { 1 }));
+    }
+  };
+}
+
+TEST(island, migration_spreads_best)
+{
+  std::array<std::size_t, 2> shape = { 20, 3 };
+  xt::xarray<double> X = 0.1 * xt::ones<double>(shape);
+  std::vector<xt::xarray<double>> populations(6, X);
+  populations[0](7, 1) = 10.0;
+
+  for (auto topology : { xevo::migration_topology::ring, xevo::migration_topology::fully_connected })
+  {
+    xevo::island_options options;
+    options.migration_interval = 2;
+    options.migrants = 2;
+    options.topology = topology;
+
+    // no crossover and no mutation: the individuals are only copied around
+    xevo::island_ga<xt::xarray<double>, Sum_of_genes, xevo::Elitism, xevo::Roulette_selection,
+      xevo::Crossover_sbx, xevo::Mutation_polynomial> islands(populations, Sum_of_genes{},
+        std::make_tuple(0.1), std::make_tuple(), std::make_tuple(0.0), std::make_tuple(0.0, 20.0), options);
+    islands.run(20);
+
+    for (std::size_t i{ 0 }; i < islands.size(); ++i)
+    {
+      auto y = islands.island(i).fitness();
+      EXPECT_DOUBLE_EQ(*std::max_element(y.begin(), y.end()), 10.2);
+      // migrants arrive with their fitness: every generation is evaluated once
+      EXPECT_EQ(islands.island(i).evaluations(), 20u * 21u);
+    }
+    EXPECT_EQ(islands.best().first, 0u);
+    EXPECT_EQ(islands.migrations(), 6u * 10u);
+  }
+}
+
+TEST(island, threaded_run)
+{
+  std::array<std::size_t, 2> shape = { 40, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  std::vector<xt::xarray<double>> populations(4, X);
+  xevo::ga genetic_algorithm;
+  for (auto& population : populations)
+  {
+    genetic_algorithm.initialise(population);
+  }
+
+  xevo::island_options options;
+  options.topology = xevo::migration_topology::random;
+  options.degree = 2;
+
+  xevo::island_ga<xt::xarray<double>, xevo::Rosenbrock_scaled> islands(populations, xevo::Rosenbrock_scaled{},
+    std::make_tuple(0.05), std::make_tuple(), std::make_tuple(0.8), std::make_tuple(0.1, 60.0), options,
+    std::make_shared<xevo::thread_pool>(4));
+  islands.run(300);
+
+  // the elite of every island is kept in the first row
+  for (std::size_t i{ 0 }; i < islands.size(); ++i)
+  {
+    EXPECT_NEAR(0.666, islands.island(i).population()(0, 0), 1e-002);
+    EXPECT_NEAR(0.666, islands.island(i).population()(0, 1), 1e-002);
+  }
+  EXPECT_EQ(islands.migrations(), 4u * 30u);
+}
@@ -0,0 +1,154 @@
+#include "gtest/gtest.h"
+
+#include "xevo/nsga2.hpp"
+
+#include "xtensor/xio.hpp"
+#include "xtensor/xbuilder.hpp"
+#include "xtensor/xreducer.hpp"
+#include "xtensor/xrandom.hpp"
+
+namespace
+{
+  // ZDT1: Pareto front f_2 = 1 - sqrt(f_1) for x_1 = ... = x_{n-1} = 0
+  struct Zdt1
+  {
+    template <class E>
+    auto operator()(const xt::xexpression<E>& X)
+    {
+      const E& _X = X.derived_cast();
+      std::size_t num_of_vars = _X.shape()[1];
+      xt::xtensor<double, 1> f1 = xt::view(_X, xt::all(), 0);
+      xt::xtensor<double, 1> g = 1.0 + 9.0 * xt::sum(xt::view(_X, xt::all(), xt::range(1, num_of_vars)), { 1 }) /
+        double(num_of_vars - 1);
+      xt::xtensor<double, 2> y = xt::stack(xt::xtuple(f1, g * (1.0 - xt::sqrt(f1 / g))), 1);
+      return y;
+    }
+  };
+
+  // fronts by repeatedly peeling the non-dominated rows (O(M N^3) reference)
+  std::vector<std::size_t> peel_fronts(const xt::xtensor<double, 2>& Y)
+  {
+    std::size_t num_of_indiv = Y.shape()[0];
+    std::vector<std::size_t> rank(num_of_indiv, 0);
+    std::vector<std::size_t> left(num_of_indiv);
+    std::iota(left.begin(), left.end(), 0);
+    for (std::size_t front{ 0 }; !left.empty(); ++front)
+    {
+      std::vector<std::size_t> rest;
+      std::vector<std::size_t> current;
+      for (std::size_t p : left)
+      {
+        bool dominated = std::any_of(left.begin(), left.end(), [&](std::size_t q) { return xevo::dominates(Y, q, p); });
+        (dominated ? rest : current).push_back(p);
+      }
+      for (std::size_t p : current)
+      {
+        rank[p] = front;
+      }
+      left = rest;
+    }
+    return rank;
+  }
+}
+
+TEST(nsga2, non_dominated_sort)
+{
+  xt::random::seed(7);
+  for (std::size_t num_of_objectives : { 2, 3 })
+  {
+    std::array<std::size_t, 2> shape = { 150, num_of_objectives };
+    // few distinct values: many ties and duplicates
+    xt::xtensor<double, 2> Y = xt::floor(5.0 * xt::random::rand<double>(shape));
+
+    std::vector<std::size_t> rank;
+    std::size_t num_of_fronts = xevo::non_dominated_sort(Y, false, rank);
+
+    EXPECT_EQ(rank, peel_fronts(Y));
+    EXPECT_EQ(num_of_fronts, *std::max_element(rank.begin(), rank.end()) + 1);
+  }
+}
+
+TEST(nsga2, crowding_distance)
+{
+  xt::xtensor<double, 2> Y = { { 0.0, 4.0 }, { 1.0, 3.0 }, { 3.0, 1.0 }, { 4.0, 0.0 } };
+  std::vector<double> distance;
+  xevo::crowding_distance(Y, { 0, 1, 2, 3 }, distance);
+
+  EXPECT_TRUE(std::isinf(distance[0]));
+  EXPECT_DOUBLE_EQ(distance[1], 1.5);
+  EXPECT_DOUBLE_EQ(distance[2], 1.5);
+  EXPECT_TRUE(std::isinf(distance[3]));
+}
+
+TEST(nsga2, state_run_zdt1)
+{
+  std::array<std::size_t, 2> shape = { 60, 5 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xevo::nsga2 moea;
+  moea.initialise(X);
+
+  auto state = xevo::make_nsga2_state(X, Zdt1{}, xevo::Selection_nsga2{}, xevo::Crossover_sbx(0.9),
+    xevo::Mutation_polynomial(0.2, 20.0));
+  std::size_t num_generations = 300;
+  state.run(num_generations);
+
+  EXPECT_EQ(state.evaluations(), 60 * (num_generations + 1));
+
+  auto front = state.pareto_front();
+  const auto& y = state.fitness();
+  EXPECT_GT(front.size(), 30u);
+  double f1_min{ 1.0 };
+  double f1_max{ 0.0 };
+  for (std::size_t i : front)
+  {
+    EXPECT_NEAR(1.0 - std::sqrt(y(i, 0)), y(i, 1), 5e-002);
+    f1_min = std::min(f1_min, y(i, 0));
+    f1_max = std::max(f1_max, y(i, 0));
+  }
+  EXPECT_GT(f1_max - f1_min, 0.5);
+}
+
+TEST(nsga2, state_column_major)
+{
+  using column_major_type = xt::xarray<double, xt::layout_type::column_major>;
+  std::array<std::size_t, 2> shape = { 20, 4 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xevo::nsga2 moea;
+  moea.initialise(X);
+  column_major_type X_c = X;
+
+  // same generations as on the row-major population
+  xevo::seed(3);
+  auto state = xevo::make_nsga2_state(X, Zdt1{}, xevo::Selection_nsga2{}, xevo::Crossover_sbx(0.9),
+    xevo::Mutation_polynomial(0.2, 20.0));
+  state.run(20);
+  xevo::seed(3);
+  auto state_c = xevo::make_nsga2_state(X_c, Zdt1{}, xevo::Selection_nsga2{}, xevo::Crossover_sbx(0.9),
+    xevo::Mutation_polynomial(0.2, 20.0));
+  state_c.run(20);
+
+  for (std::size_t i{ 0 }; i < shape[0]; ++i)
+  {
+    for (std::size_t j{ 0 }; j < shape[1]; ++j)
+    {
+      EXPECT_DOUBLE_EQ(state_c.population()(i, j), state.population()(i, j));
+    }
+  }
+}
+
+TEST(nsga2, void_evolve)
+{
+  std::array<std::size_t, 2> shape = { 20, 3 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xevo::nsga2 moea;
+  moea.initialise(X);
+  xt::xarray<double> Y = Zdt1{}(X);
+
+  for (std::size_t i{ 0 }; i < 50; ++i)
+  {
+    moea.evolve(X, Y, Zdt1{}, std::make_tuple(), std::make_tuple(0.9), std::make_tuple(0.2, 20.0));
+  }
+
+  xt::xarray<double> Y_check = Zdt1{}(X);
+  EXPECT_TRUE(xt::allclose(Y, Y_check));
+}
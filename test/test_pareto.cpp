@@ -0,0 +1,123 @@
+#include "gtest/gtest.h"
+
+#include "xevo/pareto.hpp"
+
+#include "xtensor/xio.hpp"
+#include "xtensor/xbuilder.hpp"
+#include "xtensor/xrandom.hpp"
+#include "xtensor/xreducer.hpp"
+#include "xtensor/xview.hpp"
+
+TEST(pareto, hypervolume_2d)
+{
+  xt::xtensor<double, 2> Y = { { 1.0, 3.0 }, { 2.0, 2.0 }, { 3.0, 1.0 }, { 3.0, 3.0 }, { 5.0, 0.0 } };
+  xevo::hypervolume<double> hv({ 4.0, 4.0 });
+  // (3 x 1) + (2 x 1) + (1 x 1); the dominated row and the row outside the reference add nothing
+  EXPECT_DOUBLE_EQ(hv(Y), 6.0);
+
+  xt::xtensor<double, 2> Y_max = -Y;
+  xevo::hypervolume<double> hv_max({ -4.0, -4.0 }, true);
+  EXPECT_DOUBLE_EQ(hv_max(Y_max), 6.0);
+}
+
+TEST(pareto, hypervolume_union_of_boxes)
+{
+  // two boxes of volume 2^(M - 1) overlapping in a box of volume 2^(M - 2)
+  for (std::size_t num_of_objectives : { 3, 4, 5 })
+  {
+    std::array<std::size_t, 2> shape = { 2, num_of_objectives };
+    xt::xtensor<double, 2> Y = xt::zeros<double>(shape);
+    Y(0, 0) = 1.0;
+    Y(1, 1) = 1.0;
+    xevo::hypervolume<double> hv(std::vector<double>(num_of_objectives, 2.0));
+    double box = std::pow(2.0, double(num_of_objectives - 1));
+    EXPECT_DOUBLE_EQ(hv(Y), box + box - box / 2.0);
+  }
+}
+
+TEST(pareto, archive_keeps_non_dominated)
+{
+  xevo::pareto_archive<double> archive(2, 1, 100);
+  xt::xtensor<double, 2> X = { { 0.0 }, { 1.0 }, { 2.0 }, { 3.0 }, { 4.0 } };
+  xt::xtensor<double, 2> Y = { { 1.0, 3.0 }, { 2.0, 2.0 }, { 3.0, 3.0 }, { 3.0, 1.0 }, { 2.0, 2.0 } };
+  EXPECT_EQ(archive.insert(X, Y), 3u);
+  EXPECT_EQ(archive.size(), 3u);
+
+  // dominates two of the points
+  double y[2] = { 1.5, 1.0 };
+  double x[1] = { 5.0 };
+  EXPECT_TRUE(archive.insert(y, x));
+  EXPECT_EQ(archive.size(), 2u);
+
+  auto objectives = archive.objectives();
+  auto genes = archive.genes();
+  for (std::size_t i{ 0 }; i < archive.size(); ++i)
+  {
+    EXPECT_TRUE(genes(i, 0) == 0.0 || genes(i, 0) == 5.0);
+    EXPECT_TRUE(objectives(i, 0) == 1.0 || objectives(i, 0) == 1.5);
+  }
+}
+
+TEST(pareto, archive_bounded)
+{
+  xt::random::seed(3);
+  std::array<std::size_t, 2> shape = { 2000, 3 };
+  xt::xtensor<double, 2> Y = xt::random::rand<double>(shape);
+  // project on the unit sphere: every row is non-dominated
+  for (std::size_t i{ 0 }; i < shape[0]; ++i)
+  {
+    double norm = std::sqrt(Y(i, 0) * Y(i, 0) + Y(i, 1) * Y(i, 1) + Y(i, 2) * Y(i, 2));
+    for (std::size_t m{ 0 }; m < 3; ++m)
+    {
+      Y(i, m) /= norm;
+    }
+  }
+
+  xevo::pareto_archive<double> archive(3, 0, 100);
+  xt::xtensor<double, 2> X = xt::zeros<double>({ std::size_t(2000), std::size_t(0) });
+  archive.insert(X, Y);
+  EXPECT_EQ(archive.size(), 100u);
+
+  auto objectives = archive.objectives();
+  for (std::size_t i{ 0 }; i < archive.size(); ++i)
+  {
+    for (std::size_t j{ 0 }; j < archive.size(); ++j)
+    {
+      EXPECT_FALSE(xevo::dominates(objectives, i, j));
+    }
+  }
+  // the extreme points of every objective are kept
+  for (std::size_t m{ 0 }; m < 3; ++m)
+  {
+    EXPECT_DOUBLE_EQ(xt::amin(xt::view(objectives, xt::all(), m))(), xt::amin(xt::view(Y, xt::all(), m))());
+  }
+}
+
+TEST(pareto, terminate_hypervolume)
+{
+  std::array<std::size_t, 2> shape = { 40, 4 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xevo::nsga2 moea;
+  moea.initialise(X);
+
+  auto objective_f = [](const xt::xarray<double>& X)
+  {
+    xt::xtensor<double, 2> y = xt::stack(xt::xtuple(xt::view(X, xt::all(), 0),
+      1.0 - xt::view(X, xt::all(), 0) + xt::sum(xt::view(X, xt::all(), xt::range(1, 4)), { 1 })), 1);
+    return y;
+  };
+  auto state = xevo::make_nsga2_state(X, objective_f, xevo::Selection_nsga2{}, xevo::Crossover_sbx(0.9),
+    xevo::Mutation_polynomial(0.25, 20.0));
+
+  xevo::Terminate_hypervolume terminate_f({ 2.0, 2.0 }, 10, 1e-006);
+  std::size_t generations{ 0 };
+  while (state.step(terminate_f) && generations < 1000)
+  {
+    ++generations;
+  }
+  EXPECT_LT(generations, 1000u);
+  EXPECT_EQ(terminate_f.stalled(), 10u);
+  // front y_2 = 1 - y_1 for y_1 in [0, 1] with reference (2, 2): 4 - 1/2
+  EXPECT_GT(terminate_f.value(), 3.0);
+  EXPECT_LE(terminate_f.value(), 3.5);
+}
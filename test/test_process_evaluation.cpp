@@ -0,0 +1,121 @@
+#include "gtest/gtest.h"
+
+#include "xevo/process_evaluation.hpp"
+
+#if defined(XEVO_HAS_PROCESS_EVALUATION) && defined(XEVO_EVALUATION_WORKER)
+
+#include "xevo/ga.hpp"
+
+#include "xtensor/xarray.hpp"
+#include "xtensor/xio.hpp"
+#include "xtensor/xrandom.hpp"
+#include "xtensor/xreducer.hpp"
+
+namespace
+{
+  // fitness computed by the worker executable (test/evaluation_worker.cpp)
+  xt::xtensor<double, 1> sum_of_squares(const xt::xarray<double>& X)
+  {
+    return xt::sum(X * X, { 1 });
+  }
+}
+
+TEST(process_evaluation, matches_objective)
+{
+  std::array<std::size_t, 2> shape = { 50, 4 };
+  xt::random::seed(0);
+  xt::xarray<double> X = xt::random::rand<double>(shape, -1.0, 1.0);
+
+  xevo::process_pool_options options;
+  options.num_workers = 3;
+  options.batch_size = 7;
+  xevo::Evaluate_process evaluate_f({ XEVO_EVALUATION_WORKER }, options);
+
+  // the workers stay alive between evaluations
+  for (std::size_t k{ 0 }; k < 3; ++k)
+  {
+    auto y = evaluate_f(X);
+    auto y_expected = sum_of_squares(X);
+    for (std::size_t i{ 0 }; i < shape[0]; ++i)
+    {
+      EXPECT_DOUBLE_EQ(y(i), y_expected(i));
+    }
+  }
+  EXPECT_EQ(evaluate_f.pool()->restarts(), 0u);
+}
+
+TEST(process_evaluation, restarts_crashed_workers)
+{
+  std::array<std::size_t, 2> shape = { 60, 3 };
+  xt::random::seed(0);
+  xt::xarray<double> X = xt::random::rand<double>(shape, -1.0, 1.0);
+
+  xevo::process_pool_options options;
+  options.num_workers = 4;
+  options.batch_size = 5;
+  // every worker process exits on its third request
+  xevo::Evaluate_process evaluate_f({ XEVO_EVALUATION_WORKER, "--crash-after", "2" }, options);
+
+  auto y = evaluate_f(X);
+  auto y_expected = sum_of_squares(X);
+  for (std::size_t i{ 0 }; i < shape[0]; ++i)
+  {
+    EXPECT_DOUBLE_EQ(y(i), y_expected(i));
+  }
+  EXPECT_GT(evaluate_f.pool()->restarts(), 0u);
+}
+
+TEST(process_evaluation, timeout)
+{
+  std::array<std::size_t, 2> shape = { 10, 2 };
+  xt::xarray<double> X = 0.5 * xt::ones<double>(shape);
+
+  xevo::process_pool_options options;
+  options.num_workers = 2;
+  options.timeout = 0.2;
+  options.max_retries = 1;
+  xevo::Evaluate_process evaluate_f({ XEVO_EVALUATION_WORKER, "--hang-above", "0.9" }, options);
+
+  X(3, 1) = 1.0;
+  EXPECT_THROW(evaluate_f(X), std::runtime_error);
+  EXPECT_EQ(evaluate_f.pool()->timeouts(), 2u);
+
+  // the hanging workers have been replaced
+  X(3, 1) = 0.5;
+  auto y = evaluate_f(X);
+  EXPECT_DOUBLE_EQ(y(3), 0.5);
+}
+
+TEST(process_evaluation, missing_executable)
+{
+  std::array<std::size_t, 2> shape = { 4, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+
+  xevo::Evaluate_process evaluate_f({ "xevo_missing_evaluation_worker" });
+  EXPECT_THROW(evaluate_f(X), std::runtime_error);
+}
+
+TEST(process_evaluation, ga_state)
+{
+  std::array<std::size_t, 2> shape = { 40, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+
+  xevo::ga genetic_algorithm;
+  genetic_algorithm.initialise(X);
+
+  xevo::process_pool_options options;
+  options.num_workers = 4;
+  auto state = xevo::make_ga_state(X, xevo::Evaluate_process({ XEVO_EVALUATION_WORKER }, options),
+    xevo::Elitism(0.05), xevo::Roulette_selection{}, xevo::Crossover(0.8), xevo::Mutation_polynomial(0.1, 60.0));
+
+  state.run(10);
+
+  EXPECT_EQ(state.evaluations(), 40 * 11);
+  auto y_expected = sum_of_squares(state.population());
+  for (std::size_t i{ 0 }; i < shape[0]; ++i)
+  {
+    EXPECT_DOUBLE_EQ(state.fitness()(i), y_expected(i));
+  }
+}
+
+#endif
@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+
+#include "xevo/process_island.hpp"
+
+#ifdef XEVO_HAS_PROCESS_ISLANDS
+
+#include <chrono>
+
+#include "xtensor/xio.hpp"
+#include "xtensor/xreducer.hpp"
+
+namespace
+{
+  // positive fitness growing with the genes
+  struct Sum_of_genes
+  {
+    template <class E>
+    auto operator()(const xt::xexpression<E>& X)
+    {
+      return xt::eval(xt::sum(X.derived_cast(), { 1 }));
+    }
+  };
+}
+
+TEST(process_island, migration_spreads_best)
+{
+  for (auto topology : { xevo::migration_topology::ring, xevo::migration_topology::fully_connected })
+  {
+    xevo::island_options options;
+    options.topology = topology;
+    xevo::process_islands islands(4, 3, options);
+
+    auto results = islands.run([](xevo::island_channel& channel)
+    {
+      std::array<std::size_t, 2> shape = { 10, 3 };
+      xt::xarray<double> X = 0.1 * xt::ones<double>(shape);
+      if (channel.island() == 0)
+      {
+        X(7, 1) = 10.0;
+      }
+
+      // no crossover and no mutation: the individuals are only copied around
+      auto state = xevo::make_ga_state(X, Sum_of_genes{}, xevo::Elitism(0.1), xevo::Roulette_selection{},
+        xevo::Crossover_sbx(0.0), xevo::Mutation_polynomial(0.0, 20.0));
+
+      auto start = std::chrono::steady_clock::now();
+      bool received{ false };
+      while (!received && std::chrono::steady_clock::now() - start < std::chrono::seconds(30))
+      {
+        state.step();
+        xevo::exchange(channel, state);
+        auto y = state.fitness();
+        received = *std::max_element(y.begin(), y.end()) > 10.0;
+      }
+      // pass the superior individual on to the next island
+      xevo::exchange(channel, state);
+      if (!received)
+      {
+        throw std::runtime_error("no migrant received");
+      }
+      // migrants arrive with their fitness: every generation is evaluated once
+      if (state.evaluations() != 10 * (state.generation() + 1))
+      {
+        throw std::runtime_error("population evaluated again after a migration");
+      }
+    });
+
+    ASSERT_EQ(results.size(), 4u);
+    for (const auto& result : results)
+    {
+      EXPECT_EQ(result.exit_status, 0);
+      EXPECT_TRUE(result.has_best);
+      EXPECT_DOUBLE_EQ(result.fitness, 10.2);
+      EXPECT_DOUBLE_EQ(result.genes[1], 10.0);
+    }
+  }
+}
+
+TEST(process_island, islands_draw_different_numbers)
+{
+  xevo::process_islands islands(3, 4);
+  auto worker = [](xevo::island_channel& channel)
+  {
+    std::array<std::size_t, 2> shape = { 1, 4 };
+    xt::xarray<double> X = xt::zeros<double>(shape);
+    xevo::Population pop_f;
+    pop_f(X);
+    channel.publish_best(X.data(), X(0, 0));
+  };
+
+  // seeded launcher that has already built functors of its own
+  xevo::seed(42);
+  xevo::Population pop_f;
+  auto results = islands.run(worker);
+  for (std::size_t i{ 0 }; i < 3; ++i)
+  {
+    ASSERT_TRUE(results[i].has_best);
+    for (std::size_t k{ 0 }; k < i; ++k)
+    {
+      EXPECT_NE(results[i].genes, results[k].genes);
+    }
+  }
+
+  // the islands are reproducible for the same seed
+  xevo::seed(42);
+  xevo::Population pop_again_f;
+  auto results_again = islands.run(worker);
+  for (std::size_t i{ 0 }; i < 3; ++i)
+  {
+    EXPECT_EQ(results_again[i].genes, results[i].genes);
+  }
+}
+
+TEST(process_island, global_best)
+{
+  xevo::island_options options;
+  options.maximise = false;
+  xevo::process_islands islands(3, 2, options);
+
+  auto results = islands.run([](xevo::island_channel& channel)
+  {
+    double genes[2] = { double(channel.island()), 1.0 };
+    channel.publish_best(genes, 5.0 - double(channel.island()));
+    if (channel.island() == 2)
+    {
+      throw std::runtime_error("failing island");
+    }
+  });
+
+  EXPECT_EQ(results[0].exit_status, 0);
+  EXPECT_EQ(results[1].exit_status, 0);
+  EXPECT_EQ(results[2].exit_status, 1);
+
+  std::vector<double> genes(2);
+  double y{ 0.0 };
+  ASSERT_TRUE(islands.global_best(genes.data(), y));
+  EXPECT_DOUBLE_EQ(y, 3.0);
+  EXPECT_DOUBLE_EQ(genes[0], 2.0);
+}
+
+#endif
@@ -152,4 +152,34 @@ TEST(pso, void_evolve_rosenbork_ring_topology)
   EXPECT_NEAR(best_x1, x_best(0), 1e-003);
   EXPECT_NEAR(best_x2, x_best(1), 1e-003);
 
-}
\ No newline at end of file
+}
+TEST(pso, state_run_sphere)
+{
+  std::array<std::size_t, 2> shape = { 30, 2 };
+  std::array<std::size_t, 1> shape_y = { 30 };
+
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xt::xarray<double> V = xt::zeros<double>(shape);
+  double max_double_value = std::numeric_limits<double>::max();
+
+  xevo::pso pso_algorithm;
+  pso_algorithm.initialise<xt::xarray<double>, xevo::Population>(X);
+  pso_algorithm.initialise<xt::xarray<double>, xevo::Velocity_zero>(V);
+
+  xt::xarray<double> XB(X);
+  xt::xarray<double> YB = xt::ones<double>(shape_y) * max_double_value;
+
+  auto state = xevo::make_pso_state(X, XB, YB, V, xevo::Sphere{}, xevo::Position{},
+    xevo::Velocity(0.5, 0.8, 0.9), xevo::Selection_best_pso{});
+
+  std::size_t num_generations = 100;
+  state.run(num_generations);
+
+  EXPECT_EQ(state.evaluations(), 30 * (num_generations + 1));
+
+  auto y_args_sort = xt::argsort(state.fitness_best());
+  auto x_best = xt::view(state.position_best(), y_args_sort(0), xt::all());
+
+  EXPECT_NEAR(0.5, x_best(0), 1e-006);
+  EXPECT_NEAR(0.5, x_best(1), 1e-006);
+}
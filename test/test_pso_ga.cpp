@@ -37,4 +37,60 @@ TEST(pso_ga, void_evolve_sphere)
   EXPECT_NEAR(best_x1, x_best(0), 1e-006);
   EXPECT_NEAR(best_x2, x_best(1), 1e-006);
 
-}
\ No newline at end of file
+}
+
+TEST(pso_ga, state_mutation)
+{
+  std::array<std::size_t, 2> shape = { 30, 2 };
+
+  xt::xarray<double> X = xt::zeros<double>(shape);
+
+  xevo::Sphere objective_f;
+
+  xevo::pso_ga pso_ga_algorithm;
+  pso_ga_algorithm.initialise(X);
+  xt::xarray<double> A(X);
+  xt::xarray<double> Xm1(X);
+  xt::xarray<double> YB = objective_f(A);
+
+  // same position update, with and without mutation of every gene
+  xevo::seed(1);
+  auto state = xevo::make_pso_ga_state(X, Xm1, YB, A, xevo::Sphere{},
+    xevo::Position_pso_ga(0.5, 2.1, 2.1, 20, true), xevo::Selection_best_pso_ga(true),
+    xevo::Mutation_polynomial(0.0, 50.0));
+  state.step();
+
+  xevo::seed(1);
+  auto state_mutated = xevo::make_pso_ga_state(X, Xm1, YB, A, xevo::Sphere{},
+    xevo::Position_pso_ga(0.5, 2.1, 2.1, 20, true), xevo::Selection_best_pso_ga(true),
+    xevo::Mutation_polynomial(1.0, 50.0));
+  state_mutated.step();
+
+  std::size_t num_of_changed{ 0 };
+  for (std::size_t i{ 0 }; i < shape[0]; ++i)
+  {
+    for (std::size_t j{ 0 }; j < shape[1]; ++j)
+    {
+      num_of_changed += state_mutated.position()(i, j) != state.position()(i, j) ? 1 : 0;
+    }
+  }
+  EXPECT_EQ(num_of_changed, shape[0] * shape[1]);
+
+  // the stateless evolve mutates the swarm as well
+  xt::xarray<double> X_evolve(X);
+  xt::xarray<double> X_mutated(X);
+  xt::xarray<double> Xm1_evolve(Xm1);
+  xt::xarray<double> Xm1_mutated(Xm1);
+  xt::xarray<double> YB_evolve(YB);
+  xt::xarray<double> YB_mutated(YB);
+  xt::xarray<double> A_evolve(A);
+  xt::xarray<double> A_mutated(A);
+  xevo::seed(2);
+  pso_ga_algorithm.evolve(X_evolve, Xm1_evolve, YB_evolve, A_evolve, objective_f,
+    std::make_tuple(0.5, 2.1, 2.1, 20, true), std::make_tuple(true), std::make_tuple(0.0, 50.0));
+  xevo::seed(2);
+  pso_ga_algorithm.evolve(X_mutated, Xm1_mutated, YB_mutated, A_mutated, objective_f,
+    std::make_tuple(0.5, 2.1, 2.1, 20, true), std::make_tuple(true), std::make_tuple(1.0, 50.0));
+  EXPECT_FALSE(X_mutated == X_evolve);
+  EXPECT_TRUE(A_mutated == A_evolve);
+}
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "xevo/rng.hpp"
+#include "xevo/ga.hpp"
+#include "xevo/analytical_functions.hpp"
+
+
+TEST(rng, philox_known_answer)
+{
+  // known answer test of Random123 for philox4x32-10
+  auto r = xevo::philox4x32::block({ { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 } },
+    { { 0xa4093822, 0x299f31d0 } });
+
+  EXPECT_EQ(r[0], 0xd16cfe09u);
+  EXPECT_EQ(r[1], 0x94fdccebu);
+  EXPECT_EQ(r[2], 0x5001e420u);
+  EXPECT_EQ(r[3], 0x24126ea1u);
+}
+
+TEST(rng, batch_equals_sequential)
+{
+  xevo::rng r(42, 7);
+  auto gen_a = r.stream(3, 5);
+  auto gen_b = r.stream(3, 5);
+
+  std::vector<std::uint32_t> a(1003);
+  std::vector<std::uint32_t> b(1003);
+  gen_a();
+  for (auto& x : a)
+  {
+    x = gen_a();
+  }
+  gen_b();
+  gen_b.generate(b.data(), b.size());
+
+  EXPECT_EQ(a, b);
+
+  // different substreams give different numbers
+  auto gen_c = r.stream(3, 6);
+  EXPECT_NE(gen_c(), r.stream(3, 5)());
+}
+
+TEST(rng, normal_moments)
+{
+  xevo::rng r(1, 0);
+  auto gen = r.stream();
+  std::vector<double> z(100000);
+  xevo::fill_normal(gen, z.data(), z.size(), 1.0, 2.0);
+
+  double mean = 0.0;
+  double var = 0.0;
+  for (double v : z)
+  {
+    mean += v / z.size();
+  }
+  for (double v : z)
+  {
+    var += (v - mean) * (v - mean) / z.size();
+  }
+
+  EXPECT_NEAR(mean, 1.0, 0.05);
+  EXPECT_NEAR(var, 4.0, 0.1);
+}
+
+TEST(rng, reproducible_ga)
+{
+  auto run = []()
+  {
+    xevo::seed(2020);
+    std::array<std::size_t, 2> shape = { 20, 2 };
+    xt::xarray<double> X = xt::zeros<double>(shape);
+
+    xevo::ga genetic_algorithm;
+    genetic_algorithm.initialise(X);
+
+    auto state = xevo::make_ga_state(X, xevo::Rosenbrock_scaled{}, xevo::Elitism(0.05),
+      xevo::Roulette_selection{}, xevo::Crossover(0.8), xevo::Mutation_polynomial(0.1, 60.0));
+    state.run(20);
+    return xt::xarray<double>(state.population());
+  };
+
+  xt::xarray<double> first = run();
+  xt::xarray<double> second = run();
+
+  EXPECT_TRUE(first == second);
+}
@@ -0,0 +1,195 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "xevo/surrogate.hpp"
+#include "xevo/ga.hpp"
+#include "xevo/pso.hpp"
+
+#include "xtensor/xarray.hpp"
+#include "xtensor/xio.hpp"
+#include "xtensor/xrandom.hpp"
+
+namespace
+{
+  // quadratic q of every row with its optimum at 0.3, or 1 / (1 + q) for maximising
+  // algorithms (counts the evaluated rows)
+  struct Quadratic
+  {
+    template <class E>
+    xt::xtensor<double, 1> operator()(const xt::xexpression<E>& X)
+    {
+      const E& _X = X.derived_cast();
+      std::array<std::size_t, 1> shape_y = { _X.shape()[0] };
+      xt::xtensor<double, 1> y(shape_y);
+      for (std::size_t i{ 0 }; i < _X.shape()[0]; ++i)
+      {
+        double q{ 0.0 };
+        for (std::size_t j{ 0 }; j < _X.shape()[1]; ++j)
+        {
+          double d = _X(i, j) - 0.3;
+          q += d * d;
+        }
+        y(i) = inverse ? 1.0 / (1.0 + q) : q;
+      }
+      *num_of_evaluations += _X.shape()[0];
+      return y;
+    }
+
+    bool inverse;
+    std::size_t* num_of_evaluations;
+  };
+}
+
+TEST(surrogate, gaussian_process_interpolates)
+{
+  std::array<std::size_t, 2> shape = { 120, 3 };
+  xt::random::seed(0);
+  xt::xarray<double> X = xt::random::rand<double>(shape);
+  std::size_t num_of_evaluations{ 0 };
+  auto y = Quadratic{ false, &num_of_evaluations }(X);
+
+  xevo::gaussian_process_options options;
+  options.length_scale = 0.4;
+  options.regularisation = 1e-6;
+  xevo::gaussian_process<> model(3, options);
+  EXPECT_EQ(model.insert(X, y), 120u);
+  // duplicates add no information
+  EXPECT_EQ(model.insert(X, y), 0u);
+  EXPECT_EQ(model.size(), 120u);
+
+  std::array<std::size_t, 2> shape_test = { 20, 3 };
+  xt::xarray<double> X_test = xt::random::rand<double>(shape_test);
+  auto y_test = Quadratic{ false, &num_of_evaluations }(X_test);
+  std::array<std::size_t, 1> shape_prediction = { 20 };
+  xt::xtensor<double, 1> y_prediction(shape_prediction);
+  model.predict(X_test, y_prediction);
+  for (std::size_t i{ 0 }; i < 20; ++i)
+  {
+    EXPECT_NEAR(y_prediction(i), y_test(i), 0.05);
+  }
+}
+
+TEST(surrogate, gaussian_process_capacity)
+{
+  std::array<std::size_t, 2> shape = { 80, 2 };
+  xt::random::seed(1);
+  xt::xarray<double> X = xt::random::rand<double>(shape);
+  std::size_t num_of_evaluations{ 0 };
+  auto y = Quadratic{ false, &num_of_evaluations }(X);
+
+  // the factor updated when the oldest samples are dropped matches a model of the last samples
+  xevo::gaussian_process_options options;
+  options.length_scale = 0.3;
+  options.capacity = 30;
+  xevo::gaussian_process<> window(2, options);
+  window.insert(X, y);
+  EXPECT_EQ(window.size(), 30u);
+
+  options.capacity = 1000;
+  xevo::gaussian_process<> last(2, options);
+  xt::xarray<double> X_last = xt::view(X, xt::range(50, 80), xt::all());
+  xt::xarray<double> y_last = xt::view(y, xt::range(50, 80));
+  last.insert(X_last, y_last);
+
+  std::array<std::size_t, 1> shape_prediction = { 80 };
+  xt::xtensor<double, 1> y_window(shape_prediction);
+  xt::xtensor<double, 1> y_last_prediction(shape_prediction);
+  window.predict(X, y_window);
+  last.predict(X, y_last_prediction);
+  for (std::size_t i{ 0 }; i < 80; ++i)
+  {
+    EXPECT_NEAR(y_window(i), y_last_prediction(i), 1e-8);
+  }
+}
+
+TEST(surrogate, ga_state_prescreening)
+{
+  std::array<std::size_t, 2> shape = { 40, 2 };
+  xt::xarray<double> X = xt::zeros<double>(shape);
+
+  xevo::ga genetic_algorithm;
+  genetic_algorithm.initialise(X);
+
+  std::size_t num_of_evaluations{ 0 };
+  xevo::surrogate_options options;
+  options.fraction = 0.25;
+  xevo::Evaluate_surrogate<Quadratic> objective_f(Quadratic{ true, &num_of_evaluations }, 2, options);
+
+  auto state = xevo::make_ga_state(X, objective_f, xevo::Elitism(0.05),
+    xevo::Roulette_selection{}, xevo::Crossover(0.8), xevo::Mutation_polynomial(0.1, 60.0));
+  std::size_t num_generations = 50;
+  state.run(num_generations);
+
+  // the initial population is evaluated, then 10 candidates per generation
+  EXPECT_EQ(num_of_evaluations, 40 + num_generations * 10);
+  EXPECT_EQ(objective_f.evaluations(), num_of_evaluations);
+  EXPECT_EQ(objective_f.screened(), num_generations * 30);
+  EXPECT_EQ(state.evaluations(), 40 * (num_generations + 1));
+
+  std::size_t num_of_checks{ 0 };
+  auto y = Quadratic{ true, &num_of_checks }(state.population());
+  EXPECT_GT(*std::max_element(y.begin(), y.end()), 1.0 / (1.0 + 1e-2));
+}
+
+TEST(surrogate, prescreening_view)
+{
+  xt::random::seed(5);
+  std::array<std::size_t, 2> shape = { 40, 2 };
+  xt::xarray<double> X = xt::random::rand<double>(shape);
+
+  std::size_t num_of_evaluations{ 0 };
+  xevo::surrogate_options options;
+  options.fraction = 0.25;
+  options.maximise = false;
+  xevo::Evaluate_surrogate<Quadratic> objective_f(Quadratic{ false, &num_of_evaluations }, 2, options);
+
+  // the selected rows of a view are evaluated on a row-major copy
+  objective_f(xt::view(X, xt::range(0, 20), xt::all()));
+  auto X_view = xt::view(X, xt::range(20, 40), xt::all());
+  objective_f(X_view);
+
+  EXPECT_EQ(num_of_evaluations, 20 + 5);
+  EXPECT_EQ(objective_f.screened(), 15);
+}
+
+TEST(surrogate, pso_state_prescreening)
+{
+  std::array<std::size_t, 2> shape = { 30, 2 };
+  std::array<std::size_t, 1> shape_y = { 30 };
+
+  xt::xarray<double> X = xt::zeros<double>(shape);
+  xt::xarray<double> V = xt::zeros<double>(shape);
+
+  xevo::pso pso_algorithm;
+  pso_algorithm.initialise<xt::xarray<double>, xevo::Population>(X);
+  pso_algorithm.initialise<xt::xarray<double>, xevo::Velocity_zero>(V);
+
+  xt::xarray<double> XB(X);
+  xt::xarray<double> YB = xt::ones<double>(shape_y) * std::numeric_limits<double>::max();
+
+  std::size_t num_of_evaluations{ 0 };
+  xevo::surrogate_options options;
+  options.fraction = 0.2;
+  options.maximise = false;
+  // personal bests are only replaced by evaluated positions
+  options.screened = xevo::screened_fitness::excluded;
+  xevo::Evaluate_surrogate<Quadratic> objective_f(Quadratic{ false, &num_of_evaluations }, 2, options);
+
+  auto state = xevo::make_pso_state(X, XB, YB, V, objective_f, xevo::Position{},
+    xevo::Velocity(0.5, 0.8, 0.9), xevo::Selection_best_pso{});
+  std::size_t num_generations = 100;
+  state.run(num_generations);
+
+  EXPECT_EQ(num_of_evaluations, 30 + num_generations * 6);
+
+  auto y_best = state.fitness_best();
+  std::size_t best = std::min_element(y_best.begin(), y_best.end()) - y_best.begin();
+  std::size_t num_of_checks{ 0 };
+  xt::xarray<double> x_best = xt::view(state.position_best(), xt::range(best, best + 1), xt::all());
+  // the stored best fitness is a true evaluation
+  EXPECT_DOUBLE_EQ(y_best(best), Quadratic{ false, &num_of_checks }(x_best)(0));
+  EXPECT_NEAR(x_best(0, 0), 0.3, 0.1);
+  EXPECT_NEAR(x_best(0, 1), 0.3, 0.1);
+}